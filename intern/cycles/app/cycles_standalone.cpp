@@ -16,10 +16,19 @@
 
 #include <stdio.h>
 
+#ifdef _WIN32
+#  include <process.h>
+#else
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
 #include "device/device.h"
 #include "render/buffers.h"
 #include "render/camera.h"
+#include "render/film.h"
 #include "render/integrator.h"
+#include "render/merge.h"
 #include "render/scene.h"
 #include "render/session.h"
 
@@ -31,6 +40,7 @@
 #include "util/util_path.h"
 #include "util/util_progress.h"
 #include "util/util_string.h"
+#include "util/util_system.h"
 #include "util/util_time.h"
 #include "util/util_transform.h"
 #include "util/util_unique_ptr.h"
@@ -54,6 +64,12 @@ struct Options {
   bool quiet;
   bool show_help, interactive, pause;
   string output_path;
+  /* Multi-process rendering: number of child processes to split the samples over,
+   * the sample range rendered by this process and the images to merge. */
+  int processes;
+  int range_start_sample, range_num_samples;
+  bool merge;
+  vector<string> merge_inputs;
 } options;
 
 static void session_print(const string &str)
@@ -113,6 +129,72 @@ static bool write_render(const uchar *pixels, int w, int h, int channels)
   return true;
 }
 
+/* Write the float passes of a sample range render, in the multilayer EXR layout that
+ * ImageMerger expects, so separately rendered ranges can be merged afterwards. */
+static bool write_render_range()
+{
+  Session *session = options.session;
+  RenderBuffers *buffers = session->buffers;
+  if (!buffers || !buffers->copy_from_device()) {
+    return false;
+  }
+
+  const int w = buffers->params.width;
+  const int h = buffers->params.height;
+  vector<float> pixels(w * h * 4);
+  if (!buffers->get_pass_rect("Combined",
+                              options.scene->film->exposure,
+                              options.range_num_samples,
+                              4,
+                              pixels.data())) {
+    return false;
+  }
+
+  unique_ptr<ImageOutput> out = unique_ptr<ImageOutput>(ImageOutput::create(options.output_path));
+  if (!out) {
+    return false;
+  }
+
+  ImageSpec spec(w, h, 4, TypeDesc::FLOAT);
+  spec.channelnames.clear();
+  spec.channelnames.push_back("RenderLayer.Combined.R");
+  spec.channelnames.push_back("RenderLayer.Combined.G");
+  spec.channelnames.push_back("RenderLayer.Combined.B");
+  spec.channelnames.push_back("RenderLayer.Combined.A");
+  spec.alpha_channel = 3;
+
+  double total_time, render_time;
+  session->progress.get_time(total_time, render_time);
+  spec.attribute("cycles.RenderLayer.samples",
+                 TypeDesc::STRING,
+                 string_printf("%d", options.range_num_samples));
+  spec.attribute("cycles.RenderLayer.range_start_sample",
+                 TypeDesc::STRING,
+                 string_printf("%d", options.range_start_sample));
+  spec.attribute("cycles.RenderLayer.total_time",
+                 TypeDesc::STRING,
+                 time_human_readable_from_seconds(total_time));
+
+  if (!out->open(options.output_path, spec)) {
+    return false;
+  }
+
+  /* conversion for different top/bottom convention */
+  const int stride = w * 4 * sizeof(float);
+  out->write_image(
+      TypeDesc::FLOAT, pixels.data() + (h - 1) * w * 4, AutoStride, -stride, AutoStride);
+
+  return out->close();
+}
+
+static bool write_render_none(const uchar * /*pixels*/,
+                              int /*w*/,
+                              int /*h*/,
+                              int /*channels*/)
+{
+  return true;
+}
+
 static BufferParams &session_buffer_params()
 {
   static BufferParams buffer_params;
@@ -148,6 +230,10 @@ static void scene_init()
 static void session_init()
 {
   options.session_params.write_render_cb = write_render;
+  if (options.range_num_samples != -1) {
+    /* Keep full frame buffers, the float result is written in session_exit(). */
+    options.session_params.write_render_cb = write_render_none;
+  }
   options.session = new Session(options.session_params);
 
   if (options.session_params.background && !options.quiet)
@@ -161,12 +247,26 @@ static void session_init()
   scene_init();
   options.session->scene = options.scene;
 
+  /* Sample range, the kernel uses the sample index for random numbers, so the ranges of a frame
+   * don't correlate. */
+  if (options.range_num_samples != -1) {
+    options.session->tile_manager.range_start_sample = options.range_start_sample;
+    options.session->tile_manager.range_num_samples = options.range_num_samples;
+  }
+
   options.session->reset(session_buffer_params(), options.session_params.samples);
   options.session->start();
 }
 
 static void session_exit()
 {
+  if (options.session && options.range_num_samples != -1 &&
+      !options.session->progress.get_cancel()) {
+    if (!write_render_range()) {
+      fprintf(stderr, "Failed to write image %s\n", options.output_path.c_str());
+    }
+  }
+
   if (options.session) {
     delete options.session;
     options.session = NULL;
@@ -355,11 +455,187 @@ static void keyboard(unsigned char key)
 }
 #endif
 
+/* Multi-process rendering
+ *
+ * The coordinator splits the samples of the frame into contiguous ranges, renders each
+ * range in a child process and merges the resulting images in range order, so the result
+ * does not depend on which process finishes first. Farm nodes can render ranges with
+ * --sample-range themselves and merge the files with --merge. */
+
+static bool output_is_exr()
+{
+  const string &path = options.output_path;
+  return path.size() > 4 && string_iequals(path.substr(path.size() - 4), ".exr");
+}
+
+static bool process_wait(intptr_t pid)
+{
+#ifdef _WIN32
+  int status;
+  return _cwait(&status, pid, 0) != -1 && status == 0;
+#else
+  int status;
+  return waitpid((pid_t)pid, &status, 0) != -1 && WIFEXITED(status) &&
+         WEXITSTATUS(status) == 0;
+#endif
+}
+
+#ifdef _WIN32
+/* The arguments of _spawnvp() are joined into a single command line, which the child splits
+ * again. Quote them the way the C runtime parses them, so paths with spaces survive. */
+static string process_argument_quote(const string &arg)
+{
+  if (!arg.empty() && arg.find_first_of(" \t\"") == string::npos) {
+    return arg;
+  }
+
+  string quoted = "\"";
+  size_t num_backslashes = 0;
+  foreach (const char c, arg) {
+    if (c == '\\') {
+      num_backslashes++;
+      continue;
+    }
+    /* Backslashes are only special in front of a quote. */
+    quoted.append(c == '"' ? num_backslashes * 2 + 1 : num_backslashes, '\\');
+    quoted.push_back(c);
+    num_backslashes = 0;
+  }
+  /* Backslashes in front of the closing quote. */
+  quoted.append(num_backslashes * 2, '\\');
+  quoted.push_back('"');
+  return quoted;
+}
+#endif
+
+static intptr_t process_spawn(const vector<string> &args)
+{
+#ifdef _WIN32
+  vector<string> args_quoted;
+  foreach (const string &arg, args) {
+    args_quoted.push_back(process_argument_quote(arg));
+  }
+  vector<const char *> argv;
+  foreach (const string &arg, args_quoted) {
+    argv.push_back(arg.c_str());
+  }
+  argv.push_back(NULL);
+
+  /* The program is found by its unquoted path. */
+  return _spawnvp(_P_NOWAIT, args[0].c_str(), argv.data());
+#else
+  vector<const char *> argv;
+  foreach (const string &arg, args) {
+    argv.push_back(arg.c_str());
+  }
+  argv.push_back(NULL);
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    execvp(argv[0], (char *const *)argv.data());
+    _exit(EXIT_FAILURE);
+  }
+  return pid;
+#endif
+}
+
+static bool images_merge(const vector<string> &inputs, const string &output)
+{
+  ImageMerger merger;
+  merger.input = inputs;
+  merger.output = output;
+
+  if (!merger.run()) {
+    fprintf(stderr, "%s\n", merger.error.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+static int render_processes(int argc, const char **argv)
+{
+  const int num_processes = options.processes;
+  const int num_samples = options.session_params.samples;
+
+  /* Arguments shared by all child processes, output and process count are per child. */
+  vector<string> args;
+  args.push_back(argv[0]);
+  for (int i = 1; i < argc; i++) {
+    if (string_iequals(argv[i], "--processes") || string_iequals(argv[i], "--output")) {
+      i++;
+      continue;
+    }
+    args.push_back(argv[i]);
+  }
+
+  args.push_back("--background");
+  args.push_back("--quiet");
+  if (options.session_params.threads == 0) {
+    const int threads = max((int)system_cpu_thread_count() / num_processes, 1);
+    args.push_back("--threads");
+    args.push_back(string_printf("%d", threads));
+  }
+
+  vector<string> outputs;
+  vector<intptr_t> pids;
+  for (int i = 0; i < num_processes; i++) {
+    const int start_sample = (num_samples * i) / num_processes;
+    const int end_sample = (num_samples * (i + 1)) / num_processes;
+
+    string output = string_printf("%s.range%04d.exr", options.output_path.c_str(), i);
+    vector<string> process_args = args;
+    process_args.push_back("--sample-range");
+    process_args.push_back(string_printf("%d", start_sample));
+    process_args.push_back(string_printf("%d", end_sample - start_sample));
+    process_args.push_back("--output");
+    process_args.push_back(output);
+
+    intptr_t pid = process_spawn(process_args);
+    if (pid == -1) {
+      fprintf(stderr, "Failed to start render process %d\n", i);
+      break;
+    }
+
+    outputs.push_back(output);
+    pids.push_back(pid);
+  }
+
+  if (!options.quiet) {
+    printf("Rendering %d samples in %d processes\n", num_samples, (int)pids.size());
+  }
+
+  bool success = ((int)pids.size() == num_processes);
+  for (size_t i = 0; i < pids.size(); i++) {
+    if (!process_wait(pids[i])) {
+      fprintf(stderr, "Render process %d failed\n", (int)i);
+      success = false;
+    }
+  }
+
+  if (success) {
+    success = images_merge(outputs, options.output_path);
+  }
+
+  foreach (const string &output, outputs) {
+    path_remove(output);
+  }
+
+  if (success && !options.quiet) {
+    printf("Merged %d sample ranges into %s\n", num_processes, options.output_path.c_str());
+  }
+
+  return (success) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 static int files_parse(int argc, const char *argv[])
 {
-  if (argc > 0)
+  if (argc > 0 && options.filepath == "")
     options.filepath = argv[0];
 
+  for (int i = 0; i < argc; i++)
+    options.merge_inputs.push_back(argv[i]);
+
   return 0;
 }
 
@@ -370,6 +646,10 @@ static void options_parse(int argc, const char **argv)
   options.filepath = "";
   options.session = NULL;
   options.quiet = false;
+  options.processes = 0;
+  options.range_start_sample = 0;
+  options.range_num_samples = -1;
+  options.merge = false;
 
   /* device names */
   string device_names = "";
@@ -388,6 +668,9 @@ static void options_parse(int argc, const char **argv)
   /* shading system */
   string ssname = "svm";
 
+  /* hair shape */
+  string hair_shape = "ribbon";
+
   /* parse options */
   ArgParse ap;
   bool help = false, debug = false, version = false;
@@ -432,6 +715,22 @@ static void options_parse(int argc, const char **argv)
              "--tile-height %d",
              &options.session_params.tile_size.y,
              "Tile height in pixels",
+             "--hair-shape %s",
+             &hair_shape,
+             "Hair curve shape: ribbon, thick",
+             "--compress-geometry",
+             &options.scene_params.use_compressed_geometry,
+             "Store vertex normals and UV maps in compressed form",
+             "--processes %d",
+             &options.processes,
+             "Split the samples over this number of render processes and merge the result",
+             "--sample-range %d %d",
+             &options.range_start_sample,
+             &options.range_num_samples,
+             "Render only the given start sample and number of samples, to an EXR file",
+             "--merge",
+             &options.merge,
+             "Merge the given EXR sample range renders into the output file",
              "--list-devices",
              &list,
              "List information about all available devices",
@@ -489,8 +788,16 @@ static void options_parse(int argc, const char **argv)
   else if (ssname == "svm")
     options.scene_params.shadingsystem = SHADINGSYSTEM_SVM;
 
+  if (hair_shape == "thick")
+    options.scene_params.hair_shape = CURVE_THICK;
+  else if (hair_shape == "ribbon")
+    options.scene_params.hair_shape = CURVE_RIBBON;
+
 #ifndef WITH_CYCLES_STANDALONE_GUI
   options.session_params.background = true;
+#else
+  if (options.processes > 1 || options.range_num_samples != -1 || options.merge)
+    options.session_params.background = true;
 #endif
 
   /* Use progressive rendering */
@@ -522,6 +829,10 @@ static void options_parse(int argc, const char **argv)
     exit(EXIT_FAILURE);
   }
 #endif
+  else if (!(hair_shape == "ribbon" || hair_shape == "thick")) {
+    fprintf(stderr, "Unknown hair shape: %s\n", hair_shape.c_str());
+    exit(EXIT_FAILURE);
+  }
   else if (options.session_params.samples < 0) {
     fprintf(stderr, "Invalid number of samples: %d\n", options.session_params.samples);
     exit(EXIT_FAILURE);
@@ -530,6 +841,23 @@ static void options_parse(int argc, const char **argv)
     fprintf(stderr, "No file path specified\n");
     exit(EXIT_FAILURE);
   }
+  else if ((options.processes > 1 || options.range_num_samples != -1 || options.merge) &&
+           !output_is_exr()) {
+    fprintf(stderr, "Multi-process rendering needs an EXR output file path\n");
+    exit(EXIT_FAILURE);
+  }
+  else if (options.processes > 1 && options.processes > options.session_params.samples) {
+    fprintf(stderr, "More render processes than samples: %d\n", options.processes);
+    exit(EXIT_FAILURE);
+  }
+  else if (options.range_num_samples != -1 &&
+           (options.range_start_sample < 0 || options.range_num_samples < 1)) {
+    fprintf(stderr,
+            "Invalid sample range: %d %d\n",
+            options.range_start_sample,
+            options.range_num_samples);
+    exit(EXIT_FAILURE);
+  }
 
   /* For smoother Viewport */
   options.session_params.start_resolution = 64;
@@ -545,6 +873,14 @@ int main(int argc, const char **argv)
   path_init();
   options_parse(argc, argv);
 
+  if (options.merge) {
+    return images_merge(options.merge_inputs, options.output_path) ? EXIT_SUCCESS :
+                                                                     EXIT_FAILURE;
+  }
+  else if (options.processes > 1) {
+    return render_processes(argc, argv);
+  }
+
 #ifdef WITH_CYCLES_STANDALONE_GUI
   if (options.session_params.background) {
 #endif
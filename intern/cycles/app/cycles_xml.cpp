@@ -26,6 +26,7 @@
 #include "render/camera.h"
 #include "render/film.h"
 #include "render/graph.h"
+#include "render/hair.h"
 #include "render/integrator.h"
 #include "render/light.h"
 #include "render/mesh.h"
@@ -533,6 +534,61 @@ static void xml_read_mesh(const XMLReadState &state, xml_node node)
   }
 }
 
+/* Hair */
+
+static void xml_read_hair(const XMLReadState &state, xml_node node)
+{
+  /* add hair */
+  Hair *hair = new Hair();
+  state.scene->geometry.push_back(hair);
+  hair->used_shaders.push_back(state.shader);
+
+  /* create object*/
+  Object *object = new Object();
+  object->geometry = hair;
+  object->tfm = state.tfm;
+  state.scene->objects.push_back(object);
+
+  /* read curve keys, radius per key or for all keys, and number of keys per curve */
+  vector<float3> P;
+  vector<float> radius;
+  vector<int> nkeys;
+
+  xml_read_float3_array(P, node, "P");
+  xml_read_float_array(radius, node, "radius");
+  xml_read_int_array(nkeys, node, "nkeys");
+
+  if (radius.empty()) {
+    radius.push_back(0.01f);
+  }
+  else if (radius.size() != 1 && radius.size() != P.size()) {
+    fprintf(stderr,
+            "Hair has %d radii for %d keys, using the first radius for all keys.\n",
+            (int)radius.size(),
+            (int)P.size());
+    radius.resize(1);
+  }
+
+  /* create curves */
+  hair->reserve_curves(nkeys.size(), P.size());
+
+  int key_offset = 0;
+  for (size_t i = 0; i < nkeys.size(); i++) {
+    if (nkeys[i] < 2 || key_offset + nkeys[i] > (int)P.size()) {
+      fprintf(stderr, "Invalid number of keys for curve %d.\n", (int)i);
+      break;
+    }
+
+    for (int j = 0; j < nkeys[i]; j++) {
+      const int key = key_offset + j;
+      hair->add_curve_key(P[key], (radius.size() == 1) ? radius[0] : radius[key]);
+    }
+
+    hair->add_curve(key_offset, 0);
+    key_offset += nkeys[i];
+  }
+}
+
 /* Light */
 
 static void xml_read_light(XMLReadState &state, xml_node node)
@@ -632,6 +688,9 @@ static void xml_read_scene(XMLReadState &state, xml_node scene_node)
     else if (string_iequals(node.name(), "mesh")) {
       xml_read_mesh(state, node);
     }
+    else if (string_iequals(node.name(), "hair")) {
+      xml_read_hair(state, node);
+    }
     else if (string_iequals(node.name(), "light")) {
       xml_read_light(state, node);
     }
@@ -676,6 +676,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         description="Use BVH spatial splits: longer builder time, faster render",
         default=False,
     )
+    use_compressed_geometry: BoolProperty(
+        name="Compressed Geometry",
+        description="Store vertex normals and UV maps in compressed form to reduce memory usage, "
+        "at the cost of slightly lower precision",
+        default=False,
+    )
     debug_use_hair_bvh: BoolProperty(
         name="Use Hair BVH",
         description="Use special type BVH optimized for hair (uses more ram but renders faster)",
@@ -794,6 +800,21 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         items=enum_texture_limit
     )
 
+    use_texture_cache: BoolProperty(
+        name="Texture Cache",
+        description="Read image textures on demand at the mipmap level needed, instead of loading them into memory fully "
+        "(final CPU rendering only)",
+        default=False,
+    )
+
+    texture_cache_size: IntProperty(
+        name="Texture Cache Size",
+        description="Maximum memory used by the texture cache, in megabytes",
+        default=4096,
+        min=64,
+        soft_max=65536,
+    )
+
     ao_bounces: IntProperty(
         name="AO Bounces",
         default=0,
@@ -723,6 +723,8 @@ class CYCLES_RENDER_PT_performance_acceleration_structure(CyclesButtonsPanel, Pa
         sub.active = not cscene.debug_use_spatial_splits and not use_embree
         sub.prop(cscene, "debug_bvh_time_steps")
 
+        col.prop(cscene, "use_compressed_geometry")
+
 
 class CYCLES_RENDER_PT_performance_final_render(CyclesButtonsPanel, Panel):
     bl_label = "Final Render"
@@ -735,12 +737,17 @@ class CYCLES_RENDER_PT_performance_final_render(CyclesButtonsPanel, Panel):
 
         scene = context.scene
         rd = scene.render
+        cscene = scene.cycles
 
         col = layout.column()
 
         col.prop(rd, "use_save_buffers")
         col.prop(rd, "use_persistent_data", text="Persistent Images")
 
+        col.prop(cscene, "use_texture_cache")
+        sub = col.column()
+        sub.active = cscene.use_texture_cache
+        sub.prop(cscene, "texture_cache_size", text="Cache Size")
 
 class CYCLES_RENDER_PT_performance_viewport(CyclesButtonsPanel, Panel):
     bl_label = "Viewport"
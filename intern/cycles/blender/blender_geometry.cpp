@@ -31,7 +31,8 @@ Geometry *BlenderSync::sync_geometry(BL::Depsgraph &b_depsgraph,
                                      BL::Object &b_ob,
                                      BL::Object &b_ob_instance,
                                      bool object_updated,
-                                     bool use_particle_hair)
+                                     bool use_particle_hair,
+                                     BlenderGeometryTasks *geom_tasks)
 {
   /* Test if we can instance or if the object is modified. */
   BL::ID b_ob_data = b_ob.data();
@@ -115,23 +116,41 @@ Geometry *BlenderSync::sync_geometry(BL::Depsgraph &b_depsgraph,
     return geom;
   }
 
-  progress.set_sync_status("Synchronizing object", b_ob.name());
-
   geometry_synced.insert(geom);
 
   geom->name = ustring(b_ob_data.name().c_str());
 
-  if (b_ob.type() == BL::Object::type_HAIR || use_particle_hair) {
-    Hair *hair = static_cast<Hair *>(geom);
-    sync_hair(b_depsgraph, b_ob, hair, used_shaders);
-  }
-  else if (b_ob.type() == BL::Object::type_VOLUME || object_fluid_gas_domain_find(b_ob)) {
-    Mesh *mesh = static_cast<Mesh *>(geom);
-    sync_volume(b_ob, mesh, used_shaders);
+  /* Tag for update right away, the object loop uses this to decide what else
+   * to update. The export tags it again with whether the BVH needs a rebuild. */
+  geom->used_shaders = used_shaders;
+  geom->tag_update(scene, false);
+
+  auto sync_func = [=]() mutable {
+    if (progress.get_cancel()) {
+      return;
+    }
+
+    progress.set_sync_status("Synchronizing object", b_ob.name());
+
+    if (geom_type == Geometry::HAIR) {
+      Hair *hair = static_cast<Hair *>(geom);
+      sync_hair(b_depsgraph, b_ob, hair, used_shaders);
+    }
+    else if (b_ob.type() == BL::Object::type_VOLUME || object_fluid_gas_domain_find(b_ob)) {
+      Mesh *mesh = static_cast<Mesh *>(geom);
+      sync_volume(b_ob, mesh, used_shaders);
+    }
+    else {
+      Mesh *mesh = static_cast<Mesh *>(geom);
+      sync_mesh(b_depsgraph, b_ob, mesh, used_shaders);
+    }
+  };
+
+  if (geom_tasks) {
+    (*geom_tasks)[b_ob.ptr.data].push_back(sync_func);
   }
   else {
-    Mesh *mesh = static_cast<Mesh *>(geom);
-    sync_mesh(b_depsgraph, b_ob, mesh, used_shaders);
+    sync_func();
   }
 
   return geom;
@@ -141,7 +160,8 @@ void BlenderSync::sync_geometry_motion(BL::Depsgraph &b_depsgraph,
                                        BL::Object &b_ob,
                                        Object *object,
                                        float motion_time,
-                                       bool use_particle_hair)
+                                       bool use_particle_hair,
+                                       BlenderGeometryTasks *geom_tasks)
 {
   /* Ensure we only sync instanced geometry once. */
   Geometry *geom = object->geometry;
@@ -162,16 +182,29 @@ void BlenderSync::sync_geometry_motion(BL::Depsgraph &b_depsgraph,
     return;
   }
 
-  if (b_ob.type() == BL::Object::type_HAIR || use_particle_hair) {
-    Hair *hair = static_cast<Hair *>(geom);
-    sync_hair_motion(b_depsgraph, b_ob, hair, motion_step);
-  }
-  else if (b_ob.type() == BL::Object::type_VOLUME || object_fluid_gas_domain_find(b_ob)) {
-    /* No volume motion blur support yet. */
+  auto sync_func = [=]() mutable {
+    if (progress.get_cancel()) {
+      return;
+    }
+
+    if (b_ob.type() == BL::Object::type_HAIR || use_particle_hair) {
+      Hair *hair = static_cast<Hair *>(geom);
+      sync_hair_motion(b_depsgraph, b_ob, hair, motion_step);
+    }
+    else if (b_ob.type() == BL::Object::type_VOLUME || object_fluid_gas_domain_find(b_ob)) {
+      /* No volume motion blur support yet. */
+    }
+    else {
+      Mesh *mesh = static_cast<Mesh *>(geom);
+      sync_mesh_motion(b_depsgraph, b_ob, mesh, motion_step);
+    }
+  };
+
+  if (geom_tasks) {
+    (*geom_tasks)[b_ob.ptr.data].push_back(sync_func);
   }
   else {
-    Mesh *mesh = static_cast<Mesh *>(geom);
-    sync_mesh_motion(b_depsgraph, b_ob, mesh, motion_step);
+    sync_func();
   }
 }
 
@@ -103,7 +103,8 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
                                  bool use_particle_hair,
                                  bool show_lights,
                                  BlenderObjectCulling &culling,
-                                 bool *use_portal)
+                                 bool *use_portal,
+                                 BlenderGeometryTasks *geom_tasks)
 {
   const bool is_instance = b_instance.is_instance();
   BL::Object b_ob = b_instance.object();
@@ -198,7 +199,8 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
 
       /* mesh deformation */
       if (object->geometry)
-        sync_geometry_motion(b_depsgraph, b_ob, object, motion_time, use_particle_hair);
+        sync_geometry_motion(
+            b_depsgraph, b_ob_instance, object, motion_time, use_particle_hair, geom_tasks);
     }
 
     return object;
@@ -210,9 +212,11 @@ Object *BlenderSync::sync_object(BL::Depsgraph &b_depsgraph,
   if (object_map.add_or_update(&object, b_ob, b_parent, key))
     object_updated = true;
 
-  /* mesh sync */
+  /* mesh sync
+   * b_ob is owned by the instance iterator and only valid until the next instance,
+   * while b_ob_instance remains valid for the deferred geometry export. */
   object->geometry = sync_geometry(
-      b_depsgraph, b_ob, b_ob_instance, object_updated, use_particle_hair);
+      b_depsgraph, b_ob_instance, b_ob_instance, object_updated, use_particle_hair, geom_tasks);
 
   /* special case not tracked by object update flags */
 
@@ -356,6 +360,10 @@ void BlenderSync::sync_objects(BL::Depsgraph &b_depsgraph,
 
   BL::ViewLayer b_view_layer = b_depsgraph.view_layer_eval();
 
+  /* Geometry is exported after the object loop. Objects are still created in
+   * depsgraph order, only the conversion of their data runs in parallel. */
+  BlenderGeometryTasks geom_tasks;
+
   BL::Depsgraph::object_instances_iterator b_instance_iter;
   for (b_depsgraph.object_instances.begin(b_instance_iter);
        b_instance_iter != b_depsgraph.object_instances.end() && !cancel;
@@ -381,7 +389,8 @@ void BlenderSync::sync_objects(BL::Depsgraph &b_depsgraph,
                   false,
                   show_lights,
                   culling,
-                  &use_portal);
+                  &use_portal,
+                  &geom_tasks);
     }
 
     /* Particle hair as separate object. */
@@ -393,8 +402,24 @@ void BlenderSync::sync_objects(BL::Depsgraph &b_depsgraph,
                   true,
                   show_lights,
                   culling,
-                  &use_portal);
+                  &use_portal,
+                  &geom_tasks);
+    }
+
+    cancel = progress.get_cancel();
+  }
+
+  if (!cancel) {
+    TaskPool pool;
+    for (const BlenderGeometryTasks::value_type &it : geom_tasks) {
+      const vector<TaskRunFunction> &sync_funcs = it.second;
+      pool.push([&sync_funcs]() {
+        for (const TaskRunFunction &sync_func : sync_funcs) {
+          sync_func();
+        }
+      });
     }
+    pool.wait_work();
 
     cancel = progress.get_cancel();
   }
@@ -767,6 +767,16 @@ SceneParams BlenderSync::get_scene_params(BL::Scene &b_scene, bool background)
     params.texture_limit = 0;
   }
 
+  if (background) {
+    params.use_texture_cache = get_boolean(cscene, "use_texture_cache");
+    params.texture_cache_size = get_int(cscene, "texture_cache_size");
+  }
+  else {
+    params.use_texture_cache = false;
+  }
+
+  params.use_compressed_geometry = get_boolean(cscene, "use_compressed_geometry");
+
   params.bvh_layout = DebugFlags().cpu.bvh_layout;
 
   params.background = background;
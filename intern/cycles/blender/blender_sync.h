@@ -30,6 +30,7 @@
 
 #include "util/util_map.h"
 #include "util/util_set.h"
+#include "util/util_task.h"
 #include "util/util_transform.h"
 #include "util/util_vector.h"
 
@@ -51,6 +52,11 @@ class Shader;
 class ShaderGraph;
 class ShaderNode;
 
+/* Geometry export deferred by the object loop to run on the task pool, grouped
+ * by Blender object since evaluating the same object from multiple threads is
+ * not safe. */
+typedef map<void *, vector<TaskRunFunction>> BlenderGeometryTasks;
+
 class BlenderSync {
  public:
   BlenderSync(BL::RenderEngine &b_engine,
@@ -145,7 +151,8 @@ class BlenderSync {
                       bool use_particle_hair,
                       bool show_lights,
                       BlenderObjectCulling &culling,
-                      bool *use_portal);
+                      bool *use_portal,
+                      BlenderGeometryTasks *geom_tasks);
 
   /* Volume */
   void sync_volume(BL::Object &b_ob, Mesh *mesh, const vector<Shader *> &used_shaders);
@@ -177,12 +184,14 @@ class BlenderSync {
                           BL::Object &b_ob,
                           BL::Object &b_ob_instance,
                           bool object_updated,
-                          bool use_particle_hair);
+                          bool use_particle_hair,
+                          BlenderGeometryTasks *geom_tasks);
   void sync_geometry_motion(BL::Depsgraph &b_depsgraph,
                             BL::Object &b_ob,
                             Object *object,
                             float motion_time,
-                            bool use_particle_hair);
+                            bool use_particle_hair,
+                            BlenderGeometryTasks *geom_tasks);
 
   /* Light */
   void sync_light(BL::Object &b_parent,
@@ -92,7 +92,12 @@ int BVHStackEntry::encodeIdx() const
 BVH::BVH(const BVHParams &params_,
          const vector<Geometry *> &geometry_,
          const vector<Object *> &objects_)
-    : params(params_), geometry(geometry_), objects(objects_)
+    : params(params_),
+      geometry(geometry_),
+      objects(objects_),
+      top_level_prim_size(0),
+      top_level_nodes_size(0),
+      top_level_leaf_nodes_size(0)
 {
 }
 
@@ -191,6 +196,47 @@ void BVH::refit(Progress &progress)
   refit_nodes();
 }
 
+bool BVH::refit_top_level(Progress &progress)
+{
+  assert(params.top_level);
+
+  /* Strip merged instance BVHs, they are merged again once the top level nodes are refit. */
+  pack.prim_index.resize(top_level_prim_size);
+  pack.prim_type.resize(top_level_prim_size);
+  pack.prim_object.resize(top_level_prim_size);
+  if (pack.prim_time.size()) {
+    pack.prim_time.resize(top_level_prim_size);
+  }
+  pack.nodes.resize(top_level_nodes_size);
+  pack.leaf_nodes.resize(top_level_leaf_nodes_size);
+
+  progress.set_substatus("Refitting BVH nodes");
+  refit_nodes();
+
+  if (progress.get_cancel()) {
+    return false;
+  }
+
+  if (!rebuild_degraded_nodes()) {
+    return false;
+  }
+
+  /* Back to geometry local primitive indices, as the builder leaves them. */
+  for (size_t i = 0; i < pack.prim_index.size(); i++) {
+    if (pack.prim_index[i] != -1) {
+      pack.prim_index[i] -= objects[pack.prim_object[i]]->geometry->prim_offset;
+    }
+  }
+
+  progress.set_substatus("Packing BVH primitives");
+  pack_primitives();
+
+  progress.set_substatus("Packing BVH instances");
+  pack_instances(top_level_nodes_size, top_level_leaf_nodes_size);
+
+  return true;
+}
+
 void BVH::refit_primitives(int start, int end, BoundBox &bbox, uint &visibility)
 {
   /* Refit range of primitives. */
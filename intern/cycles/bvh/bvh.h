@@ -101,11 +101,21 @@ class BVH {
 
   void refit(Progress &progress);
 
+  /* Refit top level BVH after objects moved or geometry deformed, without changes to the
+   * primitives it contains. Subtrees whose bounds grew too much are rebuilt in place.
+   * Returns false when quality degraded too much and a full build is needed instead. */
+  bool refit_top_level(Progress &progress);
+
  protected:
   BVH(const BVHParams &params,
       const vector<Geometry *> &geometry,
       const vector<Object *> &objects);
 
+  /* Size of the top level part of the packed arrays, merged instance BVHs follow it. */
+  size_t top_level_prim_size;
+  size_t top_level_nodes_size;
+  size_t top_level_leaf_nodes_size;
+
   /* Refit range of primitives. */
   void refit_primitives(int start, int end, BoundBox &bbox, uint &visibility);
 
@@ -119,6 +129,10 @@ class BVH {
   /* for subclasses to implement */
   virtual void pack_nodes(const BVHNode *root) = 0;
   virtual void refit_nodes() = 0;
+  virtual bool rebuild_degraded_nodes()
+  {
+    return false;
+  }
 
   virtual BVHNode *widen_children_nodes(const BVHNode *root) = 0;
 };
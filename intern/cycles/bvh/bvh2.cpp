@@ -23,6 +23,9 @@
 #include "bvh/bvh_node.h"
 #include "bvh/bvh_unaligned.h"
 
+#include "util/util_algorithm.h"
+#include "util/util_logging.h"
+
 CCL_NAMESPACE_BEGIN
 
 BVH2::BVH2(const BVHParams &params_,
@@ -182,6 +185,12 @@ void BVH2::pack_nodes(const BVHNode *root)
   pack.leaf_nodes.clear();
   /* For top level BVH, first merge existing BVH's so we know the offsets. */
   if (params.top_level) {
+    top_level_prim_size = pack.prim_index.size();
+    top_level_nodes_size = node_size;
+    top_level_leaf_nodes_size = num_leaf_nodes * BVH_NODE_LEAF_SIZE;
+    build_area.clear();
+    build_area.resize(node_size, 0.0f);
+
     pack_instances(node_size, num_leaf_nodes * BVH_NODE_LEAF_SIZE);
   }
   else {
@@ -228,6 +237,10 @@ void BVH2::pack_nodes(const BVHNode *root)
       stack.push_back(BVHStackEntry(e.node->get_child(1), idx[1]));
 
       pack_inner(e, stack[stack.size() - 2], stack[stack.size() - 1]);
+
+      if (params.top_level) {
+        build_area[e.idx] = e.node->bounds.safe_area();
+      }
     }
   }
   assert(node_size == nextNodeIdx);
@@ -237,8 +250,6 @@ void BVH2::pack_nodes(const BVHNode *root)
 
 void BVH2::refit_nodes()
 {
-  assert(!params.top_level);
-
   BoundBox bbox = BoundBox::empty;
   uint visibility = 0;
   refit_node(0, (pack.root_index == -1) ? true : false, bbox, visibility);
@@ -253,7 +264,13 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
     const int c0 = data[0].x;
     const int c1 = data[0].y;
 
-    BVH::refit_primitives(c0, c1, bbox, visibility);
+    if (c0 < 0) {
+      /* Object instance leaf in the top level BVH. */
+      BVH::refit_primitives(~c0, ~c0 + 1, bbox, visibility);
+    }
+    else {
+      BVH::refit_primitives(c0, c1, bbox, visibility);
+    }
 
     /* TODO(sergey): De-duplicate with pack_leaf(). */
     float4 leaf_data[BVH_NODE_LEAF_SIZE];
@@ -292,4 +309,199 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility)
   }
 }
 
+/* Partial rebuild of refit top level BVH */
+
+BoundBox BVH2::packed_node_bounds(int idx) const
+{
+  const int4 *data = &pack.nodes[idx];
+  BoundBox bounds = BoundBox::empty;
+  bounds.grow(make_float3(__int_as_float(data[1].x),
+                          __int_as_float(data[2].x),
+                          __int_as_float(data[3].x)));
+  bounds.grow(make_float3(__int_as_float(data[1].z),
+                          __int_as_float(data[2].z),
+                          __int_as_float(data[3].z)));
+  bounds.grow(make_float3(__int_as_float(data[1].y),
+                          __int_as_float(data[2].y),
+                          __int_as_float(data[3].y)));
+  bounds.grow(make_float3(__int_as_float(data[1].w),
+                          __int_as_float(data[2].w),
+                          __int_as_float(data[3].w)));
+  return bounds;
+}
+
+bool BVH2::rebuild_degraded_nodes()
+{
+  if (pack.root_index == -1) {
+    return true;
+  }
+
+  const size_t num_leaves = top_level_leaf_nodes_size / BVH_NODE_LEAF_SIZE;
+  size_t num_rebuilt_leaves = 0;
+  size_t num_rebuilt_subtrees = 0;
+
+  vector<int> stack;
+  stack.push_back(0);
+
+  while (stack.size()) {
+    const int idx = stack.back();
+    stack.pop_back();
+
+    const int4 *data = &pack.nodes[idx];
+    if (data[0].x & PATH_RAY_NODE_UNALIGNED) {
+      /* Refit unaligned nodes don't have meaningful bounds to compare against,
+       * and are not restructured either. */
+      return false;
+    }
+
+    const float area = packed_node_bounds(idx).safe_area();
+    if (area > build_area[idx] * BVH_REFIT_MAX_AREA_GROWTH) {
+      if (idx == 0) {
+        return false;
+      }
+
+      vector<BVHRefitLeaf> leaves;
+      vector<int> slots;
+      if (!gather_subtree(idx, leaves, slots)) {
+        return false;
+      }
+
+      num_rebuilt_leaves += leaves.size();
+      if (num_rebuilt_leaves > num_leaves * BVH_REFIT_MAX_REBUILD_FRACTION) {
+        return false;
+      }
+
+      BoundBox bounds;
+      uint visibility;
+      int next_slot = 0;
+      build_subtree(leaves, 0, leaves.size(), slots, next_slot, bounds, visibility);
+      assert(next_slot == slots.size());
+      num_rebuilt_subtrees++;
+      continue;
+    }
+
+    if (data[0].z >= 0) {
+      stack.push_back(data[0].z);
+    }
+    if (data[0].w >= 0) {
+      stack.push_back(data[0].w);
+    }
+  }
+
+  VLOG(1) << "Refit top level BVH, rebuilt " << num_rebuilt_subtrees << " subtrees with "
+          << num_rebuilt_leaves << " of " << num_leaves << " leaves.";
+
+  return true;
+}
+
+bool BVH2::gather_subtree(int idx, vector<BVHRefitLeaf> &leaves, vector<int> &slots)
+{
+  vector<int> stack;
+  stack.push_back(idx);
+
+  while (stack.size()) {
+    const int node_idx = stack.back();
+    stack.pop_back();
+
+    const int4 *data = &pack.nodes[node_idx];
+    if (data[0].x & PATH_RAY_NODE_UNALIGNED) {
+      return false;
+    }
+
+    /* Inner node slots are reused in the order they are gathered,
+     * so the subtree root stays where its parent points to. */
+    slots.push_back(node_idx);
+
+    for (int i = 0; i < 2; i++) {
+      const int child = (i == 0) ? data[0].z : data[0].w;
+
+      if (child < 0) {
+        BVHRefitLeaf leaf;
+        leaf.child = child;
+        leaf.visibility = (i == 0) ? data[0].x : data[0].y;
+        leaf.bounds = BoundBox(make_float3(__int_as_float(data[1][i]),
+                                           __int_as_float(data[2][i]),
+                                           __int_as_float(data[3][i])),
+                               make_float3(__int_as_float(data[1][i + 2]),
+                                           __int_as_float(data[2][i + 2]),
+                                           __int_as_float(data[3][i + 2])));
+        leaves.push_back(leaf);
+      }
+      else {
+        stack.push_back(child);
+      }
+    }
+  }
+
+  /* A binary tree with N leaves always has N - 1 inner nodes. */
+  assert(slots.size() + 1 == leaves.size());
+  return true;
+}
+
+int BVH2::build_subtree(vector<BVHRefitLeaf> &leaves,
+                        int start,
+                        int end,
+                        const vector<int> &slots,
+                        int &next_slot,
+                        BoundBox &bounds,
+                        uint &visibility)
+{
+  if (end - start == 1) {
+    bounds = leaves[start].bounds;
+    visibility = leaves[start].visibility;
+    return leaves[start].child;
+  }
+
+  const int idx = slots[next_slot++];
+
+  /* Sort along the largest axis of the leaf centroids. */
+  BoundBox centroid_bounds = BoundBox::empty;
+  for (int i = start; i < end; i++) {
+    centroid_bounds.grow(leaves[i].bounds.center());
+  }
+  const float3 extent = centroid_bounds.size();
+  const int axis = (extent.x > extent.y) ? ((extent.x > extent.z) ? 0 : 2) :
+                                           ((extent.y > extent.z) ? 1 : 2);
+
+  sort(leaves.begin() + start,
+       leaves.begin() + end,
+       [axis](const BVHRefitLeaf &a, const BVHRefitLeaf &b) {
+         return a.bounds.center()[axis] < b.bounds.center()[axis];
+       });
+
+  /* Pick the split with the lowest surface area heuristic cost. */
+  const int num = end - start;
+  vector<float> right_area(num);
+  BoundBox right_bounds = BoundBox::empty;
+  for (int i = num - 1; i > 0; i--) {
+    right_bounds.grow(leaves[start + i].bounds);
+    right_area[i] = right_bounds.safe_area();
+  }
+
+  BoundBox left_bounds = BoundBox::empty;
+  float min_cost = FLT_MAX;
+  int mid = start + num / 2;
+  for (int i = 1; i < num; i++) {
+    left_bounds.grow(leaves[start + i - 1].bounds);
+    const float cost = left_bounds.safe_area() * i + right_area[i] * (num - i);
+    if (cost < min_cost) {
+      min_cost = cost;
+      mid = start + i;
+    }
+  }
+
+  BoundBox bounds0, bounds1;
+  uint visibility0, visibility1;
+  const int c0 = build_subtree(leaves, start, mid, slots, next_slot, bounds0, visibility0);
+  const int c1 = build_subtree(leaves, mid, end, slots, next_slot, bounds1, visibility1);
+
+  pack_aligned_node(idx, bounds0, bounds1, c0, c1, visibility0, visibility1);
+
+  bounds = merge(bounds0, bounds1);
+  visibility = visibility0 | visibility1;
+  build_area[idx] = bounds.safe_area();
+
+  return idx;
+}
+
 CCL_NAMESPACE_END
@@ -21,6 +21,7 @@
 #include "bvh/bvh.h"
 #include "bvh/bvh_params.h"
 
+#include "util/util_boundbox.h"
 #include "util/util_types.h"
 #include "util/util_vector.h"
 
@@ -38,6 +39,20 @@ class Progress;
 #define BVH_NODE_LEAF_SIZE 1
 #define BVH_UNALIGNED_NODE_SIZE 7
 
+/* Inner nodes of a refit top level BVH whose surface area grew by more than this factor
+ * since they were built get their subtree rebuilt. */
+#define BVH_REFIT_MAX_AREA_GROWTH 2.0f
+/* When subtrees with more than this fraction of all leaves need to be rebuilt,
+ * a full build gives better quality for a similar cost. */
+#define BVH_REFIT_MAX_REBUILD_FRACTION 0.5f
+
+/* Leaf referenced from a subtree which is rebuilt after refitting. */
+struct BVHRefitLeaf {
+  BoundBox bounds;
+  int child;
+  uint visibility;
+};
+
 /* BVH2
  *
  * Typical BVH with each node having two children.
@@ -86,6 +101,21 @@ class BVH2 : public BVH {
   /* refit */
   void refit_nodes() override;
   void refit_node(int idx, bool leaf, BoundBox &bbox, uint &visibility);
+
+  /* Partial rebuild of degraded subtrees after refitting the top level BVH. */
+  bool rebuild_degraded_nodes() override;
+  BoundBox packed_node_bounds(int idx) const;
+  bool gather_subtree(int idx, vector<BVHRefitLeaf> &leaves, vector<int> &slots);
+  int build_subtree(vector<BVHRefitLeaf> &leaves,
+                    int start,
+                    int end,
+                    const vector<int> &slots,
+                    int &next_slot,
+                    BoundBox &bounds,
+                    uint &visibility);
+
+  /* Surface area of top level inner nodes when they were built, indexed like pack.nodes. */
+  vector<float> build_area;
 };
 
 CCL_NAMESPACE_END
@@ -531,7 +531,11 @@ bool BVHBuild::range_within_max_leaf_size(const BVHRange &range,
                                           const vector<BVHReference> &references) const
 {
   size_t size = range.size();
-  size_t max_leaf_size = max(params.max_triangle_leaf_size, params.max_curve_leaf_size);
+  /* With oriented leaf bounds, several segments of a strand fit tightly in one leaf. */
+  const int max_curve_leaf_size = (params.use_unaligned_nodes) ?
+                                      params.max_curve_segment_group_size :
+                                      params.max_curve_leaf_size;
+  size_t max_leaf_size = max(params.max_triangle_leaf_size, max_curve_leaf_size);
 
   if (size > max_leaf_size)
     return false;
@@ -564,7 +568,7 @@ bool BVHBuild::range_within_max_leaf_size(const BVHRange &range,
 
   return (num_triangles <= params.max_triangle_leaf_size) &&
          (num_motion_triangles <= params.max_motion_triangle_leaf_size) &&
-         (num_curves <= params.max_curve_leaf_size) &&
+         (num_curves <= max_curve_leaf_size) &&
          (num_motion_curves <= params.max_motion_curve_leaf_size);
 }
 
@@ -893,8 +897,6 @@ BVHNode *BVHBuild::create_leaf_node(const BVHRange &range, const vector<BVHRefer
     if (num != 0) {
       assert(p_type[i].size() == p_index[i].size());
       assert(p_type[i].size() == p_object[i].size());
-      Transform aligned_space;
-      bool alignment_found = false;
       for (int j = 0; j < num; ++j) {
         const int index = start_index + j;
         local_prim_type[index] = p_type[i][j];
@@ -903,9 +905,13 @@ BVHNode *BVHBuild::create_leaf_node(const BVHRange &range, const vector<BVHRefer
         if (need_prim_time) {
           local_prim_time[index] = p_time[i][j];
         }
-        if (params.use_unaligned_nodes && !alignment_found) {
-          alignment_found = unaligned_heuristic.compute_aligned_space(p_ref[i][j], &aligned_space);
-        }
+      }
+      /* Oriented bounds fitted to the whole group of curve segments in the leaf. */
+      Transform aligned_space;
+      bool alignment_found = false;
+      if (params.use_unaligned_nodes) {
+        alignment_found = unaligned_heuristic.compute_aligned_space(
+            &p_ref[i][0], num, &aligned_space);
       }
       LeafNode *leaf_node = new LeafNode(bounds[i], visibility[i], start_index, start_index + num);
       if (true) {
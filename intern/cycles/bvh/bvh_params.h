@@ -62,6 +62,8 @@ class BVHParams {
   int max_motion_triangle_leaf_size;
   int max_curve_leaf_size;
   int max_motion_curve_leaf_size;
+  /* Curve segments grouped in a leaf when leaves have oriented bounds. */
+  int max_curve_segment_group_size;
 
   /* object or mesh level bvh */
   bool top_level;
@@ -111,6 +113,7 @@ class BVHParams {
     max_motion_triangle_leaf_size = 8;
     max_curve_leaf_size = 1;
     max_motion_curve_leaf_size = 4;
+    max_curve_segment_group_size = 4;
 
     top_level = false;
     bvh_layout = BVH_LAYOUT_BVH2;
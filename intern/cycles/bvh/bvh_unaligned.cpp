@@ -63,7 +63,7 @@ Transform BVHUnaligned::compute_aligned_space(const BVHRange &range,
   return transform_identity();
 }
 
-bool BVHUnaligned::compute_aligned_space(const BVHReference &ref, Transform *aligned_space) const
+bool BVHUnaligned::compute_curve_axis(const BVHReference &ref, float3 *axis) const
 {
   const Object *object = objects_[ref.prim_object()];
   const int packed_type = ref.prim_type();
@@ -77,16 +77,54 @@ bool BVHUnaligned::compute_aligned_space(const BVHReference &ref, Transform *ali
     const int key = curve.first_key + segment;
     const float3 v1 = hair->curve_keys[key], v2 = hair->curve_keys[key + 1];
     float length;
-    const float3 axis = normalize_len(v2 - v1, &length);
-    if (length > 1e-6f) {
-      *aligned_space = make_transform_frame(axis);
-      return true;
-    }
+    *axis = normalize_len(v2 - v1, &length);
+    return (length > 1e-6f);
+  }
+  return false;
+}
+
+bool BVHUnaligned::compute_aligned_space(const BVHReference &ref, Transform *aligned_space) const
+{
+  float3 axis;
+  if (compute_curve_axis(ref, &axis)) {
+    *aligned_space = make_transform_frame(axis);
+    return true;
   }
   *aligned_space = transform_identity();
   return false;
 }
 
+bool BVHUnaligned::compute_aligned_space(const BVHReference *references,
+                                         const int num_references,
+                                         Transform *aligned_space) const
+{
+  /* Sum segment directions flipped into the hemisphere of the first segment, so that
+   * consecutive segments of a strand and neighboring strands don't cancel out. The sum
+   * has at least unit length along the first direction, so normalizing is safe. */
+  float3 first_axis = make_float3(0.0f, 0.0f, 0.0f);
+  float3 axis_sum = make_float3(0.0f, 0.0f, 0.0f);
+  bool found = false;
+  for (int i = 0; i < num_references; ++i) {
+    float3 axis;
+    if (!compute_curve_axis(references[i], &axis)) {
+      continue;
+    }
+    if (!found) {
+      first_axis = axis;
+      found = true;
+    }
+    axis_sum += (dot(axis, first_axis) < 0.0f) ? -axis : axis;
+  }
+
+  if (!found) {
+    *aligned_space = transform_identity();
+    return false;
+  }
+
+  *aligned_space = make_transform_frame(normalize(axis_sum));
+  return true;
+}
+
 BoundBox BVHUnaligned::compute_aligned_prim_boundbox(const BVHReference &prim,
                                                      const Transform &aligned_space) const
 {
@@ -44,6 +44,15 @@ class BVHUnaligned {
    */
   bool compute_aligned_space(const BVHReference &ref, Transform *aligned_space) const;
 
+  /* Calculate alignment for the oriented bounds of a group of curve segments in a leaf,
+   * following their average direction.
+   *
+   * Return true when space was calculated successfully.
+   */
+  bool compute_aligned_space(const BVHReference *references,
+                             const int num_references,
+                             Transform *aligned_space) const;
+
   /* Calculate primitive's bounding box in given space. */
   BoundBox compute_aligned_prim_boundbox(const BVHReference &prim,
                                          const Transform &aligned_space) const;
@@ -64,6 +73,9 @@ class BVHUnaligned {
   static Transform compute_node_transform(const BoundBox &bounds, const Transform &aligned_space);
 
  protected:
+  /* Direction of a curve segment reference, false for other primitives. */
+  bool compute_curve_axis(const BVHReference &ref, float3 *axis) const;
+
   /* List of objects BVH is being created for. */
   const vector<Object *> &objects_;
 };
@@ -189,6 +189,8 @@ class CPUDevice : public Device {
   DeviceRequestedFeatures requested_features;
 
   KernelFunctions<void (*)(KernelGlobals *, float *, int, int, int, int, int)> path_trace_kernel;
+  KernelFunctions<void (*)(KernelGlobals *, float *, int, int, int, int, int, int)>
+      path_trace_packet_kernel;
   KernelFunctions<void (*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)>
       convert_to_half_float_kernel;
   KernelFunctions<void (*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)>
@@ -275,6 +277,7 @@ class CPUDevice : public Device {
         texture_info(this, "__texture_info", MEM_GLOBAL),
 #define REGISTER_KERNEL(name) name##_kernel(KERNEL_FUNCTIONS(name))
         REGISTER_KERNEL(path_trace),
+        REGISTER_KERNEL(path_trace_packet),
         REGISTER_KERNEL(convert_to_half_float),
         REGISTER_KERNEL(convert_to_byte),
         REGISTER_KERNEL(shader),
@@ -911,11 +914,20 @@ class CPUDevice : public Device {
 
       if (tile.task == RenderTile::PATH_TRACE) {
         for (int y = tile.y; y < tile.y + tile.h; y++) {
-          for (int x = tile.x; x < tile.x + tile.w; x++) {
-            if (use_coverage) {
+          if (use_coverage) {
+            for (int x = tile.x; x < tile.x + tile.w; x++) {
               coverage.init_pixel(x, y);
+              path_trace_kernel()(kg, render_buffer, sample, x, y, tile.offset, tile.stride);
+            }
+          }
+          else {
+            /* Neighboring pixels are traced together so their camera rays
+             * can share BVH traversal. */
+            for (int x = tile.x; x < tile.x + tile.w; x += BVH_PACKET_SIZE) {
+              const int num_pixels = min(BVH_PACKET_SIZE, tile.x + tile.w - x);
+              path_trace_packet_kernel()(
+                  kg, render_buffer, sample, x, y, num_pixels, tile.offset, tile.stride);
             }
-            path_trace_kernel()(kg, render_buffer, sample, x, y, tile.offset, tile.stride);
           }
         }
       }
@@ -1432,6 +1444,9 @@ class CPUDevice : public Device {
     }
     kg.decoupled_volume_steps_index = 0;
     kg.coverage_asset = kg.coverage_object = kg.coverage_material = NULL;
+#ifdef __BVH_PACKET__
+    kg.camera_packet_isect = NULL;
+#endif
 #ifdef WITH_OSL
     OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
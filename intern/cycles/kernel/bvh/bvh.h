@@ -236,6 +236,47 @@ ccl_device_intersect bool scene_intersect(KernelGlobals *kg,
 #endif   /* __KERNEL_OPTIX__ */
 }
 
+#ifdef __BVH_PACKET__
+#  include "kernel/bvh/bvh_packet.h"
+
+/* Intersect up to BVH_PACKET_SIZE coherent rays with the same visibility,
+ * returning a bit mask of the rays that hit. Scenes that the packet traversal
+ * does not support are traced one ray at a time. Embree already uses SIMD
+ * traversal for single rays, so it is not involved here. */
+ccl_device_intersect int scene_intersect_packet(KernelGlobals *kg,
+                                                const Ray *rays,
+                                                const int num_rays,
+                                                const uint visibility,
+                                                Intersection *isects)
+{
+  bool use_packet = (num_rays > 1);
+#  ifdef __EMBREE__
+  if (kernel_data.bvh.scene) {
+    use_packet = false;
+  }
+#  endif
+#  ifdef __OBJECT_MOTION__
+  if (kernel_data.bvh.have_motion) {
+    use_packet = false;
+  }
+#  endif
+
+  if (use_packet) {
+    PROFILING_INIT(kg, PROFILING_INTERSECT);
+    return bvh_intersect_packet(kg, rays, num_rays, isects, visibility);
+  }
+
+  int hit_mask = 0;
+  for (int i = 0; i < num_rays; i++) {
+    isects[i].prim = PRIM_NONE;
+    if (scene_intersect(kg, &rays[i], visibility, &isects[i])) {
+      hit_mask |= (1 << i);
+    }
+  }
+  return hit_mask;
+}
+#endif /* __BVH_PACKET__ */
+
 #ifdef __BVH_LOCAL__
 ccl_device_intersect bool scene_intersect_local(KernelGlobals *kg,
                                                 const Ray *ray,
@@ -0,0 +1,392 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Packet traversal of the BVH2 for coherent rays on the CPU.
+ *
+ * Up to BVH_PACKET_SIZE rays are traversed together, one ray per SSE lane.
+ * Each stack entry records which lanes still need to visit the node, so
+ * incoherent rays only cost extra node tests and not extra primitive tests.
+ * Node bounds are tested for all lanes at once, primitives and hair nodes
+ * are intersected per lane with the regular single ray functions so the
+ * results match bvh_intersect(). Only the distance of a hit may differ in the
+ * last bits: it is scaled into and out of object space for every instance the
+ * ray enters after the hit, and nodes are visited in a different order.
+ *
+ * Motion blur is not supported, scene_intersect_packet() falls back to single
+ * ray traversal for such scenes. */
+
+/* Gather per lane ray origins and inverse directions into SSE registers. */
+ccl_device_forceinline void bvh_packet_load_rays(const float3 P[BVH_PACKET_SIZE],
+                                                 const float3 idir[BVH_PACKET_SIZE],
+                                                 ssef *Px,
+                                                 ssef *Py,
+                                                 ssef *Pz,
+                                                 ssef *idirx,
+                                                 ssef *idiry,
+                                                 ssef *idirz)
+{
+  *Px = ssef(P[0].x, P[1].x, P[2].x, P[3].x);
+  *Py = ssef(P[0].y, P[1].y, P[2].y, P[3].y);
+  *Pz = ssef(P[0].z, P[1].z, P[2].z, P[3].z);
+  *idirx = ssef(idir[0].x, idir[1].x, idir[2].x, idir[3].x);
+  *idiry = ssef(idir[0].y, idir[1].y, idir[2].y, idir[3].y);
+  *idirz = ssef(idir[0].z, idir[1].z, idir[2].z, idir[3].z);
+}
+
+ccl_device_forceinline ssef bvh_packet_load_t(const Intersection isect[BVH_PACKET_SIZE])
+{
+  return ssef(isect[0].t, isect[1].t, isect[2].t, isect[3].t);
+}
+
+/* Pop the next node that still has lanes to traverse, skipping nodes whose
+ * lanes all terminated since they were pushed. Instance sentinels are always
+ * returned so the instance can be popped. */
+ccl_device_forceinline int bvh_packet_pop(const int *traversal_stack,
+                                          const int *traversal_mask,
+                                          int *stack_ptr,
+                                          const int active_mask,
+                                          int *node_mask)
+{
+  int node_addr;
+  do {
+    node_addr = traversal_stack[*stack_ptr];
+    *node_mask = traversal_mask[*stack_ptr] & active_mask;
+    --(*stack_ptr);
+  } while (*node_mask == 0 && node_addr != ENTRYPOINT_SENTINEL);
+  return node_addr;
+}
+
+/* Intersect both children of an aligned node for all lanes, returning the
+ * lanes that hit each child and the entry distance per lane. */
+ccl_device_forceinline void bvh_packet_aligned_node_intersect(KernelGlobals *kg,
+                                                              const ssef &Px,
+                                                              const ssef &Py,
+                                                              const ssef &Pz,
+                                                              const ssef &idirx,
+                                                              const ssef &idiry,
+                                                              const ssef &idirz,
+                                                              const ssef &tmax,
+                                                              const int node_addr,
+                                                              int *mask0,
+                                                              int *mask1,
+                                                              ssef *dist0,
+                                                              ssef *dist1)
+{
+  const float4 node0 = kernel_tex_fetch(__bvh_nodes, node_addr + 1);
+  const float4 node1 = kernel_tex_fetch(__bvh_nodes, node_addr + 2);
+  const float4 node2 = kernel_tex_fetch(__bvh_nodes, node_addr + 3);
+  const ssef zero = ssef(0.0f);
+
+  const ssef c0lox = (ssef(node0.x) - Px) * idirx;
+  const ssef c0hix = (ssef(node0.z) - Px) * idirx;
+  const ssef c0loy = (ssef(node1.x) - Py) * idiry;
+  const ssef c0hiy = (ssef(node1.z) - Py) * idiry;
+  const ssef c0loz = (ssef(node2.x) - Pz) * idirz;
+  const ssef c0hiz = (ssef(node2.z) - Pz) * idirz;
+  const ssef c0min = max(max(zero, min(c0lox, c0hix)), max(min(c0loy, c0hiy), min(c0loz, c0hiz)));
+  const ssef c0max = min(min(tmax, max(c0lox, c0hix)), min(max(c0loy, c0hiy), max(c0loz, c0hiz)));
+
+  const ssef c1lox = (ssef(node0.y) - Px) * idirx;
+  const ssef c1hix = (ssef(node0.w) - Px) * idirx;
+  const ssef c1loy = (ssef(node1.y) - Py) * idiry;
+  const ssef c1hiy = (ssef(node1.w) - Py) * idiry;
+  const ssef c1loz = (ssef(node2.y) - Pz) * idirz;
+  const ssef c1hiz = (ssef(node2.w) - Pz) * idirz;
+  const ssef c1min = max(max(zero, min(c1lox, c1hix)), max(min(c1loy, c1hiy), min(c1loz, c1hiz)));
+  const ssef c1max = min(min(tmax, max(c1lox, c1hix)), min(max(c1loy, c1hiy), max(c1loz, c1hiz)));
+
+  *mask0 = (int)movemask(c0max >= c0min);
+  *mask1 = (int)movemask(c1max >= c1min);
+  *dist0 = c0min;
+  *dist1 = c1min;
+}
+
+/* Returns a bit mask of the rays that hit something. Intersections of rays
+ * that missed have prim set to PRIM_NONE. For shadow rays with
+ * PATH_RAY_SHADOW_OPAQUE, lanes stop at their first hit and the returned
+ * intersection is not necessarily the closest one. */
+ccl_device_noinline int bvh_intersect_packet(KernelGlobals *kg,
+                                             const Ray *rays,
+                                             const int num_rays,
+                                             Intersection *isects,
+                                             const uint visibility)
+{
+  kernel_assert(num_rays > 0 && num_rays <= BVH_PACKET_SIZE);
+
+  /* Traversal stack, with the lanes that still have to visit each node. */
+  int traversal_stack[BVH_STACK_SIZE];
+  int traversal_mask[BVH_STACK_SIZE];
+  traversal_stack[0] = ENTRYPOINT_SENTINEL;
+  traversal_mask[0] = 0;
+
+  int stack_ptr = 0;
+  int node_addr = kernel_data.bvh.root;
+
+  /* Per lane ray parameters, scalar for primitive tests and packed for node tests.
+   * Unused lanes keep a zero length ray and never become active. */
+  float3 P[BVH_PACKET_SIZE];
+  float3 dir[BVH_PACKET_SIZE];
+  float3 idir[BVH_PACKET_SIZE];
+  Intersection isect[BVH_PACKET_SIZE];
+  int active_mask = 0;
+
+  for (int lane = 0; lane < BVH_PACKET_SIZE; lane++) {
+    const bool valid = (lane < num_rays) && scene_intersect_valid(&rays[lane]);
+    P[lane] = valid ? rays[lane].P : make_float3(0.0f, 0.0f, 0.0f);
+    dir[lane] = bvh_clamp_direction(valid ? rays[lane].D : make_float3(0.0f, 0.0f, 1.0f));
+    idir[lane] = bvh_inverse_direction(dir[lane]);
+
+    isect[lane].t = valid ? rays[lane].t : 0.0f;
+    isect[lane].u = 0.0f;
+    isect[lane].v = 0.0f;
+    isect[lane].prim = PRIM_NONE;
+    isect[lane].object = OBJECT_NONE;
+    isect[lane].type = PRIMITIVE_NONE;
+#ifdef __KERNEL_DEBUG__
+    isect[lane].num_traversed_nodes = 0;
+    isect[lane].num_traversed_instances = 0;
+    isect[lane].num_intersections = 0;
+#endif
+
+    if (valid) {
+      active_mask |= (1 << lane);
+    }
+  }
+
+  ssef Px, Py, Pz, idirx, idiry, idirz;
+  bvh_packet_load_rays(P, idir, &Px, &Py, &Pz, &idirx, &idiry, &idirz);
+  ssef tmax = bvh_packet_load_t(isect);
+
+  int node_mask = active_mask;
+  int object = OBJECT_NONE;
+  int instance_mask = 0;
+
+  if (active_mask == 0) {
+    node_addr = ENTRYPOINT_SENTINEL;
+    stack_ptr = -1;
+  }
+
+  /* traversal loop */
+  do {
+    do {
+      /* traverse internal nodes */
+      while (node_addr >= 0 && node_addr != ENTRYPOINT_SENTINEL) {
+        const float4 cnodes = kernel_tex_fetch(__bvh_nodes, node_addr + 0);
+        int mask0, mask1;
+        ssef dist0, dist1;
+
+#ifdef __HAIR__
+        if (__float_as_uint(cnodes.x) & PATH_RAY_NODE_UNALIGNED) {
+          /* Oriented hair nodes are rare, test them one lane at a time. */
+          float lane_dist0[BVH_PACKET_SIZE] = {0.0f, 0.0f, 0.0f, 0.0f};
+          float lane_dist1[BVH_PACKET_SIZE] = {0.0f, 0.0f, 0.0f, 0.0f};
+          mask0 = mask1 = 0;
+          for (int lanes = node_mask; lanes;) {
+            const int lane = __bscf(lanes);
+            float dist[2];
+            const int traverse_mask = bvh_unaligned_node_intersect(
+                kg, P[lane], dir[lane], idir[lane], isect[lane].t, node_addr, visibility, dist);
+            mask0 |= (traverse_mask & 1) << lane;
+            mask1 |= ((traverse_mask >> 1) & 1) << lane;
+            lane_dist0[lane] = dist[0];
+            lane_dist1[lane] = dist[1];
+          }
+          dist0 = ssef(lane_dist0[0], lane_dist0[1], lane_dist0[2], lane_dist0[3]);
+          dist1 = ssef(lane_dist1[0], lane_dist1[1], lane_dist1[2], lane_dist1[3]);
+        }
+        else
+#endif
+        {
+          bvh_packet_aligned_node_intersect(kg,
+                                            Px,
+                                            Py,
+                                            Pz,
+                                            idirx,
+                                            idiry,
+                                            idirz,
+                                            tmax,
+                                            node_addr,
+                                            &mask0,
+                                            &mask1,
+                                            &dist0,
+                                            &dist1);
+#ifdef __VISIBILITY_FLAG__
+          if (!(__float_as_uint(cnodes.x) & visibility)) {
+            mask0 = 0;
+          }
+          if (!(__float_as_uint(cnodes.y) & visibility)) {
+            mask1 = 0;
+          }
+#endif
+        }
+
+        mask0 &= node_mask;
+        mask1 &= node_mask;
+
+        node_addr = __float_as_int(cnodes.z);
+        int node_addr_child1 = __float_as_int(cnodes.w);
+
+        if (mask0 && mask1) {
+          /* Both children were intersected, visit the one closest to any of
+           * its lanes first and push the other. */
+          const float d0 = reduce_min(select(sseb(mask0), dist0, ssef(FLT_MAX)));
+          const float d1 = reduce_min(select(sseb(mask1), dist1, ssef(FLT_MAX)));
+          if (d1 < d0) {
+            int tmp = node_addr;
+            node_addr = node_addr_child1;
+            node_addr_child1 = tmp;
+            tmp = mask0;
+            mask0 = mask1;
+            mask1 = tmp;
+          }
+
+          ++stack_ptr;
+          kernel_assert(stack_ptr < BVH_STACK_SIZE);
+          traversal_stack[stack_ptr] = node_addr_child1;
+          traversal_mask[stack_ptr] = mask1;
+          node_mask = mask0;
+        }
+        else if (mask0) {
+          node_mask = mask0;
+        }
+        else if (mask1) {
+          node_addr = node_addr_child1;
+          node_mask = mask1;
+        }
+        else {
+          /* Neither child was intersected. */
+          node_addr = bvh_packet_pop(
+              traversal_stack, traversal_mask, &stack_ptr, active_mask, &node_mask);
+        }
+      }
+
+      /* if node is leaf, fetch triangle list */
+      if (node_addr < 0) {
+        const float4 leaf = kernel_tex_fetch(__bvh_leaf_nodes, (-node_addr - 1));
+        int prim_addr = __float_as_int(leaf.x);
+
+        if (prim_addr >= 0) {
+          const int prim_addr2 = __float_as_int(leaf.y);
+          const uint type = __float_as_int(leaf.w);
+          int leaf_mask = node_mask;
+
+          /* primitive intersection */
+          for (; prim_addr < prim_addr2 && leaf_mask; prim_addr++) {
+            kernel_assert(kernel_tex_fetch(__prim_type, prim_addr) == type);
+            for (int lanes = leaf_mask; lanes;) {
+              const int lane = __bscf(lanes);
+              bool hit = false;
+
+              switch (type & PRIMITIVE_ALL) {
+                case PRIMITIVE_TRIANGLE: {
+                  hit = triangle_intersect(
+                      kg, &isect[lane], P[lane], dir[lane], visibility, object, prim_addr);
+                  break;
+                }
+#ifdef __HAIR__
+                case PRIMITIVE_CURVE_THICK:
+                case PRIMITIVE_CURVE_RIBBON: {
+                  const uint curve_type = kernel_tex_fetch(__prim_type, prim_addr);
+                  hit = curve_intersect(kg,
+                                        &isect[lane],
+                                        P[lane],
+                                        dir[lane],
+                                        visibility,
+                                        object,
+                                        prim_addr,
+                                        rays[lane].time,
+                                        curve_type);
+                  break;
+                }
+#endif
+              }
+
+              /* shadow ray early termination */
+              if (hit && (visibility & PATH_RAY_SHADOW_OPAQUE)) {
+                leaf_mask &= ~(1 << lane);
+                active_mask &= ~(1 << lane);
+              }
+            }
+          }
+
+          if (active_mask == 0) {
+            break;
+          }
+
+          tmax = bvh_packet_load_t(isect);
+
+          /* pop */
+          node_addr = bvh_packet_pop(
+              traversal_stack, traversal_mask, &stack_ptr, active_mask, &node_mask);
+        }
+        else {
+          /* instance push */
+          object = kernel_tex_fetch(__prim_object, -prim_addr - 1);
+          instance_mask = node_mask;
+
+          for (int lanes = instance_mask; lanes;) {
+            const int lane = __bscf(lanes);
+            isect[lane].t = bvh_instance_push(
+                kg, object, &rays[lane], &P[lane], &dir[lane], &idir[lane], isect[lane].t);
+          }
+
+          bvh_packet_load_rays(P, idir, &Px, &Py, &Pz, &idirx, &idiry, &idirz);
+          tmax = bvh_packet_load_t(isect);
+
+          ++stack_ptr;
+          kernel_assert(stack_ptr < BVH_STACK_SIZE);
+          traversal_stack[stack_ptr] = ENTRYPOINT_SENTINEL;
+          traversal_mask[stack_ptr] = instance_mask;
+
+          node_addr = kernel_tex_fetch(__object_node, object);
+        }
+      }
+    } while (node_addr != ENTRYPOINT_SENTINEL);
+
+    if (active_mask == 0) {
+      break;
+    }
+
+    if (stack_ptr >= 0) {
+      kernel_assert(object != OBJECT_NONE);
+
+      /* instance pop */
+      for (int lanes = instance_mask & active_mask; lanes;) {
+        const int lane = __bscf(lanes);
+        isect[lane].t = bvh_instance_pop(
+            kg, object, &rays[lane], &P[lane], &dir[lane], &idir[lane], isect[lane].t);
+      }
+
+      bvh_packet_load_rays(P, idir, &Px, &Py, &Pz, &idirx, &idiry, &idirz);
+      tmax = bvh_packet_load_t(isect);
+
+      object = OBJECT_NONE;
+      instance_mask = 0;
+      node_addr = bvh_packet_pop(
+          traversal_stack, traversal_mask, &stack_ptr, active_mask, &node_mask);
+    }
+  } while (node_addr != ENTRYPOINT_SENTINEL);
+
+  int hit_mask = 0;
+  for (int lane = 0; lane < num_rays; lane++) {
+    isects[lane] = isect[lane];
+    if (isect[lane].prim != PRIM_NONE) {
+      hit_mask |= (1 << lane);
+    }
+  }
+
+  return hit_mask;
+}
@@ -88,6 +88,20 @@ ccl_device_inline AttributeDescriptor find_attribute(KernelGlobals *kg,
   return desc;
 }
 
+/* Compressed float2 attributes, two 16 bit unsigned normalized values packed into one uint. */
+
+ccl_device_inline float2 attribute_fetch_float2(KernelGlobals *kg,
+                                                const AttributeDescriptor desc,
+                                                int index)
+{
+  if (desc.flags & ATTR_COMPRESSED) {
+    const uint packed = kernel_tex_fetch(__attributes_unorm2, index);
+    return make_float2((float)(packed & 0xffff) * (1.0f / 65535.0f),
+                       (float)(packed >> 16) * (1.0f / 65535.0f));
+  }
+  return kernel_tex_fetch(__attributes_float2, index);
+}
+
 /* Transform matrix attribute on meshes */
 
 ccl_device Transform primitive_attribute_matrix(KernelGlobals *kg,
@@ -538,6 +538,70 @@ ccl_device_inline float4 ribbon_to_ray_space(const float3 ray_space[3],
   return make_float4(dot(ray_space[0], P), dot(ray_space[1], P), dot(ray_space[2], P), P4.w);
 }
 
+/* Intersect the ribbon quad of the curve segment between u and u + step_size. */
+ccl_device_inline bool ribbon_intersect_segment(const float4 curve[4],
+                                                const float u,
+                                                const float step_size,
+                                                const float eps,
+                                                Intersection *isect)
+{
+  /* Evaluate points and radius scaled normal directions. */
+  const float4 p0 = catmull_rom_basis_eval(curve, u);
+  const float4 p1 = catmull_rom_basis_eval(curve, u + step_size);
+
+  float3 dp0dt = float4_to_float3(catmull_rom_basis_derivative(curve, u));
+  float3 dp1dt = float4_to_float3(catmull_rom_basis_derivative(curve, u + step_size));
+  dp0dt = (max3(fabs(dp0dt)) < eps) ? float4_to_float3(p1 - p0) : dp0dt;
+  dp1dt = (max3(fabs(dp1dt)) < eps) ? float4_to_float3(p1 - p0) : dp1dt;
+  const float3 wn0 = normalize(make_float3(dp0dt.y, -dp0dt.x, 0.0f)) * p0.w;
+  const float3 wn1 = normalize(make_float3(dp1dt.y, -dp1dt.x, 0.0f)) * p1.w;
+
+  /* Construct quad coordinates. */
+  const float3 lp0 = float4_to_float3(p0) + wn0;
+  const float3 lp1 = float4_to_float3(p1) + wn1;
+  const float3 up0 = float4_to_float3(p0) - wn0;
+  const float3 up1 = float4_to_float3(p1) - wn1;
+
+  /* Intersect quad. */
+  float vu, vv, vt;
+  if (!ribbon_intersect_quad(isect->t, lp0, lp1, up1, up0, &vu, &vv, &vt)) {
+    return false;
+  }
+
+  /* ignore self intersections */
+  const float avoidance_factor = 2.0f;
+  if (avoidance_factor != 0.0f) {
+    float r = mix(p0.w, p1.w, vu);
+    if (!(vt > avoidance_factor * r)) {
+      return false;
+    }
+  }
+
+  /* Record intersection. */
+  isect->t = vt;
+  isect->u = u + vu * step_size;
+  isect->v = 2.0f * vv - 1.0f;
+  return true;
+}
+
+#  if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
+/* Catmull-rom curve evaluation of the x, y and radius components at four
+ * parameters at once. */
+ccl_device_inline void catmull_rom_basis_eval_sse(
+    const float4 curve[4], const ssef &u, ssef *x, ssef *y, ssef *w)
+{
+  const ssef t = u;
+  const ssef s = ssef(1.0f) - u;
+  const ssef n0 = -t * s * s;
+  const ssef n1 = ssef(2.0f) + t * t * (ssef(3.0f) * t - ssef(5.0f));
+  const ssef n2 = ssef(2.0f) + s * s * (ssef(3.0f) * s - ssef(5.0f));
+  const ssef n3 = -s * t * t;
+  *x = ssef(0.5f) * (n0 * curve[0].x + n1 * curve[1].x + n2 * curve[2].x + n3 * curve[3].x);
+  *y = ssef(0.5f) * (n0 * curve[0].y + n1 * curve[1].y + n2 * curve[2].y + n3 * curve[3].y);
+  *w = ssef(0.5f) * (n0 * curve[0].w + n1 * curve[1].w + n2 * curve[2].w + n3 * curve[3].w);
+}
+#  endif
+
 ccl_device_inline bool ribbon_intersect(const float3 ray_org,
                                         const float3 ray_dir,
                                         const float ray_tfar,
@@ -558,62 +622,50 @@ ccl_device_inline bool ribbon_intersect(const float3 ray_org,
   const float eps = 4.0f * FLT_EPSILON * max(max(mx.x, mx.y), max(mx.z, mx.w));
   const float step_size = 1.0f / (float)N;
 
-  /* Evaluate first point and radius scaled normal direction. */
-  float4 p0 = catmull_rom_basis_eval(curve, 0.0f);
-  float3 dp0dt = float4_to_float3(catmull_rom_basis_derivative(curve, 0.0f));
-  if (max3(fabs(dp0dt)) < eps) {
-    const float4 p1 = catmull_rom_basis_eval(curve, step_size);
-    dp0dt = float4_to_float3(p1 - p0);
+#  if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
+  /* Evaluate the curve and perform the cylinder culling test for four segments at
+   * once, only segments passing the test get their quad intersected. Segments are
+   * visited in the same order as the scalar loop, so the same hit is found. */
+  const ssef lane(0.0f, 1.0f, 2.0f, 3.0f);
+  for (int i = 0; i < N; i += 4) {
+    const ssef u0 = (ssef((float)i) + lane) * ssef(step_size);
+    const ssef u1 = u0 + ssef(step_size);
+
+    ssef p0x, p0y, p0w, p1x, p1y, p1w;
+    catmull_rom_basis_eval_sse(curve, u0, &p0x, &p0y, &p0w);
+    catmull_rom_basis_eval_sse(curve, u1, &p1x, &p1y, &p1w);
+
+    const ssef dpx = p1x - p0x;
+    const ssef dpy = p1y - p0y;
+    const ssef num = dpx * p0y - dpy * p0x;
+    const ssef den2 = dpx * dpx + dpy * dpy;
+    const ssef r = max(p0w, p1w);
+    const sseb valid = (num * num <= r * r * den2) & (ssef((float)i) + lane < ssef((float)N));
+
+    size_t mask = movemask(valid);
+    while (mask) {
+      const size_t j = __bscf(mask);
+      if (ribbon_intersect_segment(curve, (i + j) * step_size, step_size, eps, isect)) {
+        return true;
+      }
+    }
   }
-  float3 wn0 = normalize(make_float3(dp0dt.y, -dp0dt.x, 0.0f)) * p0.w;
-
+#  else
   /* Evaluate the bezier curve. */
+  float4 p0 = catmull_rom_basis_eval(curve, 0.0f);
   for (int i = 0; i < N; i++) {
     const float u = i * step_size;
     const float4 p1 = catmull_rom_basis_eval(curve, u + step_size);
-    bool valid = cylinder_culling_test(
+    const bool valid = cylinder_culling_test(
         make_float2(p0.x, p0.y), make_float2(p1.x, p1.y), max(p0.w, p1.w));
-    if (!valid) {
-      continue;
-    }
-
-    /* Evaluate next point. */
-    float3 dp1dt = float4_to_float3(catmull_rom_basis_derivative(curve, u + step_size));
-    dp1dt = (max3(fabs(dp1dt)) < eps) ? float4_to_float3(p1 - p0) : dp1dt;
-    const float3 wn1 = normalize(make_float3(dp1dt.y, -dp1dt.x, 0.0f)) * p1.w;
-
-    /* Construct quad coordinates. */
-    const float3 lp0 = float4_to_float3(p0) + wn0;
-    const float3 lp1 = float4_to_float3(p1) + wn1;
-    const float3 up0 = float4_to_float3(p0) - wn0;
-    const float3 up1 = float4_to_float3(p1) - wn1;
-
-    /* Intersect quad. */
-    float vu, vv, vt;
-    bool valid0 = ribbon_intersect_quad(isect->t, lp0, lp1, up1, up0, &vu, &vv, &vt);
-
-    if (valid0) {
-      /* ignore self intersections */
-      const float avoidance_factor = 2.0f;
-      if (avoidance_factor != 0.0f) {
-        float r = mix(p0.w, p1.w, vu);
-        valid0 = vt > avoidance_factor * r;
-      }
-
-      if (valid0) {
-        vv = 2.0f * vv - 1.0f;
+    p0 = p1;
 
-        /* Record intersection. */
-        isect->t = vt;
-        isect->u = u + vu * step_size;
-        isect->v = vv;
-        return true;
-      }
+    if (valid && ribbon_intersect_segment(curve, u, step_size, eps, isect)) {
+      return true;
     }
-
-    p0 = p1;
-    wn0 = wn1;
   }
+#  endif
+
   return false;
 }
 
@@ -75,6 +75,26 @@ ccl_device_inline void triangle_vertices(KernelGlobals *kg, int prim, float3 P[3
   P[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w + 2));
 }
 
+/* Vertex normal, either stored as float4 or octahedral encoded with 16 bits per component. */
+
+ccl_device_inline float3 triangle_vertex_normal(KernelGlobals *kg, uint vert)
+{
+  if (!kernel_data.bvh.use_compressed_normals) {
+    return float4_to_float3(kernel_tex_fetch(__tri_vnormal, vert));
+  }
+
+  const uint packed = kernel_tex_fetch(__tri_vnormal_packed, vert);
+  float x = (float)(packed & 0xffff) * (2.0f / 65535.0f) - 1.0f;
+  float y = (float)(packed >> 16) * (2.0f / 65535.0f) - 1.0f;
+  const float z = 1.0f - fabsf(x) - fabsf(y);
+  if (z < 0.0f) {
+    const float fold_x = (1.0f - fabsf(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+    y = (1.0f - fabsf(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+    x = fold_x;
+  }
+  return normalize(make_float3(x, y, z));
+}
+
 /* Interpolate smooth vertex normal from vertices */
 
 ccl_device_inline float3
@@ -82,9 +102,9 @@ triangle_smooth_normal(KernelGlobals *kg, float3 Ng, int prim, float u, float v)
 {
   /* load triangle vertices */
   const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-  float3 n0 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.x));
-  float3 n1 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.y));
-  float3 n2 = float4_to_float3(kernel_tex_fetch(__tri_vnormal, tri_vindex.z));
+  float3 n0 = triangle_vertex_normal(kg, tri_vindex.x);
+  float3 n1 = triangle_vertex_normal(kg, tri_vindex.y);
+  float3 n2 = triangle_vertex_normal(kg, tri_vindex.z);
 
   float3 N = safe_normalize((1.0f - u - v) * n2 + u * n0 + v * n1);
 
@@ -183,14 +203,14 @@ ccl_device float2 triangle_attribute_float2(KernelGlobals *kg,
     if (dy)
       *dy = make_float2(0.0f, 0.0f);
 
-    return kernel_tex_fetch(__attributes_float2, desc.offset + sd->prim);
+    return attribute_fetch_float2(kg, desc, desc.offset + sd->prim);
   }
   else if (desc.element == ATTR_ELEMENT_VERTEX || desc.element == ATTR_ELEMENT_VERTEX_MOTION) {
     uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, sd->prim);
 
-    float2 f0 = kernel_tex_fetch(__attributes_float2, desc.offset + tri_vindex.x);
-    float2 f1 = kernel_tex_fetch(__attributes_float2, desc.offset + tri_vindex.y);
-    float2 f2 = kernel_tex_fetch(__attributes_float2, desc.offset + tri_vindex.z);
+    float2 f0 = attribute_fetch_float2(kg, desc, desc.offset + tri_vindex.x);
+    float2 f1 = attribute_fetch_float2(kg, desc, desc.offset + tri_vindex.y);
+    float2 f2 = attribute_fetch_float2(kg, desc, desc.offset + tri_vindex.z);
 
 #ifdef __RAY_DIFFERENTIALS__
     if (dx)
@@ -206,9 +226,9 @@ ccl_device float2 triangle_attribute_float2(KernelGlobals *kg,
     float2 f0, f1, f2;
 
     if (desc.element == ATTR_ELEMENT_CORNER) {
-      f0 = kernel_tex_fetch(__attributes_float2, tri + 0);
-      f1 = kernel_tex_fetch(__attributes_float2, tri + 1);
-      f2 = kernel_tex_fetch(__attributes_float2, tri + 2);
+      f0 = attribute_fetch_float2(kg, desc, tri + 0);
+      f1 = attribute_fetch_float2(kg, desc, tri + 1);
+      f2 = attribute_fetch_float2(kg, desc, tri + 2);
     }
 
 #ifdef __RAY_DIFFERENTIALS__
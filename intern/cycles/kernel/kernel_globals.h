@@ -69,6 +69,12 @@ typedef struct KernelGlobals {
   /* Heap-allocated storage for transparent shadows intersections. */
   Intersection *transparent_shadow_intersections;
 
+#  ifdef __BVH_PACKET__
+  /* Camera ray intersection found by packet traversal, used instead of
+   * tracing the first ray of the path again. */
+  const Intersection *camera_packet_isect;
+#  endif
+
   /* Storage for decoupled volume steps. */
   VolumeStep *decoupled_volume_steps[2];
   int decoupled_volume_steps_index;
@@ -69,7 +69,20 @@ ccl_device_forceinline bool kernel_path_scene_intersect(KernelGlobals *kg,
     ray->t = kernel_data.background.ao_distance;
   }
 
+#ifdef __BVH_PACKET__
+  bool hit;
+  if (kg->camera_packet_isect) {
+    /* Camera ray was already traced as part of a packet. */
+    *isect = *kg->camera_packet_isect;
+    kg->camera_packet_isect = NULL;
+    hit = (isect->prim != PRIM_NONE);
+  }
+  else {
+    hit = scene_intersect(kg, ray, visibility, isect);
+  }
+#else
   bool hit = scene_intersect(kg, ray, visibility, isect);
+#endif
 
 #ifdef __KERNEL_DEBUG__
   if (state->flag & PATH_RAY_CAMERA) {
@@ -696,6 +709,65 @@ ccl_device void kernel_path_trace(
   kernel_write_result(kg, buffer, sample, &L);
 }
 
+#  ifdef __BVH_PACKET__
+/* Trace the camera rays of up to BVH_PACKET_SIZE neighboring pixels in a row
+ * as one packet. Returns a bit mask of the pixels whose intersection was
+ * written to isects, other pixels need no camera ray. The ray setup matches
+ * kernel_path_trace() so its first scene intersection can be skipped. */
+ccl_device int kernel_path_trace_camera_packet(KernelGlobals *kg,
+                                               ccl_global float *buffer,
+                                               int sample,
+                                               int x,
+                                               int y,
+                                               int num_pixels,
+                                               int offset,
+                                               int stride,
+                                               Intersection *isects)
+{
+  PROFILING_INIT(kg, PROFILING_RAY_SETUP);
+
+  const int pass_stride = kernel_data.film.pass_stride;
+  Ray rays[BVH_PACKET_SIZE];
+  int ray_pixel[BVH_PACKET_SIZE];
+  int num_rays = 0;
+
+  for (int i = 0; i < num_pixels; i++) {
+    if (kernel_data.film.pass_adaptive_aux_buffer) {
+      ccl_global float *pixel_buffer = buffer + (offset + x + i + y * stride) * pass_stride;
+      ccl_global float4 *aux = (ccl_global float4 *)(pixel_buffer +
+                                                     kernel_data.film.pass_adaptive_aux_buffer);
+      if ((*aux).w > 0.0f) {
+        continue;
+      }
+    }
+
+    uint rng_hash;
+    kernel_path_trace_setup(kg, sample, x + i, y, &rng_hash, &rays[num_rays]);
+
+    if (rays[num_rays].t != 0.0f) {
+      ray_pixel[num_rays] = i;
+      num_rays++;
+    }
+  }
+
+  if (num_rays == 0) {
+    return 0;
+  }
+
+  /* Same visibility as path_state_ray_visibility() gives a new camera path. */
+  Intersection ray_isects[BVH_PACKET_SIZE];
+  scene_intersect_packet(kg, rays, num_rays, PATH_RAY_CAMERA, ray_isects);
+
+  int traced_mask = 0;
+  for (int r = 0; r < num_rays; r++) {
+    isects[ray_pixel[r]] = ray_isects[r];
+    traced_mask |= (1 << ray_pixel[r]);
+  }
+
+  return traced_mask;
+}
+#  endif /* __BVH_PACKET__ */
+
 #endif /* __SPLIT_KERNEL__ */
 
 CCL_NAMESPACE_END
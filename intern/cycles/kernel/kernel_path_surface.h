@@ -18,6 +18,61 @@ CCL_NAMESPACE_BEGIN
 
 #if defined(__BRANCHED_PATH__) || defined(__SUBSURFACE__) || defined(__SHADOW_TRICKS__) || \
     defined(__BAKING__)
+#  ifdef __EMISSION__
+/* branched path tracing: sample light sample j of light i, returning the shadow ray to trace
+ * and the light contribution. The ray has zero length if there is nothing to trace. */
+ccl_device_forceinline bool kernel_branched_path_surface_sample_light(
+    KernelGlobals *kg,
+    ShaderData *sd,
+    ShaderData *emission_sd,
+    ccl_addr_space PathState *state,
+    int i,
+    int j,
+    int num_samples,
+    uint lamp_rng_hash,
+    bool double_pdf,
+    bool is_mesh_light,
+    bool *is_lamp,
+    Ray *light_ray,
+    BsdfEval *L_light)
+{
+  light_ray->t = 0.0f; /* reset ray */
+#  ifdef __OBJECT_MOTION__
+  light_ray->time = sd->time;
+#  endif
+  bool has_emission = false;
+
+  if (kernel_data.integrator.use_direct_light && (sd->flag & SD_BSDF_HAS_EVAL)) {
+    float light_u, light_v;
+    path_branched_rng_2D(
+        kg, lamp_rng_hash, state, j, num_samples, PRNG_LIGHT_U, &light_u, &light_v);
+    float terminate = path_branched_rng_light_termination(
+        kg, lamp_rng_hash, state, j, num_samples);
+
+    /* only sample triangle lights */
+    if (is_mesh_light && double_pdf) {
+      light_u = 0.5f * light_u;
+    }
+
+    LightSample ls ccl_optional_struct_init;
+    const int lamp = *is_lamp ? i : -1;
+    if (light_sample(kg, lamp, light_u, light_v, sd->time, sd->P, state->bounce, &ls)) {
+      /* The sampling probability returned by lamp_light_sample assumes that all lights were
+       * sampled. However, this code only samples lamps, so if the scene also had mesh lights,
+       * the real probability is twice as high. */
+      if (double_pdf) {
+        ls.pdf *= 2.0f;
+      }
+
+      has_emission = direct_emission(
+          kg, sd, emission_sd, &ls, state, light_ray, L_light, is_lamp, terminate);
+    }
+  }
+
+  return has_emission;
+}
+#  endif
+
 /* branched path tracing: connect path directly to position on one or more lights and add it to L
  */
 ccl_device_noinline_cpu void kernel_branched_path_surface_connect_light(
@@ -32,8 +87,6 @@ ccl_device_noinline_cpu void kernel_branched_path_surface_connect_light(
 {
 #  ifdef __EMISSION__
   /* sample illumination from lights to find path contribution */
-  BsdfEval L_light ccl_optional_struct_init;
-
   int num_lights = 0;
   if (kernel_data.integrator.use_direct_light) {
     if (sample_all_lights) {
@@ -78,40 +131,80 @@ ccl_device_noinline_cpu void kernel_branched_path_surface_connect_light(
 
     float num_samples_inv = num_samples_adjust / (num_samples * num_all_lights);
 
-    for (int j = 0; j < num_samples; j++) {
-      Ray light_ray ccl_optional_struct_init;
-      light_ray.t = 0.0f; /* reset ray */
-#    ifdef __OBJECT_MOTION__
-      light_ray.time = sd->time;
-#    endif
-      bool has_emission = false;
-
-      if (kernel_data.integrator.use_direct_light && (sd->flag & SD_BSDF_HAS_EVAL)) {
-        float light_u, light_v;
-        path_branched_rng_2D(
-            kg, lamp_rng_hash, state, j, num_samples, PRNG_LIGHT_U, &light_u, &light_v);
-        float terminate = path_branched_rng_light_termination(
-            kg, lamp_rng_hash, state, j, num_samples);
-
-        /* only sample triangle lights */
-        if (is_mesh_light && double_pdf) {
-          light_u = 0.5f * light_u;
+#    ifdef __BVH_PACKET__
+    /* Light samples are traced in batches so their shadow rays can share one
+     * packet traversal. */
+    for (int j_start = 0; j_start < num_samples; j_start += BVH_PACKET_SIZE) {
+      const int num_batch = min(BVH_PACKET_SIZE, num_samples - j_start);
+      Ray light_ray[BVH_PACKET_SIZE];
+      BsdfEval L_light[BVH_PACKET_SIZE];
+      bool has_emission[BVH_PACKET_SIZE];
+      bool sample_is_lamp[BVH_PACKET_SIZE];
+
+      for (int b = 0; b < num_batch; b++) {
+        has_emission[b] = kernel_branched_path_surface_sample_light(kg,
+                                                                    sd,
+                                                                    emission_sd,
+                                                                    state,
+                                                                    i,
+                                                                    j_start + b,
+                                                                    num_samples,
+                                                                    lamp_rng_hash,
+                                                                    double_pdf,
+                                                                    is_mesh_light,
+                                                                    &is_lamp,
+                                                                    &light_ray[b],
+                                                                    &L_light[b]);
+        sample_is_lamp[b] = is_lamp;
+        /* Skip the shadow ray when there is nothing to accumulate. */
+        if (!has_emission[b]) {
+          light_ray[b].t = 0.0f;
         }
+      }
 
-        LightSample ls ccl_optional_struct_init;
-        const int lamp = is_lamp ? i : -1;
-        if (light_sample(kg, lamp, light_u, light_v, sd->time, sd->P, state->bounce, &ls)) {
-          /* The sampling probability returned by lamp_light_sample assumes that all lights were
-           * sampled. However, this code only samples lamps, so if the scene also had mesh lights,
-           * the real probability is twice as high. */
-          if (double_pdf) {
-            ls.pdf *= 2.0f;
+      /* trace shadow rays */
+      float3 shadow[BVH_PACKET_SIZE];
+      bool blocked[BVH_PACKET_SIZE];
+      shadow_blocked_packet(kg, sd, emission_sd, state, light_ray, num_batch, shadow, blocked);
+
+      for (int b = 0; b < num_batch; b++) {
+        if (has_emission[b]) {
+          if (!blocked[b]) {
+            /* accumulate */
+            path_radiance_accum_light(kg,
+                                      L,
+                                      state,
+                                      throughput * num_samples_inv,
+                                      &L_light[b],
+                                      shadow[b],
+                                      num_samples_inv,
+                                      sample_is_lamp[b]);
+          }
+          else {
+            path_radiance_accum_total_light(
+                L, state, throughput * num_samples_inv, &L_light[b]);
           }
-
-          has_emission = direct_emission(
-              kg, sd, emission_sd, &ls, state, &light_ray, &L_light, &is_lamp, terminate);
         }
       }
+    }
+#    else
+    BsdfEval L_light ccl_optional_struct_init;
+
+    for (int j = 0; j < num_samples; j++) {
+      Ray light_ray ccl_optional_struct_init;
+      const bool has_emission = kernel_branched_path_surface_sample_light(kg,
+                                                                          sd,
+                                                                          emission_sd,
+                                                                          state,
+                                                                          i,
+                                                                          j,
+                                                                          num_samples,
+                                                                          lamp_rng_hash,
+                                                                          double_pdf,
+                                                                          is_mesh_light,
+                                                                          &is_lamp,
+                                                                          &light_ray,
+                                                                          &L_light);
 
       /* trace shadow ray */
       float3 shadow;
@@ -135,6 +228,7 @@ ccl_device_noinline_cpu void kernel_branched_path_surface_connect_light(
         }
       }
     }
+#    endif /* __BVH_PACKET__ */
   }
 #  endif
 }
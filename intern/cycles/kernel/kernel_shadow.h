@@ -461,6 +461,76 @@ ccl_device_inline bool shadow_blocked(KernelGlobals *kg,
 #endif   /* __TRANSPARENT_SHADOWS__ */
 }
 
+#ifdef __BVH_PACKET__
+/* Shadow test for up to BVH_PACKET_SIZE rays leaving the same shading point.
+ * Opaque shadows are traced as one BVH packet, transparent shadows go through
+ * shadow_blocked() one ray at a time. */
+ccl_device_inline void shadow_blocked_packet(KernelGlobals *kg,
+                                             ShaderData *sd,
+                                             ShaderData *shadow_sd,
+                                             ccl_addr_space PathState *state,
+                                             Ray *rays,
+                                             const int num_rays,
+                                             float3 *shadow,
+                                             bool *blocked)
+{
+  bool use_packet = (num_rays > 1);
+#  ifdef __TRANSPARENT_SHADOWS__
+  if (kernel_data.integrator.transparent_shadows) {
+    use_packet = false;
+  }
+#  endif
+
+  if (!use_packet) {
+    for (int i = 0; i < num_rays; i++) {
+      blocked[i] = shadow_blocked(kg, sd, shadow_sd, state, &rays[i], &shadow[i]);
+    }
+    return;
+  }
+
+#  ifdef __SHADOW_TRICKS__
+  const uint visibility = (state->flag & PATH_RAY_SHADOW_CATCHER) ? PATH_RAY_SHADOW_NON_CATCHER :
+                                                                    PATH_RAY_SHADOW;
+#  else
+  const uint visibility = PATH_RAY_SHADOW;
+#  endif
+
+  /* Gather the rays that need tracing. */
+  Ray packet_rays[BVH_PACKET_SIZE];
+  int ray_index[BVH_PACKET_SIZE];
+  int num_packet_rays = 0;
+
+  for (int i = 0; i < num_rays; i++) {
+    shadow[i] = make_float3(1.0f, 1.0f, 1.0f);
+    blocked[i] = false;
+    if (rays[i].t != 0.0f) {
+      packet_rays[num_packet_rays] = rays[i];
+      ray_index[num_packet_rays] = i;
+      num_packet_rays++;
+    }
+  }
+
+  if (num_packet_rays == 0) {
+    return;
+  }
+
+  Intersection isects[BVH_PACKET_SIZE];
+  const int hit_mask = scene_intersect_packet(
+      kg, packet_rays, num_packet_rays, visibility & PATH_RAY_SHADOW_OPAQUE, isects);
+
+  for (int k = 0; k < num_packet_rays; k++) {
+    const int i = ray_index[k];
+    blocked[i] = (hit_mask & (1 << k)) != 0;
+#  ifdef __VOLUME__
+    if (!blocked[i] && state->volume_stack[0].shader != SHADER_NONE) {
+      /* Apply attenuation from current volume shader. */
+      kernel_volume_shadow(kg, shadow_sd, state, &rays[i], &shadow[i]);
+    }
+#  endif
+  }
+}
+#endif /* __BVH_PACKET__ */
+
 #undef SHADOW_STACK_MAX_HITS
 
 CCL_NAMESPACE_END
@@ -51,6 +51,9 @@ CCL_NAMESPACE_BEGIN
 #define BSSRDF_MAX_BOUNCES 256
 #define LOCAL_MAX_HITS 4
 
+/* Number of coherent rays traced together by BVH packet traversal. */
+#define BVH_PACKET_SIZE 4
+
 #define VOLUME_BOUNDS_MAX 1024
 
 #define BECKMANN_TABLE_SIZE 256
@@ -128,6 +131,11 @@ CCL_NAMESPACE_BEGIN
 #  endif
 #  define __VOLUME_DECOUPLED__
 #  define __VOLUME_RECORD_ALL__
+/* Trace camera and opaque shadow rays through the BVH2 in SSE packets,
+ * undefine to compare against single ray traversal. */
+#  ifdef __KERNEL_SSE2__
+#    define __BVH_PACKET__
+#  endif
 #endif /* __KERNEL_CPU__ */
 
 #ifdef __KERNEL_CUDA__
@@ -782,6 +790,8 @@ typedef enum AttributeStandard {
 typedef enum AttributeFlag {
   ATTR_FINAL_SIZE = (1 << 0),
   ATTR_SUBDIVIDED = (1 << 1),
+  /* Stored as 16 bit unorm in __attributes_unorm2, see SceneParams::use_compressed_geometry. */
+  ATTR_COMPRESSED = (1 << 2),
 } AttributeFlag;
 
 typedef struct AttributeDescriptor {
@@ -1413,6 +1423,9 @@ typedef struct KernelBVH {
   int bvh_layout;
   int use_bvh_steps;
   int curve_subdivisions;
+  /* Vertex normals are octahedral encoded in __tri_vnormal_packed. */
+  int use_compressed_normals;
+  int pad1, pad3, pad4;
 
   /* Custom BVH */
 #ifdef __KERNEL_OPTIX__
@@ -474,6 +474,11 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
 {
   const TextureInfo &info = kernel_tex_fetch(__texture_info, id);
 
+  if (info.cache) {
+    return ((ImageCacheLookup *)info.cache)
+        ->lookup(x, y, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f));
+  }
+
   switch (info.data_type) {
     case IMAGE_DATA_TYPE_HALF:
       return TextureInterpolator<half>::interp(info, x, y);
@@ -498,6 +503,20 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
   }
 }
 
+/* Lookup with the differentials of the texture coordinate, which cached images use to
+ * select the mipmap level. */
+ccl_device float4 kernel_tex_image_interp_differentials(
+    KernelGlobals *kg, int id, float x, float y, float2 dx, float2 dy)
+{
+  const TextureInfo &info = kernel_tex_fetch(__texture_info, id);
+
+  if (info.cache) {
+    return ((ImageCacheLookup *)info.cache)->lookup(x, y, dx, dy);
+  }
+
+  return kernel_tex_image_interp(kg, id, x, y);
+}
+
 ccl_device float4 kernel_tex_image_interp_3d(KernelGlobals *kg,
                                              int id,
                                              float3 P,
@@ -98,6 +98,37 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(
 #  endif /* KERNEL_STUB */
 }
 
+void KERNEL_FUNCTION_FULL_NAME(path_trace_packet)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int sample,
+                                                  int x,
+                                                  int y,
+                                                  int num_pixels,
+                                                  int offset,
+                                                  int stride)
+{
+#  ifdef KERNEL_STUB
+  STUB_ASSERT(KERNEL_ARCH, path_trace_packet);
+#  else
+#    ifdef __BVH_PACKET__
+  Intersection isects[BVH_PACKET_SIZE];
+  const int traced_mask = kernel_path_trace_camera_packet(
+      kg, buffer, sample, x, y, num_pixels, offset, stride, isects);
+#    endif
+
+  for (int i = 0; i < num_pixels; i++) {
+#    ifdef __BVH_PACKET__
+    kg->camera_packet_isect = (traced_mask & (1 << i)) ? &isects[i] : NULL;
+#    endif
+    KERNEL_FUNCTION_FULL_NAME(path_trace)(kg, buffer, sample, x + i, y, offset, stride);
+  }
+
+#    ifdef __BVH_PACKET__
+  kg->camera_packet_isect = NULL;
+#    endif
+#  endif /* KERNEL_STUB */
+}
+
 /* Film */
 
 void KERNEL_FUNCTION_FULL_NAME(convert_to_byte)(KernelGlobals *kg,
@@ -202,6 +202,13 @@ ccl_device float4 kernel_tex_image_interp(KernelGlobals *kg, int id, float x, fl
   }
 }
 
+/* Images are always fully loaded on the GPU, so differentials are not needed. */
+ccl_device float4 kernel_tex_image_interp_differentials(
+    KernelGlobals *kg, int id, float x, float y, float2 dx, float2 dy)
+{
+  return kernel_tex_image_interp(kg, id, x, y);
+}
+
 ccl_device float4 kernel_tex_image_interp_3d(KernelGlobals *kg, int id, float3 P, int interp)
 {
   const ccl_global TextureInfo *info = kernel_tex_info(kg, id);
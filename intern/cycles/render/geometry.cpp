@@ -37,8 +37,10 @@
 
 #include "kernel/osl/osl_globals.h"
 
+#include "util/util_atomic.h"
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
+#include "util/util_md5.h"
 #include "util/util_progress.h"
 
 CCL_NAMESPACE_BEGIN
@@ -55,9 +57,13 @@ NODE_ABSTRACT_DEFINE(Geometry)
   return type;
 }
 
+static uint64_t geometry_id_counter = 0;
+
 Geometry::Geometry(const NodeType *node_type, const Type type)
     : Node(node_type), type(type), attributes(this, ATTR_PRIM_GEOMETRY)
 {
+  id = atomic_add_and_fetch_uint64(&geometry_id_counter, 1);
+
   need_update = true;
   need_update_rebuild = false;
 
@@ -259,14 +265,25 @@ void Geometry::tag_update(Scene *scene, bool rebuild)
 
 /* Geometry Manager */
 
+static void persistent_bvh_free(map<string, BVH *> &persistent_bvh)
+{
+  foreach (auto &it, persistent_bvh) {
+    delete it.second;
+  }
+  persistent_bvh.clear();
+}
+
 GeometryManager::GeometryManager()
 {
   need_update = true;
   need_flags_update = true;
+  bvh = NULL;
 }
 
 GeometryManager::~GeometryManager()
 {
+  delete bvh;
+  persistent_bvh_free(persistent_bvh);
 }
 
 void GeometryManager::update_osl_attributes(Device *device,
@@ -472,11 +489,50 @@ void GeometryManager::update_svm_attributes(Device *,
   dscene->attributes_map.copy_to_device();
 }
 
+/* With compressed geometry, float2 attributes on triangles (mostly UV maps) are stored as two
+ * 16 bit unsigned normalized values. That only covers the 0..1 range, so attributes with values
+ * outside of it, like UDIM or tiling UV maps, keep full precision. Subdivision surfaces evaluate
+ * their attributes through the patch table and keep full precision, as do curves. */
+static bool update_attribute_use_unorm2(Scene *scene,
+                                        Geometry *geom,
+                                        Attribute *mattr,
+                                        AttributePrimitive prim)
+{
+  if (!(scene->params.use_compressed_geometry && mattr && mattr->type == TypeFloat2 &&
+        geom->type == Geometry::MESH && prim == ATTR_PRIM_GEOMETRY &&
+        !(mattr->flags & ATTR_SUBDIVIDED))) {
+    return false;
+  }
+
+  if (!(mattr->element == ATTR_ELEMENT_VERTEX || mattr->element == ATTR_ELEMENT_VERTEX_MOTION ||
+        mattr->element == ATTR_ELEMENT_FACE || mattr->element == ATTR_ELEMENT_CORNER)) {
+    return false;
+  }
+
+  const float2 *data = mattr->data_float2();
+  const size_t size = mattr->element_size(geom, prim);
+  for (size_t k = 0; k < size; k++) {
+    if (!(data[k].x >= 0.0f && data[k].x <= 1.0f && data[k].y >= 0.0f && data[k].y <= 1.0f)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/* Round a value in the 0..1 range to the nearest 16 bit unsigned normalized value. */
+static uint float_to_unorm16(float f)
+{
+  return (uint)(f * 65535.0f + 0.5f);
+}
+
 static void update_attribute_element_size(Geometry *geom,
                                           Attribute *mattr,
                                           AttributePrimitive prim,
+                                          bool use_unorm2,
                                           size_t *attr_float_size,
                                           size_t *attr_float2_size,
+                                          size_t *attr_unorm2_size,
                                           size_t *attr_float3_size,
                                           size_t *attr_uchar4_size)
 {
@@ -492,6 +548,9 @@ static void update_attribute_element_size(Geometry *geom,
     else if (mattr->type == TypeDesc::TypeFloat) {
       *attr_float_size += size;
     }
+    else if (use_unorm2) {
+      *attr_unorm2_size += size;
+    }
     else if (mattr->type == TypeFloat2) {
       *attr_float2_size += size;
     }
@@ -505,10 +564,13 @@ static void update_attribute_element_size(Geometry *geom,
 }
 
 static void update_attribute_element_offset(Geometry *geom,
+                                            bool use_unorm2,
                                             device_vector<float> &attr_float,
                                             size_t &attr_float_offset,
                                             device_vector<float2> &attr_float2,
                                             size_t &attr_float2_offset,
+                                            device_vector<uint> &attr_unorm2,
+                                            size_t &attr_unorm2_offset,
                                             device_vector<float4> &attr_float3,
                                             size_t &attr_float3_offset,
                                             device_vector<uchar4> &attr_uchar4,
@@ -555,6 +617,18 @@ static void update_attribute_element_offset(Geometry *geom,
       }
       attr_float_offset += size;
     }
+    else if (use_unorm2) {
+      float2 *data = mattr->data_float2();
+      offset = attr_unorm2_offset;
+      desc.flags |= ATTR_COMPRESSED;
+
+      assert(attr_unorm2.size() >= offset + size);
+      for (size_t k = 0; k < size; k++) {
+        attr_unorm2[offset + k] = float_to_unorm16(data[k].x) |
+                                  (float_to_unorm16(data[k].y) << 16);
+      }
+      attr_unorm2_offset += size;
+    }
     else if (mattr->type == TypeFloat2) {
       float2 *data = mattr->data_float2();
       offset = attr_float2_offset;
@@ -660,6 +734,7 @@ void GeometryManager::device_update_attributes(Device *device,
    */
   size_t attr_float_size = 0;
   size_t attr_float2_size = 0;
+  size_t attr_unorm2_size = 0;
   size_t attr_float3_size = 0;
   size_t attr_uchar4_size = 0;
   for (size_t i = 0; i < scene->geometry.size(); i++) {
@@ -671,8 +746,11 @@ void GeometryManager::device_update_attributes(Device *device,
       update_attribute_element_size(geom,
                                     attr,
                                     ATTR_PRIM_GEOMETRY,
+                                    update_attribute_use_unorm2(
+                                        scene, geom, attr, ATTR_PRIM_GEOMETRY),
                                     &attr_float_size,
                                     &attr_float2_size,
+                                    &attr_unorm2_size,
                                     &attr_float3_size,
                                     &attr_uchar4_size);
 
@@ -683,8 +761,10 @@ void GeometryManager::device_update_attributes(Device *device,
         update_attribute_element_size(mesh,
                                       subd_attr,
                                       ATTR_PRIM_SUBD,
+                                      false,
                                       &attr_float_size,
                                       &attr_float2_size,
+                                      &attr_unorm2_size,
                                       &attr_float3_size,
                                       &attr_uchar4_size);
       }
@@ -693,11 +773,19 @@ void GeometryManager::device_update_attributes(Device *device,
 
   dscene->attributes_float.alloc(attr_float_size);
   dscene->attributes_float2.alloc(attr_float2_size);
+  dscene->attributes_unorm2.alloc(attr_unorm2_size);
   dscene->attributes_float3.alloc(attr_float3_size);
   dscene->attributes_uchar4.alloc(attr_uchar4_size);
 
+  if (attr_unorm2_size) {
+    VLOG(1) << "Compressed float2 attributes, saved "
+            << string_human_readable_size(attr_unorm2_size * (sizeof(float2) - sizeof(uint)))
+            << ".";
+  }
+
   size_t attr_float_offset = 0;
   size_t attr_float2_offset = 0;
+  size_t attr_unorm2_offset = 0;
   size_t attr_float3_offset = 0;
   size_t attr_uchar4_offset = 0;
 
@@ -711,10 +799,14 @@ void GeometryManager::device_update_attributes(Device *device,
     foreach (AttributeRequest &req, attributes.requests) {
       Attribute *attr = geom->attributes.find(req);
       update_attribute_element_offset(geom,
+                                      update_attribute_use_unorm2(
+                                          scene, geom, attr, ATTR_PRIM_GEOMETRY),
                                       dscene->attributes_float,
                                       attr_float_offset,
                                       dscene->attributes_float2,
                                       attr_float2_offset,
+                                      dscene->attributes_unorm2,
+                                      attr_unorm2_offset,
                                       dscene->attributes_float3,
                                       attr_float3_offset,
                                       dscene->attributes_uchar4,
@@ -729,10 +821,13 @@ void GeometryManager::device_update_attributes(Device *device,
         Attribute *subd_attr = mesh->subd_attributes.find(req);
 
         update_attribute_element_offset(mesh,
+                                        false,
                                         dscene->attributes_float,
                                         attr_float_offset,
                                         dscene->attributes_float2,
                                         attr_float2_offset,
+                                        dscene->attributes_unorm2,
+                                        attr_unorm2_offset,
                                         dscene->attributes_float3,
                                         attr_float3_offset,
                                         dscene->attributes_uchar4,
@@ -766,6 +861,9 @@ void GeometryManager::device_update_attributes(Device *device,
   if (dscene->attributes_float2.size()) {
     dscene->attributes_float2.copy_to_device();
   }
+  if (dscene->attributes_unorm2.size()) {
+    dscene->attributes_unorm2.copy_to_device();
+  }
   if (dscene->attributes_float3.size()) {
     dscene->attributes_float3.copy_to_device();
   }
@@ -910,7 +1008,17 @@ void GeometryManager::device_update_mesh(
     progress.set_status("Updating Mesh", "Computing normals");
 
     uint *tri_shader = dscene->tri_shader.alloc(tri_size);
-    float4 *vnormal = dscene->tri_vnormal.alloc(vert_size);
+    float4 *vnormal = NULL;
+    uint *vnormal_packed = NULL;
+    if (scene->params.use_compressed_geometry) {
+      vnormal_packed = dscene->tri_vnormal_packed.alloc(vert_size);
+      VLOG(1) << "Compressed vertex normals, saved "
+              << string_human_readable_size(vert_size * (sizeof(float4) - sizeof(uint))) << ".";
+    }
+    else {
+      vnormal = dscene->tri_vnormal.alloc(vert_size);
+    }
+    dscene->data.bvh.use_compressed_normals = scene->params.use_compressed_geometry;
     uint4 *tri_vindex = dscene->tri_vindex.alloc(tri_size);
     uint *tri_patch = dscene->tri_patch.alloc(tri_size);
     float2 *tri_patch_uv = dscene->tri_patch_uv.alloc(vert_size);
@@ -919,7 +1027,12 @@ void GeometryManager::device_update_mesh(
       if (geom->type == Geometry::MESH) {
         Mesh *mesh = static_cast<Mesh *>(geom);
         mesh->pack_shaders(scene, &tri_shader[mesh->prim_offset]);
-        mesh->pack_normals(&vnormal[mesh->vert_offset]);
+        if (vnormal_packed) {
+          mesh->pack_normals_compressed(&vnormal_packed[mesh->vert_offset]);
+        }
+        else {
+          mesh->pack_normals(&vnormal[mesh->vert_offset]);
+        }
         mesh->pack_verts(tri_prim_index,
                          &tri_vindex[mesh->prim_offset],
                          &tri_patch[mesh->prim_offset],
@@ -935,7 +1048,12 @@ void GeometryManager::device_update_mesh(
     progress.set_status("Updating Mesh", "Copying Mesh to device");
 
     dscene->tri_shader.copy_to_device();
-    dscene->tri_vnormal.copy_to_device();
+    if (vnormal_packed) {
+      dscene->tri_vnormal_packed.copy_to_device();
+    }
+    else {
+      dscene->tri_vnormal.copy_to_device();
+    }
     dscene->tri_vindex.copy_to_device();
     dscene->tri_patch.copy_to_device();
     dscene->tri_patch_uv.copy_to_device();
@@ -1007,9 +1125,77 @@ void GeometryManager::device_update_mesh(
   }
 }
 
+/* Copy packed BVH array to the device, stealing it unless the BVH is kept for refitting. */
+template<typename T>
+static void bvh_array_copy_to_device(device_vector<T> &dst, array<T> &src, bool keep)
+{
+  if (keep) {
+    T *data = dst.alloc(src.size());
+    memcpy(data, src.data(), sizeof(T) * src.size());
+  }
+  else {
+    dst.steal_data(src);
+  }
+  dst.copy_to_device();
+}
+
+bool GeometryManager::can_refit_bvh(Scene *scene, const BVHParams &bparams)
+{
+  if (bvh == NULL || bparams.bvh_layout != BVH_LAYOUT_BVH2 ||
+      bparams.bvh_type != SceneParams::BVH_DYNAMIC) {
+    return false;
+  }
+
+  /* Motion steps and unaligned nodes are not preserved by refitting. */
+  if (bparams.num_motion_triangle_steps || bparams.num_motion_curve_steps ||
+      bparams.use_unaligned_nodes) {
+    return false;
+  }
+
+  const BVHParams &old_bparams = bvh->params;
+  if (old_bparams.bvh_layout != bparams.bvh_layout ||
+      old_bparams.use_spatial_split != bparams.use_spatial_split ||
+      old_bparams.use_unaligned_nodes != bparams.use_unaligned_nodes ||
+      old_bparams.num_motion_triangle_steps != bparams.num_motion_triangle_steps ||
+      old_bparams.num_motion_curve_steps != bparams.num_motion_curve_steps ||
+      old_bparams.curve_subdivisions != bparams.curve_subdivisions) {
+    return false;
+  }
+
+  /* The top level BVH references objects and geometry by index. Compare identifiers rather
+   * than pointers, a deleted object may be replaced by a new one at the same address. */
+  if (bvh_object_id.size() != scene->objects.size() ||
+      bvh_geometry_id.size() != scene->geometry.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < scene->objects.size(); i++) {
+    if (bvh_object_id[i] != scene->objects[i]->id) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < scene->geometry.size(); i++) {
+    if (bvh_geometry_id[i] != scene->geometry[i]->id) {
+      return false;
+    }
+  }
+
+  /* Primitives of geometry without own BVH are part of the top level BVH,
+   * they must still be the same and at the same offset. */
+  for (size_t i = 0; i < scene->objects.size(); i++) {
+    Geometry *geom = scene->objects[i]->geometry;
+    const int prim_offset = geom->need_build_bvh(bparams.bvh_layout) ? -1 : geom->prim_offset;
+    if (bvh_object_prim_offset[i] != prim_offset) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 void GeometryManager::device_update_bvh(Device *device,
                                         DeviceScene *dscene,
                                         Scene *scene,
+                                        bool need_rebuild,
                                         Progress &progress)
 {
   /* bvh build */
@@ -1029,8 +1215,20 @@ void GeometryManager::device_update_bvh(Device *device,
 
   VLOG(1) << "Using " << bvh_layout_name(bparams.bvh_layout) << " layout.";
 
-  BVH *bvh = BVH::create(bparams, scene->geometry, scene->objects);
-  bvh->build(progress, &device->stats);
+  /* Refit the previous BVH when objects only moved, falling back to a full build
+   * when that is not possible or the tree quality degraded too much. */
+  bool refit = false;
+  if (!need_rebuild && can_refit_bvh(scene, bparams)) {
+    progress.set_status("Updating Scene BVH", "Refitting");
+    refit = bvh->refit_top_level(progress);
+    VLOG(1) << (refit ? "Refit" : "Failed to refit") << " top level BVH.";
+  }
+
+  if (!refit) {
+    delete bvh;
+    bvh = BVH::create(bparams, scene->geometry, scene->objects);
+    bvh->build(progress, &device->stats);
+  }
 
   if (progress.get_cancel()) {
 #ifdef WITH_EMBREE
@@ -1040,53 +1238,46 @@ void GeometryManager::device_update_bvh(Device *device,
     }
 #endif
     delete bvh;
+    bvh = NULL;
     return;
   }
 
   /* copy to device */
   progress.set_status("Updating Scene BVH", "Copying BVH to device");
 
+  const bool keep_bvh = bparams.bvh_layout == BVH_LAYOUT_BVH2 &&
+                        bparams.bvh_type == SceneParams::BVH_DYNAMIC;
   PackedBVH &pack = bvh->pack;
 
   if (pack.nodes.size()) {
-    dscene->bvh_nodes.steal_data(pack.nodes);
-    dscene->bvh_nodes.copy_to_device();
+    bvh_array_copy_to_device(dscene->bvh_nodes, pack.nodes, keep_bvh);
   }
   if (pack.leaf_nodes.size()) {
-    dscene->bvh_leaf_nodes.steal_data(pack.leaf_nodes);
-    dscene->bvh_leaf_nodes.copy_to_device();
+    bvh_array_copy_to_device(dscene->bvh_leaf_nodes, pack.leaf_nodes, keep_bvh);
   }
   if (pack.object_node.size()) {
-    dscene->object_node.steal_data(pack.object_node);
-    dscene->object_node.copy_to_device();
+    bvh_array_copy_to_device(dscene->object_node, pack.object_node, keep_bvh);
   }
   if (pack.prim_tri_index.size()) {
-    dscene->prim_tri_index.steal_data(pack.prim_tri_index);
-    dscene->prim_tri_index.copy_to_device();
+    bvh_array_copy_to_device(dscene->prim_tri_index, pack.prim_tri_index, keep_bvh);
   }
   if (pack.prim_tri_verts.size()) {
-    dscene->prim_tri_verts.steal_data(pack.prim_tri_verts);
-    dscene->prim_tri_verts.copy_to_device();
+    bvh_array_copy_to_device(dscene->prim_tri_verts, pack.prim_tri_verts, keep_bvh);
   }
   if (pack.prim_type.size()) {
-    dscene->prim_type.steal_data(pack.prim_type);
-    dscene->prim_type.copy_to_device();
+    bvh_array_copy_to_device(dscene->prim_type, pack.prim_type, keep_bvh);
   }
   if (pack.prim_visibility.size()) {
-    dscene->prim_visibility.steal_data(pack.prim_visibility);
-    dscene->prim_visibility.copy_to_device();
+    bvh_array_copy_to_device(dscene->prim_visibility, pack.prim_visibility, keep_bvh);
   }
   if (pack.prim_index.size()) {
-    dscene->prim_index.steal_data(pack.prim_index);
-    dscene->prim_index.copy_to_device();
+    bvh_array_copy_to_device(dscene->prim_index, pack.prim_index, keep_bvh);
   }
   if (pack.prim_object.size()) {
-    dscene->prim_object.steal_data(pack.prim_object);
-    dscene->prim_object.copy_to_device();
+    bvh_array_copy_to_device(dscene->prim_object, pack.prim_object, keep_bvh);
   }
   if (pack.prim_time.size()) {
-    dscene->prim_time.steal_data(pack.prim_time);
-    dscene->prim_time.copy_to_device();
+    bvh_array_copy_to_device(dscene->prim_time, pack.prim_time, keep_bvh);
   }
 
   dscene->data.bvh.root = pack.root_index;
@@ -1096,7 +1287,166 @@ void GeometryManager::device_update_bvh(Device *device,
 
   bvh->copy_to_device(progress, dscene);
 
-  delete bvh;
+  if (keep_bvh) {
+    bvh_object_id.resize(scene->objects.size());
+    bvh_geometry_id.resize(scene->geometry.size());
+    bvh_object_prim_offset.resize(scene->objects.size());
+    for (size_t i = 0; i < scene->geometry.size(); i++) {
+      bvh_geometry_id[i] = scene->geometry[i]->id;
+    }
+    for (size_t i = 0; i < scene->objects.size(); i++) {
+      bvh_object_id[i] = scene->objects[i]->id;
+      Geometry *geom = scene->objects[i]->geometry;
+      bvh_object_prim_offset[i] = geom->need_build_bvh(bparams.bvh_layout) ? -1 :
+                                                                              geom->prim_offset;
+    }
+  }
+  else {
+    delete bvh;
+    bvh = NULL;
+  }
+}
+
+/* Hash only the xyz components, the padding of float3 is not guaranteed to be initialized. */
+static void bvh_hash_append_float3(MD5Hash &md5, const float3 *data, size_t size)
+{
+  const size_t chunk_size = 1024;
+  float chunk[chunk_size * 3];
+
+  for (size_t offset = 0; offset < size; offset += chunk_size) {
+    const size_t num = std::min(chunk_size, size - offset);
+    for (size_t i = 0; i < num; i++) {
+      chunk[i * 3 + 0] = data[offset + i].x;
+      chunk[i * 3 + 1] = data[offset + i].y;
+      chunk[i * 3 + 2] = data[offset + i].z;
+    }
+    md5.append((const uint8_t *)chunk, num * 3 * sizeof(float));
+  }
+}
+
+template<typename T> static void bvh_hash_append_array(MD5Hash &md5, const array<T> &data)
+{
+  const uint8_t *bytes = (const uint8_t *)data.data();
+  const size_t size = data.size() * sizeof(T);
+  const size_t chunk_size = 1 << 30;
+
+  for (size_t offset = 0; offset < size; offset += chunk_size) {
+    md5.append(bytes + offset, std::min(chunk_size, size - offset));
+  }
+}
+
+static void geometry_bvh_hash(Geometry *geom, const string &prefix)
+{
+  MD5Hash md5;
+  md5.append(prefix);
+  md5.append(
+      string_printf("%d %u %d", (int)geom->type, geom->motion_steps, geom->use_motion_blur));
+
+  if (geom->type == Geometry::MESH) {
+    Mesh *mesh = static_cast<Mesh *>(geom);
+    bvh_hash_append_float3(md5, mesh->verts.data(), mesh->verts.size());
+    bvh_hash_append_array(md5, mesh->triangles);
+  }
+  else if (geom->type == Geometry::HAIR) {
+    Hair *hair = static_cast<Hair *>(geom);
+    md5.append(string_printf("%d", (int)hair->curve_shape));
+    bvh_hash_append_float3(md5, hair->curve_keys.data(), hair->curve_keys.size());
+    bvh_hash_append_array(md5, hair->curve_radius);
+    bvh_hash_append_array(md5, hair->curve_first_key);
+  }
+
+  Attribute *attr_mP = geom->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
+  if (attr_mP) {
+    /* Curve motion keys store the radius in the fourth component. */
+    if (geom->type == Geometry::HAIR) {
+      md5.append((const uint8_t *)attr_mP->buffer.data(), attr_mP->buffer.size());
+    }
+    else {
+      bvh_hash_append_float3(md5, attr_mP->data_float3(), attr_mP->buffer.size() / sizeof(float3));
+    }
+  }
+
+  geom->bvh_hash = md5.get_hex();
+}
+
+void GeometryManager::reuse_persistent_bvh(Device *device,
+                                           DeviceScene *dscene,
+                                           Scene *scene,
+                                           Progress &progress)
+{
+  const BVHLayout bvh_layout = BVHParams::best_bvh_layout(scene->params.bvh_layout,
+                                                          device->get_bvh_layout_mask());
+
+  /* OptiX acceleration structures live on the device and embed the primitive offsets of the
+   * current scene, so only BVHs built on the host are kept. */
+  if (!scene->params.persistent_data || bvh_layout == BVH_LAYOUT_OPTIX) {
+    persistent_bvh_free(persistent_bvh);
+    return;
+  }
+
+  /* Everything compute_bvh() passes to the BVH build, so a different setting never reuses
+   * a BVH built with other parameters. */
+  const string prefix = string_printf(
+      "%d %d %d %d %d %d ",
+      (int)bvh_layout,
+      (int)scene->params.use_bvh_spatial_split,
+      (int)(dscene->data.bvh.have_curves && scene->params.use_bvh_unaligned_nodes),
+      scene->params.num_bvh_time_steps,
+      (int)scene->params.bvh_type,
+      scene->params.curve_subdivisions());
+
+  progress.set_status("Updating Geometry BVH", "Looking up persistent BVHs");
+
+  /* Static transforms were applied by the object manager already. Geometry they were applied
+   * to has its primitives in the top level BVH, unless it still needs its own BVH, in which case
+   * the hash is computed from the transformed positions that BVH is built from. */
+  TaskPool pool;
+  foreach (Geometry *geom, scene->geometry) {
+    if (geom->need_update && geom->need_build_bvh(bvh_layout)) {
+      pool.push(function_bind(&geometry_bvh_hash, geom, prefix));
+    }
+  }
+  pool.wait_work();
+
+  size_t num_reused = 0;
+  foreach (Geometry *geom, scene->geometry) {
+    if (!geom->need_update || !geom->need_build_bvh(bvh_layout) || geom->bvh) {
+      continue;
+    }
+
+    map<string, BVH *>::iterator it = persistent_bvh.find(geom->bvh_hash);
+    if (it == persistent_bvh.end()) {
+      continue;
+    }
+
+    geom->bvh = it->second;
+    geom->bvh->geometry.clear();
+    geom->bvh->geometry.push_back(geom);
+    persistent_bvh.erase(it);
+
+    /* Same as compute_bvh() without the build. */
+    geom->compute_bounds();
+    geom->need_update = false;
+    geom->need_update_rebuild = false;
+    num_reused++;
+  }
+
+  VLOG(1) << "Reused " << num_reused << " persistent geometry BVHs, freeing "
+          << persistent_bvh.size() << " unused ones.";
+
+  /* Geometry which changed or was removed does not come back. */
+  persistent_bvh_free(persistent_bvh);
+}
+
+void GeometryManager::store_persistent_bvh(Scene *scene)
+{
+  foreach (Geometry *geom, scene->geometry) {
+    if (geom->bvh && !geom->bvh_hash.empty() &&
+        persistent_bvh.find(geom->bvh_hash) == persistent_bvh.end()) {
+      persistent_bvh[geom->bvh_hash] = geom->bvh;
+      geom->bvh = NULL;
+    }
+  }
 }
 
 void GeometryManager::device_update_preprocess(Device *device, Scene *scene, Progress &progress)
@@ -1352,6 +1702,19 @@ void GeometryManager::device_update(Device *device,
       return;
   }
 
+  /* Changed primitives of geometry without own BVH require a top level BVH build,
+   * compute_bvh() clears the flags. */
+  bool need_bvh_rebuild = false;
+  foreach (Geometry *geom, scene->geometry) {
+    if (geom->need_update_rebuild && !geom->need_build_bvh(bvh_layout)) {
+      need_bvh_rebuild = true;
+    }
+  }
+
+  reuse_persistent_bvh(device, dscene, scene, progress);
+  if (progress.get_cancel())
+    return;
+
   TaskPool pool;
 
   size_t i = 0;
@@ -1385,7 +1748,7 @@ void GeometryManager::device_update(Device *device,
   if (progress.get_cancel())
     return;
 
-  device_update_bvh(device, dscene, scene, progress);
+  device_update_bvh(device, dscene, scene, need_bvh_rebuild, progress);
   if (progress.get_cancel())
     return;
 
@@ -1428,6 +1791,7 @@ void GeometryManager::device_free(Device *device, DeviceScene *dscene)
   dscene->prim_time.free();
   dscene->tri_shader.free();
   dscene->tri_vnormal.free();
+  dscene->tri_vnormal_packed.free();
   dscene->tri_vindex.free();
   dscene->tri_patch.free();
   dscene->tri_patch_uv.free();
@@ -1437,6 +1801,7 @@ void GeometryManager::device_free(Device *device, DeviceScene *dscene)
   dscene->attributes_map.free();
   dscene->attributes_float.free();
   dscene->attributes_float2.free();
+  dscene->attributes_unorm2.free();
   dscene->attributes_float3.free();
   dscene->attributes_uchar4.free();
 
@@ -1468,6 +1833,17 @@ void GeometryManager::collect_statistics(const Scene *scene, RenderStats *stats)
     stats->mesh.geometry.add_entry(
         NamedSizeEntry(string(geometry->name.c_str()), geometry->get_total_size_in_bytes()));
   }
+
+  const DeviceScene &dscene = scene->dscene;
+  if (dscene.tri_vnormal_packed.data_size) {
+    stats->mesh.compressed.add_entry(NamedSizeEntry(
+        "Vertex normals", dscene.tri_vnormal_packed.data_size * (sizeof(float4) - sizeof(uint))));
+  }
+  if (dscene.attributes_unorm2.data_size) {
+    stats->mesh.compressed.add_entry(
+        NamedSizeEntry("Float2 attributes",
+                       dscene.attributes_unorm2.data_size * (sizeof(float2) - sizeof(uint))));
+  }
 }
 
 CCL_NAMESPACE_END
@@ -24,6 +24,7 @@
 #include "render/attribute.h"
 
 #include "util/util_boundbox.h"
+#include "util/util_map.h"
 #include "util/util_set.h"
 #include "util/util_transform.h"
 #include "util/util_types.h"
@@ -80,6 +81,10 @@ class Geometry : public Node {
   size_t attr_map_offset;
   size_t prim_offset;
   size_t optix_prim_offset;
+  /* Hash of the data the BVH was built from, for reuse across persistent data renders. */
+  string bvh_hash;
+  /* Unique identifier, unlike the address it is never reused by a later geometry. */
+  uint64_t id;
 
   /* Shader Properties */
   bool has_volume;         /* Set in the device_update_flags(). */
@@ -148,6 +153,18 @@ class GeometryManager {
   bool need_update;
   bool need_flags_update;
 
+  /* Top level BVH of the last update, kept for dynamic BVHs so it can be refit when
+   * objects only moved, along with the identifiers of the objects and geometry it was built
+   * from and the primitive offset of every object's geometry in it (-1 for instanced
+   * geometry with its own BVH). */
+  BVH *bvh;
+  vector<uint64_t> bvh_object_id;
+  vector<uint64_t> bvh_geometry_id;
+  vector<int> bvh_object_prim_offset;
+
+  /* Geometry BVHs kept from the previous render with persistent data, by BVH hash. */
+  map<string, BVH *> persistent_bvh;
+
   /* Constructor/Destructor */
   GeometryManager();
   ~GeometryManager();
@@ -160,6 +177,12 @@ class GeometryManager {
   /* Updates */
   void tag_update(Scene *scene);
 
+  /* Persistent Data
+   *
+   * Take over the BVHs of the scene geometry before it is freed, so that the next
+   * render can skip building them for geometry which did not change. */
+  void store_persistent_bvh(Scene *scene);
+
   /* Statistics */
   void collect_statistics(const Scene *scene, RenderStats *stats);
 
@@ -193,7 +216,13 @@ class GeometryManager {
                                 Scene *scene,
                                 Progress &progress);
 
-  void device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
+  void device_update_bvh(Device *device,
+                         DeviceScene *dscene,
+                         Scene *scene,
+                         bool need_rebuild,
+                         Progress &progress);
+  bool can_refit_bvh(Scene *scene, const BVHParams &bparams);
+  void reuse_persistent_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress &progress);
 
   void device_update_displacement_images(Device *device, Scene *scene, Progress &progress);
 
@@ -775,6 +775,30 @@ void ShaderGraph::compute_displacement_hash()
   displacement_hash = md5.get_hex();
 }
 
+void ShaderGraph::compute_compile_hash()
+{
+  /* Compute hash of the entire graph before it is finalized, so shaders with identical
+   * graphs can share the compiled SVM program. Left empty if any node can't be shared. */
+  MD5Hash md5;
+  foreach (ShaderNode *node, nodes) {
+    node->hash(md5);
+    foreach (ShaderInput *input, node->inputs) {
+      int link_id = (input->link) ? input->link->parent->id : 0;
+      md5.append((uint8_t *)&link_id, sizeof(link_id));
+      if (input->link) {
+        md5.append(input->link->name().string());
+      }
+    }
+
+    if (!node->compile_hash(md5)) {
+      compile_hash = "";
+      return;
+    }
+  }
+
+  compile_hash = md5.get_hex();
+}
+
 void ShaderGraph::clean(Scene *scene)
 {
   /* Graph simplification */
@@ -220,6 +220,15 @@ class ShaderNode : public Node {
   {
     return false;
   }
+
+  /* Hash state used by SVM compilation that is not stored in sockets, like image slots.
+   * Returns false if compilation depends on scene state or modifies it, in which case the
+   * compiled shader can not be shared with other shaders. */
+  virtual bool compile_hash(MD5Hash & /*md5*/)
+  {
+    return true;
+  }
+
   vector<ShaderInput *> inputs;
   vector<ShaderOutput *> outputs;
 
@@ -319,6 +328,7 @@ class ShaderGraph {
   bool finalized;
   bool simplified;
   string displacement_hash;
+  string compile_hash;
 
   ShaderGraph();
   ~ShaderGraph();
@@ -335,6 +345,7 @@ class ShaderGraph {
 
   void remove_proxy_nodes();
   void compute_displacement_hash();
+  void compute_compile_hash();
   void simplify(Scene *scene);
   void finalize(Scene *scene,
                 bool do_bump = false,
@@ -17,6 +17,7 @@
 #include "render/image.h"
 #include "device/device.h"
 #include "render/colorspace.h"
+#include "render/image_cache.h"
 #include "render/image_oiio.h"
 #include "render/scene.h"
 #include "render/stats.h"
@@ -162,6 +163,17 @@ int ImageHandle::svm_slot(const int tile_index) const
   return tile_slots[tile_index];
 }
 
+bool ImageHandle::use_image_cache() const
+{
+  foreach (int slot, tile_slots) {
+    if (manager->image_use_cache(manager->images[slot])) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 device_texture *ImageHandle::image_memory(const int tile_index) const
 {
   if (tile_index >= tile_slots.size()) {
@@ -281,6 +293,11 @@ void ImageManager::set_osl_texture_system(void *texture_system)
   osl_texture_system = texture_system;
 }
 
+void ImageManager::set_image_cache(int max_memory_mb)
+{
+  image_cache.reset(new ImageCache(max_memory_mb));
+}
+
 bool ImageManager::set_animation_frame_update(int frame)
 {
   if (frame != animation_frame) {
@@ -410,6 +427,7 @@ int ImageManager::add_image_slot(ImageLoader *loader,
   img->builtin = builtin;
   img->users = 1;
   img->mem = NULL;
+  img->cache_lookup = NULL;
 
   images[slot] = img;
 
@@ -452,6 +470,32 @@ static bool image_associate_alpha(ImageManager::Image *img)
            img->params.alpha_type == IMAGE_ALPHA_CHANNEL_PACKED);
 }
 
+bool ImageManager::image_use_cache(Image *img)
+{
+  if (!image_cache || osl_texture_system || img->loader->osl_filepath().empty()) {
+    return false;
+  }
+
+  load_image_metadata(img);
+  const ImageMetaData &metadata = img->metadata;
+
+  /* The texture system returns the file pixels with associated alpha, only use it
+   * for 2D images that need no other processing to match a full load. */
+  if (metadata.depth > 1 || metadata.channels < 1 || metadata.channels > 4) {
+    return false;
+  }
+  const bool has_alpha = (metadata.channels == 2 || metadata.channels == 4);
+  if (has_alpha && !image_associate_alpha(img)) {
+    return false;
+  }
+  /* Converted to scene linear and then compressed as sRGB, not worth doing per lookup. */
+  if (metadata.compress_as_srgb && metadata.colorspace != u_colorspace_srgb) {
+    return false;
+  }
+
+  return true;
+}
+
 template<TypeDesc::BASETYPE FileFormat, typename StorageType>
 bool ImageManager::file_load_image(Image *img, int texture_limit)
 {
@@ -632,14 +676,35 @@ void ImageManager::device_load_image(Device *device, Scene *scene, int slot, Pro
     delete img->mem;
     img->mem = NULL;
   }
+  if (img->cache_lookup) {
+    image_cache->remove_image(img->cache_lookup);
+    img->cache_lookup = NULL;
+  }
 
   img->mem = new device_texture(
       device, img->mem_name.c_str(), slot, type, img->params.interpolation, img->params.extension);
   img->mem->info.use_transform_3d = img->metadata.use_transform_3d;
   img->mem->info.transform_3d = img->metadata.transform_3d;
 
+  /* Read through the image cache as the kernel samples it, with only a placeholder
+   * pixel in memory. */
+  if (image_use_cache(img)) {
+    img->cache_lookup = image_cache->add_image(
+        img->loader->osl_filepath(), img->params, img->metadata);
+  }
+
+  if (img->cache_lookup) {
+    thread_scoped_lock device_lock(device_mutex);
+    void *pixels = img->mem->alloc(1, 1);
+    memset(pixels, 0, img->mem->memory_size());
+    img->mem->info.cache = (uint64_t)img->cache_lookup;
+  }
+
   /* Create new texture. */
-  if (type == IMAGE_DATA_TYPE_FLOAT4) {
+  if (img->cache_lookup) {
+    /* Nothing to load. */
+  }
+  else if (type == IMAGE_DATA_TYPE_FLOAT4) {
     if (!file_load_image<TypeDesc::FLOAT, float>(img, texture_limit)) {
       /* on failure to load, we set a 1x1 pixels pink image */
       thread_scoped_lock device_lock(device_mutex);
@@ -755,6 +820,10 @@ void ImageManager::device_free_image(Device *, int slot)
     delete img->mem;
   }
 
+  if (img->cache_lookup) {
+    image_cache->remove_image(img->cache_lookup);
+  }
+
   delete img->loader;
   delete img;
   images[slot] = NULL;
@@ -840,6 +909,10 @@ void ImageManager::collect_statistics(RenderStats *stats)
     stats->image.textures.add_entry(
         NamedSizeEntry(image->loader->name(), image->mem->memory_size()));
   }
+
+  if (image_cache) {
+    image_cache->collect_statistics(&stats->image);
+  }
 }
 
 CCL_NAMESPACE_END
@@ -31,6 +31,7 @@ CCL_NAMESPACE_BEGIN
 
 class Device;
 class DeviceInfo;
+class ImageCache;
 class ImageHandle;
 class ImageKey;
 class ImageMetaData;
@@ -114,7 +115,7 @@ class ImageLoader {
   /* Name for logs and stats. */
   virtual string name() const = 0;
 
-  /* Optional for OSL texture cache. */
+  /* Optional for OSL texture cache, and the image cache on the CPU. */
   virtual ustring osl_filepath() const;
 
   /* Free any memory used for loading metadata and pixels. */
@@ -147,6 +148,7 @@ class ImageHandle {
 
   ImageMetaData metadata();
   int svm_slot(const int tile_index = 0) const;
+  bool use_image_cache() const;
   device_texture *image_memory(const int tile_index = 0) const;
 
  protected:
@@ -179,6 +181,7 @@ class ImageManager {
   void device_free_builtin(Device *device);
 
   void set_osl_texture_system(void *texture_system);
+  void set_image_cache(int max_memory_mb);
   bool set_animation_frame_update(int frame);
 
   void collect_statistics(RenderStats *stats);
@@ -197,6 +200,7 @@ class ImageManager {
 
     string mem_name;
     device_texture *mem;
+    ImageCacheLookup *cache_lookup;
 
     int users;
     thread_mutex mutex;
@@ -211,12 +215,14 @@ class ImageManager {
 
   vector<Image *> images;
   void *osl_texture_system;
+  unique_ptr<ImageCache> image_cache;
 
   int add_image_slot(ImageLoader *loader, const ImageParams &params, const bool builtin);
   void add_image_user(int slot);
   void remove_image_user(int slot);
 
   void load_image_metadata(Image *img);
+  bool image_use_cache(Image *img);
 
   template<TypeDesc::BASETYPE FileFormat, typename StorageType>
   bool file_load_image(Image *img, int texture_limit);
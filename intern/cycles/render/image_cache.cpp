@@ -0,0 +1,189 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/image_cache.h"
+#include "render/colorspace.h"
+#include "render/image.h"
+#include "render/stats.h"
+
+#include "util/util_logging.h"
+
+#include <OpenImageIO/texture.h>
+
+CCL_NAMESPACE_BEGIN
+
+OIIO_NAMESPACE_USING
+
+/* Lookup of a single image file in the texture system. */
+
+class ImageCacheFile : public ImageCacheLookup {
+ public:
+  ImageCacheFile(TextureSystem *texture_system,
+                 TextureSystem::TextureHandle *handle,
+                 ustring filepath,
+                 ColorSpaceProcessor *processor)
+      : texture_system(texture_system), handle(handle), filepath(filepath), processor(processor)
+  {
+  }
+
+  float4 lookup(float x, float y, float2 dx, float2 dy) override
+  {
+    /* Options are modified by the lookup, so use a copy. */
+    TextureOpt lookup_options = options;
+    float result[4];
+
+    /* Kernel textures are stored bottom to top, while t goes from the top in
+     * OpenImageIO, so flip the coordinate and its differentials. */
+    if (!texture_system->texture(handle,
+                                 texture_system->get_perthread_info(),
+                                 lookup_options,
+                                 x,
+                                 1.0f - y,
+                                 dx.x,
+                                 -dx.y,
+                                 dy.x,
+                                 -dy.y,
+                                 4,
+                                 result)) {
+      /* Clear the error so it does not accumulate. */
+      texture_system->geterror();
+      return make_float4(
+          TEX_IMAGE_MISSING_R, TEX_IMAGE_MISSING_G, TEX_IMAGE_MISSING_B, TEX_IMAGE_MISSING_A);
+    }
+
+    if (processor) {
+      ColorSpaceManager::to_scene_linear(processor, result, 4);
+    }
+
+    return make_float4(result[0], result[1], result[2], result[3]);
+  }
+
+  TextureSystem *texture_system;
+  TextureSystem::TextureHandle *handle;
+  TextureOpt options;
+  ustring filepath;
+  ColorSpaceProcessor *processor;
+};
+
+static TextureOpt::InterpMode image_cache_interp_mode(InterpolationType interpolation)
+{
+  switch (interpolation) {
+    case INTERPOLATION_CLOSEST:
+      return TextureOpt::InterpClosest;
+    case INTERPOLATION_CUBIC:
+    case INTERPOLATION_SMART:
+      return TextureOpt::InterpBicubic;
+    case INTERPOLATION_LINEAR:
+    default:
+      return TextureOpt::InterpBilinear;
+  }
+}
+
+static TextureOpt::Wrap image_cache_wrap_mode(ExtensionType extension)
+{
+  switch (extension) {
+    case EXTENSION_REPEAT:
+      return TextureOpt::WrapPeriodic;
+    case EXTENSION_EXTEND:
+      return TextureOpt::WrapClamp;
+    case EXTENSION_CLIP:
+    default:
+      return TextureOpt::WrapBlack;
+  }
+}
+
+/* Image Cache */
+
+ImageCache::ImageCache(int max_memory_mb)
+{
+  /* Not shared with OSL, so the memory budget applies to SVM images only. */
+  TextureSystem *ts = TextureSystem::create(false);
+
+  ts->attribute("automip", 1);
+  ts->attribute("autotile", 64);
+  ts->attribute("gray_to_rgb", 1);
+  ts->attribute("max_memory_MB", (float)max_memory_mb);
+
+  texture_system = ts;
+}
+
+ImageCache::~ImageCache()
+{
+  TextureSystem *ts = (TextureSystem *)texture_system;
+  ts->invalidate_all(true);
+  TextureSystem::destroy(ts);
+}
+
+ImageCacheLookup *ImageCache::add_image(ustring filepath,
+                                        const ImageParams &params,
+                                        const ImageMetaData &metadata)
+{
+  TextureSystem *ts = (TextureSystem *)texture_system;
+
+  TextureSystem::TextureHandle *handle = ts->get_texture_handle(filepath);
+  if (handle == NULL || !ts->good(handle)) {
+    ts->geterror();
+    return NULL;
+  }
+
+  /* Same color space conversion as done when loading the full image, sRGB is
+   * left for the kernel to convert. */
+  ColorSpaceProcessor *processor = NULL;
+  if (metadata.channels > 1 && metadata.colorspace != u_colorspace_raw &&
+      metadata.colorspace != u_colorspace_srgb) {
+    processor = ColorSpaceManager::get_processor(metadata.colorspace);
+  }
+
+  ImageCacheFile *file = new ImageCacheFile(ts, handle, filepath, processor);
+  file->options.interpmode = image_cache_interp_mode(params.interpolation);
+  file->options.swrap = image_cache_wrap_mode(params.extension);
+  file->options.twrap = file->options.swrap;
+  /* Opaque alpha for images without an alpha channel. */
+  file->options.fill = 1.0f;
+
+  VLOG(1) << "Reading " << filepath.string() << " through the image cache.";
+
+  return file;
+}
+
+void ImageCache::remove_image(ImageCacheLookup *lookup)
+{
+  TextureSystem *ts = (TextureSystem *)texture_system;
+  ImageCacheFile *file = (ImageCacheFile *)lookup;
+
+  ts->invalidate(file->filepath);
+  delete file;
+}
+
+void ImageCache::collect_statistics(ImageStats *stats)
+{
+  TextureSystem *ts = (TextureSystem *)texture_system;
+
+  long long tile_lookups = 0, bytes_loaded = 0, memory_used = 0;
+  int tile_misses = 0;
+  ts->getattribute("stat:find_tile_calls", TypeDesc::INT64, &tile_lookups);
+  ts->getattribute("stat:find_tile_cache_misses", TypeDesc::INT, &tile_misses);
+  ts->getattribute("stat:bytes_read", TypeDesc::INT64, &bytes_loaded);
+  ts->getattribute("stat:cache_memory_used", TypeDesc::INT64, &memory_used);
+
+  stats->use_cache = true;
+  stats->cache_tile_lookups = tile_lookups;
+  stats->cache_tile_misses = tile_misses;
+  stats->cache_bytes_loaded = bytes_loaded;
+  stats->cache_memory_used = memory_used;
+}
+
+CCL_NAMESPACE_END
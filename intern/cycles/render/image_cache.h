@@ -0,0 +1,55 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __IMAGE_CACHE_H__
+#define __IMAGE_CACHE_H__
+
+#include "util/util_param.h"
+#include "util/util_texture.h"
+
+CCL_NAMESPACE_BEGIN
+
+class ImageMetaData;
+class ImageParams;
+class ImageStats;
+
+/* Image Cache
+ *
+ * Out of core image textures for the CPU device. Instead of loading all pixels
+ * at device update, images are read through the OpenImageIO texture system in
+ * tiles of automatically generated mipmap levels, as they are sampled by the
+ * kernel. The level is selected from the ray differentials, and the tiles are
+ * kept within a fixed memory budget. */
+class ImageCache {
+ public:
+  explicit ImageCache(int max_memory_mb);
+  ~ImageCache();
+
+  /* Create lookup for an image file, returns NULL if it can not be opened. */
+  ImageCacheLookup *add_image(ustring filepath,
+                              const ImageParams &params,
+                              const ImageMetaData &metadata);
+  void remove_image(ImageCacheLookup *lookup);
+
+  void collect_statistics(ImageStats *stats);
+
+ protected:
+  void *texture_system;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __IMAGE_CACHE_H__ */
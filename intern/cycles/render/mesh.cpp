@@ -606,6 +606,48 @@ void Mesh::pack_normals(float4 *vnormal)
   }
 }
 
+/* Octahedral encoding with 16 bits per component, decoded by triangle_vertex_normal() in the
+ * kernel. */
+static uint encode_octahedral_normal(const float3 N)
+{
+  const float sum = fabsf(N.x) + fabsf(N.y) + fabsf(N.z);
+  float x = (sum > 0.0f) ? N.x / sum : 0.0f;
+  float y = (sum > 0.0f) ? N.y / sum : 0.0f;
+  if (N.z < 0.0f) {
+    const float fold_x = (1.0f - fabsf(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+    y = (1.0f - fabsf(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+    x = fold_x;
+  }
+
+  const uint ux = (uint)(saturate(x * 0.5f + 0.5f) * 65535.0f + 0.5f);
+  const uint uy = (uint)(saturate(y * 0.5f + 0.5f) * 65535.0f + 0.5f);
+  return ux | (uy << 16);
+}
+
+void Mesh::pack_normals_compressed(uint *vnormal)
+{
+  Attribute *attr_vN = attributes.find(ATTR_STD_VERTEX_NORMAL);
+  if (attr_vN == NULL) {
+    /* Happens on objects with just hair. */
+    return;
+  }
+
+  bool do_transform = transform_applied;
+  Transform ntfm = transform_normal;
+
+  float3 *vN = attr_vN->data_float3();
+  size_t verts_size = verts.size();
+
+  for (size_t i = 0; i < verts_size; i++) {
+    float3 vNi = vN[i];
+
+    if (do_transform)
+      vNi = safe_normalize(transform_direction(&ntfm, vNi));
+
+    vnormal[i] = encode_octahedral_normal(vNi);
+  }
+}
+
 void Mesh::pack_verts(const vector<uint> &tri_prim_index,
                       uint4 *tri_vindex,
                       uint *tri_patch,
@@ -31,6 +31,7 @@
 
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
+#include "util/util_md5.h"
 #include "util/util_transform.h"
 
 #include "kernel/svm/svm_color_util.h"
@@ -206,6 +207,36 @@ void TextureMapping::compile(OSLCompiler &compiler)
   }
 }
 
+/* Image Slot Texture */
+
+/* Compiling adds the image if the node does not reference one yet, so only nodes with an image
+ * can share compiled shaders. Flags of the compiled node come from the image metadata, which
+ * can change while the slots stay the same, for example when the image is reloaded. */
+static bool image_handle_compile_hash(ImageHandle &handle, MD5Hash &md5)
+{
+  if (handle.empty()) {
+    return false;
+  }
+
+  for (int i = 0; i < handle.num_tiles(); i++) {
+    const int slot = handle.svm_slot(i);
+    md5.append((uint8_t *)&slot, sizeof(slot));
+  }
+
+  const ImageMetaData metadata = handle.metadata();
+  const uint8_t compress_as_srgb = metadata.compress_as_srgb;
+  const int type = metadata.type;
+  md5.append(&compress_as_srgb, sizeof(compress_as_srgb));
+  md5.append((uint8_t *)&type, sizeof(type));
+  md5.append(metadata.colorspace.string());
+  return true;
+}
+
+bool ImageSlotTextureNode::compile_hash(MD5Hash &md5)
+{
+  return image_handle_compile_hash(handle, md5);
+}
+
 /* Image Texture */
 
 NODE_DEFINE(ImageTextureNode)
@@ -388,6 +419,24 @@ void ImageTextureNode::compile(SVMCompiler &compiler)
       flags |= NODE_IMAGE_ALPHA_UNASSOCIATE;
     }
   }
+  if (projection == NODE_IMAGE_PROJ_FLAT && tex_mapping.skip() && vector_in->link &&
+      handle.use_image_cache()) {
+    /* Cached images select the mipmap level from the differentials of the default UV
+     * map, which only match when it is used directly as texture coordinate. */
+    ShaderNode *node = vector_in->link->parent;
+    if (node->type == UVMapNode::node_type) {
+      UVMapNode *uvmap = (UVMapNode *)node;
+      if (uvmap->attribute.empty() && !uvmap->from_dupli) {
+        flags |= NODE_IMAGE_UV_DIFFERENTIALS;
+      }
+    }
+    else if (node->type == TextureCoordinateNode::node_type) {
+      TextureCoordinateNode *texco = (TextureCoordinateNode *)node;
+      if (vector_in->link == node->output("UV") && !texco->from_dupli) {
+        flags |= NODE_IMAGE_UV_DIFFERENTIALS;
+      }
+    }
+  }
 
   if (projection != NODE_IMAGE_PROJ_BOX) {
     /* If there only is one image (a very common case), we encode it as a negative value. */
@@ -817,6 +866,12 @@ SkyTextureNode::SkyTextureNode() : TextureNode(node_type)
 {
 }
 
+bool SkyTextureNode::compile_hash(MD5Hash &md5)
+{
+  /* Only the Nishita model uses a precomputed image. */
+  return (type != NODE_SKY_NISHITA) || image_handle_compile_hash(handle, md5);
+}
+
 void SkyTextureNode::compile(SVMCompiler &compiler)
 {
   ShaderInput *vector_in = input("Vector");
@@ -1782,6 +1837,11 @@ PointDensityTextureNode::~PointDensityTextureNode()
 {
 }
 
+bool PointDensityTextureNode::compile_hash(MD5Hash &md5)
+{
+  return image_handle_compile_hash(handle, md5);
+}
+
 ShaderNode *PointDensityTextureNode::clone() const
 {
   /* Increase image user count for new node. We need to ensure to not call
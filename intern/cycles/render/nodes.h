@@ -86,6 +86,8 @@ class ImageSlotTextureNode : public TextureNode {
     return TextureNode::equals(other) && handle == other_node.handle;
   }
 
+  virtual bool compile_hash(MD5Hash &md5);
+
   ImageHandle handle;
 };
 
@@ -164,6 +166,8 @@ class SkyTextureNode : public TextureNode {
     return NODE_GROUP_LEVEL_2;
   }
 
+  virtual bool compile_hash(MD5Hash &md5);
+
   NodeSkyType type;
   float3 sun_direction;
   float turbidity;
@@ -218,6 +222,12 @@ class OutputAOVNode : public ShaderNode {
     return false;
   }
 
+  /* The slot depends on the film passes, which may change without the graph changing. */
+  virtual bool compile_hash(MD5Hash & /*md5*/)
+  {
+    return false;
+  }
+
   int slot;
   bool is_color;
 };
@@ -387,6 +397,8 @@ class PointDensityTextureNode : public ShaderNode {
     const PointDensityTextureNode &other_node = (const PointDensityTextureNode &)other;
     return ShaderNode::equals(other) && handle == other_node.handle;
   }
+
+  virtual bool compile_hash(MD5Hash &md5);
 };
 
 class IESLightNode : public TextureNode {
@@ -400,6 +412,12 @@ class IESLightNode : public TextureNode {
     return NODE_GROUP_LEVEL_2;
   }
 
+  /* Compiling registers the IES data with the light manager for this node. */
+  virtual bool compile_hash(MD5Hash & /*md5*/)
+  {
+    return false;
+  }
+
   ustring filename;
   ustring ies;
 
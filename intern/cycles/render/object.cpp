@@ -25,6 +25,7 @@
 #include "render/particles.h"
 #include "render/scene.h"
 
+#include "util/util_atomic.h"
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_map.h"
@@ -108,8 +109,11 @@ NODE_DEFINE(Object)
   return type;
 }
 
+static uint64_t object_id_counter = 0;
+
 Object::Object() : Node(node_type)
 {
+  id = atomic_add_and_fetch_uint64(&object_id_counter, 1);
   particle_system = NULL;
   particle_index = 0;
   bounds = BoundBox::empty;
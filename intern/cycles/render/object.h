@@ -67,6 +67,9 @@ class Object : public Node {
   ParticleSystem *particle_system;
   int particle_index;
 
+  /* Unique identifier, unlike the address it is never reused by a later object. */
+  uint64_t id;
+
   Object();
   ~Object();
 
@@ -53,6 +53,7 @@ DeviceScene::DeviceScene(Device *device)
       prim_time(device, "__prim_time", MEM_GLOBAL),
       tri_shader(device, "__tri_shader", MEM_GLOBAL),
       tri_vnormal(device, "__tri_vnormal", MEM_GLOBAL),
+      tri_vnormal_packed(device, "__tri_vnormal_packed", MEM_GLOBAL),
       tri_vindex(device, "__tri_vindex", MEM_GLOBAL),
       tri_patch(device, "__tri_patch", MEM_GLOBAL),
       tri_patch_uv(device, "__tri_patch_uv", MEM_GLOBAL),
@@ -68,6 +69,7 @@ DeviceScene::DeviceScene(Device *device)
       attributes_map(device, "__attributes_map", MEM_GLOBAL),
       attributes_float(device, "__attributes_float", MEM_GLOBAL),
       attributes_float2(device, "__attributes_float2", MEM_GLOBAL),
+      attributes_unorm2(device, "__attributes_unorm2", MEM_GLOBAL),
       attributes_float3(device, "__attributes_float3", MEM_GLOBAL),
       attributes_uchar4(device, "__attributes_uchar4", MEM_GLOBAL),
       light_distribution(device, "__light_distribution", MEM_GLOBAL),
@@ -107,6 +109,10 @@ Scene::Scene(const SceneParams &params_, Device *device)
   object_manager = new ObjectManager();
   integrator = new Integrator();
   image_manager = new ImageManager(device->info);
+  /* Out of core images are only supported on the CPU. */
+  if (params.use_texture_cache && device->info.type == DEVICE_CPU) {
+    image_manager->set_image_cache(params.texture_cache_size);
+  }
   particle_system_manager = new ParticleSystemManager();
   bake_manager = new BakeManager();
 
@@ -126,6 +132,9 @@ Scene::~Scene()
 
 void Scene::free_memory(bool final)
 {
+  if (params.persistent_data && !final)
+    geometry_manager->store_persistent_bvh(this);
+
   foreach (Shader *s, shaders)
     delete s;
   foreach (Geometry *g, geometry)
@@ -77,6 +77,7 @@ class DeviceScene {
   /* mesh */
   device_vector<uint> tri_shader;
   device_vector<float4> tri_vnormal;
+  device_vector<uint> tri_vnormal_packed;
   device_vector<uint4> tri_vindex;
   device_vector<uint> tri_patch;
   device_vector<float2> tri_patch_uv;
@@ -100,6 +101,7 @@ class DeviceScene {
   device_vector<uint4> attributes_map;
   device_vector<float> attributes_float;
   device_vector<float2> attributes_float2;
+  device_vector<uint> attributes_unorm2;
   device_vector<float4> attributes_float3;
   device_vector<uchar4> attributes_uchar4;
 
@@ -172,6 +174,12 @@ class SceneParams {
   CurveShapeType hair_shape;
   bool persistent_data;
   int texture_limit;
+  bool use_texture_cache;
+  int texture_cache_size;
+  /* Store vertex normals octahedral encoded and UV maps within 0..1 as 16 bit unorm, trading
+   * some precision for memory in very large scenes. Vertex positions keep full precision, since
+   * ray intersection must match the BVH bounds. */
+  bool use_compressed_geometry;
 
   bool background;
 
@@ -187,6 +195,9 @@ class SceneParams {
     hair_shape = CURVE_RIBBON;
     persistent_data = false;
     texture_limit = 0;
+    use_texture_cache = false;
+    texture_cache_size = 4096;
+    use_compressed_geometry = false;
     background = true;
   }
 
@@ -198,7 +209,10 @@ class SceneParams {
              use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes &&
              num_bvh_time_steps == params.num_bvh_time_steps &&
              hair_subdivisions == params.hair_subdivisions && hair_shape == params.hair_shape &&
-             persistent_data == params.persistent_data && texture_limit == params.texture_limit);
+             persistent_data == params.persistent_data && texture_limit == params.texture_limit &&
+             use_texture_cache == params.use_texture_cache &&
+             texture_cache_size == params.texture_cache_size &&
+             use_compressed_geometry == params.use_compressed_geometry);
   }
 
   int curve_subdivisions()
@@ -510,6 +510,12 @@ void Session::release_tile(RenderTile &rtile, const bool need_denoise)
 
   progress.add_finished_tile(rtile.task == RenderTile::DENOISE);
 
+  /* Per tile buffers measure the render time of just this tile, use it to estimate the cost of
+   * the tiles that are still queued. */
+  if (rtile.task != RenderTile::DENOISE && !buffers) {
+    tile_manager.add_tile_cost(rtile.tile_index, rtile.buffers->render_time);
+  }
+
   bool delete_tile;
 
   if (tile_manager.finish_tile(rtile.tile_index, need_denoise, delete_tile)) {
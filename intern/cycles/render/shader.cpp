@@ -278,6 +278,7 @@ void Shader::set_graph(ShaderGraph *graph_)
    * are connected but proxy nodes should not count */
   if (graph_) {
     graph_->remove_proxy_nodes();
+    graph_->compute_compile_hash();
 
     if (displacement_method != DISPLACE_BUMP) {
       graph_->compute_displacement_hash();
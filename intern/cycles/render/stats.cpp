@@ -207,12 +207,20 @@ string MeshStats::full_report(int indent_level)
   const string indent(indent_level * kIndentNumSpaces, ' ');
   string result = "";
   result += indent + "Geometry:\n" + geometry.full_report(indent_level + 1);
+  if (compressed.total_size) {
+    result += indent + "Saved by compression:\n" + compressed.full_report(indent_level + 1);
+  }
   return result;
 }
 
 /* Image statistics. */
 
 ImageStats::ImageStats()
+    : use_cache(false),
+      cache_tile_lookups(0),
+      cache_tile_misses(0),
+      cache_bytes_loaded(0),
+      cache_memory_used(0)
 {
 }
 
@@ -221,6 +229,18 @@ string ImageStats::full_report(int indent_level)
   const string indent(indent_level * kIndentNumSpaces, ' ');
   string result = "";
   result += indent + "Textures:\n" + textures.full_report(indent_level + 1);
+  if (use_cache) {
+    const string double_indent = indent + indent;
+    const double hit_rate = (cache_tile_lookups) ? 1.0 - (double)cache_tile_misses /
+                                                             (double)cache_tile_lookups :
+                                                   0.0;
+    result += indent + "Texture cache:\n";
+    result += double_indent + string_printf("Hit rate: %.2f%%\n", hit_rate * 100.0);
+    result += double_indent + "Bytes loaded: " + string_human_readable_size(cache_bytes_loaded) +
+              "\n";
+    result += double_indent + "Memory used: " + string_human_readable_size(cache_memory_used) +
+              "\n";
+  }
   return result;
 }
 
@@ -122,6 +122,10 @@ class MeshStats {
    * memory like BVH.
    */
   NamedSizeStats geometry;
+
+  /* Memory saved by storing geometry in compressed form on the device,
+   * see SceneParams::use_compressed_geometry. */
+  NamedSizeStats compressed;
 };
 
 /* Statistics about images held in memory. */
@@ -133,6 +137,13 @@ class ImageStats {
   string full_report(int indent_level = 0);
 
   NamedSizeStats textures;
+
+  /* Image cache, when images are read on demand rather than loaded fully. */
+  bool use_cache;
+  uint64_t cache_tile_lookups;
+  uint64_t cache_tile_misses;
+  uint64_t cache_bytes_loaded;
+  uint64_t cache_memory_used;
 };
 
 /* Render process statistics. */
@@ -18,6 +18,7 @@
 
 #include "render/background.h"
 #include "render/graph.h"
+#include "render/integrator.h"
 #include "render/light.h"
 #include "render/mesh.h"
 #include "render/nodes.h"
@@ -44,6 +45,60 @@ SVMShaderManager::~SVMShaderManager()
 
 void SVMShaderManager::reset(Scene * /*scene*/)
 {
+  compile_cache.clear();
+}
+
+void SVMShaderManager::CompiledShader::store_flags(const Shader *shader)
+{
+  has_surface = shader->has_surface;
+  has_surface_emission = shader->has_surface_emission;
+  has_surface_transparent = shader->has_surface_transparent;
+  has_surface_bssrdf = shader->has_surface_bssrdf;
+  has_bump = shader->has_bump;
+  has_bssrdf_bump = shader->has_bssrdf_bump;
+  has_volume = shader->has_volume;
+  has_displacement = shader->has_displacement;
+  has_surface_spatial_varying = shader->has_surface_spatial_varying;
+  has_volume_spatial_varying = shader->has_volume_spatial_varying;
+  has_volume_attribute_dependency = shader->has_volume_attribute_dependency;
+  has_integrator_dependency = shader->has_integrator_dependency;
+}
+
+void SVMShaderManager::CompiledShader::restore_flags(Shader *shader) const
+{
+  shader->has_surface = has_surface;
+  shader->has_surface_emission = has_surface_emission;
+  shader->has_surface_transparent = has_surface_transparent;
+  shader->has_surface_bssrdf = has_surface_bssrdf;
+  shader->has_bump = has_bump;
+  shader->has_bssrdf_bump = has_bssrdf_bump;
+  shader->has_volume = has_volume;
+  shader->has_displacement = has_displacement;
+  shader->has_surface_spatial_varying = has_surface_spatial_varying;
+  shader->has_volume_spatial_varying = has_volume_spatial_varying;
+  shader->has_volume_attribute_dependency = has_volume_attribute_dependency;
+  shader->has_integrator_dependency = has_integrator_dependency;
+}
+
+string SVMShaderManager::compile_cache_key(Scene *scene, Shader *shader)
+{
+  /* The background shader is never shared, since the background and light manager inspect its
+   * finalized graph. */
+  if (shader->graph->compile_hash.empty() || shader == scene->background->get_shader(scene)) {
+    return "";
+  }
+
+  /* Besides the graph, compilation depends on these shader settings. Nodes also simplify
+   * differently depending on integrator settings, which are part of the key for every shader
+   * since whether a graph depends on them is only known after it was compiled. */
+  const Integrator *integrator = scene->integrator;
+  return string_printf("%s %d %d %d %d %d",
+                       shader->graph->compile_hash.c_str(),
+                       (int)shader->used,
+                       (int)shader->displacement_method,
+                       (int)(integrator->filter_glossy == 0.0f),
+                       (int)integrator->caustics_reflective,
+                       (int)integrator->caustics_refractive);
 }
 
 void SVMShaderManager::device_update_shader(Scene *scene,
@@ -85,16 +140,55 @@ void SVMShaderManager::device_update(Device *device,
   /* test if we need to update */
   device_free(device, dscene, scene);
 
-  /* Build all shaders. */
+  /* Build all shaders. Shaders that can be shared look up their program in the compile cache,
+   * and only the first shader with a new graph compiles it. */
   TaskPool task_pool;
-  vector<array<int4>> shader_svm_nodes(num_shaders);
+  map<string, CompiledShader> cache;
+  vector<array<int4>> uncached_svm_nodes(num_shaders);
+  vector<array<int4> *> shader_svm_nodes(num_shaders);
+  vector<CompiledShader *> shader_compiled(num_shaders, NULL);
+  vector<pair<Shader *, CompiledShader *>> compiled;
+  int num_compiled = 0;
+
   for (int i = 0; i < num_shaders; i++) {
-    task_pool.push(function_bind(&SVMShaderManager::device_update_shader,
-                                 this,
-                                 scene,
-                                 scene->shaders[i],
-                                 &progress,
-                                 &shader_svm_nodes[i]));
+    Shader *shader = scene->shaders[i];
+    const string key = compile_cache_key(scene, shader);
+    bool need_compile = true;
+
+    if (key.empty()) {
+      shader_svm_nodes[i] = &uncached_svm_nodes[i];
+    }
+    else {
+      map<string, CompiledShader>::iterator it = cache.find(key);
+      if (it != cache.end()) {
+        need_compile = false;
+      }
+      else {
+        it = cache.insert(std::make_pair(key, CompiledShader())).first;
+
+        map<string, CompiledShader>::const_iterator cached = compile_cache.find(key);
+        if (cached != compile_cache.end()) {
+          it->second = cached->second;
+          need_compile = false;
+        }
+        else {
+          compiled.push_back(std::make_pair(shader, &it->second));
+        }
+      }
+
+      shader_svm_nodes[i] = &it->second.svm_nodes;
+      shader_compiled[i] = &it->second;
+    }
+
+    if (need_compile) {
+      task_pool.push(function_bind(&SVMShaderManager::device_update_shader,
+                                   this,
+                                   scene,
+                                   shader,
+                                   &progress,
+                                   shader_svm_nodes[i]));
+      num_compiled++;
+    }
   }
   task_pool.wait_work();
 
@@ -102,17 +196,29 @@ void SVMShaderManager::device_update(Device *device,
     return;
   }
 
+  /* Shaders sharing a program get the flags of the shader it was compiled for. */
+  for (size_t i = 0; i < compiled.size(); i++) {
+    compiled[i].second->store_flags(compiled[i].first);
+  }
+  for (int i = 0; i < num_shaders; i++) {
+    if (shader_compiled[i]) {
+      shader_compiled[i]->restore_flags(scene->shaders[i]);
+    }
+  }
+
   /* The global node list contains a jump table (one node per shader)
-   * followed by the nodes of all shaders. */
+   * followed by the nodes of all programs, with shared programs stored once. */
+  map<const array<int4> *, int> program_offsets;
   int svm_nodes_size = num_shaders;
   for (int i = 0; i < num_shaders; i++) {
-    /* Since we're not copying the local jump node, the size ends up being one node lower. */
-    svm_nodes_size += shader_svm_nodes[i].size() - 1;
+    if (program_offsets.insert(std::make_pair(shader_svm_nodes[i], svm_nodes_size)).second) {
+      /* Since we're not copying the local jump node, the size ends up being one node lower. */
+      svm_nodes_size += shader_svm_nodes[i]->size() - 1;
+    }
   }
 
   int4 *svm_nodes = dscene->svm_nodes.alloc(svm_nodes_size);
 
-  int node_offset = num_shaders;
   for (int i = 0; i < num_shaders; i++) {
     Shader *shader = scene->shaders[i];
 
@@ -124,24 +230,25 @@ void SVMShaderManager::device_update(Device *device,
     /* Update the global jump table.
      * Each compiled shader starts with a jump node that has offsets local
      * to the shader, so copy those and add the offset into the global node list. */
+    const array<int4> &local_svm_nodes = *shader_svm_nodes[i];
+    const int node_offset = program_offsets[shader_svm_nodes[i]];
     int4 &global_jump_node = svm_nodes[shader->id];
-    int4 &local_jump_node = shader_svm_nodes[i][0];
+    const int4 &local_jump_node = local_svm_nodes[0];
 
     global_jump_node.x = NODE_SHADER_JUMP;
     global_jump_node.y = local_jump_node.y - 1 + node_offset;
     global_jump_node.z = local_jump_node.z - 1 + node_offset;
     global_jump_node.w = local_jump_node.w - 1 + node_offset;
-
-    node_offset += shader_svm_nodes[i].size() - 1;
   }
 
-  /* Copy the nodes of each shader into the correct location. */
-  svm_nodes += num_shaders;
-  for (int i = 0; i < num_shaders; i++) {
-    int shader_size = shader_svm_nodes[i].size() - 1;
-
-    memcpy(svm_nodes, &shader_svm_nodes[i][1], sizeof(int4) * shader_size);
-    svm_nodes += shader_size;
+  /* Copy the nodes of each program into the correct location. */
+  for (map<const array<int4> *, int>::iterator it = program_offsets.begin();
+       it != program_offsets.end();
+       it++) {
+    const array<int4> &local_svm_nodes = *it->first;
+    memcpy(svm_nodes + it->second,
+           &local_svm_nodes[1],
+           sizeof(int4) * (local_svm_nodes.size() - 1));
   }
 
   if (progress.get_cancel()) {
@@ -152,10 +259,13 @@ void SVMShaderManager::device_update(Device *device,
 
   device_update_common(device, dscene, scene, progress);
 
+  compile_cache.swap(cache);
+
   need_update = false;
 
   VLOG(1) << "Shader manager updated " << num_shaders << " shaders in " << time_dt() - start_time
-          << " seconds.";
+          << " seconds, compiling " << num_compiled << " and reusing "
+          << num_shaders - num_compiled << ".";
 }
 
 void SVMShaderManager::device_free(Device *device, DeviceScene *dscene, Scene *scene)
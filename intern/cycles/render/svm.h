@@ -50,6 +50,34 @@ class SVMShaderManager : public ShaderManager {
   void device_free(Device *device, DeviceScene *dscene, Scene *scene);
 
  protected:
+  /* Compiled program of a shader, along with the shader flags set by compiling it. */
+  struct CompiledShader {
+    array<int4> svm_nodes;
+
+    bool has_surface;
+    bool has_surface_emission;
+    bool has_surface_transparent;
+    bool has_surface_bssrdf;
+    bool has_bump;
+    bool has_bssrdf_bump;
+    bool has_volume;
+    bool has_displacement;
+    bool has_surface_spatial_varying;
+    bool has_volume_spatial_varying;
+    bool has_volume_attribute_dependency;
+    bool has_integrator_dependency;
+
+    void store_flags(const Shader *shader);
+    void restore_flags(Shader *shader) const;
+  };
+
+  /* Compiled shaders by graph hash and compile settings. Shaders with identical graphs share a
+   * single compiled program, and unchanged shaders reuse theirs on the next update. Only the
+   * entries used by the last update are kept. */
+  map<string, CompiledShader> compile_cache;
+
+  string compile_cache_key(Scene *scene, Shader *shader);
+
   void device_update_shader(Scene *scene,
                             Shader *shader,
                             Progress *progress,
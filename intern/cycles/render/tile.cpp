@@ -84,6 +84,9 @@ enum SpiralDirection {
   DIRECTION_RIGHT,
 };
 
+/* Tiles are not split below this size, the per tile overhead would outweigh the gain. */
+const int MIN_SPLIT_TILE_SIZE = 16;
+
 } /* namespace */
 
 TileManager::TileManager(bool progressive_,
@@ -111,6 +114,9 @@ TileManager::TileManager(bool progressive_,
   range_start_sample = 0;
   range_num_samples = -1;
 
+  state.cost_grid_size = make_int2(0, 0);
+  state.cost_total = make_float2(0.0f, 0.0f);
+
   BufferParams buffer_params;
   reset(buffer_params, 0);
 }
@@ -155,6 +161,7 @@ void TileManager::reset(BufferParams &params_, int num_samples_)
   state.sample = range_start_sample - 1;
   state.num_tiles = 0;
   state.num_samples = 0;
+  state.num_active_tiles = 0;
   state.resolution_divider = get_divider(params.width, params.height, start_resolution);
   state.render_tiles.clear();
   state.denoising_tiles.clear();
@@ -381,6 +388,23 @@ void TileManager::set_tiles()
   int image_h = max(1, params.height / resolution);
 
   state.num_tiles = gen_tiles(!background);
+  state.num_active_tiles = 0;
+
+  if (use_tile_splitting()) {
+    /* Reserve room for every possible split up front, tile pointers handed out by next_tile()
+     * are used outside of the tile lock and must not be invalidated by splitting. */
+    state.tiles.reserve(state.num_tiles + divide_up(image_w, MIN_SPLIT_TILE_SIZE) *
+                                              divide_up(image_h, MIN_SPLIT_TILE_SIZE));
+
+    const int2 cost_grid_size = make_int2(divide_up(image_w, tile_size.x),
+                                          divide_up(image_h, tile_size.y));
+    if (!(cost_grid_size == state.cost_grid_size)) {
+      state.cost_grid_size = cost_grid_size;
+      state.cost_grid.clear();
+      state.cost_grid.resize(cost_grid_size.x * cost_grid_size.y, make_float2(0.0f, 0.0f));
+      state.cost_total = make_float2(0.0f, 0.0f);
+    }
+  }
 
   state.buffer.width = image_w;
   state.buffer.height = image_h;
@@ -447,6 +471,8 @@ bool TileManager::finish_tile(const int index, const bool need_denoise, bool &de
 
   switch (state.tiles[index].state) {
     case Tile::RENDER: {
+      state.num_active_tiles--;
+
       if (!(schedule_denoising && need_denoise)) {
         state.tiles[index].state = Tile::DONE;
         delete_tile = !progressive;
@@ -542,6 +568,10 @@ bool TileManager::next_tile(Tile *&tile, int device, uint tile_types)
         }
       }
 
+      if (use_tile_splitting()) {
+        split_render_tiles(state.render_tiles[logical_device]);
+      }
+
       tile_index = state.render_tiles[logical_device].front();
       state.render_tiles[logical_device].pop_front();
       break;
@@ -549,6 +579,7 @@ bool TileManager::next_tile(Tile *&tile, int device, uint tile_types)
 
     if (tile_index >= 0) {
       tile = &state.tiles[tile_index];
+      state.num_active_tiles++;
       return true;
     }
   }
@@ -556,6 +587,114 @@ bool TileManager::next_tile(Tile *&tile, int device, uint tile_types)
   return false;
 }
 
+bool TileManager::use_tile_splitting()
+{
+  return background && !progressive && !preserve_tile_device && !schedule_denoising;
+}
+
+/* Record the render time of a finished tile, spread over the cost grid cells it covers. With
+ * adaptive sampling this directly reflects how many samples the tile actually needed. */
+void TileManager::add_tile_cost(const int index, const double render_time)
+{
+  if (!use_tile_splitting() || render_time <= 0.0 || state.cost_grid.empty()) {
+    return;
+  }
+
+  const Tile &tile = state.tiles[index];
+  const float time_per_pixel = (float)(render_time / (tile.w * tile.h));
+
+  const int x0 = tile.x / tile_size.x, x1 = (tile.x + tile.w - 1) / tile_size.x;
+  const int y0 = tile.y / tile_size.y, y1 = (tile.y + tile.h - 1) / tile_size.y;
+  for (int cy = y0; cy <= min(y1, state.cost_grid_size.y - 1); cy++) {
+    for (int cx = x0; cx <= min(x1, state.cost_grid_size.x - 1); cx++) {
+      const int w = min(tile.x + tile.w, (cx + 1) * tile_size.x) - max(tile.x, cx * tile_size.x);
+      const int h = min(tile.y + tile.h, (cy + 1) * tile_size.y) - max(tile.y, cy * tile_size.y);
+      const float num_pixels = (float)(w * h);
+      state.cost_grid[cy * state.cost_grid_size.x + cx] += make_float2(
+          time_per_pixel * num_pixels, num_pixels);
+    }
+  }
+
+  state.cost_total += make_float2((float)render_time, (float)(tile.w * tile.h));
+}
+
+/* Estimated render time of a tile, from the time per pixel measured around it. Falls back to
+ * the image average when nothing close to the tile has been rendered yet, and to the tile area
+ * when nothing has been rendered at all. */
+float TileManager::estimate_tile_cost(const Tile &tile)
+{
+  const int x0 = max(tile.x / tile_size.x - 1, 0);
+  const int y0 = max(tile.y / tile_size.y - 1, 0);
+  const int x1 = min((tile.x + tile.w - 1) / tile_size.x + 1, state.cost_grid_size.x - 1);
+  const int y1 = min((tile.y + tile.h - 1) / tile_size.y + 1, state.cost_grid_size.y - 1);
+
+  float2 cost = make_float2(0.0f, 0.0f);
+  for (int cy = y0; cy <= y1; cy++) {
+    for (int cx = x0; cx <= x1; cx++) {
+      cost += state.cost_grid[cy * state.cost_grid_size.x + cx];
+    }
+  }
+
+  if (cost.y == 0.0f) {
+    cost = state.cost_total;
+  }
+
+  const float time_per_pixel = (cost.y > 0.0f) ? cost.x / cost.y : 1.0f;
+  return time_per_pixel * tile.w * tile.h;
+}
+
+void TileManager::split_render_tiles(list<int> &tile_list)
+{
+  /* Keep at least one queued tile for every tile that is still being rendered, so that every
+   * thread finishing its tile has work left to take. */
+  while ((int)tile_list.size() <= state.num_active_tiles &&
+         state.tiles.size() < state.tiles.capacity()) {
+    list<int>::iterator heaviest = tile_list.end();
+    float heaviest_cost = 0.0f;
+
+    for (list<int>::iterator it = tile_list.begin(); it != tile_list.end(); it++) {
+      const Tile &tile = state.tiles[*it];
+      if (max(tile.w, tile.h) < 2 * MIN_SPLIT_TILE_SIZE) {
+        continue;
+      }
+
+      const float cost = estimate_tile_cost(tile);
+      if (cost > heaviest_cost) {
+        heaviest = it;
+        heaviest_cost = cost;
+      }
+    }
+
+    if (heaviest == tile_list.end()) {
+      break;
+    }
+
+    /* Split along the longer side, the first half stays in place. */
+    Tile &tile = state.tiles[*heaviest];
+    Tile split = tile;
+    split.index = state.tiles.size();
+    if (tile.w >= tile.h) {
+      tile.w /= 2;
+      split.x += tile.w;
+      split.w -= tile.w;
+    }
+    else {
+      tile.h /= 2;
+      split.y += tile.h;
+      split.h -= tile.h;
+    }
+
+    /* Heavy regions go first, so they are not the last ones to finish. */
+    const int index = tile.index;
+    tile_list.erase(heaviest);
+    tile_list.push_front(split.index);
+    tile_list.push_front(index);
+
+    state.tiles.push_back(split);
+    state.num_tiles++;
+  }
+}
+
 bool TileManager::done()
 {
   int end_sample = (range_num_samples == -1) ? num_samples :
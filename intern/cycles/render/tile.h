@@ -86,6 +86,17 @@ class TileManager {
      * Each list in each vector is for one logical device. */
     vector<list<int>> render_tiles;
     vector<list<int>> denoising_tiles;
+
+    /* Number of render tiles handed out to devices that have not been finished yet. */
+    int num_active_tiles;
+
+    /* Measured render time and number of pixels of finished tiles, accumulated on a coarse grid
+     * with one cell per regular tile. Used to estimate the cost of tiles that are still queued,
+     * and kept across resets with the same resolution so the next frame starts with the
+     * estimates of the previous one. */
+    vector<float2> cost_grid;
+    int2 cost_grid_size;
+    float2 cost_total;
   } state;
 
   int num_samples;
@@ -108,6 +119,7 @@ class TileManager {
   bool next();
   bool next_tile(Tile *&tile, int device, uint tile_types);
   bool finish_tile(const int index, const bool need_denoise, bool &delete_tile);
+  void add_tile_cost(const int index, const double render_time);
   bool done();
   bool has_tiles();
 
@@ -165,6 +177,14 @@ class TileManager {
   /* Generate tile list, return number of tiles. */
   int gen_tiles(bool sliced);
   void gen_render_tiles();
+
+  /* Dynamic tile splitting: once fewer tiles are queued than are being rendered, the queued
+   * tile with the highest estimated cost is split in half, so threads that run out of work
+   * pick up parts of the remaining heavy regions instead of idling until the last large tile
+   * is done. Only possible when tiles are not tied to a device or to denoising neighbors. */
+  bool use_tile_splitting();
+  float estimate_tile_cost(const Tile &tile);
+  void split_render_tiles(list<int> &tile_list);
 };
 
 CCL_NAMESPACE_END
@@ -0,0 +1,361 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "bvh/bvh.h"
+#include "bvh/bvh_params.h"
+
+#include "render/mesh.h"
+#include "render/object.h"
+
+#include "kernel/kernel_compat_cpu.h"
+#include "kernel/kernel_math.h"
+#include "kernel/kernel_types.h"
+#include "kernel/split/kernel_split_data.h"
+#include "kernel/kernel_globals.h"
+#include "kernel/kernels/cpu/kernel_cpu_image.h"
+#include "kernel/kernel_random.h"
+#include "kernel/kernel_projection.h"
+#include "kernel/kernel_montecarlo.h"
+#include "kernel/kernel_differential.h"
+#include "kernel/geom/geom.h"
+#include "kernel/bvh/bvh.h"
+
+#include "util/util_progress.h"
+#include "util/util_transform.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+#ifdef __BVH_PACKET__
+
+namespace {
+
+/* Ground is a grid of this many quads along X and Z, rocks are laid out on a grid of
+ * this many instances along X and Z. */
+const int GROUND_RESOLUTION = 16;
+const float GROUND_SIZE = 20.0f;
+const int ROCK_GRID_SIZE = 6;
+
+/* Small deterministic generator, so rays are the same on every run. */
+class RayRandom {
+ public:
+  RayRandom(uint seed) : state(seed)
+  {
+  }
+
+  float uniform()
+  {
+    state = state * 1103515245u + 12345u;
+    return (state >> 8) * (1.0f / 16777216.0f);
+  }
+
+  float uniform(float min, float max)
+  {
+    return min + (max - min) * uniform();
+  }
+
+  float3 direction()
+  {
+    const float z = uniform(-1.0f, 1.0f);
+    const float r = sqrtf(max(1.0f - z * z, 0.0f));
+    const float phi = M_2PI_F * uniform();
+    return make_float3(r * cosf(phi), r * sinf(phi), z);
+  }
+
+ protected:
+  uint state;
+};
+
+Ray make_ray(const float3 P, const float3 D, const float t)
+{
+  Ray ray;
+  ray.P = P;
+  ray.D = D;
+  ray.t = t;
+  ray.time = 0.5f;
+#  ifdef __RAY_DIFFERENTIALS__
+  ray.dP = differential3_zero();
+  ray.dD = differential3_zero();
+#  endif
+  return ray;
+}
+
+template<typename T, typename U> void texture_set(texture<T> &tex, array<U> &data)
+{
+  static_assert(sizeof(T) == sizeof(U), "texture and packed BVH element size must match");
+  tex.data = (T *)data.data();
+  tex.width = data.size();
+}
+
+}  // namespace
+
+/* Ground plane in the top level BVH with instanced rocks of different size and orientation
+ * on top of it, converted to kernel data the same way the geometry manager does. */
+class BVHPacketTest : public testing::Test {
+ protected:
+  void SetUp() override
+  {
+    /* Ground with the transform applied, its triangles are part of the top level BVH. */
+    ground = new Mesh();
+    const int num_verts = GROUND_RESOLUTION + 1;
+    ground->reserve_mesh(num_verts * num_verts, GROUND_RESOLUTION * GROUND_RESOLUTION * 2);
+    for (int z = 0; z < num_verts; z++) {
+      for (int x = 0; x < num_verts; x++) {
+        const float u = (float)x / GROUND_RESOLUTION - 0.5f;
+        const float v = (float)z / GROUND_RESOLUTION - 0.5f;
+        ground->add_vertex(make_float3(u * GROUND_SIZE, 0.1f * sinf(u * 7.0f), v * GROUND_SIZE));
+      }
+    }
+    for (int z = 0; z < GROUND_RESOLUTION; z++) {
+      for (int x = 0; x < GROUND_RESOLUTION; x++) {
+        const int v = z * num_verts + x;
+        ground->add_triangle(v, v + 1, v + num_verts + 1, 0, false);
+        ground->add_triangle(v, v + num_verts + 1, v + num_verts, 0, false);
+      }
+    }
+    ground->transform_applied = true;
+    ground->prim_offset = 0;
+    ground->compute_bounds();
+
+    /* Rock is an octahedron with its own BVH, instanced many times. */
+    rock = new Mesh();
+    rock->reserve_mesh(6, 8);
+    rock->add_vertex(make_float3(1.0f, 0.0f, 0.0f));
+    rock->add_vertex(make_float3(-1.0f, 0.0f, 0.0f));
+    rock->add_vertex(make_float3(0.0f, 1.0f, 0.0f));
+    rock->add_vertex(make_float3(0.0f, -1.0f, 0.0f));
+    rock->add_vertex(make_float3(0.0f, 0.0f, 1.0f));
+    rock->add_vertex(make_float3(0.0f, 0.0f, -1.0f));
+    for (int i = 0; i < 8; i++) {
+      const int vx = (i & 1) ? 1 : 0;
+      const int vy = (i & 2) ? 3 : 2;
+      const int vz = (i & 4) ? 5 : 4;
+      rock->add_triangle(vx, vy, vz, 0, false);
+    }
+    rock->prim_offset = ground->num_triangles();
+    rock->compute_bounds();
+
+    BVHParams rock_params;
+    rock_object.geometry = rock;
+    rock->bvh = BVH::create(rock_params, {rock}, {&rock_object});
+    rock->bvh->build(progress);
+
+    Object *ground_object = new Object();
+    ground_object->geometry = ground;
+    ground_object->compute_bounds(false);
+    objects.push_back(ground_object);
+
+    RayRandom random(1);
+    for (int iz = 0; iz < ROCK_GRID_SIZE; iz++) {
+      for (int ix = 0; ix < ROCK_GRID_SIZE; ix++) {
+        const float spacing = GROUND_SIZE / ROCK_GRID_SIZE;
+        const float x = (ix + 0.5f) * spacing - 0.5f * GROUND_SIZE;
+        const float z = (iz + 0.5f) * spacing - 0.5f * GROUND_SIZE;
+        const float scale = random.uniform(0.3f, 1.2f);
+        Object *object = new Object();
+        object->geometry = rock;
+        object->tfm = transform_translate(x, scale * 0.5f, z) *
+                      transform_rotate(random.uniform(0.0f, M_2PI_F), random.direction()) *
+                      transform_scale(scale, scale * random.uniform(0.5f, 1.5f), scale);
+        object->compute_bounds(false);
+        objects.push_back(object);
+      }
+    }
+
+    BVHParams params;
+    params.top_level = true;
+    bvh = BVH::create(params, {ground, rock}, objects);
+    bvh->build(progress);
+
+    kernel_objects.resize(objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+      const Transform tfm = objects[i]->geometry->transform_applied ? transform_identity() :
+                                                                       objects[i]->tfm;
+      kernel_objects[i].tfm = tfm;
+      kernel_objects[i].itfm = transform_inverse(tfm);
+    }
+
+    PackedBVH &pack = bvh->pack;
+    texture_set(kg.__bvh_nodes, pack.nodes);
+    texture_set(kg.__bvh_leaf_nodes, pack.leaf_nodes);
+    texture_set(kg.__prim_tri_verts, pack.prim_tri_verts);
+    texture_set(kg.__prim_tri_index, pack.prim_tri_index);
+    texture_set(kg.__prim_type, pack.prim_type);
+    texture_set(kg.__prim_visibility, pack.prim_visibility);
+    texture_set(kg.__prim_index, pack.prim_index);
+    texture_set(kg.__prim_object, pack.prim_object);
+    texture_set(kg.__object_node, pack.object_node);
+    texture_set(kg.__objects, kernel_objects);
+
+    kg.__data.bvh.root = pack.root_index;
+    kg.__data.bvh.bvh_layout = BVH_LAYOUT_BVH2;
+  }
+
+  void TearDown() override
+  {
+    delete bvh;
+    for (Object *object : objects) {
+      delete object;
+    }
+    delete ground;
+    delete rock;
+  }
+
+  /* Trace rays in packets of the given size and one at a time, and check that the same rays
+   * hit. For regular rays the intersections must be the same, up to rounding of the distance
+   * from entering instances in a different order. Opaque shadow rays stop at any hit so only
+   * whether they are occluded is compared. */
+  void check_packets(const vector<Ray> &rays, const uint visibility, const int packet_size)
+  {
+    const bool any_hit = (visibility & PATH_RAY_SHADOW_OPAQUE) != 0;
+    int num_hits = 0;
+
+    for (size_t start = 0; start < rays.size(); start += packet_size) {
+      const int num_rays = min((int)(rays.size() - start), packet_size);
+      Intersection packet_isect[BVH_PACKET_SIZE];
+      const int hit_mask = bvh_intersect_packet(
+          &kg, &rays[start], num_rays, packet_isect, visibility);
+
+      for (int lane = 0; lane < num_rays; lane++) {
+        const Ray &ray = rays[start + lane];
+        Intersection isect;
+        isect.prim = PRIM_NONE;
+        const bool hit = scene_intersect(&kg, &ray, visibility, &isect);
+        const bool packet_hit = (hit_mask & (1 << lane)) != 0;
+
+        ASSERT_EQ(hit, packet_hit) << "ray " << start + lane;
+        if (!hit) {
+          EXPECT_EQ(packet_isect[lane].prim, PRIM_NONE) << "ray " << start + lane;
+          continue;
+        }
+
+        num_hits++;
+        if (!any_hit) {
+          EXPECT_NEAR(isect.t, packet_isect[lane].t, isect.t * 1e-5f) << "ray " << start + lane;
+          EXPECT_EQ(isect.u, packet_isect[lane].u) << "ray " << start + lane;
+          EXPECT_EQ(isect.v, packet_isect[lane].v) << "ray " << start + lane;
+          EXPECT_EQ(isect.prim, packet_isect[lane].prim) << "ray " << start + lane;
+          EXPECT_EQ(isect.object, packet_isect[lane].object) << "ray " << start + lane;
+          EXPECT_EQ(isect.type, packet_isect[lane].type) << "ray " << start + lane;
+        }
+      }
+    }
+
+    /* Both hits and misses must be covered for the comparison to mean anything. */
+    EXPECT_GT(num_hits, 0);
+    EXPECT_LT(num_hits, (int)rays.size());
+  }
+
+  /* Coherent rays from a pinhole camera looking down at the scene, in rows. */
+  vector<Ray> camera_rays()
+  {
+    const int width = 64, height = 48;
+    const float3 P = make_float3(0.3f, 8.0f, -16.0f);
+    const Transform tfm = transform_rotate(0.45f, make_float3(1.0f, 0.0f, 0.0f));
+
+    vector<Ray> rays;
+    for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+        const float3 D = make_float3((x + 0.5f) / width - 0.5f,
+                                     ((y + 0.5f) / height - 0.5f) * height / width,
+                                     1.0f);
+        rays.push_back(make_ray(P, normalize(transform_direction(&tfm, D)), FLT_MAX));
+      }
+    }
+    return rays;
+  }
+
+  /* Incoherent rays in random directions from random points above the ground. */
+  vector<Ray> random_rays(const int num_rays)
+  {
+    RayRandom random(2);
+    vector<Ray> rays;
+    for (int i = 0; i < num_rays; i++) {
+      const float3 P = make_float3(random.uniform(-12.0f, 12.0f),
+                                   random.uniform(0.2f, 3.0f),
+                                   random.uniform(-12.0f, 12.0f));
+      const float t = (i % 3 == 0) ? FLT_MAX : random.uniform(0.5f, 10.0f);
+      rays.push_back(make_ray(P, random.direction(), t));
+    }
+    /* Invalid ray in the middle of a packet, which must not disturb the other lanes. */
+    rays[5].D = make_float3(0.0f, 0.0f, 0.0f);
+    return rays;
+  }
+
+  /* Segments from points just above the ground towards a light, some blocked by rocks. */
+  vector<Ray> shadow_rays(const int num_rays)
+  {
+    RayRandom random(3);
+    const float3 light = make_float3(-3.0f, 6.0f, 2.0f);
+    vector<Ray> rays;
+    for (int i = 0; i < num_rays; i++) {
+      const float3 P = make_float3(
+          random.uniform(-10.0f, 10.0f), 0.2f, random.uniform(-10.0f, 10.0f));
+      float t;
+      const float3 D = normalize_len(light - P, &t);
+      rays.push_back(make_ray(P, D, t));
+    }
+    return rays;
+  }
+
+  Progress progress;
+  Mesh *ground;
+  Mesh *rock;
+  Object rock_object;
+  vector<Object *> objects;
+  BVH *bvh;
+
+  array<KernelObject> kernel_objects;
+  KernelGlobals kg = KernelGlobals();
+};
+
+TEST_F(BVHPacketTest, camera_rays_match_single_ray)
+{
+  const vector<Ray> rays = camera_rays();
+  for (int packet_size = 1; packet_size <= BVH_PACKET_SIZE; packet_size++) {
+    check_packets(rays, PATH_RAY_CAMERA, packet_size);
+  }
+}
+
+TEST_F(BVHPacketTest, random_rays_match_single_ray)
+{
+  const vector<Ray> rays = random_rays(1001);
+  for (int packet_size = 1; packet_size <= BVH_PACKET_SIZE; packet_size++) {
+    check_packets(rays, PATH_RAY_CAMERA, packet_size);
+  }
+}
+
+TEST_F(BVHPacketTest, shadow_rays_match_single_ray)
+{
+  const vector<Ray> rays = shadow_rays(1001);
+  for (int packet_size = 1; packet_size <= BVH_PACKET_SIZE; packet_size++) {
+    check_packets(rays, PATH_RAY_SHADOW_OPAQUE, packet_size);
+  }
+}
+
+TEST_F(BVHPacketTest, random_occlusion_matches_single_ray)
+{
+  const vector<Ray> rays = random_rays(1001);
+  for (int packet_size = 1; packet_size <= BVH_PACKET_SIZE; packet_size++) {
+    check_packets(rays, PATH_RAY_SHADOW_OPAQUE, packet_size);
+  }
+}
+
+#endif /* __BVH_PACKET__ */
+
+CCL_NAMESPACE_END
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2011-2020 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "bvh/bvh2.h"
+#include "bvh/bvh_params.h"
+
+#include "render/mesh.h"
+#include "render/object.h"
+
+#include "util/util_progress.h"
+#include "util/util_transform.h"
+#include "util/util_unique_ptr.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Objects are laid out on a grid of this many objects along X and Z. */
+const int GRID_SIZE = 8;
+const float GRID_SPACING = 4.0f;
+
+/* BVH2 with access to the packed top level nodes. */
+class TestBVH2 : public BVH2 {
+ public:
+  TestBVH2(const BVHParams &params,
+           const vector<Geometry *> &geometry,
+           const vector<Object *> &objects)
+      : BVH2(params, geometry, objects)
+  {
+  }
+
+  using BVH2::refit_nodes;
+
+  BoundBox root_bounds() const
+  {
+    return packed_node_bounds(0);
+  }
+
+  /* Number of top level inner nodes that a refit would rebuild. */
+  int num_degraded_nodes() const
+  {
+    int num_degraded = 0;
+    vector<int> stack;
+    stack.push_back(0);
+    while (stack.size()) {
+      const int idx = stack.back();
+      stack.pop_back();
+      if (packed_node_bounds(idx).safe_area() > build_area[idx] * BVH_REFIT_MAX_AREA_GROWTH) {
+        num_degraded++;
+      }
+      push_inner_children(idx, stack);
+    }
+    return num_degraded;
+  }
+
+  /* Sum of the surface area of all top level inner nodes, proportional to the SAH cost of
+   * traversing them. */
+  float nodes_area() const
+  {
+    float area = 0.0f;
+    vector<int> stack;
+    stack.push_back(0);
+    while (stack.size()) {
+      const int idx = stack.back();
+      stack.pop_back();
+      area += packed_node_bounds(idx).safe_area();
+      push_inner_children(idx, stack);
+    }
+    return area;
+  }
+
+  /* Check that the bounds of every child contain its content, and count how often each
+   * object is referenced from a leaf. */
+  void check_nodes(vector<int> &num_object_leaves) const
+  {
+    num_object_leaves.clear();
+    num_object_leaves.resize(objects.size(), 0);
+
+    vector<int> stack;
+    stack.push_back(0);
+    while (stack.size()) {
+      const int idx = stack.back();
+      stack.pop_back();
+
+      const int4 *data = &pack.nodes[idx];
+      for (int i = 0; i < 2; i++) {
+        const int child = (i == 0) ? data[0].z : data[0].w;
+        const BoundBox child_bounds(make_float3(__int_as_float(data[1][i]),
+                                                __int_as_float(data[2][i]),
+                                                __int_as_float(data[3][i])),
+                                    make_float3(__int_as_float(data[1][i + 2]),
+                                                __int_as_float(data[2][i + 2]),
+                                                __int_as_float(data[3][i + 2])));
+        if (child < 0) {
+          const int prim = ~pack.leaf_nodes[-child - 1].x;
+          ASSERT_GE(prim, 0);
+          const int object = pack.prim_object[prim];
+          num_object_leaves[object]++;
+          EXPECT_TRUE(bounds_contain(child_bounds, objects[object]->bounds))
+              << "object " << object << " outside of node " << idx;
+        }
+        else {
+          EXPECT_TRUE(bounds_contain(child_bounds, packed_node_bounds(child)))
+              << "node " << child << " outside of node " << idx;
+          stack.push_back(child);
+        }
+      }
+    }
+  }
+
+ protected:
+  void push_inner_children(int idx, vector<int> &stack) const
+  {
+    const int4 *data = &pack.nodes[idx];
+    if (data[0].z >= 0) {
+      stack.push_back(data[0].z);
+    }
+    if (data[0].w >= 0) {
+      stack.push_back(data[0].w);
+    }
+  }
+
+  static bool bounds_contain(const BoundBox &outer, const BoundBox &inner)
+  {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+           outer.min.z <= inner.min.z && outer.max.x >= inner.max.x &&
+           outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+  }
+};
+
+}  // namespace
+
+/* Grid of objects instancing a single tetrahedron, with a top level BVH2 built over them. */
+class BVHRefitTest : public testing::Test {
+ protected:
+  void SetUp() override
+  {
+    mesh = new Mesh();
+    mesh->reserve_mesh(4, 4);
+    mesh->add_vertex(make_float3(0.0f, 0.0f, 0.0f));
+    mesh->add_vertex(make_float3(1.0f, 0.0f, 0.0f));
+    mesh->add_vertex(make_float3(0.0f, 1.0f, 0.0f));
+    mesh->add_vertex(make_float3(0.0f, 0.0f, 1.0f));
+    mesh->add_triangle(0, 1, 2, 0, false);
+    mesh->add_triangle(0, 1, 3, 0, false);
+    mesh->add_triangle(0, 2, 3, 0, false);
+    mesh->add_triangle(1, 2, 3, 0, false);
+    mesh->prim_offset = 0;
+    mesh->compute_bounds();
+
+    /* Instanced geometry needs its own BVH to be merged into the top level one. */
+    BVHParams mesh_params;
+    mesh_object.geometry = mesh;
+    mesh->bvh = BVH::create(mesh_params, {mesh}, {&mesh_object});
+    mesh->bvh->build(progress);
+
+    for (int iz = 0; iz < GRID_SIZE; iz++) {
+      for (int ix = 0; ix < GRID_SIZE; ix++) {
+        Object *object = new Object();
+        object->geometry = mesh;
+        objects.push_back(object);
+        move_object(ix, iz, ix, iz);
+      }
+    }
+
+    params.top_level = true;
+  }
+
+  void TearDown() override
+  {
+    for (Object *object : objects) {
+      delete object;
+    }
+    delete mesh;
+  }
+
+  /* Move the object at grid cell (ix, iz) to grid position (x, z). */
+  void move_object(int ix, int iz, int x, int z)
+  {
+    Object *object = objects[iz * GRID_SIZE + ix];
+    object->tfm = transform_translate(x * GRID_SPACING, 0.0f, z * GRID_SPACING);
+    object->compute_bounds(false);
+  }
+
+  TestBVH2 *build_top_level()
+  {
+    TestBVH2 *bvh = new TestBVH2(params, {mesh}, objects);
+    bvh->build(progress);
+    return bvh;
+  }
+
+  Progress progress;
+  BVHParams params;
+  Mesh *mesh;
+  Object mesh_object;
+  vector<Object *> objects;
+};
+
+TEST_F(BVHRefitTest, partial_rebuild_matches_full_build)
+{
+  unique_ptr<TestBVH2> bvh(build_top_level());
+  unique_ptr<TestBVH2> bvh_refit_only(build_top_level());
+  EXPECT_EQ(bvh->num_degraded_nodes(), 0);
+
+  /* Spread a 2x2 block of objects to the corners of the 4x4 quadrant it is in. The bounds of
+   * the quadrant and everything above it stay the same, while the nodes below it which
+   * contain the moved objects grow well beyond the rebuild threshold. */
+  for (int iz = 2; iz < 4; iz++) {
+    for (int ix = 2; ix < 4; ix++) {
+      move_object(ix, iz, (ix - 2) * 3, (iz - 2) * 3);
+    }
+  }
+
+  bvh_refit_only->refit_nodes();
+  EXPECT_GT(bvh_refit_only->num_degraded_nodes(), 0);
+
+  ASSERT_TRUE(bvh->refit_top_level(progress));
+  EXPECT_EQ(bvh->num_degraded_nodes(), 0);
+
+  unique_ptr<TestBVH2> bvh_full(build_top_level());
+
+  vector<int> num_object_leaves;
+  bvh->check_nodes(num_object_leaves);
+  for (size_t i = 0; i < objects.size(); i++) {
+    EXPECT_EQ(num_object_leaves[i], 1) << "object " << i;
+  }
+  bvh_full->check_nodes(num_object_leaves);
+  for (size_t i = 0; i < objects.size(); i++) {
+    EXPECT_EQ(num_object_leaves[i], 1) << "object " << i;
+  }
+
+  /* Same layout of the packed arrays, including the merged instance BVH. */
+  EXPECT_EQ(bvh->pack.nodes.size(), bvh_full->pack.nodes.size());
+  EXPECT_EQ(bvh->pack.leaf_nodes.size(), bvh_full->pack.leaf_nodes.size());
+  EXPECT_EQ(bvh->pack.prim_index.size(), bvh_full->pack.prim_index.size());
+  EXPECT_EQ(bvh->pack.object_node, bvh_full->pack.object_node);
+
+  const BoundBox bounds = bvh->root_bounds();
+  const BoundBox bounds_full = bvh_full->root_bounds();
+  EXPECT_EQ(bounds.min.x, bounds_full.min.x);
+  EXPECT_EQ(bounds.min.y, bounds_full.min.y);
+  EXPECT_EQ(bounds.min.z, bounds_full.min.z);
+  EXPECT_EQ(bounds.max.x, bounds_full.max.x);
+  EXPECT_EQ(bounds.max.y, bounds_full.max.y);
+  EXPECT_EQ(bounds.max.z, bounds_full.max.z);
+
+  /* Rebuilding the degraded subtrees recovers most of the quality of a full build. */
+  EXPECT_LT(bvh->nodes_area(), bvh_refit_only->nodes_area());
+  EXPECT_LE(bvh->nodes_area(), bvh_full->nodes_area() * 1.5f);
+}
+
+TEST_F(BVHRefitTest, degraded_root_needs_full_build)
+{
+  unique_ptr<TestBVH2> bvh(build_top_level());
+
+  /* Move one corner object far away, growing the root bounds. */
+  move_object(0, 0, -4 * GRID_SIZE, -4 * GRID_SIZE);
+
+  EXPECT_FALSE(bvh->refit_top_level(progress));
+}
+
+TEST(BVHRefit, object_id_not_reused)
+{
+  /* The top level BVH is only refit for the same objects, which must not be confused with
+   * new objects allocated at the address of deleted ones. */
+  Object *object = new Object();
+  const uint64_t id = object->id;
+  delete object;
+
+  Object *new_object = new Object();
+  EXPECT_NE(new_object->id, id);
+  delete new_object;
+}
+
+CCL_NAMESPACE_END
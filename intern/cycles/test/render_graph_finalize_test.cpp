@@ -1532,4 +1532,37 @@ TEST_F(RenderGraph, constant_fold_convert_color_float_color)
   graph.finalize(scene);
 }
 
+/*
+ * Tests:
+ *  - Identical graphs share a compile hash, differing values do not.
+ */
+TEST_F(RenderGraph, compile_hash_content)
+{
+  EXPECT_ANY_MESSAGE(log);
+
+  ShaderGraph graph2, graph3;
+  ShaderGraphBuilder builder2(&graph2), builder3(&graph3);
+
+  builder.add_attribute("Attribute")
+      .add_node(ShaderNodeBuilder<MathNode>("Math").set(&MathNode::type, NODE_MATH_ADD))
+      .add_connection("Attribute::Fac", "Math::Value1")
+      .output_value("Math::Value");
+  builder2.add_attribute("Attribute")
+      .add_node(ShaderNodeBuilder<MathNode>("Math").set(&MathNode::type, NODE_MATH_ADD))
+      .add_connection("Attribute::Fac", "Math::Value1")
+      .output_value("Math::Value");
+  builder3.add_attribute("Attribute")
+      .add_node(ShaderNodeBuilder<MathNode>("Math").set(&MathNode::type, NODE_MATH_MULTIPLY))
+      .add_connection("Attribute::Fac", "Math::Value1")
+      .output_value("Math::Value");
+
+  graph.compute_compile_hash();
+  graph2.compute_compile_hash();
+  graph3.compute_compile_hash();
+
+  EXPECT_FALSE(graph.compile_hash.empty());
+  EXPECT_EQ(graph.compile_hash, graph2.compile_hash);
+  EXPECT_NE(graph.compile_hash, graph3.compile_hash);
+}
+
 CCL_NAMESPACE_END
@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+#
+# Copyright 2011-2020 Blender Foundation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# <pep8 compliant>
+
+"""
+Generate hair_patch.xml, the patch of strands instanced by hair.xml.
+
+The patch is a 32x32 grid of slightly curled strands with 5 keys each over a 2x2 square,
+tapering from root to tip. Strand jitter comes from a fixed LCG so the output is identical
+on every run.
+
+Usage: generate_hair_patch.py [output_path]
+"""
+
+import math
+import os
+import sys
+
+GRID_SIZE = 32
+NUM_KEYS = 5
+HEIGHT = 0.6
+CURL = 0.08
+ROOT_RADIUS = 0.006
+TIP_RADIUS = 0.001
+
+
+def random_unit(seed):
+    x = (seed * 1103515245 + 12345) & 0x7fffffff
+    return x / 0x7fffffff
+
+
+def generate_strands():
+    positions = []
+    radii = []
+    for iy in range(GRID_SIZE):
+        for ix in range(GRID_SIZE):
+            index = iy * GRID_SIZE + ix
+            root_x = (ix + random_unit(index * 3)) / GRID_SIZE * 2 - 1
+            root_z = (iy + random_unit(index * 3 + 1)) / GRID_SIZE * 2 - 1
+            phase = random_unit(index * 3 + 2) * 2 * math.pi
+            for k in range(NUM_KEYS):
+                t = k / (NUM_KEYS - 1)
+                x = root_x + CURL * t * math.cos(phase + 3 * t)
+                z = root_z + CURL * t * math.sin(phase + 3 * t)
+                y = HEIGHT * t
+                positions.append("%.4f %.4f %.4f" % (x, y, z))
+                radii.append("%.4f" % (ROOT_RADIUS * (1 - t) + TIP_RADIUS * t))
+    return positions, radii
+
+
+def write_lines(f, values, per_line, separator, indent):
+    for i in range(0, len(values), per_line):
+        f.write(("" if i == 0 else indent) + separator.join(values[i:i + per_line]))
+        if i + per_line < len(values):
+            f.write("\n")
+
+
+def main():
+    path = sys.argv[1] if len(sys.argv) > 1 else os.path.join(
+        os.path.dirname(os.path.abspath(__file__)), "hair_patch.xml")
+    positions, radii = generate_strands()
+    num_strands = GRID_SIZE * GRID_SIZE
+
+    with open(path, "w") as f:
+        f.write("<cycles>\n")
+        f.write("<!-- One patch of %d strands with %d keys each, "
+                "generated by generate_hair_patch.py. -->\n" % (num_strands, NUM_KEYS))
+        f.write("<hair\n")
+        f.write("  nkeys=\"")
+        write_lines(f, [str(NUM_KEYS)] * num_strands, 32, " ", "         ")
+        f.write("\"\n  P=\"")
+        write_lines(f, positions, 4, "  ", "     ")
+        f.write("\"\n  radius=\"")
+        write_lines(f, radii, 16, " ", "          ")
+        f.write("\" />\n</cycles>\n")
+
+
+if __name__ == "__main__":
+    main()
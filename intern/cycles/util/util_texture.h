@@ -93,6 +93,8 @@ typedef enum ExtensionType {
 typedef struct TextureInfo {
   /* Pointer, offset or texture depending on device. */
   uint64_t data;
+  /* Image cache to do lookups through instead of data, CPU only. */
+  uint64_t cache;
   /* Data Type */
   uint data_type;
   /* Buffer number for OpenCL. */
@@ -106,6 +108,20 @@ typedef struct TextureInfo {
   Transform transform_3d;
 } TextureInfo;
 
+#ifndef __KERNEL_GPU__
+/* Lookups into images which are not loaded into memory as a whole, but read on demand
+ * by an image cache on the CPU. Derivatives are in normalized texture coordinates and
+ * select the mipmap level. */
+class ImageCacheLookup {
+ public:
+  virtual ~ImageCacheLookup()
+  {
+  }
+
+  virtual float4 lookup(float x, float y, float2 dx, float2 dy) = 0;
+};
+#endif
+
 CCL_NAMESPACE_END
 
 #endif /* __UTIL_TEXTURE_H__ */
@@ -35,6 +35,11 @@
 #include <opensubdiv/osd/types.h>
 #include <opensubdiv/version.h>
 
+#ifdef WITH_TBB
+#  include <tbb/blocked_range.h>
+#  include <tbb/parallel_for.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "internal/base/type.h"
@@ -56,6 +61,47 @@ using OpenSubdiv::Osd::PatchCoord;
 namespace blender {
 namespace opensubdiv {
 
+// Stencils are factorized down to the coarse points, so every stencil only reads coarse points
+// and writes its own refined point. This makes it possible to evaluate ranges of them in
+// parallel, which is what takes most of the time of refining on every frame of a deforming
+// animation.
+void evalStencilsCpu(float *data,
+                     const BufferDescriptor &src_desc,
+                     const BufferDescriptor &dst_desc,
+                     const StencilTable *stencils)
+{
+  const int num_stencils = stencils->GetNumStencils();
+  if (num_stencils == 0) {
+    return;
+  }
+  const int *sizes = &stencils->GetSizes()[0];
+  const int *offsets = &stencils->GetOffsets()[0];
+  const int *indices = &stencils->GetControlIndices()[0];
+  const float *weights = &stencils->GetWeights()[0];
+#ifdef WITH_TBB
+  tbb::parallel_for(tbb::blocked_range<int>(0, num_stencils, 1024),
+                    [&](const tbb::blocked_range<int> &range) {
+                      // The evaluation writes the first stencil of the range to the offset of
+                      // the destination descriptor, so it has to point to that stencil.
+                      BufferDescriptor range_dst_desc = dst_desc;
+                      range_dst_desc.offset += range.begin() * dst_desc.stride;
+                      CpuEvaluator::EvalStencils(data,
+                                                 src_desc,
+                                                 data,
+                                                 range_dst_desc,
+                                                 sizes,
+                                                 offsets,
+                                                 indices,
+                                                 weights,
+                                                 range.begin(),
+                                                 range.end());
+                    });
+#else
+  CpuEvaluator::EvalStencils(
+      data, src_desc, data, dst_desc, sizes, offsets, indices, weights, 0, num_stencils);
+#endif
+}
+
 namespace {
 
 // Array implementation which stores small data on stack (or, rather, in the class itself).
@@ -183,6 +229,33 @@ class ConstPatchCoordWrapperBuffer : public RawDataWrapperVertexBuffer<const Pat
   }
 };
 
+// Evaluate stencils of a buffer which holds the coarse points followed by the refined points.
+template<typename VERTEX_BUFFER,
+         typename STENCIL_TABLE,
+         typename EVALUATOR,
+         typename DEVICE_CONTEXT>
+void evalStencils(VERTEX_BUFFER *buffer,
+                  const BufferDescriptor &src_desc,
+                  const BufferDescriptor &dst_desc,
+                  const STENCIL_TABLE *stencils,
+                  const EVALUATOR *eval_instance,
+                  DEVICE_CONTEXT *device_context)
+{
+  EVALUATOR::EvalStencils(
+      buffer, src_desc, buffer, dst_desc, stencils, eval_instance, device_context);
+}
+
+template<typename VERTEX_BUFFER, typename DEVICE_CONTEXT>
+void evalStencils(VERTEX_BUFFER *buffer,
+                  const BufferDescriptor &src_desc,
+                  const BufferDescriptor &dst_desc,
+                  const StencilTable *stencils,
+                  const CpuEvaluator * /*eval_instance*/,
+                  DEVICE_CONTEXT * /*device_context*/)
+{
+  evalStencilsCpu(buffer->BindCpuBuffer(), src_desc, dst_desc, stencils);
+}
+
 template<typename EVAL_VERTEX_BUFFER,
          typename STENCIL_TABLE,
          typename PATCH_TABLE,
@@ -232,13 +305,12 @@ class FaceVaryingVolatileEval {
                                     src_face_varying_desc_.stride;
     const EVALUATOR *eval_instance = OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(
         evaluator_cache_, src_face_varying_desc_, dst_face_varying_desc, device_context_);
-    EVALUATOR::EvalStencils(src_face_varying_data_,
-                            src_face_varying_desc_,
-                            src_face_varying_data_,
-                            dst_face_varying_desc,
-                            face_varying_stencils_,
-                            eval_instance,
-                            device_context_);
+    evalStencils(src_face_varying_data_,
+                 src_face_varying_desc_,
+                 dst_face_varying_desc,
+                 face_varying_stencils_,
+                 eval_instance,
+                 device_context_);
   }
 
   // NOTE: face_varying must point to a memory of at least float[2]*num_patch_coords.
@@ -391,26 +463,20 @@ class VolatileEvalOutput {
     dst_desc.offset += num_coarse_vertices_ * src_desc_.stride;
     const EVALUATOR *eval_instance = OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(
         evaluator_cache_, src_desc_, dst_desc, device_context_);
-    EVALUATOR::EvalStencils(src_data_,
-                            src_desc_,
-                            src_data_,
-                            dst_desc,
-                            vertex_stencils_,
-                            eval_instance,
-                            device_context_);
+    evalStencils(
+        src_data_, src_desc_, dst_desc, vertex_stencils_, eval_instance, device_context_);
     // Evaluate varying data.
     if (hasVaryingData()) {
       BufferDescriptor dst_varying_desc = src_varying_desc_;
       dst_varying_desc.offset += num_coarse_vertices_ * src_varying_desc_.stride;
       eval_instance = OpenSubdiv::Osd::GetEvaluator<EVALUATOR>(
           evaluator_cache_, src_varying_desc_, dst_varying_desc, device_context_);
-      EVALUATOR::EvalStencils(src_varying_data_,
-                              src_varying_desc_,
-                              src_varying_data_,
-                              dst_varying_desc,
-                              varying_stencils_,
-                              eval_instance,
-                              device_context_);
+      evalStencils(src_varying_data_,
+                   src_varying_desc_,
+                   dst_varying_desc,
+                   varying_stencils_,
+                   eval_instance,
+                   device_context_);
     }
     // Evaluate face-varying data.
     if (hasFaceVaryingData()) {
@@ -25,6 +25,8 @@
 
 #include <opensubdiv/far/patchMap.h>
 #include <opensubdiv/far/patchTable.h>
+#include <opensubdiv/far/stencilTable.h>
+#include <opensubdiv/osd/bufferDescriptor.h>
 
 #include "internal/base/memory.h"
 
@@ -37,6 +39,13 @@ namespace opensubdiv {
 // Anonymous forward declaration of actual evaluator implementation.
 class CpuEvalOutput;
 
+// Evaluate stencils of a buffer which holds the coarse points followed by the refined points.
+// Ranges of stencils are evaluated in parallel when built with TBB.
+void evalStencilsCpu(float *data,
+                     const OpenSubdiv::Osd::BufferDescriptor &src_desc,
+                     const OpenSubdiv::Osd::BufferDescriptor &dst_desc,
+                     const OpenSubdiv::Far::StencilTable *stencils);
+
 // Wrapper around implementaiton, which defines API which we are capable to
 // provide over the implementation.
 //
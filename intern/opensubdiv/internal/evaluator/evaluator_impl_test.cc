@@ -0,0 +1,135 @@
+// Copyright 2020 Blender Foundation. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software Foundation,
+// Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+
+#include "internal/evaluator/evaluator_impl.h"
+
+#include <cmath>
+#include <vector>
+
+#include <opensubdiv/far/stencilTableFactory.h>
+#include <opensubdiv/far/topologyDescriptor.h>
+#include <opensubdiv/far/topologyRefinerFactory.h>
+#include <opensubdiv/osd/cpuEvaluator.h>
+
+#include "testing/testing.h"
+
+using OpenSubdiv::Far::StencilTable;
+using OpenSubdiv::Far::StencilTableFactory;
+using OpenSubdiv::Far::TopologyDescriptor;
+using OpenSubdiv::Far::TopologyRefiner;
+using OpenSubdiv::Far::TopologyRefinerFactory;
+using OpenSubdiv::Osd::BufferDescriptor;
+using OpenSubdiv::Osd::CpuEvaluator;
+
+namespace blender {
+namespace opensubdiv {
+
+namespace {
+
+// Uniformly refined plane of size by size quads.
+TopologyRefiner *createGridTopologyRefiner(const int size, const int level)
+{
+  std::vector<int> verts_per_face(size * size, 4);
+  std::vector<int> face_verts;
+  face_verts.reserve(size * size * 4);
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      const int vertex = y * (size + 1) + x;
+      face_verts.push_back(vertex);
+      face_verts.push_back(vertex + 1);
+      face_verts.push_back(vertex + size + 2);
+      face_verts.push_back(vertex + size + 1);
+    }
+  }
+
+  TopologyDescriptor descriptor;
+  descriptor.numVertices = (size + 1) * (size + 1);
+  descriptor.numFaces = size * size;
+  descriptor.numVertsPerFace = verts_per_face.data();
+  descriptor.vertIndicesPerFace = face_verts.data();
+
+  OpenSubdiv::Sdc::Options sdc_options;
+  sdc_options.SetVtxBoundaryInterpolation(OpenSubdiv::Sdc::Options::VTX_BOUNDARY_EDGE_ONLY);
+  TopologyRefinerFactory<TopologyDescriptor>::Options options(OpenSubdiv::Sdc::SCHEME_CATMARK,
+                                                              sdc_options);
+  TopologyRefiner *refiner = TopologyRefinerFactory<TopologyDescriptor>::Create(descriptor,
+                                                                                options);
+  refiner->RefineUniform(TopologyRefiner::UniformOptions(level));
+  return refiner;
+}
+
+// Compare stencils evaluated by evalStencilsCpu() with a single serial evaluation of all of them,
+// for points of the given width stored in a buffer with the given stride.
+void testStencilsMatchSerial(const int width, const int stride)
+{
+  TopologyRefiner *refiner = createGridTopologyRefiner(32, 3);
+  StencilTableFactory::Options stencil_options;
+  stencil_options.generateOffsets = true;
+  stencil_options.generateIntermediateLevels = false;
+  const StencilTable *stencils = StencilTableFactory::Create(*refiner, stencil_options);
+
+  const int num_coarse_vertices = stencils->GetNumControlVertices();
+  const int num_stencils = stencils->GetNumStencils();
+  // Needs to be split into many parallel ranges.
+  EXPECT_GT(num_stencils, 16 * 1024);
+
+  const BufferDescriptor src_desc(stride - width, width, stride);
+  BufferDescriptor dst_desc = src_desc;
+  dst_desc.offset += num_coarse_vertices * stride;
+
+  std::vector<float> serial((num_coarse_vertices + num_stencils) * stride, 0.0f);
+  for (int i = 0; i < num_coarse_vertices; i++) {
+    for (int j = 0; j < width; j++) {
+      serial[i * stride + src_desc.offset + j] = std::sin(float(i * width + j));
+    }
+  }
+  std::vector<float> parallel = serial;
+
+  CpuEvaluator::EvalStencils(serial.data(),
+                             src_desc,
+                             serial.data(),
+                             dst_desc,
+                             &stencils->GetSizes()[0],
+                             &stencils->GetOffsets()[0],
+                             &stencils->GetControlIndices()[0],
+                             &stencils->GetWeights()[0],
+                             0,
+                             num_stencils);
+  evalStencilsCpu(parallel.data(), src_desc, dst_desc, stencils);
+
+  const int num_floats = serial.size();
+  for (int i = 0; i < num_floats; i++) {
+    ASSERT_EQ(serial[i], parallel[i]) << "at float " << i;
+  }
+
+  delete stencils;
+  delete refiner;
+}
+
+}  // namespace
+
+TEST(EvaluatorImpl, StencilsMatchSerial)
+{
+  testStencilsMatchSerial(3, 3);
+}
+
+TEST(EvaluatorImpl, StencilsMatchSerialInterleaved)
+{
+  testStencilsMatchSerial(2, 5);
+}
+
+}  // namespace opensubdiv
+}  // namespace blender
@@ -173,6 +173,10 @@ class MeshTopology {
   MEM_CXX_CLASS_ALLOC_FUNCS("MeshTopology");
 };
 
+// Hash of the topology defined by the converter. Covers everything which is compared by
+// MeshTopology::isEqualToConverter(), so equal topologies always have the same hash.
+uint64_t hashConverterTopology(const OpenSubdiv_Converter *converter);
+
 }  // namespace opensubdiv
 }  // namespace blender
 
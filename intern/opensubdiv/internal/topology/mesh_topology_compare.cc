@@ -211,8 +211,74 @@ bool isEqualTags(const MeshTopology &mesh_topology, const OpenSubdiv_Converter *
   return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Hashing.
+
+// FNV-1a, over the same effective values the comparison uses.
+class TopologyHash {
+ public:
+  void add(const void *data, size_t size)
+  {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      value_ = (value_ ^ bytes[i]) * 1099511628211ull;
+    }
+  }
+
+  template<typename T> void add(const T &value)
+  {
+    add(&value, sizeof(value));
+  }
+
+  uint64_t get() const
+  {
+    return value_;
+  }
+
+ protected:
+  uint64_t value_ = 14695981039346656037ull;
+};
+
 }  // namespace
 
+uint64_t hashConverterTopology(const OpenSubdiv_Converter *converter)
+{
+  TopologyHash hash;
+
+  const int num_vertices = converter->getNumVertices(converter);
+  const int num_edges = getEffectiveNumEdges(converter);
+  const int num_faces = converter->getNumFaces(converter);
+  hash.add(num_vertices);
+  hash.add(num_edges);
+  hash.add(num_faces);
+
+  vector<int> vertices_of_face;
+  for (int face_index = 0; face_index < num_faces; ++face_index) {
+    const int num_face_vertices = converter->getNumFaceVertices(converter, face_index);
+    vertices_of_face.resize(num_face_vertices);
+    converter->getFaceVertices(converter, face_index, vertices_of_face.data());
+    hash.add(num_face_vertices);
+    hash.add(vertices_of_face.data(), sizeof(int) * num_face_vertices);
+  }
+
+  for (int vertex_index = 0; vertex_index < num_vertices; ++vertex_index) {
+    hash.add(getEffectiveVertexSharpness(converter, vertex_index));
+  }
+
+  for (int edge_index = 0; edge_index < num_edges; ++edge_index) {
+    const float sharpness = getEffectiveEdgeSharpness(converter, edge_index);
+    hash.add(sharpness);
+    if (sharpness < 1e-6f) {
+      continue;
+    }
+    int edge_vertices[2];
+    converter->getEdgeVertices(converter, edge_index, edge_vertices);
+    hash.add(edge_vertices);
+  }
+
+  return hash.get();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Entry point.
 
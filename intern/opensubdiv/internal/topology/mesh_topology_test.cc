@@ -17,6 +17,7 @@
 // Author: Sergey Sharybin
 
 #include "internal/topology/mesh_topology.h"
+#include "opensubdiv_converter_capi.h"
 #include "testing/testing.h"
 
 namespace blender {
@@ -94,5 +95,57 @@ TEST(MeshTopology, TrivialFaceTopology)
   EXPECT_TRUE(mesh_topology.isFaceVertexIndicesEqual(2, {{7, 8, 9, 10, 11}}));
 }
 
+// Two quads sharing an edge, with sharpness on one edge.
+struct TestTopology {
+  int face_vertices[2][4] = {{0, 1, 4, 3}, {1, 2, 5, 4}};
+  int edge_vertices[7][2] = {{0, 1}, {1, 2}, {3, 4}, {4, 5}, {0, 3}, {1, 4}, {2, 5}};
+  float edge_sharpness[7] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+
+  OpenSubdiv_Converter converter() const
+  {
+    OpenSubdiv_Converter converter = {};
+    converter.getNumFaces = [](const OpenSubdiv_Converter *) { return 2; };
+    converter.getNumEdges = [](const OpenSubdiv_Converter *) { return 7; };
+    converter.getNumVertices = [](const OpenSubdiv_Converter *) { return 6; };
+    converter.getNumFaceVertices = [](const OpenSubdiv_Converter *, const int) { return 4; };
+    converter.getFaceVertices =
+        [](const OpenSubdiv_Converter *converter, const int face_index, int *face_vertices) {
+          memcpy(face_vertices, get(converter)->face_vertices[face_index], sizeof(int[4]));
+        };
+    converter.getEdgeVertices =
+        [](const OpenSubdiv_Converter *converter, const int edge_index, int *edge_vertices) {
+          memcpy(edge_vertices, get(converter)->edge_vertices[edge_index], sizeof(int[2]));
+        };
+    converter.getEdgeSharpness = [](const OpenSubdiv_Converter *converter,
+                                     const int edge_index) {
+      return get(converter)->edge_sharpness[edge_index];
+    };
+    converter.user_data = const_cast<TestTopology *>(this);
+    return converter;
+  }
+
+  static const TestTopology *get(const OpenSubdiv_Converter *converter)
+  {
+    return static_cast<const TestTopology *>(converter->user_data);
+  }
+};
+
+TEST(MeshTopology, HashConverterTopology)
+{
+  TestTopology topology_a, topology_b;
+  OpenSubdiv_Converter converter_a = topology_a.converter();
+  OpenSubdiv_Converter converter_b = topology_b.converter();
+
+  EXPECT_EQ(hashConverterTopology(&converter_a), hashConverterTopology(&converter_b));
+
+  topology_b.face_vertices[1][0] = 2;
+  topology_b.face_vertices[1][1] = 1;
+  EXPECT_NE(hashConverterTopology(&converter_a), hashConverterTopology(&converter_b));
+
+  topology_b = TestTopology();
+  topology_b.edge_sharpness[5] = 0.5f;
+  EXPECT_NE(hashConverterTopology(&converter_a), hashConverterTopology(&converter_b));
+}
+
 }  // namespace opensubdiv
 }  // namespace blender
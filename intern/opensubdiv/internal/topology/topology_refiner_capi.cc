@@ -260,3 +260,8 @@ bool openSubdiv_topologyRefinerCompareWithConverter(
 {
   return topology_refiner->impl->isEqualToConverter(converter);
 }
+
+uint64_t openSubdiv_topologyHashFromConverter(const OpenSubdiv_Converter *converter)
+{
+  return blender::opensubdiv::hashConverterTopology(converter);
+}
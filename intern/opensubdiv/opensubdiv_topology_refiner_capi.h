@@ -150,6 +150,12 @@ bool openSubdiv_topologyRefinerCompareWithConverter(
     const OpenSubdiv_TopologyRefiner *topology_refiner,
     const struct OpenSubdiv_Converter *converter);
 
+// Hash of the topology defined by the converter. Converters for which
+// openSubdiv_topologyRefinerCompareWithConverter() succeeds on the same
+// refiner have the same hash, so it can be used as a key for looking up
+// refiners before doing the full comparison.
+uint64_t openSubdiv_topologyHashFromConverter(const struct OpenSubdiv_Converter *converter);
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,3 +36,8 @@ bool openSubdiv_topologyRefinerCompareWithConverter(
 {
   return false;
 }
+
+uint64_t openSubdiv_topologyHashFromConverter(const OpenSubdiv_Converter * /*converter*/)
+{
+  return 0;
+}
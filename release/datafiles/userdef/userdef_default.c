@@ -226,6 +226,7 @@ const UserDef U_default = {
     .sequencer_disk_cache_compression = 0,
     .sequencer_disk_cache_size_limit = 100,
     .sequencer_disk_cache_flag = 0,
+    .sequencer_prefetch_threads = 0,
 
     .collection_instance_empty_size = 1.0f,
 
@@ -896,6 +896,9 @@ def brush_settings_advanced(layout, context, brush, popover=False):
             col.prop(brush, "use_original_plane", text="Plane")
             layout.separator()
 
+        if brush.sculpt_tool in {'DRAW', 'CLAY_STRIPS', 'SMOOTH'}:
+            layout.prop(brush, "use_batched_kernels")
+
     # 3D and 2D Texture Paint.
     elif mode in {'PAINT_TEXTURE', 'PAINT_2D'}:
         capabilities = brush.image_paint_capabilities
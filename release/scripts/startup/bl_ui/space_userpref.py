@@ -633,6 +633,7 @@ class USERPREF_PT_system_video_sequencer(SystemPanel, CenterAlignMixIn, Panel):
         edit = prefs.edit
 
         layout.prop(system, "memory_cache_limit")
+        layout.prop(system, "sequencer_prefetch_threads")
 
         layout.separator()
 
@@ -2183,6 +2184,9 @@ class USERPREF_PT_experimental_debugging(ExperimentalPanel, Panel):
             context, (
                 ({"property": "use_undo_legacy"}, "T60695"),
                 ({"property": "use_cycles_debug"}, None),
+                ({"property": "use_draw_mesh_clusters"}, None),
+                ({"property": "use_sculpt_pbvh_sah"}, None),
+                ({"property": "use_sculpt_grids_paging"}, None),
             ),
         )
 
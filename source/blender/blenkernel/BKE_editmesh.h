@@ -84,6 +84,21 @@ typedef struct BMEditMesh {
    */
   char needs_flush_to_id;
 
+  /**
+   * Deformation tracking, so drawing can update only the parts of its buffers around moved
+   * vertices. Tools that only move vertices opt in by tagging them using
+   * #BKE_editmesh_deform_tag_begin, any geometry update that was not tagged this way
+   * invalidates the tracking (see #BKE_editmesh_deform_tag_geometry_update).
+   *
+   * Stamp of the last update that moved each vertex, NULL when nothing was tagged. */
+  int *deform_vert_stamp;
+  /** Stamp of the last deformation. */
+  int deform_stamp;
+  /** Stamp from which the tracking is valid, data older than this has to be fully updated. */
+  int deform_stamp_valid;
+  /** The next geometry update only moves the vertices tagged since the last one. */
+  int deform_tag_pending;
+
 } BMEditMesh;
 
 /* editmesh.c */
@@ -104,6 +119,11 @@ void BKE_editmesh_lnorspace_update(BMEditMesh *em, struct Mesh *me);
 void BKE_editmesh_ensure_autosmooth(BMEditMesh *em, struct Mesh *me);
 struct BoundBox *BKE_editmesh_cage_boundbox_get(BMEditMesh *em);
 
+void BKE_editmesh_deform_tag_begin(BMEditMesh *em);
+void BKE_editmesh_deform_tag_vert(BMEditMesh *em, const struct BMVert *eve);
+void BKE_editmesh_deform_tag_reset(BMEditMesh *em);
+void BKE_editmesh_deform_tag_geometry_update(BMEditMesh *em);
+
 #ifdef __cplusplus
 }
 #endif
@@ -234,12 +234,17 @@ void BKE_pbvh_sync_face_sets_to_grids(PBVH *pbvh);
 const struct CCGKey *BKE_pbvh_get_grid_key(const PBVH *pbvh);
 
 struct CCGElem **BKE_pbvh_get_grids(const PBVH *pbvh);
+/* Single grid, read back from the swap file when it is paged out. NULL when it can't be read. */
+struct CCGElem *BKE_pbvh_get_grid(const PBVH *pbvh, int grid_index);
 BLI_bitmap **BKE_pbvh_get_grid_visibility(const PBVH *pbvh);
 int BKE_pbvh_get_grid_num_vertices(const PBVH *pbvh);
 
 /* Only valid for type == PBVH_BMESH */
 struct BMesh *BKE_pbvh_get_bmesh(PBVH *pbvh);
 void BKE_pbvh_bmesh_detail_size_set(PBVH *pbvh, float detail_size);
+/* Scan the leaves for the edges to split or collapse on multiple threads (the default),
+ * the topology itself is always changed on the calling thread. */
+void BKE_pbvh_bmesh_parallel_topology_set(PBVH *pbvh, bool use_parallel);
 
 typedef enum {
   PBVH_Subdivide = 1,
@@ -318,6 +323,15 @@ void BKE_pbvh_face_sets_set(PBVH *pbvh, int *face_sets);
 void BKE_pbvh_face_sets_color_set(PBVH *pbvh, int seed, int color_default);
 
 void BKE_pbvh_respect_hide_set(PBVH *pbvh, bool respect_hide);
+void BKE_pbvh_build_sah_set(PBVH *pbvh, bool use_sah);
+
+/* Paging of the multires grids of a SubdivCCG created with a swap file. Grids are read back on
+ * access through the node (vertex iterators, ray-casts, drawing and undo).
+ *
+ * BKE_pbvh_grids_page_out_stale() pages out the grids of leaves which weren't accessed recently
+ * and the least recently used ones above the memory limit, then advances the clock. It must not
+ * run concurrently with other access to the grids, e.g. call it at the end of an operator. */
+void BKE_pbvh_grids_page_out_stale(PBVH *pbvh);
 
 /* vertex deformer */
 float (*BKE_pbvh_vert_coords_alloc(struct PBVH *pbvh))[3];
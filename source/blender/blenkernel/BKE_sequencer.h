@@ -87,9 +87,14 @@ void BKE_sequence_iterator_end(SeqIterator *iter);
   } \
   ((void)0)
 
+/* Maximum number of threads rendering frames for prefetching. */
+#define SEQ_PREFETCH_THREADS_MAX 16
+
 typedef enum eSeqTaskId {
   SEQ_TASK_MAIN_RENDER,
+  /* Each prefetch thread uses its own ID, starting with this one. */
   SEQ_TASK_PREFETCH_RENDER,
+  SEQ_TASK_MAX = SEQ_TASK_PREFETCH_RENDER + SEQ_PREFETCH_THREADS_MAX,
 } eSeqTaskId;
 
 typedef struct SeqRenderData {
@@ -179,6 +179,9 @@ typedef struct Subdiv {
    * topology to OpenSubdiv. It can be shared by both evaluator and GL mesh
    * drawer. */
   struct OpenSubdiv_TopologyRefiner *topology_refiner;
+  /* Hash of the topology the refiner is created for, used to find released
+   * descriptors which can be re-used. */
+  uint64_t topology_hash;
   /* CPU side evaluator. */
   struct OpenSubdiv_Evaluator *evaluator;
   /* Optional displacement evaluator. */
@@ -232,7 +235,8 @@ Subdiv *BKE_subdiv_new_from_mesh(const SubdivSettings *settings, const struct Me
 
 /* Similar to above, but will not re-create descriptor if it was created for the
  * same settings and topology.
- * If settings or topology did change, the existing descriptor is freed and a
+ * If settings or topology did change, the existing descriptor is released and a
+ * previously released descriptor for the new settings and topology is used, or a
  * new one is created from scratch.
  *
  * NOTE: It is allowed to pass NULL as an existing subdivision surface
@@ -247,6 +251,16 @@ Subdiv *BKE_subdiv_update_from_mesh(Subdiv *subdiv,
 
 void BKE_subdiv_free(Subdiv *subdiv);
 
+/* Free descriptor which is not needed anymore, but keep it around for a while.
+ * This way going back to a previous level or re-creating the evaluated object
+ * doesn't need to create topology refiner and evaluator again.
+ * Only a few descriptors up to a memory budget are kept, the least recently released ones are
+ * freed. */
+void BKE_subdiv_release(Subdiv *subdiv);
+
+/* Free all released descriptors, for example when their meshes are gone after loading a file. */
+void BKE_subdiv_cache_flush(void);
+
 /* ============================ DISPLACEMENT API ============================ */
 
 void BKE_subdiv_displacement_attach_from_multires(Subdiv *subdiv,
@@ -39,6 +39,7 @@ struct CCGKey;
 struct DMFlagMat;
 struct Mesh;
 struct Subdiv;
+struct SubdivCCGPaging;
 
 /* --------------------------------------------------------------------
  * Masks.
@@ -94,6 +95,9 @@ typedef struct SubdivToCCGSettings {
   /* Denotes which extra layers to be added to CCG elements. */
   bool need_normal;
   bool need_mask;
+  /* Create the grids in a swap file in the temporary directory instead of in memory, for meshes
+   * which don't fit in memory. See BKE_subdiv_ccg_grid_get(). */
+  bool use_paging;
 } SubdivToCCGSettings;
 
 typedef struct SubdivCCGCoord {
@@ -151,9 +155,12 @@ typedef struct SubdivCCG {
    * grid_size^2 elements.
    */
   /* Indexed by a grid index, points to a grid data which is stored in
-   * grids_storage. */
+   * grids_storage.
+   *
+   * With paging enabled grids are allocated individually instead, and are NULL while they are
+   * in the swap file. Use BKE_subdiv_ccg_grid_get() when grids might be paged out. */
   struct CCGElem **grids;
-  /* Flat array of all grids' data. */
+  /* Flat array of all grids' data, NULL with paging. */
   unsigned char *grids_storage;
   int num_grids;
   /* Loose edges, each array element contains grid_size elements
@@ -220,6 +227,9 @@ typedef struct SubdivCCG {
     /* Indexed by face, indicates index of the first grid which corresponds to the face. */
     int *start_face_grid_index;
   } cache_;
+
+  /* Swap file of grids which are not kept in memory, NULL when paging is disabled. */
+  struct SubdivCCGPaging *paging;
 } SubdivCCG;
 
 /* Create CCG representation of subdivision surface.
@@ -313,6 +323,32 @@ void BKE_subdiv_ccg_neighbor_coords_get(const SubdivCCG *subdiv_ccg,
 
 int BKE_subdiv_ccg_grid_to_face_index(const SubdivCCG *subdiv_ccg, const int grid_index);
 
+/* Paging of grids to a swap file in the temporary directory, for meshes which don't fit in
+ * memory, see SubdivToCCGSettings.use_paging. The grids are created in the swap file, a chunk at
+ * a time, and are read back on access with BKE_subdiv_ccg_grid_get(). Once they take more memory
+ * than a fixed limit, see BKE_subdiv_ccg_paging_over_limit(), the caller is to page some of them
+ * out again. BKE_subdiv_ccg_grid_read() reads a grid without keeping it in memory.
+ *
+ * A grid which can't be read back stays paged out: BKE_subdiv_ccg_grid_get() returns NULL and
+ * the page in functions return false. The next access tries again. After a read error no more
+ * grids are paged out, see BKE_subdiv_ccg_paging_has_error().
+ *
+ * Grids can be read back from any thread, paging them out must not run concurrently with
+ * any access to them. */
+bool BKE_subdiv_ccg_paging_has_error(const SubdivCCG *subdiv_ccg);
+bool BKE_subdiv_ccg_paging_over_limit(const SubdivCCG *subdiv_ccg);
+struct CCGElem *BKE_subdiv_ccg_grid_get(const SubdivCCG *subdiv_ccg, const int grid_index);
+/* The grid when it is in memory, otherwise it is read into the buffer of CCGKey.grid_bytes. */
+struct CCGElem *BKE_subdiv_ccg_grid_read(const SubdivCCG *subdiv_ccg,
+                                         const int grid_index,
+                                         struct CCGElem *buffer);
+bool BKE_subdiv_ccg_grids_page_in(SubdivCCG *subdiv_ccg,
+                                  const int *grid_indices,
+                                  const int num_grids);
+void BKE_subdiv_ccg_grids_page_out(SubdivCCG *subdiv_ccg,
+                                   const int *grid_indices,
+                                   const int num_grids);
+
 typedef enum SubdivCCGAdjacencyType {
   SUBDIV_CCG_ADJACENT_NONE,
   SUBDIV_CCG_ADJACENT_VERTEX,
@@ -39,11 +39,22 @@
 #include "BKE_mesh_wrapper.h"
 #include "BKE_object.h"
 
+#include "atomic_ops.h"
+
+/* Shared by all edit-meshes, so stamps of a replaced edit-mesh are never reused. */
+static int32_t editmesh_deform_stamp = 0;
+
+static int editmesh_deform_stamp_next(void)
+{
+  return atomic_add_and_fetch_int32(&editmesh_deform_stamp, 1);
+}
+
 BMEditMesh *BKE_editmesh_create(BMesh *bm, const bool do_tessellate)
 {
   BMEditMesh *em = MEM_callocN(sizeof(BMEditMesh), __func__);
 
   em->bm = bm;
+  em->deform_stamp = em->deform_stamp_valid = editmesh_deform_stamp_next();
   if (do_tessellate) {
     BKE_editmesh_looptri_calc(em);
   }
@@ -59,6 +70,9 @@ BMEditMesh *BKE_editmesh_copy(BMEditMesh *em)
   em_copy->mesh_eval_cage = em_copy->mesh_eval_final = NULL;
   em_copy->bb_cage = NULL;
 
+  em_copy->deform_vert_stamp = NULL;
+  em_copy->deform_stamp = em_copy->deform_stamp_valid = editmesh_deform_stamp_next();
+
   em_copy->bm = BM_mesh_copy(em->bm);
 
   /* The tessellation is NOT calculated on the copy here,
@@ -170,6 +184,8 @@ void BKE_editmesh_free(BMEditMesh *em)
     MEM_freeN(em->looptris);
   }
 
+  MEM_SAFE_FREE(em->deform_vert_stamp);
+
   if (em->bm) {
     BM_mesh_free(em->bm);
   }
@@ -278,3 +294,55 @@ BoundBox *BKE_editmesh_cage_boundbox_get(BMEditMesh *em)
 
   return em->bb_cage;
 }
+
+/**
+ * Start a deform-only update, vertices moved by it are then tagged with
+ * #BKE_editmesh_deform_tag_vert. Tags accumulate until #BKE_editmesh_deform_tag_reset.
+ */
+void BKE_editmesh_deform_tag_begin(BMEditMesh *em)
+{
+  BMesh *bm = em->bm;
+  if ((em->deform_vert_stamp != NULL) &&
+      (MEM_allocN_len(em->deform_vert_stamp) / sizeof(int) != (size_t)bm->totvert)) {
+    BKE_editmesh_deform_tag_reset(em);
+  }
+  if (em->deform_vert_stamp == NULL) {
+    em->deform_vert_stamp = MEM_calloc_arrayN(
+        (size_t)bm->totvert, sizeof(int), "BMEditMesh.deform_vert_stamp");
+  }
+  BM_mesh_elem_index_ensure(bm, BM_VERT);
+  em->deform_stamp = editmesh_deform_stamp_next();
+  em->deform_tag_pending = true;
+}
+
+void BKE_editmesh_deform_tag_vert(BMEditMesh *em, const BMVert *eve)
+{
+  BLI_assert(em->deform_vert_stamp != NULL);
+  em->deform_vert_stamp[BM_elem_index_get(eve)] = em->deform_stamp;
+}
+
+/**
+ * Any change other than moving vertices invalidates the deformation tracking.
+ */
+void BKE_editmesh_deform_tag_reset(BMEditMesh *em)
+{
+  MEM_SAFE_FREE(em->deform_vert_stamp);
+  em->deform_stamp = em->deform_stamp_valid = editmesh_deform_stamp_next();
+  em->deform_tag_pending = false;
+}
+
+/**
+ * The evaluated geometry of the edit-mesh changed. Unless the change was tagged as only moving
+ * vertices, the deformation tracking is invalidated.
+ *
+ * \note Can run from depsgraph evaluation threads for objects sharing the mesh, so this only
+ * updates stamps and leaves freeing the tags to #BKE_editmesh_deform_tag_reset.
+ */
+void BKE_editmesh_deform_tag_geometry_update(BMEditMesh *em)
+{
+  if (atomic_cas_int32(&em->deform_tag_pending, true, false) == true) {
+    return;
+  }
+  const int stamp = editmesh_deform_stamp_next();
+  em->deform_stamp = em->deform_stamp_valid = stamp;
+}
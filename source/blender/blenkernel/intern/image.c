@@ -291,6 +291,8 @@ static void imagecache_put(Image *image, int index, ImBuf *ibuf)
     image->cache = IMB_moviecache_create(
         "Image Datablock Cache", sizeof(ImageCacheKey), imagecache_hashhash, imagecache_hashcmp);
     IMB_moviecache_set_getdata_callback(image->cache, imagecache_keydata);
+    /* A single image sequence or movie doesn't push out all other images. */
+    IMB_moviecache_set_memory_limit_fraction(image->cache, 0.5f);
   }
 
   key.index = index;
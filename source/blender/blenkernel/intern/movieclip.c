@@ -687,6 +687,8 @@ static bool put_imbuf_cache(
                                          moviecache_getprioritydata,
                                          moviecache_getitempriority,
                                          moviecache_prioritydeleter);
+    /* Leave room for the other clips and images, tracking uses several clips at once. */
+    IMB_moviecache_set_memory_limit_fraction(moviecache, 0.5f);
 
     clip->cache->moviecache = moviecache;
     clip->cache->sequence_offset = -1;
@@ -25,6 +25,8 @@
 
 #include <string.h>
 
+#include "MEM_guardedalloc.h"
+
 #include "BLI_utildefines.h"
 
 #include "BKE_ccg.h"
@@ -39,9 +41,19 @@ bool multires_reshape_assign_final_coords_from_ccg(const MultiresReshapeContext
   const int reshape_grid_size = reshape_context->reshape.grid_size;
   const float reshape_grid_size_1_inv = 1.0f / (((float)reshape_grid_size) - 1.0f);
 
+  /* Grids in the swap file are read into the buffer, without keeping them in memory. */
+  CCGKey key;
+  BKE_subdiv_ccg_key_top_level(&key, subdiv_ccg);
+  CCGElem *grid_buffer = (subdiv_ccg->paging != NULL) ? MEM_mallocN(key.grid_bytes, __func__) :
+                                                        NULL;
+
   int num_grids = subdiv_ccg->num_grids;
   for (int grid_index = 0; grid_index < num_grids; ++grid_index) {
-    CCGElem *ccg_grid = subdiv_ccg->grids[grid_index];
+    CCGElem *ccg_grid = BKE_subdiv_ccg_grid_read(subdiv_ccg, grid_index, grid_buffer);
+    if (ccg_grid == NULL) {
+      /* Can't be read back from the swap file, keep the displacement it had. */
+      continue;
+    }
     for (int y = 0; y < reshape_grid_size; ++y) {
       const float v = (float)y * reshape_grid_size_1_inv;
       for (int x = 0; x < reshape_grid_size; ++x) {
@@ -68,5 +80,7 @@ bool multires_reshape_assign_final_coords_from_ccg(const MultiresReshapeContext
     }
   }
 
+  MEM_SAFE_FREE(grid_buffer);
+
   return true;
 }
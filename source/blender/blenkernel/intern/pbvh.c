@@ -51,6 +51,19 @@
 
 #define LEAF_LIMIT 10000
 
+/* Nodes with more primitives than this many leaves are built in their own task. */
+#define BUILD_TASK_LEAF_LIMIT 4
+
+/* Number of bins along each axis when looking for the split with the lowest SAH cost. */
+#define SAH_BINS 16
+
+/* Grids of leaves which weren't accessed during this many clock ticks (operators) are paged
+ * out. */
+#define PAGING_STALE_AGE 4
+
+/* Number of nodes of which the draw buffers are updated between page-outs. */
+#define PAGING_DRAW_BATCH_NODES 256
+
 //#define PERFCNTRS
 
 #define STACK_FIXED_DEPTH 100
@@ -255,16 +268,19 @@ void pbvh_grow_nodes(PBVH *pbvh, int totnode)
 
 /* Add a vertex to the map, with a positive value for unique vertices and
  * a negative value for additional vertices */
-static int map_insert_vert(
-    PBVH *pbvh, GHash *map, unsigned int *face_verts, unsigned int *uniq_verts, int vertex)
+static int map_insert_vert(PBVH *pbvh,
+                           GHash *map,
+                           unsigned int *face_verts,
+                           unsigned int *uniq_verts,
+                           int vertex,
+                           int leaf)
 {
   void *key, **value_p;
 
   key = POINTER_FROM_INT(vertex);
   if (!BLI_ghash_ensure_p(map, key, &value_p)) {
     int value_i;
-    if (BLI_BITMAP_TEST(pbvh->vert_bitmap, vertex) == 0) {
-      BLI_BITMAP_ENABLE(pbvh->vert_bitmap, vertex);
+    if (pbvh->vert_leaf[vertex] == leaf) {
       value_i = *uniq_verts;
       (*uniq_verts)++;
     }
@@ -281,7 +297,7 @@ static int map_insert_vert(
 }
 
 /* Find vertices used by the faces in this node and update the draw buffers */
-static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node)
+static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node, int leaf)
 {
   bool has_visible = false;
 
@@ -303,7 +319,7 @@ static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node)
     const MLoopTri *lt = &pbvh->looptri[node->prim_indices[i]];
     for (int j = 0; j < 3; j++) {
       face_vert_indices[i][j] = map_insert_vert(
-          pbvh, map, &node->face_verts, &node->uniq_verts, pbvh->mloop[lt->tri[j]].v);
+          pbvh, map, &node->face_verts, &node->uniq_verts, pbvh->mloop[lt->tri[j]].v, leaf);
     }
 
     if (has_visible == false) {
@@ -347,13 +363,12 @@ static void build_mesh_leaf_node(PBVH *pbvh, PBVHNode *node)
   BLI_ghash_free(map, NULL, NULL);
 }
 
-static void update_vb(PBVH *pbvh, PBVHNode *node, BBC *prim_bbc, int offset, int count)
+static void update_vb(PBVH *pbvh, BB *vb, BBC *prim_bbc, int offset, int count)
 {
-  BB_reset(&node->vb);
+  BB_reset(vb);
   for (int i = offset + count - 1; i >= offset; i--) {
-    BB_expand_with_bb(&node->vb, (BB *)(&prim_bbc[pbvh->prim_indices[i]]));
+    BB_expand_with_bb(vb, (BB *)(&prim_bbc[pbvh->prim_indices[i]]));
   }
-  node->orig_vb = node->vb;
 }
 
 /* Returns the number of visible quads in the nodes' grids. */
@@ -417,18 +432,11 @@ static void build_grid_leaf_node(PBVH *pbvh, PBVHNode *node)
   BKE_pbvh_node_mark_rebuild_draw(node);
 }
 
-static void build_leaf(PBVH *pbvh, int node_index, BBC *prim_bbc, int offset, int count)
+/* `leaf` is the index of the leaf in the order the leaves are stored, see #build_flatten. */
+static void build_leaf(PBVH *pbvh, int node_index, int leaf)
 {
-  pbvh->nodes[node_index].flag |= PBVH_Leaf;
-
-  pbvh->nodes[node_index].prim_indices = pbvh->prim_indices + offset;
-  pbvh->nodes[node_index].totprim = count;
-
-  /* Still need vb for searches */
-  update_vb(pbvh, &pbvh->nodes[node_index], prim_bbc, offset, count);
-
   if (pbvh->looptri) {
-    build_mesh_leaf_node(pbvh, pbvh->nodes + node_index);
+    build_mesh_leaf_node(pbvh, pbvh->nodes + node_index, leaf);
   }
   else {
     build_grid_leaf_node(pbvh, pbvh->nodes + node_index);
@@ -469,6 +477,85 @@ static bool leaf_needs_material_split(PBVH *pbvh, int offset, int count)
   return false;
 }
 
+/* Node of the tree while it is built in parallel, see #pbvh_build. */
+typedef struct PBVHBuildNode {
+  struct PBVHBuildNode *children[2];
+  BB vb;
+  int offset, count;
+} PBVHBuildNode;
+
+typedef struct PBVHBuildData {
+  PBVH *pbvh;
+  BBC *prim_bbc;
+  int leaf_len;
+} PBVHBuildData;
+
+static float BB_surface_area(const BB *bb)
+{
+  float dim[3];
+  sub_v3_v3v3(dim, bb->bmax, bb->bmin);
+  return dim[0] * dim[1] + dim[1] * dim[2] + dim[2] * dim[0];
+}
+
+/* Find the split position with the lowest surface area heuristic cost, testing the boundaries
+ * of #SAH_BINS bins of centroids along each axis. Returns false if no split separates the
+ * primitives. */
+static bool build_sah_split(
+    PBVH *pbvh, const BB *cb, BBC *prim_bbc, int offset, int count, int *r_axis, float *r_mid)
+{
+  float cost_best = FLT_MAX;
+
+  for (int axis = 0; axis < 3; axis++) {
+    const float extent = cb->bmax[axis] - cb->bmin[axis];
+    if (extent <= 0.0f) {
+      continue;
+    }
+
+    BB bins_bb[SAH_BINS];
+    int bins_count[SAH_BINS] = {0};
+    for (int b = 0; b < SAH_BINS; b++) {
+      BB_reset(&bins_bb[b]);
+    }
+
+    const float scale = SAH_BINS / extent;
+    for (int i = offset + count - 1; i >= offset; i--) {
+      BBC *bbc = &prim_bbc[pbvh->prim_indices[i]];
+      const int b = min_ii((int)((bbc->bcentroid[axis] - cb->bmin[axis]) * scale), SAH_BINS - 1);
+      bins_count[b]++;
+      BB_expand_with_bb(&bins_bb[b], (BB *)bbc);
+    }
+
+    /* Cost of the right side of every split, sweeping from the right. */
+    float right_cost[SAH_BINS];
+    BB bb;
+    BB_reset(&bb);
+    int bb_count = 0;
+    for (int b = SAH_BINS - 1; b > 0; b--) {
+      BB_expand_with_bb(&bb, &bins_bb[b]);
+      bb_count += bins_count[b];
+      right_cost[b] = bb_count ? BB_surface_area(&bb) * bb_count : FLT_MAX;
+    }
+
+    BB_reset(&bb);
+    bb_count = 0;
+    for (int b = 0; b < SAH_BINS - 1; b++) {
+      BB_expand_with_bb(&bb, &bins_bb[b]);
+      bb_count += bins_count[b];
+      if (bb_count == 0 || right_cost[b + 1] == FLT_MAX) {
+        continue;
+      }
+      const float cost = BB_surface_area(&bb) * bb_count + right_cost[b + 1];
+      if (cost < cost_best) {
+        cost_best = cost;
+        *r_axis = axis;
+        *r_mid = cb->bmin[axis] + (b + 1) / scale;
+      }
+    }
+  }
+
+  return cost_best != FLT_MAX;
+}
+
 /* Recursively build a node in the tree
  *
  * vb is the voxel box around all of the primitives contained in
@@ -478,29 +565,38 @@ static bool leaf_needs_material_split(PBVH *pbvh, int offset, int count)
  * contained in this node
  *
  * offset and start indicate a range in the array of primitive indices
+ *
+ * Large children are built in tasks of the pool, the primitive ranges of nodes never overlap.
  */
 
-static void build_sub(PBVH *pbvh, int node_index, BB *cb, BBC *prim_bbc, int offset, int count)
+static void build_sub(TaskPool *pool, PBVHBuildData *data, PBVHBuildNode *node, BB *cb);
+
+static void build_sub_task_cb(TaskPool *__restrict pool, void *taskdata)
 {
+  build_sub(pool, BLI_task_pool_user_data(pool), taskdata, NULL);
+}
+
+static void build_sub(TaskPool *pool, PBVHBuildData *data, PBVHBuildNode *node, BB *cb)
+{
+  PBVH *pbvh = data->pbvh;
+  BBC *prim_bbc = data->prim_bbc;
+  const int offset = node->offset;
+  const int count = node->count;
   int end;
   BB cb_backing;
 
+  /* Still need vb for searches */
+  update_vb(pbvh, &node->vb, prim_bbc, offset, count);
+
   /* Decide whether this is a leaf or not */
   const bool below_leaf_limit = count <= pbvh->leaf_limit;
   if (below_leaf_limit) {
     if (!leaf_needs_material_split(pbvh, offset, count)) {
-      build_leaf(pbvh, node_index, prim_bbc, offset, count);
+      atomic_add_and_fetch_int32(&data->leaf_len, 1);
       return;
     }
   }
 
-  /* Add two child nodes */
-  pbvh->nodes[node_index].children_offset = pbvh->totnode;
-  pbvh_grow_nodes(pbvh, pbvh->totnode + 2);
-
-  /* Update parent node bounding box */
-  update_vb(pbvh, &pbvh->nodes[node_index], prim_bbc, offset, count);
-
   if (!below_leaf_limit) {
     /* Find axis with widest range of primitive centroids */
     if (!cb) {
@@ -510,15 +606,15 @@ static void build_sub(PBVH *pbvh, int node_index, BB *cb, BBC *prim_bbc, int off
         BB_expand(cb, prim_bbc[pbvh->prim_indices[i]].bcentroid);
       }
     }
-    const int axis = BB_widest_axis(cb);
+    int axis;
+    float mid;
+    if (!(pbvh->use_sah && build_sah_split(pbvh, cb, prim_bbc, offset, count, &axis, &mid))) {
+      axis = BB_widest_axis(cb);
+      mid = (cb->bmax[axis] + cb->bmin[axis]) * 0.5f;
+    }
 
     /* Partition primitives along that axis */
-    end = partition_indices(pbvh->prim_indices,
-                            offset,
-                            offset + count - 1,
-                            axis,
-                            (cb->bmax[axis] + cb->bmin[axis]) * 0.5f,
-                            prim_bbc);
+    end = partition_indices(pbvh->prim_indices, offset, offset + count - 1, axis, mid, prim_bbc);
   }
   else {
     /* Partition primitives by material */
@@ -526,13 +622,107 @@ static void build_sub(PBVH *pbvh, int node_index, BB *cb, BBC *prim_bbc, int off
   }
 
   /* Build children */
-  build_sub(pbvh, pbvh->nodes[node_index].children_offset, NULL, prim_bbc, offset, end - offset);
-  build_sub(pbvh,
-            pbvh->nodes[node_index].children_offset + 1,
-            NULL,
-            prim_bbc,
-            end,
-            offset + count - end);
+  for (int i = 0; i < 2; i++) {
+    PBVHBuildNode *child = MEM_callocN(sizeof(*child), __func__);
+    child->offset = (i == 0) ? offset : end;
+    child->count = (i == 0) ? end - offset : offset + count - end;
+    node->children[i] = child;
+  }
+  for (int i = 0; i < 2; i++) {
+    if (node->children[i]->count > pbvh->leaf_limit * BUILD_TASK_LEAF_LIMIT) {
+      BLI_task_pool_push(pool, build_sub_task_cb, node->children[i], false, NULL);
+    }
+    else {
+      build_sub(pool, data, node->children[i], NULL);
+    }
+  }
+}
+
+/* Store the nodes in the order a recursive build would create them, so the tree does not depend
+ * on the order tasks were run in. Leaf nodes are added to `leaves`. */
+static void build_flatten(
+    PBVH *pbvh, PBVHBuildNode *build_node, int node_index, int *leaves, int *r_leaf_len)
+{
+  PBVHNode *node = &pbvh->nodes[node_index];
+  node->vb = build_node->vb;
+  node->orig_vb = build_node->vb;
+
+  if (build_node->children[0] == NULL) {
+    node->flag |= PBVH_Leaf;
+    node->prim_indices = pbvh->prim_indices + build_node->offset;
+    node->totprim = build_node->count;
+    leaves[(*r_leaf_len)++] = node_index;
+    return;
+  }
+
+  /* Add two child nodes */
+  const int children_offset = pbvh->totnode;
+  pbvh->nodes[node_index].children_offset = children_offset;
+  pbvh_grow_nodes(pbvh, pbvh->totnode + 2);
+
+  for (int i = 0; i < 2; i++) {
+    build_flatten(pbvh, build_node->children[i], children_offset + i, leaves, r_leaf_len);
+    MEM_freeN(build_node->children[i]);
+  }
+}
+
+typedef struct PBVHBuildLeavesData {
+  PBVH *pbvh;
+  const int *leaves;
+} PBVHBuildLeavesData;
+
+/* A vertex is unique in the first leaf that uses it. */
+static void build_leaves_vert_leaf_cb(void *__restrict userdata,
+                                      const int leaf,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVHBuildLeavesData *data = userdata;
+  PBVH *pbvh = data->pbvh;
+  const PBVHNode *node = &pbvh->nodes[data->leaves[leaf]];
+
+  for (int i = 0; i < node->totprim; i++) {
+    const MLoopTri *lt = &pbvh->looptri[node->prim_indices[i]];
+    for (int j = 0; j < 3; j++) {
+      int *vert_leaf = &pbvh->vert_leaf[pbvh->mloop[lt->tri[j]].v];
+      int leaf_prev = *vert_leaf;
+      while (leaf < leaf_prev) {
+        const int leaf_found = atomic_cas_int32(vert_leaf, leaf_prev, leaf);
+        if (leaf_found == leaf_prev) {
+          break;
+        }
+        leaf_prev = leaf_found;
+      }
+    }
+  }
+}
+
+static void build_leaves_cb(void *__restrict userdata,
+                            const int leaf,
+                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  PBVHBuildLeavesData *data = userdata;
+  build_leaf(data->pbvh, data->leaves[leaf], leaf);
+}
+
+static void build_leaves(PBVH *pbvh, const int *leaves, int leaf_len)
+{
+  PBVHBuildLeavesData data = {
+      .pbvh = pbvh,
+      .leaves = leaves,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+
+  if (pbvh->looptri) {
+    pbvh->vert_leaf = MEM_malloc_arrayN(pbvh->totvert, sizeof(int), "bvh->vert_leaf");
+    copy_vn_i(pbvh->vert_leaf, pbvh->totvert, INT_MAX);
+    BLI_task_parallel_range(0, leaf_len, &data, build_leaves_vert_leaf_cb, &settings);
+  }
+
+  BLI_task_parallel_range(0, leaf_len, &data, build_leaves_cb, &settings);
+
+  MEM_SAFE_FREE(pbvh->vert_leaf);
 }
 
 static void pbvh_build(PBVH *pbvh, BB *cb, BBC *prim_bbc, int totprim)
@@ -556,8 +746,140 @@ static void pbvh_build(PBVH *pbvh, BB *cb, BBC *prim_bbc, int totprim)
     }
   }
 
+  PBVHBuildData data = {
+      .pbvh = pbvh,
+      .prim_bbc = prim_bbc,
+  };
+  PBVHBuildNode root = {{NULL}};
+  root.count = totprim;
+
+  TaskPool *pool = BLI_task_pool_create(&data, TASK_PRIORITY_HIGH);
+  build_sub(pool, &data, &root, cb);
+  BLI_task_pool_work_and_wait(pool);
+  BLI_task_pool_free(pool);
+
+  int *leaves = MEM_malloc_arrayN(data.leaf_len, sizeof(int), __func__);
+  int leaf_len = 0;
   pbvh->totnode = 1;
-  build_sub(pbvh, 0, cb, prim_bbc, 0, totprim);
+  build_flatten(pbvh, &root, 0, leaves, &leaf_len);
+  BLI_assert(leaf_len == data.leaf_len);
+
+  build_leaves(pbvh, leaves, leaf_len);
+  MEM_freeN(leaves);
+}
+
+typedef struct PBVHBuildPrimData {
+  PBVH *pbvh;
+  BBC *prim_bbc;
+} PBVHBuildPrimData;
+
+typedef struct PBVHBuildPrimTLSData {
+  /* Bounds of the centroids. */
+  BB cb;
+  /* Grids in the swap file are read into this buffer, without keeping them in memory. */
+  CCGElem *grid_buffer;
+} PBVHBuildPrimTLSData;
+
+static void build_prim_bbc_reduce(const void *__restrict UNUSED(userdata),
+                                  void *__restrict chunk_join,
+                                  void *__restrict chunk)
+{
+  PBVHBuildPrimTLSData *tls_join = chunk_join;
+  PBVHBuildPrimTLSData *tls = chunk;
+  BB_expand_with_bb(&tls_join->cb, &tls->cb);
+}
+
+static void build_prim_bbc_free(const void *__restrict UNUSED(userdata), void *__restrict chunk)
+{
+  PBVHBuildPrimTLSData *tls = chunk;
+  MEM_SAFE_FREE(tls->grid_buffer);
+}
+
+/* For each face, store the AABB and the AABB centroid */
+static void build_mesh_prim_bbc_cb(void *__restrict userdata,
+                                   const int i,
+                                   const TaskParallelTLS *__restrict tls)
+{
+  PBVHBuildPrimData *data = userdata;
+  PBVH *pbvh = data->pbvh;
+  const MLoopTri *lt = &pbvh->looptri[i];
+  const int sides = 3;
+  BBC *bbc = data->prim_bbc + i;
+
+  BB_reset((BB *)bbc);
+
+  for (int j = 0; j < sides; j++) {
+    BB_expand((BB *)bbc, pbvh->verts[pbvh->mloop[lt->tri[j]].v].co);
+  }
+
+  BBC_update_centroid(bbc);
+
+  PBVHBuildPrimTLSData *tls_data = tls->userdata_chunk;
+  BB_expand(&tls_data->cb, bbc->bcentroid);
+}
+
+/* For each grid, store the AABB and the AABB centroid */
+static void build_grids_prim_bbc_cb(void *__restrict userdata,
+                                    const int i,
+                                    const TaskParallelTLS *__restrict tls)
+{
+  PBVHBuildPrimData *data = userdata;
+  PBVHBuildPrimTLSData *tls_data = tls->userdata_chunk;
+  PBVH *pbvh = data->pbvh;
+  const CCGKey *key = &pbvh->gridkey;
+  CCGElem *grid = pbvh->grids[i];
+  BBC *bbc = data->prim_bbc + i;
+
+  if (grid == NULL && pbvh->subdiv_ccg != NULL) {
+    /* Paged out, only its bounds are needed. */
+    if (tls_data->grid_buffer == NULL) {
+      tls_data->grid_buffer = MEM_mallocN(key->grid_bytes, __func__);
+    }
+    grid = BKE_subdiv_ccg_grid_read(pbvh->subdiv_ccg, i, tls_data->grid_buffer);
+  }
+
+  BB_reset((BB *)bbc);
+
+  if (grid == NULL) {
+    /* Could not be read back from the swap file, its leaf stays paged out. */
+    const float zero[3] = {0.0f, 0.0f, 0.0f};
+    BB_expand((BB *)bbc, zero);
+  }
+  else {
+    for (int j = 0; j < key->grid_size * key->grid_size; j++) {
+      BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
+    }
+  }
+
+  BBC_update_centroid(bbc);
+
+  BB_expand(&tls_data->cb, bbc->bcentroid);
+}
+
+static void build_prim_bbc(PBVH *pbvh,
+                           BBC *prim_bbc,
+                           int totprim,
+                           TaskParallelRangeFunc func,
+                           BB *r_cb)
+{
+  PBVHBuildPrimData data = {
+      .pbvh = pbvh,
+      .prim_bbc = prim_bbc,
+  };
+
+  PBVHBuildPrimTLSData tls_data = {{{0}}};
+  BB_reset(&tls_data.cb);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = (pbvh->looptri) ? 1024 : 16;
+  settings.userdata_chunk = &tls_data;
+  settings.userdata_chunk_size = sizeof(tls_data);
+  settings.func_reduce = build_prim_bbc_reduce;
+  settings.func_free = build_prim_bbc_free;
+  BLI_task_parallel_range(0, totprim, &data, func, &settings);
+
+  *r_cb = tls_data.cb;
 }
 
 /**
@@ -587,7 +909,6 @@ void BKE_pbvh_build_mesh(PBVH *pbvh,
   pbvh->mloop = mloop;
   pbvh->looptri = looptri;
   pbvh->verts = verts;
-  pbvh->vert_bitmap = BLI_BITMAP_NEW(totvert, "bvh->vert_bitmap");
   pbvh->totvert = totvert;
   pbvh->leaf_limit = LEAF_LIMIT;
   pbvh->vdata = vdata;
@@ -597,33 +918,16 @@ void BKE_pbvh_build_mesh(PBVH *pbvh,
   pbvh->face_sets_color_seed = mesh->face_sets_color_seed;
   pbvh->face_sets_color_default = mesh->face_sets_color_default;
 
-  BB_reset(&cb);
-
   /* For each face, store the AABB and the AABB centroid */
   prim_bbc = MEM_mallocN(sizeof(BBC) * looptri_num, "prim_bbc");
 
-  for (int i = 0; i < looptri_num; i++) {
-    const MLoopTri *lt = &looptri[i];
-    const int sides = 3;
-    BBC *bbc = prim_bbc + i;
-
-    BB_reset((BB *)bbc);
-
-    for (int j = 0; j < sides; j++) {
-      BB_expand((BB *)bbc, verts[pbvh->mloop[lt->tri[j]].v].co);
-    }
-
-    BBC_update_centroid(bbc);
-
-    BB_expand(&cb, bbc->bcentroid);
-  }
+  build_prim_bbc(pbvh, prim_bbc, looptri_num, build_mesh_prim_bbc_cb, &cb);
 
   if (looptri_num) {
     pbvh_build(pbvh, &cb, prim_bbc, looptri_num);
   }
 
   MEM_freeN(prim_bbc);
-  MEM_freeN(pbvh->vert_bitmap);
 }
 
 /* Do a full rebuild with on Grids data structure */
@@ -647,37 +951,52 @@ void BKE_pbvh_build_grids(PBVH *pbvh,
   pbvh->leaf_limit = max_ii(LEAF_LIMIT / ((gridsize - 1) * (gridsize - 1)), 1);
 
   BB cb;
-  BB_reset(&cb);
 
   /* For each grid, store the AABB and the AABB centroid */
   BBC *prim_bbc = MEM_mallocN(sizeof(BBC) * totgrid, "prim_bbc");
 
-  for (int i = 0; i < totgrid; i++) {
-    CCGElem *grid = grids[i];
-    BBC *bbc = prim_bbc + i;
-
-    BB_reset((BB *)bbc);
-
-    for (int j = 0; j < gridsize * gridsize; j++) {
-      BB_expand((BB *)bbc, CCG_elem_offset_co(key, grid, j));
-    }
-
-    BBC_update_centroid(bbc);
-
-    BB_expand(&cb, bbc->bcentroid);
-  }
+  build_prim_bbc(pbvh, prim_bbc, totgrid, build_grids_prim_bbc_cb, &cb);
 
   if (totgrid) {
     pbvh_build(pbvh, &cb, prim_bbc, totgrid);
   }
 
   MEM_freeN(prim_bbc);
+
+  /* Leaves with grids missing are tried again on access. */
+  for (int i = 0; i < pbvh->totnode; i++) {
+    PBVHNode *node = &pbvh->nodes[i];
+    if (!(node->flag & PBVH_Leaf)) {
+      continue;
+    }
+    for (int j = 0; j < node->totprim; j++) {
+      if (grids[node->prim_indices[j]] == NULL) {
+        node->paged_out = true;
+        break;
+      }
+    }
+  }
+}
+
+/* Read back the paged out grids of the leaf, and mark them as recently used. Returns false when
+ * some of the grids could not be read, the leaf then stays paged out and is to be skipped. */
+static bool pbvh_node_grids_ensure(PBVH *pbvh, PBVHNode *node)
+{
+  node->page_stamp = pbvh->page_clock;
+  if (node->paged_out && pbvh->subdiv_ccg != NULL) {
+    if (!BKE_subdiv_ccg_grids_page_in(pbvh->subdiv_ccg, node->prim_indices, node->totprim)) {
+      return false;
+    }
+    node->paged_out = false;
+  }
+  return true;
 }
 
 PBVH *BKE_pbvh_new(void)
 {
   PBVH *pbvh = MEM_callocN(sizeof(PBVH), "pbvh");
   pbvh->respect_hide = true;
+  pbvh->bm_use_parallel_topology = true;
   return pbvh;
 }
 
@@ -1305,6 +1624,10 @@ static void pbvh_update_draw_buffer_cb(void *__restrict userdata,
     const int update_flags = pbvh_get_buffers_update_flags(pbvh);
     switch (pbvh->type) {
       case PBVH_GRIDS:
+        if (!pbvh_node_grids_ensure(pbvh, node)) {
+          /* Keep drawing what is in the buffers. */
+          break;
+        }
         GPU_pbvh_grid_buffers_update(node->draw_buffers,
                                      pbvh->subdiv_ccg,
                                      pbvh->grids,
@@ -1340,6 +1663,9 @@ static void pbvh_update_draw_buffer_cb(void *__restrict userdata,
   }
 }
 
+static bool pbvh_grids_use_paging(const PBVH *pbvh);
+static void pbvh_grids_page_out_over_limit(PBVH *pbvh);
+
 static void pbvh_update_draw_buffers(PBVH *pbvh, PBVHNode **nodes, int totnode, int update_flag)
 {
   if ((update_flag & PBVH_RebuildDrawBuffers) || ELEM(pbvh->type, PBVH_GRIDS, PBVH_BMESH)) {
@@ -1368,9 +1694,18 @@ static void pbvh_update_draw_buffers(PBVH *pbvh, PBVHNode **nodes, int totnode,
       .nodes = nodes,
   };
 
-  TaskParallelSettings settings;
-  BKE_pbvh_parallel_range_settings(&settings, true, totnode);
-  BLI_task_parallel_range(0, totnode, &data, pbvh_update_draw_buffer_cb, &settings);
+  /* With paging, update in batches and page grids out in between, the draw buffers don't need
+   * them anymore and updating all nodes would read back the whole swap file. */
+  const int batch_len = pbvh_grids_use_paging(pbvh) ? PAGING_DRAW_BATCH_NODES : totnode;
+  for (int start = 0; start < totnode; start += batch_len) {
+    const int end = min_ii(start + batch_len, totnode);
+    TaskParallelSettings settings;
+    BKE_pbvh_parallel_range_settings(&settings, true, end - start);
+    BLI_task_parallel_range(start, end, &data, pbvh_update_draw_buffer_cb, &settings);
+    if (end < totnode) {
+      pbvh_grids_page_out_over_limit(pbvh);
+    }
+  }
 }
 
 static int pbvh_flush_bb(PBVH *pbvh, PBVHNode *node, int flag)
@@ -1703,6 +2038,15 @@ struct CCGElem **BKE_pbvh_get_grids(const PBVH *pbvh)
   return pbvh->grids;
 }
 
+struct CCGElem *BKE_pbvh_get_grid(const PBVH *pbvh, int grid_index)
+{
+  BLI_assert(pbvh->type == PBVH_GRIDS);
+  if (pbvh->subdiv_ccg != NULL) {
+    return BKE_subdiv_ccg_grid_get(pbvh->subdiv_ccg, grid_index);
+  }
+  return pbvh->grids[grid_index];
+}
+
 BLI_bitmap **BKE_pbvh_get_grid_visibility(const PBVH *pbvh)
 {
   BLI_assert(pbvh->type == PBVH_GRIDS);
@@ -1868,12 +2212,14 @@ void BKE_pbvh_node_get_grids(PBVH *pbvh,
                              CCGElem ***r_griddata)
 {
   switch (pbvh->type) {
-    case PBVH_GRIDS:
+    case PBVH_GRIDS: {
+      /* A leaf with grids which can't be read is reported as empty, so it isn't edited. */
+      const bool has_grids = (r_griddata == NULL) || pbvh_node_grids_ensure(pbvh, node);
       if (r_grid_indices) {
         *r_grid_indices = node->prim_indices;
       }
       if (r_totgrid) {
-        *r_totgrid = node->totprim;
+        *r_totgrid = has_grids ? node->totprim : 0;
       }
       if (r_maxgrid) {
         *r_maxgrid = pbvh->totgrid;
@@ -1885,6 +2231,7 @@ void BKE_pbvh_node_get_grids(PBVH *pbvh,
         *r_griddata = pbvh->grids;
       }
       break;
+    }
     case PBVH_FACES:
     case PBVH_BMESH:
       if (r_grid_indices) {
@@ -2212,6 +2559,8 @@ static bool pbvh_grids_node_raycast(PBVH *pbvh,
   float nearest_vertex_co[3] = {0.0};
   const CCGKey *gridkey = &pbvh->gridkey;
 
+  pbvh_node_grids_ensure(pbvh, node);
+
   for (int i = 0; i < totgrid; i++) {
     const int grid_index = node->prim_indices[i];
     CCGElem *grid = pbvh->grids[grid_index];
@@ -2499,6 +2848,8 @@ static bool pbvh_grids_node_nearest_to_ray(PBVH *pbvh,
   const int gridsize = pbvh->gridkey.grid_size;
   bool hit = false;
 
+  pbvh_node_grids_ensure(pbvh, node);
+
   for (int i = 0; i < totgrid; i++) {
     CCGElem *grid = pbvh->grids[node->prim_indices[i]];
     BLI_bitmap *gh;
@@ -2748,6 +3099,10 @@ void BKE_pbvh_draw_cb(PBVH *pbvh,
 
   MEM_SAFE_FREE(nodes);
 
+  if (pbvh_grids_use_paging(pbvh)) {
+    pbvh_grids_page_out_over_limit(pbvh);
+  }
+
   PBVHDrawSearchData draw_data = {.frustum = draw_frustum, .accum_update_flag = 0};
   BKE_pbvh_search_gather(pbvh, pbvh_draw_search_cb, &draw_data, &nodes, &totnode);
 
@@ -2776,6 +3131,12 @@ void BKE_pbvh_draw_debug_cb(
 void BKE_pbvh_grids_update(
     PBVH *pbvh, CCGElem **grids, void **gridfaces, DMFlagMat *flagmats, BLI_bitmap **grid_hidden)
 {
+  if (grids != pbvh->grids) {
+    /* Grids of a new SubdivCCG may be in its swap file, leaves read them back on access. */
+    for (int a = 0; a < pbvh->totnode; a++) {
+      pbvh->nodes[a].paged_out = true;
+    }
+  }
   pbvh->grids = grids;
   pbvh->gridfaces = gridfaces;
 
@@ -3079,3 +3440,78 @@ void BKE_pbvh_respect_hide_set(PBVH *pbvh, bool respect_hide)
 {
   pbvh->respect_hide = respect_hide;
 }
+
+void BKE_pbvh_build_sah_set(PBVH *pbvh, bool use_sah)
+{
+  pbvh->use_sah = use_sah;
+}
+
+static bool pbvh_grids_use_paging(const PBVH *pbvh)
+{
+  return pbvh->type == PBVH_GRIDS && pbvh->subdiv_ccg != NULL && pbvh->subdiv_ccg->paging != NULL;
+}
+
+/* Leaves with normals to update are skipped, the update averages them with their neighbors and
+ * would read them back. */
+static bool pbvh_node_grids_can_page_out(const PBVHNode *node)
+{
+  return (node->flag & PBVH_Leaf) && !(node->flag & PBVH_UpdateNormals);
+}
+
+static int pbvh_node_page_stamp_cmp(const void *a_v, const void *b_v)
+{
+  const PBVHNode *a = *(const PBVHNode **)a_v;
+  const PBVHNode *b = *(const PBVHNode **)b_v;
+  return (a->page_stamp > b->page_stamp) - (a->page_stamp < b->page_stamp);
+}
+
+/* Page out the grids of the least recently used leaves, until the grids in memory fit in the
+ * memory limit of the SubdivCCG again. */
+static void pbvh_grids_page_out_over_limit(PBVH *pbvh)
+{
+  SubdivCCG *subdiv_ccg = pbvh->subdiv_ccg;
+  if (!BKE_subdiv_ccg_paging_over_limit(subdiv_ccg) ||
+      BKE_subdiv_ccg_paging_has_error(subdiv_ccg)) {
+    return;
+  }
+
+  PBVHNode **leaves = MEM_malloc_arrayN(pbvh->totnode, sizeof(*leaves), __func__);
+  int leaves_len = 0;
+  for (int i = 0; i < pbvh->totnode; i++) {
+    if (pbvh_node_grids_can_page_out(&pbvh->nodes[i])) {
+      leaves[leaves_len++] = &pbvh->nodes[i];
+    }
+  }
+  qsort(leaves, leaves_len, sizeof(*leaves), pbvh_node_page_stamp_cmp);
+
+  for (int i = 0; i < leaves_len && BKE_subdiv_ccg_paging_over_limit(subdiv_ccg); i++) {
+    PBVHNode *node = leaves[i];
+    BKE_subdiv_ccg_grids_page_out(subdiv_ccg, node->prim_indices, node->totprim);
+    node->paged_out = true;
+  }
+
+  MEM_freeN(leaves);
+}
+
+void BKE_pbvh_grids_page_out_stale(PBVH *pbvh)
+{
+  if (!pbvh_grids_use_paging(pbvh)) {
+    return;
+  }
+  SubdivCCG *subdiv_ccg = pbvh->subdiv_ccg;
+
+  for (int i = 0; i < pbvh->totnode; i++) {
+    PBVHNode *node = &pbvh->nodes[i];
+    if (!pbvh_node_grids_can_page_out(node)) {
+      continue;
+    }
+    if (pbvh->page_clock - node->page_stamp >= PAGING_STALE_AGE) {
+      /* Also done when already paged out, single grids may have been read back since. */
+      BKE_subdiv_ccg_grids_page_out(subdiv_ccg, node->prim_indices, node->totprim);
+      node->paged_out = true;
+    }
+  }
+  pbvh_grids_page_out_over_limit(pbvh);
+
+  pbvh->page_clock++;
+}
@@ -25,6 +25,7 @@
 #include "BLI_heap_simple.h"
 #include "BLI_math.h"
 #include "BLI_memarena.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_DerivedMesh.h"
@@ -992,6 +993,123 @@ static void short_edge_queue_face_add(EdgeQueueContext *eq_ctx, BMFace *f)
   }
 }
 
+/* Parallel queue creation.
+ *
+ * Testing the faces of a node against the brush (front-face, range and edge length) only reads
+ * the mesh, so the leaves are scanned on separate threads, each collecting the loops of its
+ * candidate edges. The heap, the edge tags and the mempool are then filled from those in node
+ * order on a single thread, this is where an edge shared by the faces of several leaves is only
+ * queued once. The resulting queue is the same as the one built by the serial loop. */
+
+typedef struct EdgeQueueCandidate {
+  BMLoop *l;
+  float len_sq;
+} EdgeQueueCandidate;
+
+typedef struct EdgeQueueGatherData {
+  const EdgeQueue *q;
+  PBVHNode **nodes;
+  EdgeQueueCandidate **candidates;
+  int *candidates_len;
+  bool use_long;
+} EdgeQueueGatherData;
+
+static void edge_queue_gather_task_cb(void *__restrict userdata,
+                                      const int n,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  EdgeQueueGatherData *data = userdata;
+  const EdgeQueue *q = data->q;
+  PBVHNode *node = data->nodes[n];
+  EdgeQueueCandidate *candidates = MEM_malloc_arrayN(
+      3 * BLI_gset_len(node->bm_faces), sizeof(*candidates), __func__);
+  int candidates_len = 0;
+
+  GSetIterator gs_iter;
+  GSET_ITER (gs_iter, node->bm_faces) {
+    BMFace *f = BLI_gsetIterator_getKey(&gs_iter);
+
+#ifdef USE_EDGEQUEUE_FRONTFACE
+    if (q->use_view_normal) {
+      if (dot_v3v3(f->no, q->view_normal) < 0.0f) {
+        continue;
+      }
+    }
+#endif
+
+    if (!q->edge_queue_tri_in_range(q, f)) {
+      continue;
+    }
+
+    BMLoop *l_first = BM_FACE_FIRST_LOOP(f);
+    BMLoop *l_iter = l_first;
+    do {
+      const float len_sq = BM_edge_calc_length_squared(l_iter->e);
+      if (data->use_long ? (len_sq > q->limit_len_squared) : (len_sq < q->limit_len_squared)) {
+        candidates[candidates_len].l = l_iter;
+        candidates[candidates_len].len_sq = len_sq;
+        candidates_len++;
+      }
+    } while ((l_iter = l_iter->next) != l_first);
+  }
+
+  data->candidates[n] = candidates;
+  data->candidates_len[n] = candidates_len;
+}
+
+static void edge_queue_nodes_add_parallel(EdgeQueueContext *eq_ctx,
+                                          PBVH *pbvh,
+                                          const bool use_long)
+{
+  PBVHNode **nodes = MEM_malloc_arrayN(pbvh->totnode, sizeof(*nodes), __func__);
+  int totnode = 0;
+
+  for (int n = 0; n < pbvh->totnode; n++) {
+    PBVHNode *node = &pbvh->nodes[n];
+
+    /* Check leaf nodes marked for topology update */
+    if ((node->flag & PBVH_Leaf) && (node->flag & PBVH_UpdateTopology) &&
+        !(node->flag & PBVH_FullyHidden)) {
+      nodes[totnode++] = node;
+    }
+  }
+
+  EdgeQueueGatherData data = {
+      .q = eq_ctx->q,
+      .nodes = nodes,
+      .candidates = MEM_malloc_arrayN(totnode, sizeof(*data.candidates), __func__),
+      .candidates_len = MEM_malloc_arrayN(totnode, sizeof(*data.candidates_len), __func__),
+      .use_long = use_long,
+  };
+
+  TaskParallelSettings settings;
+  BKE_pbvh_parallel_range_settings(&settings, true, totnode);
+  BLI_task_parallel_range(0, totnode, &data, edge_queue_gather_task_cb, &settings);
+
+  for (int n = 0; n < totnode; n++) {
+    const EdgeQueueCandidate *candidates = data.candidates[n];
+    for (int i = 0; i < data.candidates_len[n]; i++) {
+      BMLoop *l = candidates[i].l;
+      if (use_long) {
+#ifdef USE_EDGEQUEUE_EVEN_SUBDIV
+        long_edge_queue_edge_add_recursive(
+            eq_ctx, l->radial_next, l, candidates[i].len_sq, eq_ctx->q->limit_len);
+#else
+        long_edge_queue_edge_add(eq_ctx, l->e);
+#endif
+      }
+      else {
+        short_edge_queue_edge_add(eq_ctx, l->e);
+      }
+    }
+    MEM_freeN(data.candidates[n]);
+  }
+
+  MEM_freeN(data.candidates);
+  MEM_freeN(data.candidates_len);
+  MEM_freeN(nodes);
+}
+
 /* Create a priority queue containing vertex pairs connected by a long
  * edge as defined by PBVH.bm_max_edge_len.
  *
@@ -1037,6 +1155,11 @@ static void long_edge_queue_create(EdgeQueueContext *eq_ctx,
   pbvh_bmesh_edge_tag_verify(pbvh);
 #endif
 
+  if (pbvh->bm_use_parallel_topology) {
+    edge_queue_nodes_add_parallel(eq_ctx, pbvh, true);
+    return;
+  }
+
   for (int n = 0; n < pbvh->totnode; n++) {
     PBVHNode *node = &pbvh->nodes[n];
 
@@ -1096,6 +1219,11 @@ static void short_edge_queue_create(EdgeQueueContext *eq_ctx,
     eq_ctx->q->edge_queue_tri_in_range = edge_queue_tri_in_sphere;
   }
 
+  if (pbvh->bm_use_parallel_topology) {
+    edge_queue_nodes_add_parallel(eq_ctx, pbvh, false);
+    return;
+  }
+
   for (int n = 0; n < pbvh->totnode; n++) {
     PBVHNode *node = &pbvh->nodes[n];
 
@@ -2116,6 +2244,11 @@ void BKE_pbvh_bmesh_detail_size_set(PBVH *pbvh, float detail_size)
   pbvh->bm_min_edge_len = pbvh->bm_max_edge_len * 0.4f;
 }
 
+void BKE_pbvh_bmesh_parallel_topology_set(PBVH *pbvh, bool use_parallel)
+{
+  pbvh->bm_use_parallel_topology = use_parallel;
+}
+
 void BKE_pbvh_node_mark_topology_update(PBVHNode *node)
 {
   node->flag |= PBVH_UpdateTopology;
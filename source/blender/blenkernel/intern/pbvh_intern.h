@@ -108,6 +108,11 @@ struct PBVHNode {
 
   /* Used to store the brush color during a stroke and composite it over the original color */
   PBVHColorBufferNode color_buffer;
+
+  /* Multires grids paging: PBVH.page_clock when the grids were last accessed, and whether some
+   * of them may be in the swap file. */
+  int page_stamp;
+  bool paged_out;
 };
 
 typedef enum {
@@ -153,7 +158,7 @@ struct PBVH {
 
   /* Only used during BVH build and update,
    * don't need to remain valid after */
-  BLI_bitmap *vert_bitmap;
+  int *vert_leaf;
 
 #ifdef PERFCNTRS
   int perf_modified;
@@ -164,11 +169,17 @@ struct PBVH {
   bool show_mask;
   bool show_face_sets;
   bool respect_hide;
+  /* Split nodes using the surface area heuristic instead of the middle of the centroids. */
+  bool use_sah;
+  /* Clock of the paging of grids to the swap file of the SubdivCCG, advances every
+   * BKE_pbvh_grids_page_out_stale(). */
+  int page_clock;
 
   /* Dynamic topology */
   BMesh *bm;
   float bm_max_edge_len;
   float bm_min_edge_len;
+  bool bm_use_parallel_topology;
   int cd_vert_node_offset;
   int cd_face_node_offset;
 
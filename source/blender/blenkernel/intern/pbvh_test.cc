@@ -0,0 +1,503 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_bitmap.h"
+#include "BLI_math.h"
+#include "BLI_rand.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_mesh.h"
+#include "BKE_pbvh.h"
+
+#include "PIL_time.h"
+
+#include "bmesh.h"
+
+#include "pbvh_intern.h"
+}
+
+namespace blender::bke::tests {
+
+/* Wavy grid of quads, large enough for the tree to have a few levels. */
+class PBVHTestMesh {
+ public:
+  Mesh mesh = {};
+  MVert *mvert;
+  MLoop *mloop;
+  MPoly *mpoly;
+  int totvert, totloop, totpoly;
+
+  PBVHTestMesh(const int size)
+  {
+    totvert = (size + 1) * (size + 1);
+    totpoly = size * size;
+    totloop = totpoly * 4;
+    mvert = (MVert *)MEM_calloc_arrayN(totvert, sizeof(MVert), __func__);
+    mloop = (MLoop *)MEM_calloc_arrayN(totloop, sizeof(MLoop), __func__);
+    mpoly = (MPoly *)MEM_calloc_arrayN(totpoly, sizeof(MPoly), __func__);
+
+    MVert *mv = mvert;
+    for (int y = 0; y <= size; y++) {
+      for (int x = 0; x <= size; x++, mv++) {
+        const float u = (float)x / size, v = (float)y / size;
+        mv->co[0] = u;
+        mv->co[1] = v;
+        mv->co[2] = 0.1f * sinf(u * 13.0f) * cosf(v * 7.0f) * u;
+      }
+    }
+
+    MLoop *ml = mloop;
+    MPoly *mp = mpoly;
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++, mp++, ml += 4) {
+        const int v = y * (size + 1) + x;
+        mp->loopstart = (int)(ml - mloop);
+        mp->totloop = 4;
+        ml[0].v = v;
+        ml[1].v = v + 1;
+        ml[2].v = v + size + 2;
+        ml[3].v = v + size + 1;
+      }
+    }
+  }
+
+  ~PBVHTestMesh()
+  {
+    MEM_freeN(mvert);
+    MEM_freeN(mloop);
+    MEM_freeN(mpoly);
+  }
+
+  PBVH *pbvh_build(const bool use_sah)
+  {
+    const int looptri_num = poly_to_tri_count(totpoly, totloop);
+    MLoopTri *looptri = (MLoopTri *)MEM_malloc_arrayN(looptri_num, sizeof(MLoopTri), __func__);
+    BKE_mesh_recalc_looptri(mloop, mpoly, mvert, totloop, totpoly, looptri);
+
+    PBVH *pbvh = BKE_pbvh_new();
+    BKE_pbvh_build_sah_set(pbvh, use_sah);
+    BKE_pbvh_build_mesh(pbvh,
+                        &mesh,
+                        mpoly,
+                        mloop,
+                        mvert,
+                        totvert,
+                        &mesh.vdata,
+                        &mesh.ldata,
+                        &mesh.pdata,
+                        looptri,
+                        looptri_num);
+    return pbvh;
+  }
+};
+
+static bool BB_contains(const BB *bb, const BB *bb_inner)
+{
+  for (int i = 0; i < 3; i++) {
+    if (bb_inner->bmin[i] < bb->bmin[i] || bb_inner->bmax[i] > bb->bmax[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Every primitive is in exactly one leaf and every vertex is unique to exactly one leaf. */
+static void pbvh_test_nodes(PBVH *pbvh, const PBVHTestMesh &tm)
+{
+  BLI_bitmap *prim_used = BLI_BITMAP_NEW(pbvh->totprim, __func__);
+  int totprim = 0, uniq_verts = 0;
+
+  for (int i = 0; i < pbvh->totnode; i++) {
+    const PBVHNode *node = &pbvh->nodes[i];
+    if (node->flag & PBVH_Leaf) {
+      for (uint p = 0; p < node->totprim; p++) {
+        EXPECT_FALSE(BLI_BITMAP_TEST(prim_used, node->prim_indices[p]));
+        BLI_BITMAP_ENABLE(prim_used, node->prim_indices[p]);
+      }
+      totprim += node->totprim;
+      uniq_verts += node->uniq_verts;
+    }
+    else {
+      EXPECT_TRUE(BB_contains(&node->vb, &pbvh->nodes[node->children_offset].vb));
+      EXPECT_TRUE(BB_contains(&node->vb, &pbvh->nodes[node->children_offset + 1].vb));
+    }
+  }
+
+  EXPECT_EQ(totprim, pbvh->totprim);
+  EXPECT_EQ(uniq_verts, tm.totvert);
+  MEM_freeN(prim_used);
+}
+
+TEST(pbvh, BuildMedian)
+{
+  PBVHTestMesh tm(256);
+  PBVH *pbvh = tm.pbvh_build(false);
+  EXPECT_GT(pbvh->totnode, 1);
+  pbvh_test_nodes(pbvh, tm);
+  BKE_pbvh_free(pbvh);
+}
+
+TEST(pbvh, BuildSAH)
+{
+  PBVHTestMesh tm(256);
+  PBVH *pbvh = tm.pbvh_build(true);
+  EXPECT_GT(pbvh->totnode, 1);
+  pbvh_test_nodes(pbvh, tm);
+  BKE_pbvh_free(pbvh);
+}
+
+/* The tree built in parallel doesn't depend on the order the tasks ran in. */
+TEST(pbvh, BuildDeterministic)
+{
+  PBVHTestMesh tm(256);
+  PBVH *pbvh_a = tm.pbvh_build(true);
+  PBVH *pbvh_b = tm.pbvh_build(true);
+
+  ASSERT_EQ(pbvh_a->totnode, pbvh_b->totnode);
+  EXPECT_EQ(
+      memcmp(pbvh_a->prim_indices, pbvh_b->prim_indices, sizeof(int) * pbvh_a->totprim), 0);
+  for (int i = 0; i < pbvh_a->totnode; i++) {
+    const PBVHNode *node_a = &pbvh_a->nodes[i];
+    const PBVHNode *node_b = &pbvh_b->nodes[i];
+    EXPECT_EQ(node_a->flag & PBVH_Leaf, node_b->flag & PBVH_Leaf);
+    if (node_a->flag & PBVH_Leaf) {
+      EXPECT_EQ(node_a->prim_indices - pbvh_a->prim_indices,
+                node_b->prim_indices - pbvh_b->prim_indices);
+      EXPECT_EQ(node_a->uniq_verts, node_b->uniq_verts);
+      EXPECT_EQ(node_a->face_verts, node_b->face_verts);
+    }
+    else {
+      EXPECT_EQ(node_a->children_offset, node_b->children_offset);
+    }
+  }
+
+  BKE_pbvh_free(pbvh_a);
+  BKE_pbvh_free(pbvh_b);
+}
+
+struct RaycastData {
+  PBVH *pbvh;
+  const float *ray_start;
+  const float *ray_normal;
+  IsectRayPrecalc isect_precalc;
+  float depth;
+  bool hit;
+  int nodes_len;
+};
+
+static void raycast_cb(PBVHNode *node, void *data_v, float *tmin)
+{
+  RaycastData *data = (RaycastData *)data_v;
+  int active_vertex_index, active_face_grid_index;
+  float face_normal[3];
+
+  data->nodes_len++;
+  if (BKE_pbvh_node_raycast(data->pbvh,
+                            node,
+                            NULL,
+                            false,
+                            data->ray_start,
+                            data->ray_normal,
+                            &data->isect_precalc,
+                            &data->depth,
+                            &active_vertex_index,
+                            &active_face_grid_index,
+                            face_normal)) {
+    data->hit = true;
+    *tmin = data->depth;
+  }
+}
+
+/* Cast the same rays on the trees from both split methods, they must find the same hits.
+ * Also reports the build time and the ray-cast throughput of each. */
+TEST(pbvh, RaycastMedianSAH)
+{
+  const int rays_len = 20000;
+  PBVHTestMesh tm(512);
+  float(*ray_starts)[3] = (float(*)[3])MEM_malloc_arrayN(rays_len, sizeof(float[3]), __func__);
+  float(*ray_normals)[3] = (float(*)[3])MEM_malloc_arrayN(rays_len, sizeof(float[3]), __func__);
+  float *depths[2];
+  bool *hits[2];
+
+  RNG *rng = BLI_rng_new(0);
+  for (int i = 0; i < rays_len; i++) {
+    ray_starts[i][0] = BLI_rng_get_float(rng);
+    ray_starts[i][1] = BLI_rng_get_float(rng);
+    ray_starts[i][2] = 1.0f;
+    ray_normals[i][0] = BLI_rng_get_float(rng) - 0.5f;
+    ray_normals[i][1] = BLI_rng_get_float(rng) - 0.5f;
+    ray_normals[i][2] = -1.0f;
+    normalize_v3(ray_normals[i]);
+  }
+  BLI_rng_free(rng);
+
+  for (int use_sah = 0; use_sah < 2; use_sah++) {
+    const double build_start = PIL_check_seconds_timer();
+    PBVH *pbvh = tm.pbvh_build(use_sah);
+    const double build_time = PIL_check_seconds_timer() - build_start;
+
+    depths[use_sah] = (float *)MEM_malloc_arrayN(rays_len, sizeof(float), __func__);
+    hits[use_sah] = (bool *)MEM_malloc_arrayN(rays_len, sizeof(bool), __func__);
+    int nodes_len = 0;
+
+    const double raycast_start = PIL_check_seconds_timer();
+    for (int i = 0; i < rays_len; i++) {
+      RaycastData data = {};
+      data.pbvh = pbvh;
+      data.ray_start = ray_starts[i];
+      data.ray_normal = ray_normals[i];
+      data.depth = FLT_MAX;
+      isect_ray_tri_watertight_v3_precalc(&data.isect_precalc, ray_normals[i]);
+      BKE_pbvh_raycast(pbvh, raycast_cb, &data, ray_starts[i], ray_normals[i], false);
+      depths[use_sah][i] = data.depth;
+      hits[use_sah][i] = data.hit;
+      nodes_len += data.nodes_len;
+    }
+    const double raycast_time = PIL_check_seconds_timer() - raycast_start;
+
+    printf("%s: %d nodes, build %.2f ms, %.0f rays/s, %.2f leaves/ray\n",
+           use_sah ? "SAH" : "Median",
+           pbvh->totnode,
+           build_time * 1e3,
+           rays_len / raycast_time,
+           (double)nodes_len / rays_len);
+
+    BKE_pbvh_free(pbvh);
+  }
+
+  for (int i = 0; i < rays_len; i++) {
+    EXPECT_EQ(hits[0][i], hits[1][i]);
+    if (hits[0][i] && hits[1][i]) {
+      EXPECT_FLOAT_EQ(depths[0][i], depths[1][i]);
+    }
+  }
+
+  for (int i = 0; i < 2; i++) {
+    MEM_freeN(depths[i]);
+    MEM_freeN(hits[i]);
+  }
+  MEM_freeN(ray_starts);
+  MEM_freeN(ray_normals);
+}
+
+/* Triangulated grid in dynamic topology mode, set up the way sculpt mode does. The vertices are
+ * jittered so edges have distinct lengths, which makes the order edges leave the queues in
+ * independent of the order they were added in. */
+class PBVHTestBMesh {
+ public:
+  BMesh *bm;
+  BMLog *bm_log;
+  PBVH *pbvh;
+
+  PBVHTestBMesh(const int size, const bool use_parallel)
+  {
+    BMeshCreateParams create_params = {};
+    create_params.use_toolflags = false;
+    bm = BM_mesh_create(&bm_mesh_allocsize_default, &create_params);
+
+    BMVert **verts = (BMVert **)MEM_malloc_arrayN(
+        (size + 1) * (size + 1), sizeof(BMVert *), __func__);
+    RNG *rng = BLI_rng_new(0);
+    for (int y = 0, i = 0; y <= size; y++) {
+      for (int x = 0; x <= size; x++, i++) {
+        float co[3] = {(float)x, (float)y, 0.0f};
+        if (x > 0 && x < size && y > 0 && y < size) {
+          co[0] += 0.3f * (BLI_rng_get_float(rng) - 0.5f);
+          co[1] += 0.3f * (BLI_rng_get_float(rng) - 0.5f);
+        }
+        mul_v3_fl(co, 1.0f / size);
+        verts[i] = BM_vert_create(bm, co, NULL, BM_CREATE_NOP);
+      }
+    }
+    BLI_rng_free(rng);
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        const int v = y * (size + 1) + x;
+        BMVert *tris[2][3] = {{verts[v], verts[v + 1], verts[v + size + 2]},
+                              {verts[v], verts[v + size + 2], verts[v + size + 1]}};
+        for (int i = 0; i < 2; i++) {
+          BM_face_create_verts(bm, tris[i], 3, NULL, BM_CREATE_NOP, true);
+        }
+      }
+    }
+    MEM_freeN(verts);
+    BM_mesh_normals_update(bm);
+
+    BM_data_layer_add(bm, &bm->vdata, CD_PAINT_MASK);
+    BM_data_layer_add(bm, &bm->vdata, CD_PROP_INT32);
+    BM_data_layer_add(bm, &bm->pdata, CD_PROP_INT32);
+
+    bm_log = BM_log_create(bm);
+    BM_log_entry_add(bm_log);
+
+    pbvh = BKE_pbvh_new();
+    BKE_pbvh_bmesh_parallel_topology_set(pbvh, use_parallel);
+    BKE_pbvh_build_bmesh(pbvh,
+                         bm,
+                         false,
+                         bm_log,
+                         CustomData_get_offset(&bm->vdata, CD_PROP_INT32),
+                         CustomData_get_offset(&bm->pdata, CD_PROP_INT32));
+  }
+
+  ~PBVHTestBMesh()
+  {
+    BKE_pbvh_free(pbvh);
+    BM_log_free(bm_log);
+    BM_mesh_free(bm);
+  }
+};
+
+struct SphereSearchData {
+  const float *center;
+  float radius_squared;
+};
+
+static bool sphere_search_cb(PBVHNode *node, void *data_v)
+{
+  SphereSearchData *data = (SphereSearchData *)data_v;
+  float bb_min[3], bb_max[3], nearest[3];
+
+  BKE_pbvh_node_get_BB(node, bb_min, bb_max);
+  for (int i = 0; i < 3; i++) {
+    nearest[i] = clamp_f(data->center[i], bb_min[i], bb_max[i]);
+  }
+  return len_squared_v3v3(data->center, nearest) <= data->radius_squared;
+}
+
+/* Dabs along a straight stroke across the grid, returns the time spent updating the topology. */
+static double pbvh_test_stroke(PBVH *pbvh, PBVHTopologyUpdateMode mode, const float radius)
+{
+  const int dabs_len = 32;
+  double time = 0.0;
+
+  for (int i = 0; i < dabs_len; i++) {
+    const float center[3] = {0.2f + 0.6f * i / (dabs_len - 1), 0.5f, 0.0f};
+    SphereSearchData data = {center, radius * radius};
+    PBVHNode **nodes = NULL;
+    int totnode;
+
+    BKE_pbvh_search_gather(pbvh, sphere_search_cb, &data, &nodes, &totnode);
+    for (int n = 0; n < totnode; n++) {
+      BKE_pbvh_node_mark_topology_update(nodes[n]);
+    }
+    MEM_SAFE_FREE(nodes);
+
+    const double start = PIL_check_seconds_timer();
+    BKE_pbvh_bmesh_update_topology(pbvh, mode, center, NULL, radius, false, false);
+    time += PIL_check_seconds_timer() - start;
+
+    BKE_pbvh_update_bounds(pbvh, PBVH_UpdateBB);
+  }
+
+  BKE_pbvh_bmesh_after_stroke(pbvh);
+  return time;
+}
+
+/* Every face is in the leaf it points to and the leaves don't have any other faces. */
+static void pbvh_test_bmesh_nodes(PBVH *pbvh)
+{
+  BMesh *bm = pbvh->bm;
+  int totface = 0;
+
+  for (int i = 0; i < pbvh->totnode; i++) {
+    const PBVHNode *node = &pbvh->nodes[i];
+    if (node->flag & PBVH_Leaf) {
+      totface += BLI_gset_len(node->bm_faces);
+    }
+  }
+  EXPECT_EQ(totface, bm->totface);
+
+  BMIter iter;
+  BMFace *f;
+  BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+    const int node_index = BM_ELEM_CD_GET_INT(f, pbvh->cd_face_node_offset);
+    ASSERT_TRUE(node_index >= 0 && node_index < pbvh->totnode);
+    EXPECT_TRUE(BLI_gset_haskey(pbvh->nodes[node_index].bm_faces, f));
+  }
+}
+
+/* Subdivide then collapse along a stroke with the edge queues created on one and on multiple
+ * threads. After subdividing, no face in reach of the brush may have an edge longer than the
+ * detail size. Both queues are the same, so both runs have to end up with the same mesh. Also
+ * reports the edges split and the vertices removed per second. */
+TEST(pbvh, DyntopoStrokeParallel)
+{
+  const float detail_size = 0.002f;
+  const float radius = 0.1f;
+  int subdivide_totelem[2][3], collapse_totelem[2][3];
+
+  for (int use_parallel = 0; use_parallel < 2; use_parallel++) {
+    PBVHTestBMesh tb(128, use_parallel);
+    BMesh *bm = tb.bm;
+
+    const int subdivide_totvert = bm->totvert;
+    BKE_pbvh_bmesh_detail_size_set(tb.pbvh, detail_size);
+    const double subdivide_time = pbvh_test_stroke(tb.pbvh, PBVH_Subdivide, radius);
+    /* Each split adds one vertex. */
+    const int edges_split = bm->totvert - subdivide_totvert;
+    EXPECT_GT(edges_split, 0);
+    pbvh_test_bmesh_nodes(tb.pbvh);
+    subdivide_totelem[use_parallel][0] = bm->totvert;
+    subdivide_totelem[use_parallel][1] = bm->totedge;
+    subdivide_totelem[use_parallel][2] = bm->totface;
+
+    /* Stay inside the union of the dab spheres. */
+    const float stroke_start[3] = {0.2f, 0.5f, 0.0f}, stroke_end[3] = {0.8f, 0.5f, 0.0f};
+    const float reach_squared = square_f(radius * 0.9f);
+    BMIter iter;
+    BMEdge *e;
+    BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
+      if (dist_squared_to_line_segment_v3(e->v1->co, stroke_start, stroke_end) < reach_squared &&
+          dist_squared_to_line_segment_v3(e->v2->co, stroke_start, stroke_end) < reach_squared) {
+        EXPECT_LE(BM_edge_calc_length_squared(e), square_f(detail_size) * 1.0001f);
+      }
+    }
+
+    const int collapse_totvert = bm->totvert;
+    BKE_pbvh_bmesh_detail_size_set(tb.pbvh, detail_size * 4.0f);
+    const double collapse_time = pbvh_test_stroke(tb.pbvh, PBVH_Collapse, radius);
+    const int verts_removed = collapse_totvert - bm->totvert;
+    EXPECT_GT(verts_removed, 0);
+    pbvh_test_bmesh_nodes(tb.pbvh);
+    collapse_totelem[use_parallel][0] = bm->totvert;
+    collapse_totelem[use_parallel][1] = bm->totedge;
+    collapse_totelem[use_parallel][2] = bm->totface;
+
+    printf("%s: %d edges split at %.0f edges/s, %d verts removed at %.0f verts/s\n",
+           use_parallel ? "Parallel" : "Serial",
+           edges_split,
+           edges_split / subdivide_time,
+           verts_removed,
+           verts_removed / collapse_time);
+  }
+
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(subdivide_totelem[0][i], subdivide_totelem[1][i]);
+    EXPECT_EQ(collapse_totelem[0][i], collapse_totelem[1][i]);
+  }
+}
+
+}  // namespace blender::bke::tests
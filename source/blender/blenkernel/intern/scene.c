@@ -101,6 +101,8 @@
 #include "DEG_depsgraph_debug.h"
 #include "DEG_depsgraph_query.h"
 
+#include "MOD_modifiertypes.h"
+
 #include "RE_engine.h"
 
 #include "engines/eevee/eevee_lightcache.h"
@@ -1499,6 +1501,8 @@ static void scene_graph_update_tagged(Depsgraph *depsgraph, Main *bmain, bool on
      * by depgraph or manual, no layer check here, gets correct flushed.
      */
     DEG_evaluate_on_refresh(bmain, depsgraph);
+    /* Tag objects of which the adaptive subdivision levels changed, for the next pass. */
+    MOD_subsurf_adaptive_levels_tag_update(depsgraph);
     /* Update sound system. */
     BKE_scene_update_sound(depsgraph, bmain);
     /* Notify python about depsgraph update. */
@@ -1574,6 +1578,8 @@ void BKE_scene_graph_update_for_newframe(Depsgraph *depsgraph, Main *bmain)
     else {
       DEG_evaluate_on_refresh(bmain, depsgraph);
     }
+    /* Tag objects of which the adaptive subdivision levels changed, for the next pass. */
+    MOD_subsurf_adaptive_levels_tag_update(depsgraph);
     /* Update sound system animation. */
     BKE_scene_update_sound(depsgraph, bmain);
 
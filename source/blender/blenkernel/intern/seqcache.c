@@ -49,6 +49,21 @@
 #include "BKE_scene.h"
 #include "BKE_sequencer.h"
 
+#include "atomic_ops.h"
+
+#include "zlib.h"
+
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#  define LZO_HEAP_ALLOC(var, size) \
+    lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
+#  define LZO_OUT_LEN(size) ((size) + (size) / 16 + 64 + 3)
+#endif
+
 /**
  * Sequencer Cache Design Notes
  * ============================
@@ -81,8 +96,15 @@
  * For each cached non-temp image, image data and supplementary info are written to HDD.
  * Multiple(DCACHE_IMAGES_PER_FILE) images share the same file.
  * Each of these files contains header DiskCacheHeader followed by image data.
- * Zlib compression with user definable level can be used to compress image data(per image)
+ * Image data is stored per image either uncompressed, compressed with LZO in independent
+ * blocks of DCACHE_LZO_BLOCK_SIZE bytes (fast, used for low compression level) or compressed
+ * with Zlib (used for high compression level). Codec is stored in header entry.
  * Images are written in order in which they are rendered.
+ * Writing is done by background thread, so playback and prefetching don't have to wait for
+ * compression and I/O. Writes that were queued before invalidation are discarded.
+ * Images are compressed into memory before the lock of the disk cache is taken, the lock is
+ * only held for access to the file, so reading isn't blocked by compression.
+ * Reading ahead of playhead is done by prefetching, which tries disk cache before rendering.
  * Overwriting of individual entry is not possible.
  * Stored images are deleted by invalidation, or when size of all files exceeds maximum
  * size specified in user preferences.
@@ -94,11 +116,21 @@
 /* <cache type>-<resolution X>x<resolution Y>-<rendersize>%(<view_id>)-<frame no>.dcf */
 #define DCACHE_FNAME_FORMAT "%d-%dx%d-%d%%(%d)-%d.dcf"
 #define DCACHE_IMAGES_PER_FILE 100
-#define DCACHE_CURRENT_VERSION 1
+#define DCACHE_CURRENT_VERSION 2
+#define DCACHE_LZO_BLOCK_SIZE (1 << 20)
+#define DCACHE_WRITE_QUEUE_MAX_SIZE ((size_t)256 * 1024 * 1024)
 #define COLORSPACE_NAME_MAX 64 /* XXX: defined in imb intern */
 
+/* DiskCacheHeaderEntry.codec */
+enum {
+  DCACHE_CODEC_NONE = 0,
+  DCACHE_CODEC_ZLIB = 1,
+  DCACHE_CODEC_LZO = 2,
+};
+
 typedef struct DiskCacheHeaderEntry {
   unsigned char encoding;
+  unsigned char codec;
   uint64_t frameno;
   uint64_t size_compressed;
   uint64_t size_raw;
@@ -116,8 +148,27 @@ typedef struct SeqDiskCache {
   ListBase files;
   ThreadMutex read_write_mutex;
   size_t size_total;
+  /* Images waiting to be written by write thread. */
+  ThreadQueue *write_queue;
+  /* Memory used by images in the write queue. */
+  size_t write_queue_size;
+  ListBase write_threads;
+  /* Incremented on invalidation, queued writes with different value are discarded. */
+  int invalidate_count;
 } SeqDiskCache;
 
+typedef struct DiskCacheWriteJob {
+  char path[FILE_MAX];
+  float nfra;
+  ImBuf *ibuf;
+  size_t ibuf_size;
+  int invalidate_count;
+  /* Compression settings at the time the image was queued, so the write thread doesn't read
+   * user preferences. */
+  int codec;
+  int compression_level;
+} DiskCacheWriteJob;
+
 typedef struct DiskCacheFile {
   struct DiskCacheFile *next, *prev;
   char path[FILE_MAX];
@@ -138,7 +189,8 @@ typedef struct SeqCache {
   ThreadMutex iterator_mutex;
   struct BLI_mempool *keys_pool;
   struct BLI_mempool *items_pool;
-  struct SeqCacheKey *last_key;
+  /* Last linked key for each task, so tasks rendering in parallel don't mix links. */
+  struct SeqCacheKey *last_key[SEQ_TASK_MAX];
   size_t memory_used;
   SeqDiskCache *disk_cache;
 } SeqCache;
@@ -186,6 +238,22 @@ static int seq_disk_cache_compression_level(void)
   return U.sequencer_disk_cache_compression;
 }
 
+static int seq_disk_cache_codec(void)
+{
+  switch (U.sequencer_disk_cache_compression) {
+    case USER_SEQ_DISK_CACHE_COMPRESSION_NONE:
+      return DCACHE_CODEC_NONE;
+    case USER_SEQ_DISK_CACHE_COMPRESSION_LOW:
+#ifdef WITH_LZO
+      return DCACHE_CODEC_LZO;
+#else
+      return DCACHE_CODEC_ZLIB;
+#endif
+  }
+
+  return DCACHE_CODEC_ZLIB;
+}
+
 static size_t seq_disk_cache_size_limit(void)
 {
   return (size_t)U.sequencer_disk_cache_size_limit * (1024 * 1024 * 1024);
@@ -309,7 +377,8 @@ static bool seq_disk_cache_enforce_limits(SeqDiskCache *disk_cache)
   return true;
 }
 
-static DiskCacheFile *seq_disk_cache_get_file_entry_by_path(SeqDiskCache *disk_cache, char *path)
+static DiskCacheFile *seq_disk_cache_get_file_entry_by_path(SeqDiskCache *disk_cache,
+                                                            const char *path)
 {
   DiskCacheFile *cache_file = disk_cache->files.first;
 
@@ -323,7 +392,7 @@ static DiskCacheFile *seq_disk_cache_get_file_entry_by_path(SeqDiskCache *disk_c
 }
 
 /* Update file size and timestamp. */
-static void seq_disk_cache_update_file(SeqDiskCache *disk_cache, char *path)
+static void seq_disk_cache_update_file(SeqDiskCache *disk_cache, const char *path)
 {
   DiskCacheFile *cache_file;
   int64_t size_before;
@@ -466,6 +535,9 @@ static void seq_disk_cache_invalidate(Scene *scene,
 
   BLI_mutex_lock(&disk_cache->read_write_mutex);
 
+  /* Images queued for writing may be outdated now. */
+  atomic_add_and_fetch_int32(&disk_cache->invalidate_count, 1);
+
   start = seq_changed->startdisp - DCACHE_IMAGES_PER_FILE;
   end = seq_changed->enddisp;
 
@@ -474,31 +546,168 @@ static void seq_disk_cache_invalidate(Scene *scene,
   BLI_mutex_unlock(&disk_cache->read_write_mutex);
 }
 
-static size_t deflate_imbuf_to_file(ImBuf *ibuf,
-                                    FILE *file,
-                                    int level,
-                                    DiskCacheHeaderEntry *header_entry)
+static size_t seq_disk_cache_image_data_size(const ImBuf *ibuf)
 {
   if (ibuf->rect) {
-    return BLI_gzip_mem_to_file_at_pos(
-        ibuf->rect, header_entry->size_raw, file, header_entry->offset, level);
+    return (size_t)ibuf->x * ibuf->y * ibuf->channels;
   }
-  else {
-    return BLI_gzip_mem_to_file_at_pos(
-        ibuf->rect_float, header_entry->size_raw, file, header_entry->offset, level);
+  return (size_t)ibuf->x * ibuf->y * ibuf->channels * 4;
+}
+
+static size_t seq_disk_cache_mem_to_file_at_pos(void *buf,
+                                                size_t len,
+                                                FILE *file,
+                                                size_t offset)
+{
+  fseek(file, offset, 0);
+  if (fwrite(buf, 1, len, file) != len || ferror(file)) {
+    return 0;
   }
+  return len;
 }
 
-static size_t inflate_file_to_imbuf(ImBuf *ibuf, FILE *file, DiskCacheHeaderEntry *header_entry)
+static size_t seq_disk_cache_file_to_mem_at_pos(void *buf,
+                                                size_t len,
+                                                FILE *file,
+                                                size_t offset)
 {
-  if (ibuf->rect) {
-    return BLI_ungzip_file_to_mem_at_pos(
-        ibuf->rect, header_entry->size_raw, file, header_entry->offset);
+  fseek(file, offset, 0);
+  return fread(buf, 1, len, file);
+}
+
+#ifdef WITH_LZO
+/* Data is compressed in blocks of DCACHE_LZO_BLOCK_SIZE, so reading needs only a small buffer
+ * for compressed data. Each block is preceded by its compressed size. Blocks which can't be
+ * compressed are stored as they are, compressed size is then equal to size of block.
+ */
+static void *seq_disk_cache_lzo_compress(const void *buf, size_t len, size_t *r_len)
+{
+  LZO_HEAP_ALLOC(wrkmem, LZO1X_MEM_COMPRESS);
+  const unsigned char *in = buf;
+  const size_t num_blocks = (len + DCACHE_LZO_BLOCK_SIZE - 1) / DCACHE_LZO_BLOCK_SIZE;
+  unsigned char *out = MEM_mallocN(
+      num_blocks * (sizeof(uint32_t) + LZO_OUT_LEN(DCACHE_LZO_BLOCK_SIZE)),
+      "SeqDiskCache LZO data");
+  unsigned char *out_block = out;
+
+  for (size_t block_start = 0; block_start < len; block_start += DCACHE_LZO_BLOCK_SIZE) {
+    const size_t block_len = MIN2(len - block_start, DCACHE_LZO_BLOCK_SIZE);
+    unsigned char *out_data = out_block + sizeof(uint32_t);
+    lzo_uint out_len = LZO_OUT_LEN(block_len);
+
+    int r = lzo1x_1_compress(in + block_start, (lzo_uint)block_len, out_data, &out_len, wrkmem);
+    if (r != LZO_E_OK || out_len >= block_len) {
+      memcpy(out_data, in + block_start, block_len);
+      out_len = block_len;
+    }
+
+    const uint32_t size = (uint32_t)out_len;
+    memcpy(out_block, &size, sizeof(size));
+    out_block = out_data + out_len;
   }
-  else {
-    return BLI_ungzip_file_to_mem_at_pos(
-        ibuf->rect_float, header_entry->size_raw, file, header_entry->offset);
+
+  *r_len = (size_t)(out_block - out);
+  return out;
+}
+
+static size_t seq_disk_cache_lzo_file_to_mem_at_pos(
+    void *buf, size_t len, FILE *file, size_t offset, bool switch_endian)
+{
+  unsigned char *out = buf;
+  unsigned char *in = MEM_mallocN(DCACHE_LZO_BLOCK_SIZE, "SeqDiskCache LZO block");
+  size_t bytes_read = 0;
+
+  fseek(file, offset, 0);
+
+  for (size_t block_start = 0; block_start < len; block_start += DCACHE_LZO_BLOCK_SIZE) {
+    const size_t block_len = MIN2(len - block_start, DCACHE_LZO_BLOCK_SIZE);
+    uint32_t size;
+
+    if (fread(&size, sizeof(size), 1, file) != 1) {
+      break;
+    }
+    if (switch_endian) {
+      BLI_endian_switch_uint32(&size);
+    }
+    if (size > block_len) {
+      break;
+    }
+
+    if (size == block_len) {
+      if (fread(out + block_start, 1, block_len, file) != block_len) {
+        break;
+      }
+    }
+    else {
+      lzo_uint out_len = block_len;
+      if (fread(in, 1, size, file) != size ||
+          lzo1x_decompress_safe(in, size, out + block_start, &out_len, NULL) != LZO_E_OK ||
+          out_len != block_len) {
+        break;
+      }
+    }
+    bytes_read += block_len;
   }
+
+  MEM_freeN(in);
+  return bytes_read;
+}
+#endif
+
+static void *seq_disk_cache_zlib_compress(const void *buf, size_t len, int level, size_t *r_len)
+{
+  uLongf out_len = compressBound((uLong)len);
+  void *out = MEM_mallocN(out_len, "SeqDiskCache zlib data");
+  if (compress2(out, &out_len, buf, (uLong)len, level) != Z_OK) {
+    MEM_freeN(out);
+    return NULL;
+  }
+  *r_len = out_len;
+  return out;
+}
+
+/* Compress image data as it is stored in the file. Returns NULL when compression failed, or for
+ * DCACHE_CODEC_NONE, where the image data is written as it is. */
+static void *seq_disk_cache_compress(ImBuf *ibuf, int codec, int level, size_t *r_len)
+{
+  const void *buf = ibuf->rect ? (void *)ibuf->rect : (void *)ibuf->rect_float;
+  const size_t len = seq_disk_cache_image_data_size(ibuf);
+
+  switch (codec) {
+#ifdef WITH_LZO
+    case DCACHE_CODEC_LZO:
+      return seq_disk_cache_lzo_compress(buf, len, r_len);
+#endif
+    case DCACHE_CODEC_ZLIB:
+      return seq_disk_cache_zlib_compress(buf, len, level, r_len);
+  }
+
+  return NULL;
+}
+
+static size_t inflate_file_to_imbuf(ImBuf *ibuf, FILE *file, DiskCacheHeaderEntry *header_entry)
+{
+  void *buf = ibuf->rect ? (void *)ibuf->rect : (void *)ibuf->rect_float;
+
+  switch (header_entry->codec) {
+    case DCACHE_CODEC_NONE:
+      return seq_disk_cache_file_to_mem_at_pos(
+          buf, header_entry->size_raw, file, header_entry->offset);
+#ifdef WITH_LZO
+    case DCACHE_CODEC_LZO:
+      return seq_disk_cache_lzo_file_to_mem_at_pos(buf,
+                                                   header_entry->size_raw,
+                                                   file,
+                                                   header_entry->offset,
+                                                   (ENDIAN_ORDER == B_ENDIAN) &&
+                                                       header_entry->encoding == 0);
+#endif
+    case DCACHE_CODEC_ZLIB:
+      return BLI_ungzip_file_to_mem_at_pos(
+          buf, header_entry->size_raw, file, header_entry->offset);
+  }
+
+  return 0;
 }
 
 static void seq_disk_cache_read_header(FILE *file, DiskCacheHeader *header)
@@ -522,7 +731,10 @@ static size_t seq_disk_cache_write_header(FILE *file, DiskCacheHeader *header)
   return fwrite(header, sizeof(*header), 1, file);
 }
 
-static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCacheHeader *header)
+static int seq_disk_cache_add_header_entry(float nfra,
+                                           ImBuf *ibuf,
+                                           int codec,
+                                           DiskCacheHeader *header)
 {
   int i;
   uint64_t offset = sizeof(*header);
@@ -554,17 +766,17 @@ static int seq_disk_cache_add_header_entry(SeqCacheKey *key, ImBuf *ibuf, DiskCa
     header->entry[i].encoding = 0;
   }
 
+  header->entry[i].codec = codec;
   header->entry[i].offset = offset;
-  header->entry[i].frameno = key->nfra;
+  header->entry[i].frameno = nfra;
 
   /* Store colorspace name of ibuf. */
   const char *colorspace_name;
+  header->entry[i].size_raw = seq_disk_cache_image_data_size(ibuf);
   if (ibuf->rect) {
-    header->entry[i].size_raw = ibuf->x * ibuf->y * ibuf->channels;
     colorspace_name = IMB_colormanagement_get_rect_colorspace(ibuf);
   }
   else {
-    header->entry[i].size_raw = ibuf->x * ibuf->y * ibuf->channels * 4;
     colorspace_name = IMB_colormanagement_get_float_colorspace(ibuf);
   }
   BLI_strncpy(
@@ -584,11 +796,16 @@ static int seq_disk_cache_get_header_entry(SeqCacheKey *key, DiskCacheHeader *he
   return -1;
 }
 
-static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key, ImBuf *ibuf)
+/* Write image data which is already compressed with given codec, called with the lock of the
+ * disk cache held. */
+static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache,
+                                      const char *path,
+                                      float nfra,
+                                      ImBuf *ibuf,
+                                      int codec,
+                                      void *data,
+                                      size_t data_len)
 {
-  char path[FILE_MAX];
-
-  seq_disk_cache_get_file_path(disk_cache, key, path, sizeof(path));
   BLI_make_existing_file(path);
 
   FILE *file = BLI_fopen(path, "rb+");
@@ -603,9 +820,9 @@ static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key
   DiskCacheHeader header;
   memset(&header, 0, sizeof(header));
   seq_disk_cache_read_header(file, &header);
-  int entry_index = seq_disk_cache_add_header_entry(key, ibuf, &header);
-  size_t bytes_written = deflate_imbuf_to_file(
-      ibuf, file, seq_disk_cache_compression_level(), &header.entry[entry_index]);
+  int entry_index = seq_disk_cache_add_header_entry(nfra, ibuf, codec, &header);
+  size_t bytes_written = seq_disk_cache_mem_to_file_at_pos(
+      data, data_len, file, header.entry[entry_index].offset);
 
   if (bytes_written != 0) {
     /* Last step is writing header, as image data can be overwritten,
@@ -619,9 +836,113 @@ static bool seq_disk_cache_write_file(SeqDiskCache *disk_cache, SeqCacheKey *key
     return true;
   }
 
+  fclose(file);
   return false;
 }
 
+static void seq_disk_cache_compress_and_write(SeqDiskCache *disk_cache,
+                                              const char *path,
+                                              float nfra,
+                                              ImBuf *ibuf,
+                                              int codec,
+                                              int compression_level,
+                                              int invalidate_count)
+{
+  size_t data_len = seq_disk_cache_image_data_size(ibuf);
+  void *compressed_data = seq_disk_cache_compress(ibuf, codec, compression_level, &data_len);
+  if (compressed_data == NULL && codec != DCACHE_CODEC_NONE) {
+    return;
+  }
+  void *data = compressed_data;
+  if (data == NULL) {
+    data = ibuf->rect ? (void *)ibuf->rect : (void *)ibuf->rect_float;
+  }
+
+  BLI_mutex_lock(&disk_cache->read_write_mutex);
+  if (invalidate_count == disk_cache->invalidate_count) {
+    seq_disk_cache_write_file(disk_cache, path, nfra, ibuf, codec, data, data_len);
+  }
+  BLI_mutex_unlock(&disk_cache->read_write_mutex);
+  MEM_SAFE_FREE(compressed_data);
+
+  seq_disk_cache_enforce_limits(disk_cache);
+}
+
+static void *seq_disk_cache_write_thread(void *data)
+{
+  SeqDiskCache *disk_cache = data;
+  DiskCacheWriteJob *job;
+
+  /* Queue is set to not wait when cache is destroyed, remaining jobs are discarded. */
+  while ((job = BLI_thread_queue_pop(disk_cache->write_queue))) {
+    seq_disk_cache_compress_and_write(disk_cache,
+                                      job->path,
+                                      job->nfra,
+                                      job->ibuf,
+                                      job->codec,
+                                      job->compression_level,
+                                      job->invalidate_count);
+
+    atomic_sub_and_fetch_z(&disk_cache->write_queue_size, job->ibuf_size);
+    IMB_freeImBuf(job->ibuf);
+    MEM_freeN(job);
+  }
+
+  return NULL;
+}
+
+/* Path is resolved here, so write thread doesn't need to access scene or strip. */
+static void seq_disk_cache_write_file_async(SeqDiskCache *disk_cache,
+                                            SeqCacheKey *key,
+                                            ImBuf *ibuf)
+{
+  const size_t ibuf_size = IMB_get_size_in_memory(ibuf);
+
+  /* When writing falls behind rendering, queued images would keep memory that the cache already
+   * released. Write on this thread instead, which also slows down rendering to the speed of the
+   * disk. */
+  if (atomic_add_and_fetch_z(&disk_cache->write_queue_size, ibuf_size) >
+      DCACHE_WRITE_QUEUE_MAX_SIZE) {
+    atomic_sub_and_fetch_z(&disk_cache->write_queue_size, ibuf_size);
+
+    char path[FILE_MAX];
+    seq_disk_cache_get_file_path(disk_cache, key, path, sizeof(path));
+    const int invalidate_count = atomic_add_and_fetch_int32(&disk_cache->invalidate_count, 0);
+    seq_disk_cache_compress_and_write(disk_cache,
+                                      path,
+                                      key->nfra,
+                                      ibuf,
+                                      seq_disk_cache_codec(),
+                                      seq_disk_cache_compression_level(),
+                                      invalidate_count);
+    return;
+  }
+
+  DiskCacheWriteJob *job = MEM_callocN(sizeof(DiskCacheWriteJob), "DiskCacheWriteJob");
+  seq_disk_cache_get_file_path(disk_cache, key, job->path, sizeof(job->path));
+  job->nfra = key->nfra;
+  job->invalidate_count = atomic_add_and_fetch_int32(&disk_cache->invalidate_count, 0);
+  job->codec = seq_disk_cache_codec();
+  job->compression_level = seq_disk_cache_compression_level();
+  IMB_refImBuf(ibuf);
+  job->ibuf = ibuf;
+  job->ibuf_size = ibuf_size;
+  BLI_thread_queue_push(disk_cache->write_queue, job);
+}
+
+static void seq_disk_cache_free(SeqDiskCache *disk_cache)
+{
+  /* Discard pending writes, images may belong to data which is being freed. */
+  atomic_add_and_fetch_int32(&disk_cache->invalidate_count, 1);
+  BLI_thread_queue_nowait(disk_cache->write_queue);
+  BLI_threadpool_end(&disk_cache->write_threads);
+  BLI_thread_queue_free(disk_cache->write_queue);
+
+  BLI_freelistN(&disk_cache->files);
+  BLI_mutex_end(&disk_cache->read_write_mutex);
+  MEM_freeN(disk_cache);
+}
+
 static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *key)
 {
   char path[FILE_MAX];
@@ -681,6 +1002,7 @@ static ImBuf *seq_disk_cache_read_file(SeqDiskCache *disk_cache, SeqCacheKey *ke
 
 #undef DCACHE_FNAME_FORMAT
 #undef DCACHE_IMAGES_PER_FILE
+#undef DCACHE_LZO_BLOCK_SIZE
 #undef COLORSPACE_NAME_MAX
 #undef DCACHE_CURRENT_VERSION
 
@@ -798,7 +1120,7 @@ static void seq_cache_put(SeqCache *cache, SeqCacheKey *key, ImBuf *ibuf)
 
   if (BLI_ghash_reinsert(cache->hash, key, item, seq_cache_keyfree, seq_cache_valfree)) {
     IMB_refImBuf(ibuf);
-    cache->last_key = key;
+    cache->last_key[key->task_id] = key;
     cache->memory_used += IMB_get_size_in_memory(ibuf);
   }
 }
@@ -1037,20 +1359,21 @@ static void seq_disk_cache_create(Main *bmain, Scene *scene)
   BLI_mutex_lock(&cache_create_lock);
   SeqCache *cache = seq_cache_get_from_scene(scene);
 
-  if (cache == NULL) {
-    return;
-  }
-
-  if (cache->disk_cache != NULL) {
+  if (cache == NULL || cache->disk_cache != NULL) {
+    BLI_mutex_unlock(&cache_create_lock);
     return;
   }
 
-  cache->disk_cache = MEM_callocN(sizeof(SeqDiskCache), "SeqDiskCache");
-  cache->disk_cache->bmain = bmain;
-  BLI_mutex_init(&cache->disk_cache->read_write_mutex);
-  seq_disk_cache_handle_versioning(cache->disk_cache);
-  seq_disk_cache_get_files(cache->disk_cache, seq_disk_cache_base_dir());
-  cache->disk_cache->timestamp = scene->ed->disk_cache_timestamp;
+  SeqDiskCache *disk_cache = MEM_callocN(sizeof(SeqDiskCache), "SeqDiskCache");
+  disk_cache->bmain = bmain;
+  BLI_mutex_init(&disk_cache->read_write_mutex);
+  seq_disk_cache_handle_versioning(disk_cache);
+  seq_disk_cache_get_files(disk_cache, seq_disk_cache_base_dir());
+  disk_cache->timestamp = scene->ed->disk_cache_timestamp;
+  disk_cache->write_queue = BLI_thread_queue_init();
+  BLI_threadpool_init(&disk_cache->write_threads, seq_disk_cache_write_thread, 1);
+  BLI_threadpool_insert(&disk_cache->write_threads, disk_cache);
+  cache->disk_cache = disk_cache;
   BLI_mutex_unlock(&cache_create_lock);
 }
 
@@ -1062,7 +1385,6 @@ static void seq_cache_create(Main *bmain, Scene *scene)
     cache->keys_pool = BLI_mempool_create(sizeof(SeqCacheKey), 0, 64, BLI_MEMPOOL_NOP);
     cache->items_pool = BLI_mempool_create(sizeof(SeqCacheItem), 0, 64, BLI_MEMPOOL_NOP);
     cache->hash = BLI_ghash_new(seq_cache_hashhash, seq_cache_hashcmp, "SeqCache hash");
-    cache->last_key = NULL;
     cache->bmain = bmain;
     BLI_mutex_init(&cache->iterator_mutex);
     scene->ed->cache = cache;
@@ -1112,9 +1434,7 @@ void BKE_sequencer_cache_destruct(Scene *scene)
   BLI_mutex_end(&cache->iterator_mutex);
 
   if (cache->disk_cache != NULL) {
-    BLI_freelistN(&cache->disk_cache->files);
-    BLI_mutex_end(&cache->disk_cache->read_write_mutex);
-    MEM_freeN(cache->disk_cache);
+    seq_disk_cache_free(cache->disk_cache);
   }
 
   MEM_freeN(cache);
@@ -1146,7 +1466,7 @@ void BKE_sequencer_cache_cleanup(Scene *scene)
     BLI_ghashIterator_step(&gh_iter);
     BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
   }
-  cache->last_key = NULL;
+  memset(cache->last_key, 0, sizeof(cache->last_key));
   seq_cache_unlock(scene);
 }
 
@@ -1210,7 +1530,7 @@ void BKE_sequencer_cache_cleanup_sequence(Scene *scene,
       BLI_ghash_remove(cache->hash, key, seq_cache_keyfree, seq_cache_valfree);
     }
   }
-  cache->last_key = NULL;
+  memset(cache->last_key, 0, sizeof(cache->last_key));
   seq_cache_unlock(scene);
 }
 
@@ -1305,8 +1625,8 @@ bool BKE_sequencer_cache_put_if_possible(const SeqRenderData *context,
     return true;
   }
   else {
-    seq_cache_set_temp_cache_linked(scene, scene->ed->cache->last_key);
-    scene->ed->cache->last_key = NULL;
+    seq_cache_set_temp_cache_linked(scene, scene->ed->cache->last_key[context->task_id]);
+    scene->ed->cache->last_key[context->task_id] = NULL;
     return false;
   }
 }
@@ -1378,27 +1698,27 @@ void BKE_sequencer_cache_put(const SeqRenderData *context,
   /* Item stored for later use */
   if (flag & type) {
     key->is_temp_cache = false;
-    key->link_prev = cache->last_key;
+    key->link_prev = cache->last_key[key->task_id];
   }
 
-  SeqCacheKey *temp_last_key = cache->last_key;
+  SeqCacheKey *temp_last_key = cache->last_key[key->task_id];
   seq_cache_put(cache, key, i);
 
   /* Restore pointer to previous item as this one will be freed when stack is rendered. */
   if (key->is_temp_cache) {
-    cache->last_key = temp_last_key;
+    cache->last_key[key->task_id] = temp_last_key;
   }
 
   /* Set last_key's reference to this key so we can look up chain backwards.
    * Item is already put in cache, so cache->last_key points to current key.
    */
   if (flag & type && temp_last_key) {
-    temp_last_key->link_next = cache->last_key;
+    temp_last_key->link_next = cache->last_key[key->task_id];
   }
 
   /* Reset linking. */
   if (key->type == SEQ_CACHE_STORE_FINAL_OUT) {
-    cache->last_key = NULL;
+    cache->last_key[key->task_id] = NULL;
   }
 
   seq_cache_unlock(scene);
@@ -1409,10 +1729,7 @@ void BKE_sequencer_cache_put(const SeqRenderData *context,
         seq_disk_cache_create(context->bmain, context->scene);
       }
 
-      BLI_mutex_lock(&cache->disk_cache->read_write_mutex);
-      seq_disk_cache_write_file(cache->disk_cache, key, i);
-      BLI_mutex_unlock(&cache->disk_cache->read_write_mutex);
-      seq_disk_cache_enforce_limits(cache->disk_cache);
+      seq_disk_cache_write_file_async(cache->disk_cache, key, i);
     }
   }
 }
@@ -1441,7 +1758,7 @@ void BKE_sequencer_cache_iterate(
     interrupt = callback_iter(userdata, key->seq, key->nfra, key->type, key->cost);
   }
 
-  cache->last_key = NULL;
+  memset(cache->last_key, 0, sizeof(cache->last_key));
   seq_cache_unlock(scene);
 }
 
@@ -31,10 +31,12 @@
 #include "DNA_scene_types.h"
 #include "DNA_screen_types.h"
 #include "DNA_sequence_types.h"
+#include "DNA_userdef_types.h"
 #include "DNA_windowmanager_types.h"
 
 #include "BLI_listbase.h"
 #include "BLI_threads.h"
+#include "BLI_utildefines.h"
 
 #include "IMB_imbuf.h"
 #include "IMB_imbuf_types.h"
@@ -54,23 +56,43 @@
 #include "DEG_depsgraph_debug.h"
 #include "DEG_depsgraph_query.h"
 
+#include "atomic_ops.h"
+
+/* Part of the memory cache limit that the scene copies of all workers may use. */
+#define SEQ_PREFETCH_COPIES_MEMORY_DIVISOR 4
+
+/* Each worker renders different frame with its own copy of scene. */
+typedef struct PrefetchWorker {
+  struct PrefetchJob *pfjob;
+
+  struct Main *bmain_eval;
+  struct Scene *scene_eval;
+  struct Depsgraph *depsgraph;
+
+  /* context */
+  struct SeqRenderData context;
+  struct SeqRenderData context_cpy;
+
+  /* Frame being rendered by this worker. */
+  float cfra;
+} PrefetchWorker;
+
 typedef struct PrefetchJob {
   struct PrefetchJob *next, *prev;
 
   struct Main *bmain;
-  struct Main *bmain_eval;
   struct Scene *scene;
-  struct Scene *scene_eval;
-  struct Depsgraph *depsgraph;
 
   ThreadMutex prefetch_suspend_mutex;
   ThreadCondition prefetch_suspend_cond;
 
   ListBase threads;
+  PrefetchWorker workers[SEQ_PREFETCH_THREADS_MAX];
+  int num_workers;
+  /* Number of workers from preferences, before limiting it to the available memory. */
+  int num_workers_requested;
 
   /* context */
-  struct SeqRenderData context;
-  struct SeqRenderData context_cpy;
   struct ListBase *seqbasep;
   struct ListBase *seqbasep_cpy;
 
@@ -79,8 +101,9 @@ typedef struct PrefetchJob {
   int num_frames_prefetched;
 
   /* control */
+  int num_workers_running;
+  int num_workers_waiting;
   bool running;
-  bool waiting;
   bool stop;
 } PrefetchJob;
 
@@ -113,6 +136,33 @@ static PrefetchJob *seq_prefetch_job_get(Scene *scene)
   return NULL;
 }
 
+/* Number of workers used for prefetching, 0 in preferences means automatic. */
+static int seq_prefetch_num_workers(void)
+{
+  int num_workers = U.sequencer_prefetch_threads;
+
+  if (num_workers == 0) {
+    /* Leave one thread for UI and playback. */
+    num_workers = BLI_system_thread_count() - 1;
+  }
+
+  CLAMP(num_workers, 1, SEQ_PREFETCH_THREADS_MAX);
+  return num_workers;
+}
+
+/* Limit the number of workers so their scene copies use at most a part of the memory cache
+ * limit, `worker_mem` is the size of one copy. */
+static int seq_prefetch_num_workers_limit_memory(int num_workers, size_t worker_mem)
+{
+  const size_t mem_max = ((size_t)U.memcachelimit) * 1024 * 1024 /
+                         SEQ_PREFETCH_COPIES_MEMORY_DIVISOR;
+  if (worker_mem == 0) {
+    return num_workers;
+  }
+  const size_t max_workers = mem_max / worker_mem;
+  return MAX2(1, (int)MIN2((size_t)num_workers, max_workers));
+}
+
 bool BKE_sequencer_prefetch_job_is_running(Scene *scene)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(scene);
@@ -124,6 +174,7 @@ bool BKE_sequencer_prefetch_job_is_running(Scene *scene)
   return pfjob->running;
 }
 
+/* All running workers are suspended. */
 static bool seq_prefetch_job_is_waiting(Scene *scene)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(scene);
@@ -132,7 +183,8 @@ static bool seq_prefetch_job_is_waiting(Scene *scene)
     return false;
   }
 
-  return pfjob->waiting;
+  return pfjob->num_workers_waiting > 0 &&
+         pfjob->num_workers_waiting >= pfjob->num_workers_running;
 }
 
 static Sequence *sequencer_prefetch_get_original_sequence(Sequence *seq, ListBase *seqbase)
@@ -164,8 +216,10 @@ Sequence *BKE_sequencer_prefetch_get_original_sequence(Sequence *seq, Scene *sce
 SeqRenderData *BKE_sequencer_prefetch_get_original_context(const SeqRenderData *context)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(context->scene);
+  int worker_index = context->task_id - SEQ_TASK_PREFETCH_RENDER;
 
-  return &pfjob->context;
+  BLI_assert(worker_index >= 0 && worker_index < pfjob->num_workers);
+  return &pfjob->workers[worker_index].context;
 }
 
 static bool seq_prefetch_is_cache_full(Scene *scene)
@@ -179,13 +233,14 @@ static bool seq_prefetch_is_cache_full(Scene *scene)
   return BKE_sequencer_cache_recycle_item(pfjob->scene) == false;
 }
 
+/* Next frame to be prefetched. */
 static float seq_prefetch_cfra(PrefetchJob *pfjob)
 {
   return pfjob->cfra + pfjob->num_frames_prefetched;
 }
-static AnimationEvalContext seq_prefetch_anim_eval_context(PrefetchJob *pfjob)
+static AnimationEvalContext seq_prefetch_anim_eval_context(PrefetchWorker *worker)
 {
-  return BKE_animsys_eval_context_construct(pfjob->depsgraph, seq_prefetch_cfra(pfjob));
+  return BKE_animsys_eval_context_construct(worker->depsgraph, worker->cfra);
 }
 
 void BKE_sequencer_prefetch_get_time_range(Scene *scene, int *start, int *end)
@@ -196,37 +251,38 @@ void BKE_sequencer_prefetch_get_time_range(Scene *scene, int *start, int *end)
   *end = seq_prefetch_cfra(pfjob);
 }
 
-static void seq_prefetch_free_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_free_depsgraph(PrefetchWorker *worker)
 {
-  if (pfjob->depsgraph != NULL) {
-    DEG_graph_free(pfjob->depsgraph);
+  if (worker->depsgraph != NULL) {
+    DEG_graph_free(worker->depsgraph);
   }
-  pfjob->depsgraph = NULL;
-  pfjob->scene_eval = NULL;
+  worker->depsgraph = NULL;
+  worker->scene_eval = NULL;
 }
 
-static void seq_prefetch_update_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_update_depsgraph(PrefetchWorker *worker)
 {
-  DEG_evaluate_on_framechange(pfjob->bmain_eval, pfjob->depsgraph, seq_prefetch_cfra(pfjob));
+  DEG_evaluate_on_framechange(worker->bmain_eval, worker->depsgraph, worker->cfra);
 }
 
-static void seq_prefetch_init_depsgraph(PrefetchJob *pfjob)
+static void seq_prefetch_init_depsgraph(PrefetchWorker *worker)
 {
-  Main *bmain = pfjob->bmain_eval;
-  Scene *scene = pfjob->scene;
+  Main *bmain = worker->bmain_eval;
+  Scene *scene = worker->pfjob->scene;
   ViewLayer *view_layer = BKE_view_layer_default_render(scene);
 
-  pfjob->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
-  DEG_debug_name_set(pfjob->depsgraph, "SEQUENCER PREFETCH");
+  worker->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
+  DEG_debug_name_set(worker->depsgraph, "SEQUENCER PREFETCH");
 
   /* Make sure there is a correct evaluated scene pointer. */
-  DEG_graph_build_for_render_pipeline(pfjob->depsgraph, bmain, scene, view_layer);
+  DEG_graph_build_for_render_pipeline(worker->depsgraph, bmain, scene, view_layer);
 
   /* Update immediately so we have proper evaluated scene. */
-  seq_prefetch_update_depsgraph(pfjob);
+  worker->cfra = seq_prefetch_cfra(worker->pfjob);
+  seq_prefetch_update_depsgraph(worker);
 
-  pfjob->scene_eval = DEG_get_evaluated_scene(pfjob->depsgraph);
-  pfjob->scene_eval->ed->cache_flag = 0;
+  worker->scene_eval = DEG_get_evaluated_scene(worker->depsgraph);
+  worker->scene_eval->ed->cache_flag = 0;
 }
 
 static void seq_prefetch_update_area(PrefetchJob *pfjob)
@@ -274,7 +330,7 @@ void BKE_sequencer_prefetch_stop(Scene *scene)
   pfjob->stop = true;
 
   while (pfjob->running) {
-    BLI_condition_notify_one(&pfjob->prefetch_suspend_cond);
+    BLI_condition_notify_all(&pfjob->prefetch_suspend_cond);
   }
 }
 
@@ -283,32 +339,36 @@ static void seq_prefetch_update_context(const SeqRenderData *context)
   PrefetchJob *pfjob;
   pfjob = seq_prefetch_job_get(context->scene);
 
-  BKE_sequencer_new_render_data(pfjob->bmain_eval,
-                                pfjob->depsgraph,
-                                pfjob->scene_eval,
-                                context->rectx,
-                                context->recty,
-                                context->preview_render_size,
-                                false,
-                                &pfjob->context_cpy);
-  pfjob->context_cpy.is_prefetch_render = true;
-  pfjob->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER;
-
-  BKE_sequencer_new_render_data(pfjob->bmain,
-                                pfjob->depsgraph,
-                                pfjob->scene,
-                                context->rectx,
-                                context->recty,
-                                context->preview_render_size,
-                                false,
-                                &pfjob->context);
-  pfjob->context.is_prefetch_render = false;
-
-  /* Same ID as prefetch context, because context will be swapped, but we still
-   * want to assign this ID to cache entries created in this thread.
-   * This is to allow "temp cache" work correctly for both threads.
-   */
-  pfjob->context.task_id = SEQ_TASK_PREFETCH_RENDER;
+  for (int i = 0; i < pfjob->num_workers; i++) {
+    PrefetchWorker *worker = &pfjob->workers[i];
+
+    BKE_sequencer_new_render_data(worker->bmain_eval,
+                                  worker->depsgraph,
+                                  worker->scene_eval,
+                                  context->rectx,
+                                  context->recty,
+                                  context->preview_render_size,
+                                  false,
+                                  &worker->context_cpy);
+    worker->context_cpy.is_prefetch_render = true;
+    worker->context_cpy.task_id = SEQ_TASK_PREFETCH_RENDER + i;
+
+    BKE_sequencer_new_render_data(pfjob->bmain,
+                                  worker->depsgraph,
+                                  pfjob->scene,
+                                  context->rectx,
+                                  context->recty,
+                                  context->preview_render_size,
+                                  false,
+                                  &worker->context);
+    worker->context.is_prefetch_render = false;
+
+    /* Same ID as prefetch context, because context will be swapped, but we still
+     * want to assign this ID to cache entries created in this thread.
+     * This is to allow "temp cache" work correctly for all threads.
+     */
+    worker->context.task_id = SEQ_TASK_PREFETCH_RENDER + i;
+  }
 }
 
 static void seq_prefetch_update_scene(Scene *scene)
@@ -319,16 +379,18 @@ static void seq_prefetch_update_scene(Scene *scene)
     return;
   }
 
-  seq_prefetch_free_depsgraph(pfjob);
-  seq_prefetch_init_depsgraph(pfjob);
+  for (int i = 0; i < pfjob->num_workers; i++) {
+    seq_prefetch_free_depsgraph(&pfjob->workers[i]);
+    seq_prefetch_init_depsgraph(&pfjob->workers[i]);
+  }
 }
 
 static void seq_prefetch_resume(Scene *scene)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(scene);
 
-  if (pfjob && pfjob->waiting) {
-    BLI_condition_notify_one(&pfjob->prefetch_suspend_cond);
+  if (pfjob && pfjob->num_workers_waiting > 0) {
+    BLI_condition_notify_all(&pfjob->prefetch_suspend_cond);
   }
 }
 
@@ -341,24 +403,24 @@ void BKE_sequencer_prefetch_free(Scene *scene)
 
   BKE_sequencer_prefetch_stop(scene);
 
-  BLI_threadpool_remove(&pfjob->threads, pfjob);
   BLI_threadpool_end(&pfjob->threads);
   BLI_mutex_end(&pfjob->prefetch_suspend_mutex);
   BLI_condition_end(&pfjob->prefetch_suspend_cond);
-  seq_prefetch_free_depsgraph(pfjob);
-  BKE_main_free(pfjob->bmain_eval);
+  for (int i = 0; i < pfjob->num_workers; i++) {
+    seq_prefetch_free_depsgraph(&pfjob->workers[i]);
+    BKE_main_free(pfjob->workers[i].bmain_eval);
+  }
   MEM_freeN(pfjob);
   scene->ed->prefetch_job = NULL;
 }
 
-static bool seq_prefetch_do_skip_frame(Scene *scene)
+static bool seq_prefetch_do_skip_frame(PrefetchWorker *worker)
 {
-  Editing *ed = scene->ed;
-  PrefetchJob *pfjob = seq_prefetch_job_get(scene);
-  float cfra = seq_prefetch_cfra(pfjob);
+  Editing *ed = worker->pfjob->scene->ed;
+  float cfra = worker->cfra;
   Sequence *seq_arr[MAXSEQ + 1];
   int count = BKE_sequencer_get_shown_sequences(ed->seqbasep, cfra, 0, seq_arr);
-  SeqRenderData *ctx = &pfjob->context_cpy;
+  SeqRenderData *ctx = &worker->context_cpy;
   ImBuf *ibuf = NULL;
 
   /* Disable prefetching 3D scene strips, but check for disk cache. */
@@ -422,26 +484,45 @@ static void seq_prefetch_do_suspend(PrefetchJob *pfjob)
   BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
   while (seq_prefetch_need_suspend(pfjob) &&
          (pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) && !pfjob->stop) {
-    pfjob->waiting = true;
+    pfjob->num_workers_waiting++;
     BLI_condition_wait(&pfjob->prefetch_suspend_cond, &pfjob->prefetch_suspend_mutex);
+    pfjob->num_workers_waiting--;
     seq_prefetch_update_area(pfjob);
   }
-  pfjob->waiting = false;
   BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
 }
 
+/* Assign next frame in prefetch area to worker. Returns false if there is nothing to do. */
+static bool seq_prefetch_claim_frame(PrefetchWorker *worker)
+{
+  PrefetchJob *pfjob = worker->pfjob;
+  bool has_frame = false;
+
+  BLI_mutex_lock(&pfjob->prefetch_suspend_mutex);
+  seq_prefetch_update_area(pfjob);
+  if (!pfjob->stop && seq_prefetch_cfra(pfjob) <= pfjob->scene->r.efra) {
+    worker->cfra = seq_prefetch_cfra(pfjob);
+    pfjob->num_frames_prefetched++;
+    has_frame = true;
+  }
+  BLI_mutex_unlock(&pfjob->prefetch_suspend_mutex);
+
+  return has_frame;
+}
+
 static void *seq_prefetch_frames(void *job)
 {
-  PrefetchJob *pfjob = (PrefetchJob *)job;
+  PrefetchWorker *worker = (PrefetchWorker *)job;
+  PrefetchJob *pfjob = worker->pfjob;
 
-  while (seq_prefetch_cfra(pfjob) <= pfjob->scene->r.efra) {
-    pfjob->scene_eval->ed->prefetch_job = NULL;
+  while (seq_prefetch_claim_frame(worker)) {
+    worker->scene_eval->ed->prefetch_job = NULL;
 
-    seq_prefetch_update_depsgraph(pfjob);
-    AnimData *adt = BKE_animdata_from_id(&pfjob->context_cpy.scene->id);
-    AnimationEvalContext anim_eval_context = seq_prefetch_anim_eval_context(pfjob);
+    seq_prefetch_update_depsgraph(worker);
+    AnimData *adt = BKE_animdata_from_id(&worker->context_cpy.scene->id);
+    AnimationEvalContext anim_eval_context = seq_prefetch_anim_eval_context(worker);
     BKE_animsys_evaluate_animdata(
-        &pfjob->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
+        &worker->context_cpy.scene->id, adt, &anim_eval_context, ADT_RECALC_ALL, false);
 
     /* This is quite hacky solution:
      * We need cross-reference original scene with copy for cache.
@@ -449,16 +530,14 @@ static void *seq_prefetch_frames(void *job)
      * Scene copy don't reference original scene. Perhaps, this could be done by depsgraph.
      * Set to NULL before return!
      */
-    pfjob->scene_eval->ed->prefetch_job = pfjob;
+    worker->scene_eval->ed->prefetch_job = pfjob;
 
-    if (seq_prefetch_do_skip_frame(pfjob->scene)) {
-      pfjob->num_frames_prefetched++;
+    if (seq_prefetch_do_skip_frame(worker)) {
       continue;
     }
 
-    ImBuf *ibuf = BKE_sequencer_give_ibuf(&pfjob->context_cpy, seq_prefetch_cfra(pfjob), 0);
-    BKE_sequencer_cache_free_temp_cache(
-        pfjob->scene, pfjob->context.task_id, seq_prefetch_cfra(pfjob));
+    ImBuf *ibuf = BKE_sequencer_give_ibuf(&worker->context_cpy, worker->cfra, 0);
+    BKE_sequencer_cache_free_temp_cache(pfjob->scene, worker->context.task_id, worker->cfra);
     IMB_freeImBuf(ibuf);
 
     /* Suspend thread if there is nothing to be prefetched. */
@@ -473,15 +552,15 @@ static void *seq_prefetch_frames(void *job)
     if (!(pfjob->scene->ed->cache_flag & SEQ_CACHE_PREFETCH_ENABLE) || pfjob->stop) {
       break;
     }
-
-    seq_prefetch_update_area(pfjob);
-    pfjob->num_frames_prefetched++;
   }
 
-  BKE_sequencer_cache_free_temp_cache(
-      pfjob->scene, pfjob->context.task_id, seq_prefetch_cfra(pfjob));
-  pfjob->running = false;
-  pfjob->scene_eval->ed->prefetch_job = NULL;
+  BKE_sequencer_cache_free_temp_cache(pfjob->scene, worker->context.task_id, worker->cfra);
+  worker->scene_eval->ed->prefetch_job = NULL;
+
+  /* Last worker to finish ends the job. */
+  if (atomic_sub_and_fetch_int32(&pfjob->num_workers_running, 1) == 0) {
+    pfjob->running = false;
+  }
 
   return 0;
 }
@@ -490,20 +569,43 @@ static PrefetchJob *seq_prefetch_start(const SeqRenderData *context, float cfra)
 {
   PrefetchJob *pfjob = seq_prefetch_job_get(context->scene);
 
+  /* Number of workers was changed in preferences. */
+  if (pfjob && pfjob->num_workers_requested != seq_prefetch_num_workers()) {
+    BKE_sequencer_prefetch_free(context->scene);
+    pfjob = NULL;
+  }
+
   if (!pfjob) {
     if (context->scene->ed) {
       pfjob = (PrefetchJob *)MEM_callocN(sizeof(PrefetchJob), "PrefetchJob");
       context->scene->ed->prefetch_job = pfjob;
 
-      BLI_threadpool_init(&pfjob->threads, seq_prefetch_frames, 1);
+      pfjob->num_workers_requested = seq_prefetch_num_workers();
+      pfjob->num_workers = pfjob->num_workers_requested;
       BLI_mutex_init(&pfjob->prefetch_suspend_mutex);
       BLI_condition_init(&pfjob->prefetch_suspend_cond);
 
       pfjob->bmain = context->bmain;
-      pfjob->bmain_eval = BKE_main_new();
-
       pfjob->scene = context->scene;
-      seq_prefetch_init_depsgraph(pfjob);
+
+      for (int i = 0; i < pfjob->num_workers; i++) {
+        PrefetchWorker *worker = &pfjob->workers[i];
+        const size_t mem_in_use = MEM_get_memory_in_use();
+        worker->pfjob = pfjob;
+        worker->bmain_eval = BKE_main_new();
+        seq_prefetch_init_depsgraph(worker);
+
+        if (i == 0) {
+          /* The scene copies of all workers are about as large as the first one. */
+          const size_t mem_in_use_after = MEM_get_memory_in_use();
+          const size_t worker_mem = (mem_in_use_after > mem_in_use) ?
+                                        mem_in_use_after - mem_in_use :
+                                        0;
+          pfjob->num_workers = seq_prefetch_num_workers_limit_memory(pfjob->num_workers,
+                                                                     worker_mem);
+        }
+      }
+      BLI_threadpool_init(&pfjob->threads, seq_prefetch_frames, pfjob->num_workers);
     }
   }
   seq_prefetch_update_scene(context->scene);
@@ -512,12 +614,15 @@ static PrefetchJob *seq_prefetch_start(const SeqRenderData *context, float cfra)
   pfjob->cfra = cfra;
   pfjob->num_frames_prefetched = 1;
 
-  pfjob->waiting = false;
+  pfjob->num_workers_waiting = 0;
+  pfjob->num_workers_running = pfjob->num_workers;
   pfjob->stop = false;
   pfjob->running = true;
 
-  BLI_threadpool_remove(&pfjob->threads, pfjob);
-  BLI_threadpool_insert(&pfjob->threads, pfjob);
+  for (int i = 0; i < pfjob->num_workers; i++) {
+    BLI_threadpool_remove(&pfjob->threads, &pfjob->workers[i]);
+    BLI_threadpool_insert(&pfjob->threads, &pfjob->workers[i]);
+  }
 
   return pfjob;
 }
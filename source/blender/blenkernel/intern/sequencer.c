@@ -2729,7 +2729,7 @@ static ImBuf *input_preprocess(const SeqRenderData *context,
         IMB_scaleImBuf(ibuf, ibuf->x * image_scale_factor, ibuf->y * image_scale_factor);
       }
       else {
-        IMB_scalefastImBuf(ibuf, ibuf->x * image_scale_factor, ibuf->y * image_scale_factor);
+        IMB_scale_box_threaded(ibuf, ibuf->x * image_scale_factor, ibuf->y * image_scale_factor);
       }
     }
 
@@ -2803,7 +2803,7 @@ static ImBuf *input_preprocess(const SeqRenderData *context,
       IMB_scaleImBuf(ibuf, (short)context->rectx, (short)context->recty);
     }
     else {
-      IMB_scalefastImBuf(ibuf, (short)context->rectx, (short)context->recty);
+      IMB_scale_box_threaded(ibuf, (short)context->rectx, (short)context->recty);
     }
   }
 
@@ -3012,18 +3012,41 @@ static ImBuf *seq_render_effect_strip_impl(const SeqRenderData *context,
   return out;
 }
 
-/* Render individual view for multiview or single (default view) for monoview. */
+/* Flags for loading image at preview resolution directly, if file format supports it.
+ * Resulting image is then handled same way as proxy. */
+static int seq_render_reduced_load_flag(const SeqRenderData *context)
+{
+  if (context->for_render || context->is_proxy_render) {
+    return 0;
+  }
+
+  switch (context->preview_render_size) {
+    case SEQ_PROXY_RENDER_SIZE_25:
+      return IB_reduce_4;
+    case SEQ_PROXY_RENDER_SIZE_50:
+      return IB_reduce_2;
+  }
+
+  return 0;
+}
+
+/* Render individual view for multiview or single (default view) for monoview.
+ * Image may be loaded at reduced resolution only when \a r_is_reduced is passed. */
 static ImBuf *seq_render_image_strip_view(const SeqRenderData *context,
                                           Sequence *seq,
                                           char *name,
                                           char *prefix,
                                           const char *ext,
-                                          int view_id)
+                                          int view_id,
+                                          bool *r_is_reduced)
 {
 
   ImBuf *ibuf = NULL;
 
   int flag = IB_rect | IB_metadata;
+  if (r_is_reduced != NULL) {
+    flag |= seq_render_reduced_load_flag(context);
+  }
   if (seq->alpha_mode == SEQ_ALPHA_PREMUL) {
     flag |= IB_alphamode_premul;
   }
@@ -3042,6 +3065,10 @@ static ImBuf *seq_render_image_strip_view(const SeqRenderData *context,
     return NULL;
   }
 
+  if (r_is_reduced != NULL && (ibuf->flags & (IB_reduce_2 | IB_reduce_4))) {
+    *r_is_reduced = true;
+  }
+
   /* We don't need both (speed reasons)! */
   if (ibuf->rect_float != NULL && ibuf->rect != NULL) {
     imb_freerectImBuf(ibuf);
@@ -3101,13 +3128,15 @@ static ImBuf *seq_render_image_strip(const SeqRenderData *context,
   const int totfiles = seq_num_files(context->scene, seq->views_format, true);
   bool is_multiview_render = seq_image_strip_is_multiview_render(
       context->scene, seq, totfiles, name, prefix, ext);
+  bool is_reduced = false;
 
   if (is_multiview_render) {
     int totviews = BKE_scene_multiview_num_views_get(&context->scene->r);
     ImBuf **ibufs_arr = MEM_callocN(sizeof(ImBuf *) * totviews, "Sequence Image Views Imbufs");
 
     for (int view_id = 0; view_id < totfiles; view_id++) {
-      ibufs_arr[view_id] = seq_render_image_strip_view(context, seq, name, prefix, ext, view_id);
+      ibufs_arr[view_id] = seq_render_image_strip_view(
+          context, seq, name, prefix, ext, view_id, NULL);
     }
 
     if (ibufs_arr[0] == NULL) {
@@ -3141,13 +3170,25 @@ static ImBuf *seq_render_image_strip(const SeqRenderData *context,
     MEM_freeN(ibufs_arr);
   }
   else {
-    ibuf = seq_render_image_strip_view(context, seq, name, prefix, ext, context->view_id);
+    ibuf = seq_render_image_strip_view(
+        context, seq, name, prefix, ext, context->view_id, &is_reduced);
   }
 
   if (ibuf == NULL) {
     return NULL;
   }
 
+  /* Image was loaded at preview size, keep original size from full resolution load. */
+  if (is_reduced) {
+    *r_is_proxy_image = true;
+    if (s_elem->orig_width == 0 || s_elem->orig_height == 0) {
+      const int factor = (ibuf->flags & IB_reduce_4) ? 4 : 2;
+      s_elem->orig_width = ibuf->x * factor;
+      s_elem->orig_height = ibuf->y * factor;
+    }
+    return ibuf;
+  }
+
   s_elem->orig_width = ibuf->x;
   s_elem->orig_height = ibuf->y;
 
@@ -4057,6 +4098,41 @@ static ImBuf *seq_render_strip_stack(const SeqRenderData *context,
  * you have to free after usage!
  */
 
+/* Whether strips can be rendered by several prefetch threads at once, each with its own copy of
+ * the scene. Movies open their own file handles in every copy, and images, masks and most
+ * effects only use the copied data. Other strips use state shared between the copies:
+ * - Scene strips render through render results found by scene name, and OpenGL.
+ * - Movie clips go through the clip cache and its file handles.
+ * - Text draws with the global render font. */
+static bool seq_render_is_reentrant(ListBase *seqbase)
+{
+  LISTBASE_FOREACH (Sequence *, seq, seqbase) {
+    switch (seq->type) {
+      case SEQ_TYPE_META:
+        if (!seq_render_is_reentrant(&seq->seqbase)) {
+          return false;
+        }
+        break;
+      case SEQ_TYPE_IMAGE:
+      case SEQ_TYPE_MOVIE:
+      case SEQ_TYPE_MASK:
+      case SEQ_TYPE_SOUND_RAM:
+      case SEQ_TYPE_SOUND_HD:
+        break;
+      case SEQ_TYPE_SCENE:
+      case SEQ_TYPE_MOVIECLIP:
+      case SEQ_TYPE_TEXT:
+        return false;
+      default:
+        if (!(seq->type & SEQ_TYPE_EFFECT)) {
+          return false;
+        }
+        break;
+    }
+  }
+  return true;
+}
+
 ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int chanshown)
 {
   Scene *scene = context->scene;
@@ -4095,7 +4171,13 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
   float cost = 0;
 
   if (count && !out) {
-    BLI_mutex_lock(&seq_render_mutex);
+    /* Prefetch threads render their own copy of scene and link cache entries separately,
+     * so they can render frames in parallel when the strips allow it. */
+    const bool use_render_mutex = !context->is_prefetch_render ||
+                                  !seq_render_is_reentrant(seqbasep);
+    if (use_render_mutex) {
+      BLI_mutex_lock(&seq_render_mutex);
+    }
     out = seq_render_strip_stack(context, &state, seqbasep, cfra, chanshown);
     cost = seq_estimate_render_cost_end(context->scene, begin);
 
@@ -4107,7 +4189,9 @@ ImBuf *BKE_sequencer_give_ibuf(const SeqRenderData *context, float cfra, int cha
       BKE_sequencer_cache_put_if_possible(
           context, seq_arr[count - 1], cfra, SEQ_CACHE_STORE_FINAL_OUT, out, cost, false);
     }
-    BLI_mutex_unlock(&seq_render_mutex);
+    if (use_render_mutex) {
+      BLI_mutex_unlock(&seq_render_mutex);
+    }
   }
 
   BKE_sequencer_prefetch_start(context, cfra, cost);
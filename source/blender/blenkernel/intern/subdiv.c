@@ -23,10 +23,13 @@
 
 #include "BKE_subdiv.h"
 
+#include <string.h>
+
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
 #include "DNA_modifier_types.h"
 
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "MEM_guardedalloc.h"
@@ -38,15 +41,180 @@
 #include "opensubdiv_evaluator_capi.h"
 #include "opensubdiv_topology_refiner_capi.h"
 
+/* ============================ DESCRIPTOR CACHE ============================ */
+
+/* Descriptors which are not used anymore, most recently released first.
+ * They are looked up by settings and topology hash, the full topology comparison
+ * is only done for the descriptor which is about to be re-used. */
+
+#define SUBDIV_CACHE_MAX_DESCRIPTORS 8
+#define SUBDIV_CACHE_MAX_SIZE ((size_t)256 * 1024 * 1024)
+/* Estimated bytes per coarse element and refinement level, see subdiv_size_estimate(). */
+#define SUBDIV_CACHE_ELEMENT_SIZE 128
+
+static struct {
+  ThreadMutex mutex;
+  bool is_enabled;
+  int num_descriptors;
+  Subdiv *descriptors[SUBDIV_CACHE_MAX_DESCRIPTORS];
+  size_t descriptor_sizes[SUBDIV_CACHE_MAX_DESCRIPTORS];
+  size_t size_total;
+} subdiv_cache = {BLI_MUTEX_INITIALIZER};
+
+/* OpenSubdiv doesn't report the memory it uses, estimate it from the coarse topology. Adaptive
+ * refinement only refines around extraordinary vertices, so tables grow about linearly with
+ * the level, uniform refinement has four times as many faces for every level. */
+static size_t subdiv_size_estimate(const Subdiv *subdiv)
+{
+  const OpenSubdiv_TopologyRefiner *refiner = subdiv->topology_refiner;
+  const size_t num_elements = (size_t)refiner->getNumVertices(refiner) +
+                              (size_t)refiner->getNumEdges(refiner) +
+                              (size_t)refiner->getNumFaces(refiner);
+  const int level = refiner->getSubdivisionLevel(refiner);
+  const size_t level_factor = refiner->getIsAdaptive(refiner) ? (size_t)level + 1 :
+                                                                (size_t)1 << (2 * level);
+  size_t size = num_elements * level_factor * SUBDIV_CACHE_ELEMENT_SIZE;
+  if (subdiv->evaluator != NULL) {
+    /* Patch tables and stencils are about as large as the refined topology. */
+    size *= 2;
+  }
+  return size;
+}
+
+static void subdiv_cache_clear_locked(void)
+{
+  for (int i = 0; i < subdiv_cache.num_descriptors; i++) {
+    BKE_subdiv_free(subdiv_cache.descriptors[i]);
+  }
+  subdiv_cache.num_descriptors = 0;
+  subdiv_cache.size_total = 0;
+}
+
+static void subdiv_cache_enable(void)
+{
+  BLI_mutex_lock(&subdiv_cache.mutex);
+  subdiv_cache.is_enabled = true;
+  BLI_mutex_unlock(&subdiv_cache.mutex);
+}
+
+static void subdiv_cache_disable(void)
+{
+  BLI_mutex_lock(&subdiv_cache.mutex);
+  subdiv_cache_clear_locked();
+  subdiv_cache.is_enabled = false;
+  BLI_mutex_unlock(&subdiv_cache.mutex);
+}
+
+void BKE_subdiv_cache_flush(void)
+{
+  BLI_mutex_lock(&subdiv_cache.mutex);
+  subdiv_cache_clear_locked();
+  BLI_mutex_unlock(&subdiv_cache.mutex);
+}
+
+static Subdiv *subdiv_cache_acquire(const SubdivSettings *settings,
+                                    OpenSubdiv_Converter *converter)
+{
+  /* Unlocked read, avoids hashing the topology when nothing was released. */
+  if (subdiv_cache.num_descriptors == 0 || converter->getNumVertices(converter) == 0) {
+    return NULL;
+  }
+  const uint64_t topology_hash = openSubdiv_topologyHashFromConverter(converter);
+
+  Subdiv *subdiv = NULL;
+  BLI_mutex_lock(&subdiv_cache.mutex);
+  for (int i = 0; i < subdiv_cache.num_descriptors; i++) {
+    Subdiv *subdiv_cached = subdiv_cache.descriptors[i];
+    if (subdiv_cached->topology_hash == topology_hash &&
+        BKE_subdiv_settings_equal(&subdiv_cached->settings, settings)) {
+      subdiv = subdiv_cached;
+      subdiv_cache.size_total -= subdiv_cache.descriptor_sizes[i];
+      subdiv_cache.num_descriptors--;
+      memmove(&subdiv_cache.descriptors[i],
+              &subdiv_cache.descriptors[i + 1],
+              sizeof(Subdiv *) * (subdiv_cache.num_descriptors - i));
+      memmove(&subdiv_cache.descriptor_sizes[i],
+              &subdiv_cache.descriptor_sizes[i + 1],
+              sizeof(size_t) * (subdiv_cache.num_descriptors - i));
+      break;
+    }
+  }
+  BLI_mutex_unlock(&subdiv_cache.mutex);
+
+  if (subdiv == NULL) {
+    return NULL;
+  }
+  /* Hash collision, or topology attributes which are not hashed (UV maps) differ. */
+  BKE_subdiv_stats_begin(&subdiv->stats, SUBDIV_STATS_TOPOLOGY_COMPARE);
+  const bool is_equal = openSubdiv_topologyRefinerCompareWithConverter(subdiv->topology_refiner,
+                                                                       converter);
+  BKE_subdiv_stats_end(&subdiv->stats, SUBDIV_STATS_TOPOLOGY_COMPARE);
+  if (!is_equal) {
+    BKE_subdiv_free(subdiv);
+    return NULL;
+  }
+  return subdiv;
+}
+
+void BKE_subdiv_release(Subdiv *subdiv)
+{
+  if (subdiv->topology_refiner == NULL) {
+    BKE_subdiv_free(subdiv);
+    return;
+  }
+  /* Displacement is set up by the user of the descriptor for its own data. */
+  BKE_subdiv_displacement_detach(subdiv);
+
+  const size_t size = subdiv_size_estimate(subdiv);
+  if (size > SUBDIV_CACHE_MAX_SIZE) {
+    BKE_subdiv_free(subdiv);
+    return;
+  }
+
+  Subdiv *subdiv_evicted[SUBDIV_CACHE_MAX_DESCRIPTORS + 1];
+  int num_evicted = 0;
+  BLI_mutex_lock(&subdiv_cache.mutex);
+  if (!subdiv_cache.is_enabled) {
+    subdiv_evicted[num_evicted++] = subdiv;
+  }
+  else {
+    /* Least recently released descriptors go first. */
+    while (subdiv_cache.num_descriptors > 0 &&
+           (subdiv_cache.num_descriptors == SUBDIV_CACHE_MAX_DESCRIPTORS ||
+            subdiv_cache.size_total + size > SUBDIV_CACHE_MAX_SIZE)) {
+      const int last = --subdiv_cache.num_descriptors;
+      subdiv_cache.size_total -= subdiv_cache.descriptor_sizes[last];
+      subdiv_evicted[num_evicted++] = subdiv_cache.descriptors[last];
+    }
+    memmove(&subdiv_cache.descriptors[1],
+            &subdiv_cache.descriptors[0],
+            sizeof(Subdiv *) * subdiv_cache.num_descriptors);
+    memmove(&subdiv_cache.descriptor_sizes[1],
+            &subdiv_cache.descriptor_sizes[0],
+            sizeof(size_t) * subdiv_cache.num_descriptors);
+    subdiv_cache.descriptors[0] = subdiv;
+    subdiv_cache.descriptor_sizes[0] = size;
+    subdiv_cache.size_total += size;
+    subdiv_cache.num_descriptors++;
+  }
+  BLI_mutex_unlock(&subdiv_cache.mutex);
+
+  for (int i = 0; i < num_evicted; i++) {
+    BKE_subdiv_free(subdiv_evicted[i]);
+  }
+}
+
 /* =================----====--===== MODULE ==========================------== */
 
 void BKE_subdiv_init()
 {
   openSubdiv_init();
+  subdiv_cache_enable();
 }
 
 void BKE_subdiv_exit()
 {
+  subdiv_cache_disable();
   openSubdiv_cleanup();
 }
 
@@ -130,6 +298,9 @@ Subdiv *BKE_subdiv_new_from_converter(const SubdivSettings *settings,
   Subdiv *subdiv = MEM_callocN(sizeof(Subdiv), "subdiv from converetr");
   subdiv->settings = *settings;
   subdiv->topology_refiner = osd_topology_refiner;
+  if (osd_topology_refiner != NULL) {
+    subdiv->topology_hash = openSubdiv_topologyHashFromConverter(converter);
+  }
   subdiv->evaluator = NULL;
   subdiv->displacement_evaluator = NULL;
   BKE_subdiv_stats_end(&stats, SUBDIV_STATS_TOPOLOGY_REFINER_CREATION_TIME);
@@ -174,11 +345,15 @@ Subdiv *BKE_subdiv_update_from_converter(Subdiv *subdiv,
   if (can_reuse_subdiv) {
     return subdiv;
   }
-  /* Create new subdiv. */
+  /* Pick up a released descriptor, or create new subdiv. */
+  Subdiv *subdiv_new = subdiv_cache_acquire(settings, converter);
+  if (subdiv_new == NULL) {
+    subdiv_new = BKE_subdiv_new_from_converter(settings, converter);
+  }
   if (subdiv != NULL) {
-    BKE_subdiv_free(subdiv);
+    BKE_subdiv_release(subdiv);
   }
-  return BKE_subdiv_new_from_converter(settings, converter);
+  return subdiv_new;
 }
 
 Subdiv *BKE_subdiv_update_from_mesh(Subdiv *subdiv,
@@ -26,18 +26,35 @@
 #include "DNA_mesh_types.h"
 #include "DNA_meshdata_types.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
+#include "BLI_fileops.h"
 #include "BLI_math_bits.h"
 #include "BLI_math_vector.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_DerivedMesh.h"
+#include "BKE_appdir.h"
 #include "BKE_ccg.h"
 #include "BKE_mesh.h"
 #include "BKE_subdiv.h"
 #include "BKE_subdiv_eval.h"
 
+#include "atomic_ops.h"
+
 #include "opensubdiv_topology_refiner_capi.h"
 
 /* -------------------------------------------------------------------- */
@@ -46,6 +63,21 @@
 
 static void subdiv_ccg_average_all_boundaries_and_corners(SubdivCCG *subdiv_ccg, CCGKey *key);
 
+struct CCGEvalGridsData;
+
+static void subdiv_ccg_recalc_inner_grid_normals(SubdivCCG *subdiv_ccg,
+                                                 const int start_grid,
+                                                 const int end_grid);
+static void subdiv_ccg_average_inner_grids(SubdivCCG *subdiv_ccg,
+                                           CCGKey *key,
+                                           const int start_face,
+                                           const int end_face);
+
+static bool subdiv_ccg_paging_create(SubdivCCG *subdiv_ccg);
+static bool subdiv_ccg_paging_evaluate_grids(SubdivCCG *subdiv_ccg,
+                                             struct CCGEvalGridsData *data);
+static void subdiv_ccg_paging_free(SubdivCCG *subdiv_ccg);
+
 static void subdiv_ccg_average_inner_face_grids(SubdivCCG *subdiv_ccg,
                                                 CCGKey *key,
                                                 SubdivCCGFace *face);
@@ -136,13 +168,6 @@ static void subdiv_ccg_alloc_elements(SubdivCCG *subdiv_ccg, Subdiv *subdiv)
   subdiv_ccg->grid_element_size = element_size;
   subdiv_ccg->num_grids = num_grids;
   subdiv_ccg->grids = MEM_calloc_arrayN(num_grids, sizeof(CCGElem *), "subdiv ccg grids");
-  subdiv_ccg->grids_storage = MEM_calloc_arrayN(
-      num_grids, ((size_t)grid_area) * element_size, "subdiv ccg grids storage");
-  const size_t grid_size_in_bytes = (size_t)grid_area * element_size;
-  for (int grid_index = 0; grid_index < num_grids; grid_index++) {
-    const size_t grid_offset = grid_size_in_bytes * grid_index;
-    subdiv_ccg->grids[grid_index] = (CCGElem *)&subdiv_ccg->grids_storage[grid_offset];
-  }
   /* Grid material flags. */
   subdiv_ccg->grid_flag_mats = MEM_calloc_arrayN(
       num_grids, sizeof(DMFlagMat), "ccg grid material flags");
@@ -162,6 +187,20 @@ static void subdiv_ccg_alloc_elements(SubdivCCG *subdiv_ccg, Subdiv *subdiv)
   }
 }
 
+/* Storage of the grids when they are kept in memory, allocated after the elements. */
+static void subdiv_ccg_alloc_grids_storage(SubdivCCG *subdiv_ccg)
+{
+  const int num_grids = subdiv_ccg->num_grids;
+  const size_t grid_size_in_bytes = (size_t)subdiv_ccg->grid_size * subdiv_ccg->grid_size *
+                                    subdiv_ccg->grid_element_size;
+  subdiv_ccg->grids_storage = MEM_calloc_arrayN(
+      num_grids, grid_size_in_bytes, "subdiv ccg grids storage");
+  for (int grid_index = 0; grid_index < num_grids; grid_index++) {
+    const size_t grid_offset = grid_size_in_bytes * grid_index;
+    subdiv_ccg->grids[grid_index] = (CCGElem *)&subdiv_ccg->grids_storage[grid_offset];
+  }
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -306,6 +345,14 @@ static void subdiv_ccg_eval_grids_task(void *__restrict userdata_v,
   }
 }
 
+static void subdiv_ccg_eval_grids(CCGEvalGridsData *data, const int start_face, const int end_face)
+{
+  TaskParallelSettings parallel_range_settings;
+  BLI_parallel_range_settings_defaults(&parallel_range_settings);
+  BLI_task_parallel_range(
+      start_face, end_face, data, subdiv_ccg_eval_grids_task, &parallel_range_settings);
+}
+
 static bool subdiv_ccg_evaluate_grids(SubdivCCG *subdiv_ccg,
                                       Subdiv *subdiv,
                                       SubdivCCGMaskEvaluator *mask_evaluator,
@@ -320,11 +367,16 @@ static bool subdiv_ccg_evaluate_grids(SubdivCCG *subdiv_ccg,
   data.face_ptex_offset = BKE_subdiv_face_ptex_offset_get(subdiv);
   data.mask_evaluator = mask_evaluator;
   data.material_flags_evaluator = material_flags_evaluator;
+  if (subdiv_ccg->paging != NULL) {
+    if (subdiv_ccg_paging_evaluate_grids(subdiv_ccg, &data)) {
+      return true;
+    }
+    /* The swap file could not be written, keep the grids in memory instead. */
+    subdiv_ccg_paging_free(subdiv_ccg);
+    subdiv_ccg_alloc_grids_storage(subdiv_ccg);
+  }
   /* Threaded grids evaluation. */
-  TaskParallelSettings parallel_range_settings;
-  BLI_parallel_range_settings_defaults(&parallel_range_settings);
-  BLI_task_parallel_range(
-      0, num_faces, &data, subdiv_ccg_eval_grids_task, &parallel_range_settings);
+  subdiv_ccg_eval_grids(&data, 0, num_faces);
   /* If displacement is used, need to calculate normals after all final
    * coordinates are known. */
   if (subdiv->displacement_evaluator != NULL) {
@@ -402,7 +454,52 @@ static CCGElem *subdiv_ccg_coord_to_elem(const CCGKey *key,
                                          const SubdivCCG *subdiv_ccg,
                                          const SubdivCCGCoord *coord)
 {
-  return CCG_grid_elem(key, subdiv_ccg->grids[coord->grid_index], coord->x, coord->y);
+  return CCG_grid_elem(
+      key, BKE_subdiv_ccg_grid_get(subdiv_ccg, coord->grid_index), coord->x, coord->y);
+}
+
+/* False when one of the grids can't be read back from the swap file, the elements are then left
+ * as they are. */
+static bool subdiv_ccg_coords_grids_available(const SubdivCCG *subdiv_ccg,
+                                              const SubdivCCGCoord *coords,
+                                              const int num_coords)
+{
+  int prev_grid_index = -1;
+  for (int i = 0; i < num_coords; i++) {
+    const int grid_index = coords[i].grid_index;
+    if (grid_index == prev_grid_index) {
+      continue;
+    }
+    if (BKE_subdiv_ccg_grid_get(subdiv_ccg, grid_index) == NULL) {
+      return false;
+    }
+    prev_grid_index = grid_index;
+  }
+  return true;
+}
+
+static bool subdiv_ccg_face_grids_available(const SubdivCCG *subdiv_ccg,
+                                            const SubdivCCGFace *face)
+{
+  for (int corner = 0; corner < face->num_grids; corner++) {
+    if (BKE_subdiv_ccg_grid_get(subdiv_ccg, face->start_grid_index + corner) == NULL) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* True when one of the grids is in memory, which is always the case without paging. */
+static bool subdiv_ccg_coords_grids_resident(const SubdivCCG *subdiv_ccg,
+                                             const SubdivCCGCoord *coords,
+                                             const int num_coords)
+{
+  for (int i = 0; i < num_coords; i++) {
+    if (subdiv_ccg->grids[coords[i].grid_index] != NULL) {
+      return true;
+    }
+  }
+  return false;
 }
 
 /* Returns storage where boundary elements are to be stored. */
@@ -580,6 +677,9 @@ SubdivCCG *BKE_subdiv_to_ccg(Subdiv *subdiv,
   subdiv_ccg->grid_size = BKE_subdiv_grid_size_from_level(subdiv_ccg->level);
   subdiv_ccg_init_layers(subdiv_ccg, settings);
   subdiv_ccg_alloc_elements(subdiv_ccg, subdiv);
+  if (!(settings->use_paging && subdiv_ccg_paging_create(subdiv_ccg))) {
+    subdiv_ccg_alloc_grids_storage(subdiv_ccg);
+  }
   subdiv_ccg_init_faces(subdiv_ccg);
   subdiv_ccg_init_faces_neighborhood(subdiv_ccg);
   if (!subdiv_ccg_evaluate_grids(subdiv_ccg, subdiv, mask_evaluator, material_flags_evaluator)) {
@@ -624,6 +724,7 @@ Mesh *BKE_subdiv_to_ccg_mesh(Subdiv *subdiv,
 void BKE_subdiv_ccg_destroy(SubdivCCG *subdiv_ccg)
 {
   const int num_grids = subdiv_ccg->num_grids;
+  subdiv_ccg_paging_free(subdiv_ccg);
   MEM_SAFE_FREE(subdiv_ccg->grids);
   MEM_SAFE_FREE(subdiv_ccg->grids_storage);
   MEM_SAFE_FREE(subdiv_ccg->edges);
@@ -706,7 +807,7 @@ static void subdiv_ccg_recalc_inner_face_normals(SubdivCCG *subdiv_ccg,
 {
   const int grid_size = subdiv_ccg->grid_size;
   const int grid_size_1 = grid_size - 1;
-  CCGElem *grid = subdiv_ccg->grids[grid_index];
+  CCGElem *grid = BKE_subdiv_ccg_grid_get(subdiv_ccg, grid_index);
   if (tls->face_normals == NULL) {
     tls->face_normals = MEM_malloc_arrayN(
         grid_size_1 * grid_size_1, 3 * sizeof(float), "CCG TLS normals");
@@ -740,7 +841,7 @@ static void subdiv_ccg_average_inner_face_normals(SubdivCCG *subdiv_ccg,
 {
   const int grid_size = subdiv_ccg->grid_size;
   const int grid_size_1 = grid_size - 1;
-  CCGElem *grid = subdiv_ccg->grids[grid_index];
+  CCGElem *grid = BKE_subdiv_ccg_grid_get(subdiv_ccg, grid_index);
   const float(*face_normals)[3] = tls->face_normals;
   for (int y = 0; y < grid_size; y++) {
     for (int x = 0; x < grid_size; x++) {
@@ -777,6 +878,9 @@ static void subdiv_ccg_recalc_inner_normal_task(void *__restrict userdata_v,
 {
   RecalcInnerNormalsData *data = userdata_v;
   RecalcInnerNormalsTLSData *tls = tls_v->userdata_chunk;
+  if (BKE_subdiv_ccg_grid_get(data->subdiv_ccg, grid_index) == NULL) {
+    return;
+  }
   subdiv_ccg_recalc_inner_face_normals(data->subdiv_ccg, data->key, tls, grid_index);
   subdiv_ccg_average_inner_face_normals(data->subdiv_ccg, data->key, tls, grid_index);
 }
@@ -789,7 +893,9 @@ static void subdiv_ccg_recalc_inner_normal_free(const void *__restrict UNUSED(us
 }
 
 /* Recalculate normals which corresponds to non-boundaries elements of grids. */
-static void subdiv_ccg_recalc_inner_grid_normals(SubdivCCG *subdiv_ccg)
+static void subdiv_ccg_recalc_inner_grid_normals(SubdivCCG *subdiv_ccg,
+                                                 const int start_grid,
+                                                 const int end_grid)
 {
   CCGKey key;
   BKE_subdiv_ccg_key_top_level(&key, subdiv_ccg);
@@ -803,8 +909,8 @@ static void subdiv_ccg_recalc_inner_grid_normals(SubdivCCG *subdiv_ccg)
   parallel_range_settings.userdata_chunk = &tls_data;
   parallel_range_settings.userdata_chunk_size = sizeof(tls_data);
   parallel_range_settings.func_free = subdiv_ccg_recalc_inner_normal_free;
-  BLI_task_parallel_range(0,
-                          subdiv_ccg->num_grids,
+  BLI_task_parallel_range(start_grid,
+                          end_grid,
                           &data,
                           subdiv_ccg_recalc_inner_normal_task,
                           &parallel_range_settings);
@@ -816,7 +922,7 @@ void BKE_subdiv_ccg_recalc_normals(SubdivCCG *subdiv_ccg)
     /* Grids don't have normals, can do early output. */
     return;
   }
-  subdiv_ccg_recalc_inner_grid_normals(subdiv_ccg);
+  subdiv_ccg_recalc_inner_grid_normals(subdiv_ccg, 0, subdiv_ccg->num_grids);
   BKE_subdiv_ccg_average_grids(subdiv_ccg);
 }
 
@@ -837,6 +943,9 @@ static void subdiv_ccg_recalc_modified_inner_normal_task(void *__restrict userda
   SubdivCCGFace **faces = data->effected_ccg_faces;
   SubdivCCGFace *face = faces[face_index];
   const int num_face_grids = face->num_grids;
+  if (!subdiv_ccg_face_grids_available(subdiv_ccg, face)) {
+    return;
+  }
   for (int i = 0; i < num_face_grids; i++) {
     const int grid_index = face->start_grid_index + i;
     subdiv_ccg_recalc_inner_face_normals(data->subdiv_ccg, data->key, tls, grid_index);
@@ -986,13 +1095,16 @@ static void subdiv_ccg_average_inner_face_grids(SubdivCCG *subdiv_ccg,
                                                 CCGKey *key,
                                                 SubdivCCGFace *face)
 {
-  CCGElem **grids = subdiv_ccg->grids;
   const int num_face_grids = face->num_grids;
   const int grid_size = subdiv_ccg->grid_size;
-  CCGElem *prev_grid = grids[face->start_grid_index + num_face_grids - 1];
+  if (!subdiv_ccg_face_grids_available(subdiv_ccg, face)) {
+    return;
+  }
+  CCGElem *prev_grid = BKE_subdiv_ccg_grid_get(subdiv_ccg,
+                                               face->start_grid_index + num_face_grids - 1);
   /* Average boundary between neighbor grid. */
   for (int corner = 0; corner < num_face_grids; corner++) {
-    CCGElem *grid = grids[face->start_grid_index + corner];
+    CCGElem *grid = BKE_subdiv_ccg_grid_get(subdiv_ccg, face->start_grid_index + corner);
     for (int i = 1; i < grid_size; i++) {
       CCGElem *prev_grid_element = CCG_grid_elem(key, prev_grid, i, 0);
       CCGElem *grid_element = CCG_grid_elem(key, grid, 0, i);
@@ -1005,13 +1117,13 @@ static void subdiv_ccg_average_inner_face_grids(SubdivCCG *subdiv_ccg,
   GridElementAccumulator center_accumulator;
   element_accumulator_init(&center_accumulator);
   for (int corner = 0; corner < num_face_grids; corner++) {
-    CCGElem *grid = grids[face->start_grid_index + corner];
+    CCGElem *grid = BKE_subdiv_ccg_grid_get(subdiv_ccg, face->start_grid_index + corner);
     CCGElem *grid_center_element = CCG_grid_elem(key, grid, 0, 0);
     element_accumulator_add(&center_accumulator, subdiv_ccg, key, grid_center_element);
   }
   element_accumulator_mul_fl(&center_accumulator, 1.0f / (float)num_face_grids);
   for (int corner = 0; corner < num_face_grids; corner++) {
-    CCGElem *grid = grids[face->start_grid_index + corner];
+    CCGElem *grid = BKE_subdiv_ccg_grid_get(subdiv_ccg, face->start_grid_index + corner);
     CCGElem *grid_center_element = CCG_grid_elem(key, grid, 0, 0);
     element_accumulator_copy(subdiv_ccg, key, grid_center_element, &center_accumulator);
   }
@@ -1032,6 +1144,8 @@ static void subdiv_ccg_average_inner_grids_task(void *__restrict userdata_v,
 typedef struct AverageGridsBoundariesData {
   SubdivCCG *subdiv_ccg;
   CCGKey *key;
+  /* Skip boundaries of which none of the grids are in memory. */
+  bool skip_paged_out;
 } AverageGridsBoundariesData;
 
 typedef struct AverageGridsBoundariesTLSData {
@@ -1049,6 +1163,12 @@ static void subdiv_ccg_average_grids_boundary(SubdivCCG *subdiv_ccg,
     /* Nothing to average with. */
     return;
   }
+  for (int face_index = 0; face_index < num_adjacent_faces; face_index++) {
+    if (!subdiv_ccg_coords_grids_available(
+            subdiv_ccg, adjacent_edge->boundary_coords[face_index], grid_size2)) {
+      return;
+    }
+  }
   if (tls->accumulators == NULL) {
     tls->accumulators = MEM_calloc_arrayN(
         sizeof(GridElementAccumulator), grid_size2, "average accumulators");
@@ -1087,6 +1207,16 @@ static void subdiv_ccg_average_grids_boundaries_task(void *__restrict userdata_v
   SubdivCCG *subdiv_ccg = data->subdiv_ccg;
   CCGKey *key = data->key;
   SubdivCCGAdjacentEdge *adjacent_edge = &subdiv_ccg->adjacent_edges[adjacent_edge_index];
+  if (data->skip_paged_out) {
+    bool is_resident = false;
+    for (int face_index = 0; face_index < adjacent_edge->num_adjacent_faces; face_index++) {
+      is_resident |= subdiv_ccg_coords_grids_resident(
+          subdiv_ccg, adjacent_edge->boundary_coords[face_index], subdiv_ccg->grid_size * 2);
+    }
+    if (!is_resident) {
+      return;
+    }
+  }
   subdiv_ccg_average_grids_boundary(subdiv_ccg, key, adjacent_edge, tls);
 }
 
@@ -1100,6 +1230,8 @@ static void subdiv_ccg_average_grids_boundaries_free(const void *__restrict UNUS
 typedef struct AverageGridsCornerData {
   SubdivCCG *subdiv_ccg;
   CCGKey *key;
+  /* Skip corners of which none of the grids are in memory. */
+  bool skip_paged_out;
 } AverageGridsCornerData;
 
 static void subdiv_ccg_average_grids_corners(SubdivCCG *subdiv_ccg,
@@ -1111,6 +1243,10 @@ static void subdiv_ccg_average_grids_corners(SubdivCCG *subdiv_ccg,
     /* Nothing to average with. */
     return;
   }
+  if (!subdiv_ccg_coords_grids_available(
+          subdiv_ccg, adjacent_vertex->corner_coords, num_adjacent_faces)) {
+    return;
+  }
   GridElementAccumulator accumulator;
   element_accumulator_init(&accumulator);
   for (int face_index = 0; face_index < num_adjacent_faces; face_index++) {
@@ -1135,38 +1271,53 @@ static void subdiv_ccg_average_grids_corners_task(void *__restrict userdata_v,
   SubdivCCG *subdiv_ccg = data->subdiv_ccg;
   CCGKey *key = data->key;
   SubdivCCGAdjacentVertex *adjacent_vertex = &subdiv_ccg->adjacent_vertices[adjacent_vertex_index];
+  if (data->skip_paged_out &&
+      !subdiv_ccg_coords_grids_resident(
+          subdiv_ccg, adjacent_vertex->corner_coords, adjacent_vertex->num_adjacent_faces)) {
+    return;
+  }
   subdiv_ccg_average_grids_corners(subdiv_ccg, key, adjacent_vertex);
 }
 
-static void subdiv_ccg_average_all_boundaries(SubdivCCG *subdiv_ccg, CCGKey *key)
+static void subdiv_ccg_average_boundaries(SubdivCCG *subdiv_ccg,
+                                          CCGKey *key,
+                                          const int start_adjacent_edge,
+                                          const int end_adjacent_edge,
+                                          const bool skip_paged_out)
 {
   TaskParallelSettings parallel_range_settings;
   BLI_parallel_range_settings_defaults(&parallel_range_settings);
   AverageGridsBoundariesData boundaries_data = {
       .subdiv_ccg = subdiv_ccg,
       .key = key,
+      .skip_paged_out = skip_paged_out,
   };
   AverageGridsBoundariesTLSData tls_data = {NULL};
   parallel_range_settings.userdata_chunk = &tls_data;
   parallel_range_settings.userdata_chunk_size = sizeof(tls_data);
   parallel_range_settings.func_free = subdiv_ccg_average_grids_boundaries_free;
-  BLI_task_parallel_range(0,
-                          subdiv_ccg->num_adjacent_edges,
+  BLI_task_parallel_range(start_adjacent_edge,
+                          end_adjacent_edge,
                           &boundaries_data,
                           subdiv_ccg_average_grids_boundaries_task,
                           &parallel_range_settings);
 }
 
-static void subdiv_ccg_average_all_corners(SubdivCCG *subdiv_ccg, CCGKey *key)
+static void subdiv_ccg_average_corners(SubdivCCG *subdiv_ccg,
+                                       CCGKey *key,
+                                       const int start_adjacent_vertex,
+                                       const int end_adjacent_vertex,
+                                       const bool skip_paged_out)
 {
   TaskParallelSettings parallel_range_settings;
   BLI_parallel_range_settings_defaults(&parallel_range_settings);
   AverageGridsCornerData corner_data = {
       .subdiv_ccg = subdiv_ccg,
       .key = key,
+      .skip_paged_out = skip_paged_out,
   };
-  BLI_task_parallel_range(0,
-                          subdiv_ccg->num_adjacent_vertices,
+  BLI_task_parallel_range(start_adjacent_vertex,
+                          end_adjacent_vertex,
                           &corner_data,
                           subdiv_ccg_average_grids_corners_task,
                           &parallel_range_settings);
@@ -1174,27 +1325,41 @@ static void subdiv_ccg_average_all_corners(SubdivCCG *subdiv_ccg, CCGKey *key)
 
 static void subdiv_ccg_average_all_boundaries_and_corners(SubdivCCG *subdiv_ccg, CCGKey *key)
 {
-  subdiv_ccg_average_all_boundaries(subdiv_ccg, key);
-  subdiv_ccg_average_all_corners(subdiv_ccg, key);
+  /* With paging, grids in the swap file were averaged before they were paged out and didn't
+   * change since. Only boundaries of grids in memory need to be averaged, reading back the
+   * paged out grids they share a boundary with. */
+  const bool skip_paged_out = (subdiv_ccg->paging != NULL);
+  subdiv_ccg_average_boundaries(
+      subdiv_ccg, key, 0, subdiv_ccg->num_adjacent_edges, skip_paged_out);
+  subdiv_ccg_average_corners(
+      subdiv_ccg, key, 0, subdiv_ccg->num_adjacent_vertices, skip_paged_out);
 }
 
-void BKE_subdiv_ccg_average_grids(SubdivCCG *subdiv_ccg)
+/* Average inner boundaries of grids (within one face), across faces
+ * from different face-corners. */
+static void subdiv_ccg_average_inner_grids(SubdivCCG *subdiv_ccg,
+                                           CCGKey *key,
+                                           const int start_face,
+                                           const int end_face)
 {
-  CCGKey key;
-  BKE_subdiv_ccg_key_top_level(&key, subdiv_ccg);
   TaskParallelSettings parallel_range_settings;
   BLI_parallel_range_settings_defaults(&parallel_range_settings);
-  /* Average inner boundaries of grids (within one face), across faces
-   * from different face-corners. */
   AverageInnerGridsData inner_data = {
       .subdiv_ccg = subdiv_ccg,
-      .key = &key,
+      .key = key,
   };
-  BLI_task_parallel_range(0,
-                          subdiv_ccg->num_faces,
+  BLI_task_parallel_range(start_face,
+                          end_face,
                           &inner_data,
                           subdiv_ccg_average_inner_grids_task,
                           &parallel_range_settings);
+}
+
+void BKE_subdiv_ccg_average_grids(SubdivCCG *subdiv_ccg)
+{
+  CCGKey key;
+  BKE_subdiv_ccg_key_top_level(&key, subdiv_ccg);
+  subdiv_ccg_average_inner_grids(subdiv_ccg, &key, 0, subdiv_ccg->num_faces);
   subdiv_ccg_average_all_boundaries_and_corners(subdiv_ccg, &key);
 }
 
@@ -1890,3 +2055,312 @@ SubdivCCGAdjacencyType BKE_subdiv_ccg_coarse_mesh_adjacency_info_get(const Subdi
 }
 
 /** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Grids paging
+ * \{ */
+
+/* Swap file reads and writes are split in chunks of this size, the size argument of read() and
+ * write() is not wide enough for the whole storage on all platforms. */
+#define PAGING_IO_CHUNK_SIZE (64 * 1024 * 1024)
+
+/* Memory for grids read back from the swap file, above it they are paged out again. Creation
+ * and averaging of the grids in the swap file work on chunks of half of it. */
+#define PAGING_MEMORY_LIMIT ((size_t)1024 * 1024 * 1024)
+
+typedef struct SubdivCCGPaging {
+  /* Every grid has a fixed slot in the swap file, at the offset it had in the grids storage. */
+  char filepath[FILE_MAX];
+  int file;
+  size_t grid_size_in_bytes;
+  /* Grids are read back on access, which happens from threads. */
+  ThreadMutex mutex;
+  /* Number of grids read back, which are in memory. */
+  int num_resident_grids;
+  /* A grid could not be read back, grids are not paged out anymore. */
+  bool has_read_error;
+} SubdivCCGPaging;
+
+static bool subdiv_ccg_paging_io(
+    SubdivCCGPaging *paging, void *data, size_t offset, size_t size, const bool do_write)
+{
+  if (BLI_lseek(paging->file, (int64_t)offset, SEEK_SET) == -1) {
+    return false;
+  }
+  char *data_iter = data;
+  while (size > 0) {
+    const size_t chunk_size = MIN2(size, PAGING_IO_CHUNK_SIZE);
+    const int64_t len = do_write ? write(paging->file, data_iter, chunk_size) :
+                                   read(paging->file, data_iter, chunk_size);
+    if (len == -1 && errno == EINTR) {
+      continue;
+    }
+    if (len <= 0) {
+      return false;
+    }
+    /* Short reads and writes are not errors, continue with the rest. */
+    data_iter += len;
+    size -= (size_t)len;
+  }
+  return true;
+}
+
+/* Open the swap file, the grids are created in it by #subdiv_ccg_paging_evaluate_grids. */
+static bool subdiv_ccg_paging_create(SubdivCCG *subdiv_ccg)
+{
+  SubdivCCGPaging *paging = MEM_callocN(sizeof(SubdivCCGPaging), "subdiv ccg paging");
+  char filename[64];
+  BLI_snprintf(filename, sizeof(filename), "subdiv_ccg_%p.swap", (void *)subdiv_ccg);
+  BLI_join_dirfile(paging->filepath, sizeof(paging->filepath), BKE_tempdir_session(), filename);
+  paging->file = BLI_open(paging->filepath, O_BINARY | O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (paging->file == -1) {
+    MEM_freeN(paging);
+    return false;
+  }
+  paging->grid_size_in_bytes = (size_t)subdiv_ccg->grid_size * subdiv_ccg->grid_size *
+                               subdiv_ccg->grid_element_size;
+  BLI_mutex_init(&paging->mutex);
+  subdiv_ccg->paging = paging;
+  return true;
+}
+
+/* Page out all grids which are in memory once they take more than half of the memory limit.
+ * Only for use while the grids are created, nothing else accesses them then. */
+static bool subdiv_ccg_paging_trim(SubdivCCG *subdiv_ccg)
+{
+  SubdivCCGPaging *paging = subdiv_ccg->paging;
+  if (paging->num_resident_grids * paging->grid_size_in_bytes <= PAGING_MEMORY_LIMIT / 2) {
+    return true;
+  }
+  for (int grid_index = 0; grid_index < subdiv_ccg->num_grids; grid_index++) {
+    BKE_subdiv_ccg_grids_page_out(subdiv_ccg, &grid_index, 1);
+  }
+  return paging->num_resident_grids == 0;
+}
+
+/* Average boundaries and corners between the faces of grids created in the swap file, a chunk
+ * at a time. Grids are read back as they are needed, and paged out between the chunks. */
+static bool subdiv_ccg_paging_average_boundaries_and_corners(SubdivCCG *subdiv_ccg,
+                                                             CCGKey *key)
+{
+  SubdivCCGPaging *paging = subdiv_ccg->paging;
+  /* Boundaries read two grids of every adjacent face, corners one. */
+  const size_t chunk_len = PAGING_MEMORY_LIMIT / 2 / (paging->grid_size_in_bytes * 4);
+  const int chunk_size = (int)MAX2(MIN2(chunk_len, INT_MAX / 2), 1);
+  for (int start = 0; start < subdiv_ccg->num_adjacent_edges; start += chunk_size) {
+    const int end = min_ii(start + chunk_size, subdiv_ccg->num_adjacent_edges);
+    subdiv_ccg_average_boundaries(subdiv_ccg, key, start, end, false);
+    if (paging->has_read_error || !subdiv_ccg_paging_trim(subdiv_ccg)) {
+      return false;
+    }
+  }
+  for (int start = 0; start < subdiv_ccg->num_adjacent_vertices; start += chunk_size) {
+    const int end = min_ii(start + chunk_size, subdiv_ccg->num_adjacent_vertices);
+    subdiv_ccg_average_corners(subdiv_ccg, key, start, end, false);
+    if (paging->has_read_error || !subdiv_ccg_paging_trim(subdiv_ccg)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Evaluate the grids into the swap file a chunk of faces at a time, so only a chunk of the grids
+ * is in memory at once. Returns false when the swap file can't be written or read back, the
+ * grids are then evaluated in memory instead. */
+static bool subdiv_ccg_paging_evaluate_grids(SubdivCCG *subdiv_ccg, CCGEvalGridsData *data)
+{
+  SubdivCCGPaging *paging = subdiv_ccg->paging;
+  const size_t size = paging->grid_size_in_bytes;
+  const int num_faces = subdiv_ccg->num_faces;
+  const SubdivCCGFace *faces = subdiv_ccg->faces;
+  /* Same as #BKE_subdiv_ccg_recalc_normals after the evaluation in memory. */
+  const bool need_normals = data->subdiv->displacement_evaluator != NULL &&
+                            subdiv_ccg->has_normal;
+  const size_t chunk_len = PAGING_MEMORY_LIMIT / 2 / size;
+  const int chunk_num_grids = (int)MAX2(MIN2(chunk_len, INT_MAX / 2), 1);
+  CCGKey key;
+  BKE_subdiv_ccg_key_top_level(&key, subdiv_ccg);
+
+  unsigned char *storage = NULL;
+  int storage_num_grids = 0;
+  bool success = true;
+  for (int start_face = 0; start_face < num_faces && success;) {
+    /* Grids of the faces follow each other. A chunk has at least one face, and ends before the
+     * face which doesn't fit in it anymore. */
+    const int start_grid = faces[start_face].start_grid_index;
+    int end_face = start_face + 1;
+    while (end_face < num_faces &&
+           faces[end_face].start_grid_index + faces[end_face].num_grids - start_grid <=
+               chunk_num_grids) {
+      end_face++;
+    }
+    const int end_grid = faces[end_face - 1].start_grid_index + faces[end_face - 1].num_grids;
+    const int num_grids = end_grid - start_grid;
+    if (num_grids > storage_num_grids) {
+      MEM_SAFE_FREE(storage);
+      storage = MEM_malloc_arrayN(num_grids, size, "subdiv ccg paging chunk");
+      storage_num_grids = num_grids;
+    }
+
+    for (int i = 0; i < num_grids; i++) {
+      subdiv_ccg->grids[start_grid + i] = (CCGElem *)&storage[size * i];
+    }
+    subdiv_ccg_eval_grids(data, start_face, end_face);
+    if (need_normals) {
+      /* Boundaries between faces are averaged once all grids are in the swap file. */
+      subdiv_ccg_recalc_inner_grid_normals(subdiv_ccg, start_grid, end_grid);
+      subdiv_ccg_average_inner_grids(subdiv_ccg, &key, start_face, end_face);
+    }
+    success = subdiv_ccg_paging_io(paging, storage, size * start_grid, size * num_grids, true);
+    memset(&subdiv_ccg->grids[start_grid], 0, sizeof(*subdiv_ccg->grids) * num_grids);
+
+    start_face = end_face;
+  }
+  MEM_SAFE_FREE(storage);
+
+  if (success && need_normals) {
+    success = subdiv_ccg_paging_average_boundaries_and_corners(subdiv_ccg, &key);
+  }
+  if (!success) {
+    fprintf(stderr, "Error creating multires grids in '%s'\n", paging->filepath);
+  }
+  return success;
+}
+
+static void subdiv_ccg_paging_free(SubdivCCG *subdiv_ccg)
+{
+  SubdivCCGPaging *paging = subdiv_ccg->paging;
+  if (paging == NULL) {
+    return;
+  }
+  for (int grid_index = 0; grid_index < subdiv_ccg->num_grids; grid_index++) {
+    MEM_SAFE_FREE(subdiv_ccg->grids[grid_index]);
+  }
+  close(paging->file);
+  BLI_delete(paging->filepath, false, false);
+  BLI_mutex_end(&paging->mutex);
+  MEM_freeN(paging);
+  subdiv_ccg->paging = NULL;
+}
+
+static CCGElem *subdiv_ccg_grid_page_in(const SubdivCCG *subdiv_ccg, const int grid_index)
+{
+  SubdivCCGPaging *paging = subdiv_ccg->paging;
+  const size_t size = paging->grid_size_in_bytes;
+
+  BLI_mutex_lock(&paging->mutex);
+  CCGElem *grid = subdiv_ccg->grids[grid_index];
+  if (grid == NULL) {
+    grid = MEM_mallocN(size, "subdiv ccg grid");
+    if (subdiv_ccg_paging_io(paging, grid, size * grid_index, size, false)) {
+      /* Other threads test the pointer without the lock, only publish it once the grid is
+       * read. */
+      atomic_cas_ptr((void **)&subdiv_ccg->grids[grid_index], NULL, grid);
+      paging->num_resident_grids++;
+    }
+    else {
+      /* Keep the grid paged out, its slot in the swap file is the only copy of it. Later
+       * accesses try again, only report the first failure. */
+      if (!paging->has_read_error) {
+        fprintf(stderr, "Error reading multires grids from '%s'\n", paging->filepath);
+        paging->has_read_error = true;
+      }
+      MEM_freeN(grid);
+      grid = NULL;
+    }
+  }
+  BLI_mutex_unlock(&paging->mutex);
+  return grid;
+}
+
+bool BKE_subdiv_ccg_paging_has_error(const SubdivCCG *subdiv_ccg)
+{
+  return subdiv_ccg->paging != NULL && subdiv_ccg->paging->has_read_error;
+}
+
+CCGElem *BKE_subdiv_ccg_grid_read(const SubdivCCG *subdiv_ccg,
+                                  const int grid_index,
+                                  CCGElem *buffer)
+{
+  CCGElem *grid = subdiv_ccg->grids[grid_index];
+  SubdivCCGPaging *paging = subdiv_ccg->paging;
+  if (grid != NULL || paging == NULL) {
+    return grid;
+  }
+  const size_t size = paging->grid_size_in_bytes;
+  BLI_mutex_lock(&paging->mutex);
+  /* Might have been read back in the meantime. */
+  grid = subdiv_ccg->grids[grid_index];
+  if (grid == NULL) {
+    if (subdiv_ccg_paging_io(paging, buffer, size * grid_index, size, false)) {
+      grid = buffer;
+    }
+    else if (!paging->has_read_error) {
+      fprintf(stderr, "Error reading multires grids from '%s'\n", paging->filepath);
+      paging->has_read_error = true;
+    }
+  }
+  BLI_mutex_unlock(&paging->mutex);
+  return grid;
+}
+
+bool BKE_subdiv_ccg_paging_over_limit(const SubdivCCG *subdiv_ccg)
+{
+  const SubdivCCGPaging *paging = subdiv_ccg->paging;
+  return paging != NULL &&
+         paging->num_resident_grids * paging->grid_size_in_bytes > PAGING_MEMORY_LIMIT;
+}
+
+CCGElem *BKE_subdiv_ccg_grid_get(const SubdivCCG *subdiv_ccg, const int grid_index)
+{
+  CCGElem *grid = subdiv_ccg->grids[grid_index];
+  if (UNLIKELY(grid == NULL) && subdiv_ccg->paging != NULL) {
+    grid = subdiv_ccg_grid_page_in(subdiv_ccg, grid_index);
+  }
+  return grid;
+}
+
+bool BKE_subdiv_ccg_grids_page_in(SubdivCCG *subdiv_ccg,
+                                  const int *grid_indices,
+                                  const int num_grids)
+{
+  if (subdiv_ccg->paging == NULL) {
+    return true;
+  }
+  bool success = true;
+  for (int i = 0; i < num_grids; i++) {
+    if (BKE_subdiv_ccg_grid_get(subdiv_ccg, grid_indices[i]) == NULL) {
+      success = false;
+    }
+  }
+  return success;
+}
+
+void BKE_subdiv_ccg_grids_page_out(SubdivCCG *subdiv_ccg,
+                                   const int *grid_indices,
+                                   const int num_grids)
+{
+  SubdivCCGPaging *paging = subdiv_ccg->paging;
+  if (paging == NULL || paging->has_read_error) {
+    /* After a read error keep what is still in memory there. */
+    return;
+  }
+  const size_t size = paging->grid_size_in_bytes;
+  for (int i = 0; i < num_grids; i++) {
+    const int grid_index = grid_indices[i];
+    CCGElem *grid = subdiv_ccg->grids[grid_index];
+    if (grid == NULL) {
+      continue;
+    }
+    if (!subdiv_ccg_paging_io(paging, grid, size * grid_index, size, true)) {
+      /* Keep the remaining grids in memory, sculpting goes on without paging. */
+      fprintf(stderr, "Error writing multires grid %d to '%s'\n", grid_index, paging->filepath);
+      return;
+    }
+    subdiv_ccg->grids[grid_index] = NULL;
+    paging->num_resident_grids--;
+    MEM_freeN(grid);
+  }
+}
+
+/** \} */
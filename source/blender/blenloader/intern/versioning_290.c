@@ -427,5 +427,18 @@ void blo_do_versions_290(FileData *fd, Library *UNUSED(lib), Main *bmain)
         }
       }
     }
+
+    /* Initialize the screen size of adaptive subdivision surface viewport levels. */
+    if (!DNA_struct_elem_find(
+            fd->filesdna, "SubsurfModifierData", "float", "adaptive_pixel_size")) {
+      LISTBASE_FOREACH (Object *, object, &bmain->objects) {
+        LISTBASE_FOREACH (ModifierData *, md, &object->modifiers) {
+          if (md->type == eModifierType_Subsurf) {
+            SubsurfModifierData *smd = (SubsurfModifierData *)md;
+            smd->adaptive_pixel_size = 8.0f;
+          }
+        }
+      }
+    }
   }
 }
@@ -253,6 +253,14 @@ typedef struct MeshBatchCache {
   float tot_area, tot_uv_area;
 
   bool no_loose_wire;
+
+  /** #BMEditMesh.deform_stamp the edit-mesh buffers were last updated with. */
+  int deform_stamp;
+  /** Loop normals use auto-smooth and cannot be updated partially. */
+  bool lnor_use_auto_smooth;
+
+  /** Triangles are sorted into clusters with bounds, see #GPUIndexBufCluster. */
+  bool use_clusters;
 } MeshBatchCache;
 
 void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
@@ -269,5 +277,9 @@ void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
                                         const Scene *scene,
                                         const ToolSettings *ts,
                                         const bool use_hide);
+bool mesh_buffer_cache_deform_update(Mesh *me,
+                                     const int deform_stamp,
+                                     GPUVertBuf *pos_nor,
+                                     GPUVertBuf *lnor);
 
 #endif /* __DRAW_CACHE_EXTRACT_H__ */
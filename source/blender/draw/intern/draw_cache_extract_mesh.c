@@ -504,6 +504,12 @@ BLI_INLINE const float *bm_face_no_get(const MeshRenderData *mr, const BMFace *e
   }
 }
 
+/* Buffers that #mesh_buffer_cache_deform_update can patch keep their data for edit-meshes. */
+BLI_INLINE GPUUsageType mesh_deform_vbo_usage_get(const MeshRenderData *mr)
+{
+  return (mr->extract_type == MR_EXTRACT_BMESH) ? GPU_USAGE_DYNAMIC : GPU_USAGE_STATIC;
+}
+
 /** \} */
 
 /* ---------------------------------------------------------------------- */
@@ -885,10 +891,164 @@ static void extract_tris_iter_looptri_mesh(const MeshRenderData *mr,
   EXTRACT_TRIS_LOOPTRI_FOREACH_MESH_END;
 }
 
+/* Number of triangles in each cluster, large enough for the culling of the clusters to stay
+ * cheap compared to drawing them. */
+#define MESH_CLUSTER_TRI_LEN 256
+
+typedef struct MeshClusterPoly {
+  int mat;
+  uint key;
+  uint tri_first;
+  uint tri_len;
+} MeshClusterPoly;
+
+/* Spread the 10 lower bits so there are two zero bits between each of them. */
+static uint mesh_cluster_bits_spread(uint v)
+{
+  v &= 0x3FF;
+  v = (v | (v << 16)) & 0x030000FF;
+  v = (v | (v << 8)) & 0x0300F00F;
+  v = (v | (v << 4)) & 0x030C30C3;
+  v = (v | (v << 2)) & 0x09249249;
+  return v;
+}
+
+static int mesh_cluster_poly_cmp(const void *a_, const void *b_)
+{
+  const MeshClusterPoly *a = a_, *b = b_;
+  if (a->mat != b->mat) {
+    return (a->mat < b->mat) ? -1 : 1;
+  }
+  if (a->key != b->key) {
+    return (a->key < b->key) ? -1 : 1;
+  }
+  return (a->tri_first < b->tri_first) ? -1 : (a->tri_first > b->tri_first);
+}
+
+static bool extract_tris_use_clusters(const MeshRenderData *mr, const MeshExtract_Tri_Data *data)
+{
+  const int tri_len = data->tri_mat_end[mr->mat_len - 1];
+  return (mr->cache->use_clusters && mr->extract_type == MR_EXTRACT_MESH &&
+          mr->edit_bmesh == NULL && tri_len >= MESH_CLUSTER_TRI_LEN * 4);
+}
+
+/**
+ * Sort the triangles of each material by the location of their polygon along a Z-order curve,
+ * keeping the triangles of a polygon together, and compute the bounds of every
+ * #MESH_CLUSTER_TRI_LEN triangles so the draw manager can skip the clusters out of view.
+ *
+ * The vertex buffers have one vertex per loop, so polygons never share vertices and their order
+ * does not change the vertex cache reuse, only how compact the clusters are.
+ */
+static GPUIndexBufCluster *extract_tris_clusters_build(const MeshRenderData *mr,
+                                                       MeshExtract_Tri_Data *data,
+                                                       uint *r_cluster_len)
+{
+  const int mat_last = mr->mat_len - 1;
+  const int tri_len = data->tri_mat_end[mat_last];
+
+  float min[3], max[3], scale[3];
+  INIT_MINMAX(min, max);
+  for (int v = 0; v < mr->vert_len; v++) {
+    minmax_v3v3_v3(min, max, mr->mvert[v].co);
+  }
+  for (int i = 0; i < 3; i++) {
+    scale[i] = (max[i] > min[i]) ? 1023.0f / (max[i] - min[i]) : 0.0f;
+  }
+
+  /* Find the triangles of each visible polygon, in the order they were extracted. */
+  MeshClusterPoly *polys = MEM_mallocN(sizeof(*polys) * mr->poly_len, __func__);
+  int *mat_tri_ofs = MEM_mallocN(sizeof(*mat_tri_ofs) * mr->mat_len, __func__);
+  memcpy(mat_tri_ofs, data->tri_mat_start, sizeof(*mat_tri_ofs) * mr->mat_len);
+  int poly_len = 0;
+  const MPoly *mp = mr->mpoly;
+  for (int mp_index = 0; mp_index < mr->poly_len; mp_index++, mp++) {
+    if ((mr->use_hide && (mp->flag & ME_HIDE)) || mp->totloop < 3) {
+      continue;
+    }
+    float center[3] = {0.0f};
+    const MLoop *ml = &mr->mloop[mp->loopstart];
+    for (int i = 0; i < mp->totloop; i++, ml++) {
+      add_v3_v3(center, mr->mvert[ml->v].co);
+    }
+    mul_v3_fl(center, 1.0f / mp->totloop);
+
+    uint key = 0;
+    for (int i = 0; i < 3; i++) {
+      const uint co = (uint)clamp_f((center[i] - min[i]) * scale[i], 0.0f, 1023.0f);
+      key |= mesh_cluster_bits_spread(co) << i;
+    }
+
+    MeshClusterPoly *poly = &polys[poly_len++];
+    poly->mat = min_ii(mp->mat_nr, mat_last);
+    poly->key = key;
+    poly->tri_first = mat_tri_ofs[poly->mat];
+    poly->tri_len = mp->totloop - 2;
+    mat_tri_ofs[poly->mat] += poly->tri_len;
+  }
+
+  const bool is_valid = memcmp(mat_tri_ofs, data->tri_mat_end, sizeof(int) * mr->mat_len) == 0;
+  MEM_freeN(mat_tri_ofs);
+  if (!is_valid) {
+    /* Triangles were not extracted in polygon order, keep them as they are. */
+    BLI_assert(0);
+    MEM_freeN(polys);
+    *r_cluster_len = 0;
+    return NULL;
+  }
+
+  qsort(polys, poly_len, sizeof(*polys), mesh_cluster_poly_cmp);
+
+  uint *tri_verts = MEM_mallocN(sizeof(uint[3]) * tri_len, __func__);
+  uint *tri_verts_iter = tri_verts;
+  for (int i = 0; i < poly_len; i++) {
+    const uint len = polys[i].tri_len * 3;
+    memcpy(tri_verts_iter, &data->elb.data[polys[i].tri_first * 3], sizeof(uint) * len);
+    tri_verts_iter += len;
+  }
+  memcpy(data->elb.data, tri_verts, sizeof(uint[3]) * tri_len);
+  MEM_freeN(tri_verts);
+  MEM_freeN(polys);
+
+  /* Clusters don't cross materials, so each material sub-range has its own. */
+  uint cluster_len = 0;
+  for (int i = 0; i < mr->mat_len; i++) {
+    const int mat_tri_len = data->tri_mat_end[i] - data->tri_mat_start[i];
+    cluster_len += divide_ceil_u(mat_tri_len, MESH_CLUSTER_TRI_LEN);
+  }
+
+  GPUIndexBufCluster *clusters = MEM_mallocN(sizeof(*clusters) * cluster_len, __func__);
+  GPUIndexBufCluster *cluster = clusters;
+  for (int i = 0; i < mr->mat_len; i++) {
+    for (int t = data->tri_mat_start[i]; t < data->tri_mat_end[i]; t += MESH_CLUSTER_TRI_LEN) {
+      const int t_end = min_ii(t + MESH_CLUSTER_TRI_LEN, data->tri_mat_end[i]);
+      cluster->index_start = t * 3;
+      cluster->index_len = (t_end - t) * 3;
+      INIT_MINMAX(cluster->min, cluster->max);
+      const uint *l = &data->elb.data[cluster->index_start];
+      for (uint j = 0; j < cluster->index_len; j++) {
+        minmax_v3v3_v3(cluster->min, cluster->max, mr->mvert[mr->mloop[l[j]].v].co);
+      }
+      cluster++;
+    }
+  }
+
+  *r_cluster_len = cluster_len;
+  return clusters;
+}
+
 static void extract_tris_finish(const MeshRenderData *mr, void *ibo, void *_data)
 {
   MeshExtract_Tri_Data *data = _data;
+  GPUIndexBufCluster *clusters = NULL;
+  uint cluster_len = 0;
+  if (extract_tris_use_clusters(mr, data)) {
+    clusters = extract_tris_clusters_build(mr, data, &cluster_len);
+  }
   GPU_indexbuf_build_in_place(&data->elb, ibo);
+  if (clusters) {
+    GPU_indexbuf_clusters_set(ibo, clusters, cluster_len);
+  }
   /* HACK: Create ibo sub-ranges and assign them to each #GPUBatch. */
   /* The `surface_per_mat` tests are there when object shading type is set to Wire or Bounds. In
    * these cases there isn't a surface per material. */
@@ -1858,7 +2018,7 @@ static void *extract_pos_nor_init(const MeshRenderData *mr, void *buf)
     GPU_vertformat_alias_add(&format, "vnor");
   }
   GPUVertBuf *vbo = buf;
-  GPU_vertbuf_init_with_format(vbo, &format);
+  GPU_vertbuf_init_with_format_ex(vbo, &format, mesh_deform_vbo_usage_get(mr));
   GPU_vertbuf_data_alloc(vbo, mr->loop_len + mr->loop_loose_len);
 
   /* Pack normals per vert, reduce amount of computation. */
@@ -2029,7 +2189,7 @@ static void *extract_lnor_hq_init(const MeshRenderData *mr, void *buf)
     GPU_vertformat_alias_add(&format, "lnor");
   }
   GPUVertBuf *vbo = buf;
-  GPU_vertbuf_init_with_format(vbo, &format);
+  GPU_vertbuf_init_with_format_ex(vbo, &format, mesh_deform_vbo_usage_get(mr));
   GPU_vertbuf_data_alloc(vbo, mr->loop_len);
 
   return vbo->data;
@@ -2115,7 +2275,7 @@ static void *extract_lnor_init(const MeshRenderData *mr, void *buf)
     GPU_vertformat_alias_add(&format, "lnor");
   }
   GPUVertBuf *vbo = buf;
-  GPU_vertbuf_init_with_format(vbo, &format);
+  GPU_vertbuf_init_with_format_ex(vbo, &format, mesh_deform_vbo_usage_get(mr));
   GPU_vertbuf_data_alloc(vbo, mr->loop_len);
 
   return vbo->data;
@@ -5659,3 +5819,235 @@ void mesh_buffer_cache_create_requested(struct TaskGraph *task_graph,
 }
 
 /** \} */
+
+/* ---------------------------------------------------------------------- */
+/** \name Deform Update
+ *
+ * An edit-mesh that was only deformed keeps its topology, and with it the layout of the loop
+ * buffers, so only the loops whose data changed need to be extracted again. Moving a vertex
+ * changes the normal of the faces around it, which changes the normal of all vertices of those
+ * faces, which is used by the loops of every face around them: the faces touching the 2-ring
+ * of the moved vertices.
+ * \{ */
+
+typedef struct MeshDeformUpdateData {
+  const MeshRenderData *mr;
+  const int *faces;
+  void *pos_nor_data;
+  const MeshExtract *lnor_extract;
+  void *lnor_data;
+} MeshDeformUpdateData;
+
+static void mesh_deform_update_face_cb(void *__restrict userdata,
+                                       const int i,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const MeshDeformUpdateData *data = userdata;
+  const int f_index = data->faces[i];
+  const ExtractPolyBMesh_Params params = {
+      .poly_range = {f_index, f_index + 1},
+  };
+  extract_pos_nor.iter_poly_bm(data->mr, &params, data->pos_nor_data);
+  if (data->lnor_extract) {
+    data->lnor_extract->iter_poly_bm(data->mr, &params, data->lnor_data);
+  }
+}
+
+static void mesh_deform_update_upload(GPUVertBuf *pos_nor,
+                                      GPUVertBuf *lnor,
+                                      const int first,
+                                      const int len)
+{
+  GPU_vertbuf_update_sub(pos_nor, first, len);
+  if (lnor) {
+    GPU_vertbuf_update_sub(lnor, first, len);
+  }
+}
+
+/**
+ * Update the position and normal buffers of an edit-mesh that was extracted from the #BMesh
+ * directly, for the vertices moved since \a deform_stamp (see #BMEditMesh.deform_vert_stamp).
+ * \a lnor is optional and must not use auto-smooth loop normals.
+ *
+ * \return false when the update touches too much of the mesh or the buffers do not match the
+ * mesh, the buffers are left untouched and have to be extracted again.
+ */
+bool mesh_buffer_cache_deform_update(Mesh *me,
+                                     const int deform_stamp,
+                                     GPUVertBuf *pos_nor,
+                                     GPUVertBuf *lnor)
+{
+  BMEditMesh *em = me->edit_mesh;
+  BMesh *bm = em->bm;
+  const int *vert_stamp = em->deform_vert_stamp;
+
+  if ((vert_stamp == NULL) || (deform_stamp < em->deform_stamp_valid) ||
+      (MEM_allocN_len(vert_stamp) / sizeof(*vert_stamp) != (size_t)bm->totvert)) {
+    return false;
+  }
+  if ((pos_nor->data == NULL) || (pos_nor->vertex_len < (uint)bm->totloop)) {
+    return false;
+  }
+  if (lnor && ((lnor->data == NULL) || (lnor->vertex_len != (uint)bm->totloop))) {
+    return false;
+  }
+  if (deform_stamp == em->deform_stamp) {
+    /* Nothing moved. */
+    return true;
+  }
+
+  BM_mesh_elem_index_ensure(bm, BM_VERT | BM_EDGE | BM_LOOP | BM_FACE);
+  BM_mesh_elem_table_ensure(bm, BM_VERT | BM_FACE);
+
+  /* Vertices with a new normal: all vertices of the faces around the moved ones. */
+  BLI_bitmap *vert_nor_changed = BLI_BITMAP_NEW(bm->totvert, __func__);
+  for (int v_index = 0; v_index < bm->totvert; v_index++) {
+    if (vert_stamp[v_index] <= deform_stamp) {
+      continue;
+    }
+    BLI_BITMAP_ENABLE(vert_nor_changed, v_index);
+    BMIter iter;
+    BMLoop *l;
+    BM_ITER_ELEM (l, &iter, bm->vtable[v_index], BM_LOOPS_OF_VERT) {
+      BMLoop *l_iter = l;
+      do {
+        BLI_BITMAP_ENABLE(vert_nor_changed, BM_elem_index_get(l_iter->v));
+      } while ((l_iter = l_iter->next) != l);
+    }
+  }
+
+  BLI_bitmap *face_changed = BLI_BITMAP_NEW(bm->totface, __func__);
+  for (int v_index = 0; v_index < bm->totvert; v_index++) {
+    if (!BLI_BITMAP_TEST(vert_nor_changed, v_index)) {
+      continue;
+    }
+    BMIter iter;
+    BMFace *efa;
+    BM_ITER_ELEM (efa, &iter, bm->vtable[v_index], BM_FACES_OF_VERT) {
+      BLI_BITMAP_ENABLE(face_changed, BM_elem_index_get(efa));
+    }
+  }
+  MEM_freeN(vert_nor_changed);
+
+  /* Sorted by index, so the loops of consecutive faces are consecutive in the buffers. */
+  int *faces = MEM_mallocN(sizeof(*faces) * MAX2(bm->totface, 1), __func__);
+  int faces_len = 0;
+  for (int f_index = 0; f_index < bm->totface; f_index++) {
+    if (BLI_BITMAP_TEST(face_changed, f_index)) {
+      faces[faces_len++] = f_index;
+    }
+  }
+  MEM_freeN(face_changed);
+
+  /* Past this point the threaded full extraction is faster. */
+  if (faces_len > bm->totface / 2) {
+    MEM_freeN(faces);
+    return false;
+  }
+
+  const bool has_loose = pos_nor->vertex_len > (uint)bm->totloop;
+  /* The object matrix is not used by the position and normal extractors. */
+  float obmat[4][4];
+  unit_m4(obmat);
+  MeshRenderData *mr = mesh_render_data_create(me,
+                                               true,
+                                               false,
+                                               obmat,
+                                               true,
+                                               false,
+                                               NULL,
+                                               NULL,
+                                               has_loose ? (MR_ITER_LEDGE | MR_ITER_LVERT) : 0,
+                                               0);
+  BLI_assert(mr->extract_type == MR_EXTRACT_BMESH);
+  if ((mr->extract_type != MR_EXTRACT_BMESH) ||
+      ((uint)(mr->loop_len + mr->loop_loose_len) != pos_nor->vertex_len)) {
+    mesh_render_data_free(mr);
+    MEM_freeN(faces);
+    return false;
+  }
+
+  /* Only the normals of vertices used by updated loops are packed. */
+  MeshExtract_PosNor_Data *pos_nor_data = MEM_mallocN(
+      sizeof(*pos_nor_data) + sizeof(GPUPackedNormal) * mr->vert_len, __func__);
+  pos_nor_data->vbo_data = (PosNorLoop *)pos_nor->data;
+  for (int i = 0; i < faces_len; i++) {
+    BMLoop *l_iter, *l_first;
+    l_iter = l_first = BM_FACE_FIRST_LOOP(bm->ftable[faces[i]]);
+    do {
+      pos_nor_data->packed_nor[BM_elem_index_get(l_iter->v)] = GPU_normal_convert_i10_v3(
+          bm_vert_no_get(mr, l_iter->v));
+    } while ((l_iter = l_iter->next) != l_first);
+  }
+  for (int i = 0; i < mr->edge_loose_len; i++) {
+    BMEdge *eed = BM_edge_at_index(bm, mr->ledges[i]);
+    pos_nor_data->packed_nor[BM_elem_index_get(eed->v1)] = GPU_normal_convert_i10_v3(
+        bm_vert_no_get(mr, eed->v1));
+    pos_nor_data->packed_nor[BM_elem_index_get(eed->v2)] = GPU_normal_convert_i10_v3(
+        bm_vert_no_get(mr, eed->v2));
+  }
+  for (int i = 0; i < mr->vert_loose_len; i++) {
+    BMVert *eve = BM_vert_at_index(bm, mr->lverts[i]);
+    pos_nor_data->packed_nor[mr->lverts[i]] = GPU_normal_convert_i10_v3(bm_vert_no_get(mr, eve));
+  }
+
+  MeshDeformUpdateData data = {
+      .mr = mr,
+      .faces = faces,
+      .pos_nor_data = pos_nor_data,
+      .lnor_extract = NULL,
+      .lnor_data = NULL,
+  };
+  if (lnor) {
+    data.lnor_extract = (lnor->format.stride == sizeof(gpuHQNor)) ? &extract_lnor_hq :
+                                                                     &extract_lnor;
+    data.lnor_data = lnor->data;
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+  BLI_task_parallel_range(0, faces_len, &data, mesh_deform_update_face_cb, &settings);
+
+  /* Loose geometry is cheap, always update all of it. */
+  if (mr->edge_loose_len) {
+    extract_pos_nor.iter_ledge_bm(mr,
+                                  &(const ExtractLEdgeBMesh_Params){
+                                      .ledge = mr->ledges,
+                                      .ledge_range = {0, mr->edge_loose_len},
+                                  },
+                                  pos_nor_data);
+  }
+  if (mr->vert_loose_len) {
+    extract_pos_nor.iter_lvert_bm(mr,
+                                  &(const ExtractLVertBMesh_Params){
+                                      .lvert = mr->lverts,
+                                      .lvert_range = {0, mr->vert_loose_len},
+                                  },
+                                  pos_nor_data);
+  }
+
+  /* Upload runs of consecutive loops, bridging small gaps to save calls. */
+  const int gap_max = 64;
+  int run_first = 0, run_end = 0;
+  for (int i = 0; i < faces_len; i++) {
+    BMFace *efa = bm->ftable[faces[i]];
+    const int l_first = BM_elem_index_get(BM_FACE_FIRST_LOOP(efa));
+    if (run_end == run_first || l_first > run_end + gap_max) {
+      mesh_deform_update_upload(pos_nor, lnor, run_first, run_end - run_first);
+      run_first = l_first;
+    }
+    run_end = l_first + efa->len;
+  }
+  mesh_deform_update_upload(pos_nor, lnor, run_first, run_end - run_first);
+  if (mr->loop_loose_len) {
+    GPU_vertbuf_update_sub(pos_nor, mr->loop_len, mr->loop_loose_len);
+  }
+
+  MEM_freeN(pos_nor_data);
+  MEM_freeN(faces);
+  mesh_render_data_free(mr);
+  return true;
+}
+
+/** \} */
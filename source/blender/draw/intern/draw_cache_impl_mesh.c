@@ -40,6 +40,7 @@
 #include "DNA_meshdata_types.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
+#include "DNA_userdef_types.h"
 
 #include "BKE_customdata.h"
 #include "BKE_deform.h"
@@ -451,6 +452,11 @@ BLI_INLINE void mesh_batch_cache_add_request(MeshBatchCache *cache, DRWBatchFlag
 
 /* GPUBatch cache management. */
 
+static bool mesh_batch_cache_use_clusters(void)
+{
+  return USER_EXPERIMENTAL_TEST(&U, use_draw_mesh_clusters);
+}
+
 static bool mesh_batch_cache_valid(Mesh *me)
 {
   MeshBatchCache *cache = me->runtime.batch_cache;
@@ -471,6 +477,10 @@ static bool mesh_batch_cache_valid(Mesh *me)
     return false;
   }
 
+  if (cache->use_clusters != mesh_batch_cache_use_clusters()) {
+    return false;
+  }
+
   return true;
 }
 
@@ -494,6 +504,8 @@ static void mesh_batch_cache_init(Mesh *me)
     // cache->vert_len = mesh_render_verts_len_get(me);
   }
 
+  cache->use_clusters = mesh_batch_cache_use_clusters();
+
   cache->mat_len = mesh_render_mat_len_get(me);
   cache->surface_per_mat = MEM_callocN(sizeof(*cache->surface_per_mat) * cache->mat_len, __func__);
 
@@ -501,14 +513,71 @@ static void mesh_batch_cache_init(Mesh *me)
   cache->batch_ready = 0;
   cache->batch_requested = 0;
 
+  cache->deform_stamp = me->edit_mesh ? me->edit_mesh->deform_stamp : 0;
+  cache->lnor_use_auto_smooth = (me->flag & ME_AUTOSMOOTH) != 0;
+
   drw_mesh_weight_state_clear(&cache->weight_state);
 }
 
+/**
+ * When the edit-mesh was only deformed since the last update, update the position and normal
+ * buffers around the moved vertices so they can be kept when the rest of the cache is rebuilt.
+ */
+static bool mesh_batch_cache_deform_update(Mesh *me,
+                                           MeshBatchCache *cache,
+                                           GPUVertBuf **r_pos_nor,
+                                           GPUVertBuf **r_lnor)
+{
+  BMEditMesh *em = me->edit_mesh;
+  if (!cache->is_dirty || !cache->is_editmode || (em == NULL) ||
+      (cache->mat_len != mesh_render_mat_len_get(me))) {
+    return false;
+  }
+  /* Only the edit-mesh without modifiers is extracted from the #BMesh directly. */
+  Mesh *me_eval = em->mesh_eval_final;
+  if ((me_eval == NULL) || (me_eval != em->mesh_eval_cage) ||
+      (me_eval->runtime.wrapper_type != ME_WRAPPER_TYPE_BMESH) ||
+      (me_eval->runtime.edit_data && me_eval->runtime.edit_data->vertexCos)) {
+    return false;
+  }
+  GPUVertBuf *pos_nor = cache->final.vbo.pos_nor;
+  GPUVertBuf *lnor = cache->final.vbo.lnor;
+  if ((pos_nor == NULL) || DRW_vbo_requested(pos_nor)) {
+    return false;
+  }
+  if ((lnor != NULL) && (DRW_vbo_requested(lnor) || cache->lnor_use_auto_smooth ||
+                         (me->flag & ME_AUTOSMOOTH))) {
+    lnor = NULL;
+  }
+  if (!mesh_buffer_cache_deform_update(me, cache->deform_stamp, pos_nor, lnor)) {
+    return false;
+  }
+
+  /* Taken out of the cache so they survive the clear. */
+  *r_pos_nor = pos_nor;
+  cache->final.vbo.pos_nor = NULL;
+  if (lnor) {
+    *r_lnor = lnor;
+    cache->final.vbo.lnor = NULL;
+  }
+  return true;
+}
+
 void DRW_mesh_batch_cache_validate(Mesh *me)
 {
   if (!mesh_batch_cache_valid(me)) {
+    GPUVertBuf *pos_nor = NULL, *lnor = NULL;
+    MeshBatchCache *cache = me->runtime.batch_cache;
+    if (cache) {
+      mesh_batch_cache_deform_update(me, cache, &pos_nor, &lnor);
+    }
+
     mesh_batch_cache_clear(me);
     mesh_batch_cache_init(me);
+
+    cache = me->runtime.batch_cache;
+    cache->final.vbo.pos_nor = pos_nor;
+    cache->final.vbo.lnor = lnor;
   }
 }
 
@@ -670,6 +739,10 @@ void DRW_mesh_batch_cache_dirty_tag(Mesh *me, int mode)
       break;
     case BKE_MESH_BATCH_DIRTY_ALL:
       cache->is_dirty = true;
+      if (me->edit_mesh) {
+        /* Only transform tags its updates as deform-only, see #mesh_batch_cache_deform_update. */
+        BKE_editmesh_deform_tag_geometry_update(me->edit_mesh);
+      }
       break;
     case BKE_MESH_BATCH_DIRTY_SHADING:
       mesh_batch_cache_discard_shaded_tri(cache);
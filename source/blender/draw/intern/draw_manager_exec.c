@@ -21,6 +21,7 @@
  */
 
 #include "draw_manager.h"
+#include "draw_manager_profiling.h"
 
 #include "BLI_alloca.h"
 #include "BLI_math.h"
@@ -1008,6 +1009,71 @@ static void draw_call_single_do(DRWShadingGroup *shgroup,
                         state->baseinst_loc);
 }
 
+/**
+ * Draw only the clusters of the index buffer that are inside the view frustum.
+ * Returns false when they are all visible, the call is then drawn as usual.
+ */
+static bool draw_call_clusters_do(DRWShadingGroup *shgroup,
+                                  DRWCommandsState *state,
+                                  DRWCommandDraw *call)
+{
+  const GPUIndexBuf *elem = call->batch->elem;
+  DRWCullingState *culling = DRW_memblock_elem_from_handle(DST.vmempool->cullstates,
+                                                           &call->handle);
+  if (culling->bsphere.radius < 0.0f) {
+    /* Culling is disabled for this call. */
+    return false;
+  }
+
+  /* Test the clusters in object space. */
+  DRWView *view = DST.view_active->parent ? DST.view_active->parent : DST.view_active;
+  DRWObjectMatrix *ob_mats = DRW_memblock_elem_from_handle(DST.vmempool->obmats, &call->handle);
+  float tobmat[4][4], frustum_planes[6][4];
+  transpose_m4_m4(tobmat, ob_mats->model);
+  for (int i = 0; i < 6; i++) {
+    mul_v4_m4v4(frustum_planes[i], tobmat, view->frustum_planes[i]);
+  }
+
+  /* Draw the runs of consecutive visible clusters. */
+  int culled_len = 0, tris_culled_len = 0;
+  uint run_start = 0, run_len = 0;
+  for (uint i = 0; i < elem->cluster_len; i++) {
+    const GPUIndexBufCluster *cluster = &elem->clusters[i];
+    bool culled = false;
+    for (int p = 0; p < 6 && !culled; p++) {
+      float bb_near[3], bb_far[3];
+      aabb_get_near_far_from_plane(frustum_planes[p], cluster->min, cluster->max, bb_near, bb_far);
+      culled = plane_point_side_v3(frustum_planes[p], bb_far) < 0.0f;
+    }
+
+    if (!culled) {
+      if (run_len == 0) {
+        run_start = cluster->index_start - elem->index_start;
+      }
+      run_len += cluster->index_len;
+      continue;
+    }
+
+    if (run_len > 0) {
+      draw_call_single_do(
+          shgroup, state, call->batch, call->handle, run_start, run_len, 0, 1, true);
+    }
+    run_len = 0;
+    culled_len++;
+    tris_culled_len += cluster->index_len / 3;
+  }
+
+  DRW_stats_clusters_add(elem->cluster_len, culled_len, tris_culled_len);
+
+  if (culled_len == 0) {
+    return false;
+  }
+  if (run_len > 0) {
+    draw_call_single_do(shgroup, state, call->batch, call->handle, run_start, run_len, 0, 1, true);
+  }
+  return true;
+}
+
 static void draw_call_batching_start(DRWCommandsState *state)
 {
   state->neg_scale = false;
@@ -1178,6 +1244,12 @@ static void draw_shgroup(DRWShadingGroup *shgroup, DRWState pass_state)
           state.select_buf = cmd->select_id.select_buf;
           break;
         case DRW_CMD_DRAW:
+          if (cmd->draw.batch->elem && cmd->draw.batch->elem->cluster_len > 0 &&
+              !(G.f & G_FLAG_PICKSEL) && !cmd->draw.batch->inst[0]) {
+            if (draw_call_clusters_do(shgroup, &state, &cmd->draw)) {
+              break;
+            }
+          }
           if (!USE_BATCHING || state.obmats_loc == -1 || (G.f & G_FLAG_PICKSEL) ||
               cmd->draw.batch->inst[0]) {
             draw_call_single_do(
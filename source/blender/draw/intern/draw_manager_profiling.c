@@ -59,6 +59,10 @@ static struct DRWTimerPool {
   int end_increment;   /* Keep track of bad usage. */
   bool is_recording;   /* Are we in the render loop? */
   bool is_querying;    /* Keep track of bad usage. */
+  /* Mesh clusters tested and culled while drawing the scene. */
+  int cluster_tested;
+  int cluster_culled;
+  int cluster_tris_culled;
 } DTP = {NULL};
 
 void DRW_stats_free(void)
@@ -91,6 +95,9 @@ void DRW_stats_begin(void)
   DTP.is_querying = false;
   DTP.timer_increment = 0;
   DTP.end_increment = 0;
+  DTP.cluster_tested = 0;
+  DTP.cluster_culled = 0;
+  DTP.cluster_tris_culled = 0;
 }
 
 static DRWTimer *drw_stats_timer_get(void)
@@ -159,6 +166,15 @@ void DRW_stats_query_end(void)
   }
 }
 
+void DRW_stats_clusters_add(int tested, int culled, int tris_culled)
+{
+  if (DTP.is_recording) {
+    DTP.cluster_tested += tested;
+    DTP.cluster_culled += culled;
+    DTP.cluster_tris_culled += tris_culled;
+  }
+}
+
 void DRW_stats_reset(void)
 {
   BLI_assert((DTP.timer_increment - DTP.end_increment) <= 0 &&
@@ -320,6 +336,26 @@ void DRW_stats_draw(const rcti *rect)
   draw_stat_5row(rect, 1, v++, stat_string, sizeof(stat_string));
   v += 1;
 
+  /* Mesh Cluster Culling */
+  if (DTP.cluster_tested > 0) {
+    sprintf(stat_string, "Mesh Clusters");
+    draw_stat(rect, 0, v, stat_string, sizeof(stat_string));
+    sprintf(stat_string, "%d", DTP.cluster_tested);
+    draw_stat_5row(rect, 1, v++, stat_string, sizeof(stat_string));
+    sprintf(stat_string, "Culled");
+    draw_stat(rect, 1, v, stat_string, sizeof(stat_string));
+    sprintf(stat_string,
+            "%d (%.0f%%)",
+            DTP.cluster_culled,
+            100.0 * DTP.cluster_culled / DTP.cluster_tested);
+    draw_stat_5row(rect, 1, v++, stat_string, sizeof(stat_string));
+    sprintf(stat_string, "Triangles Culled");
+    draw_stat(rect, 1, v, stat_string, sizeof(stat_string));
+    sprintf(stat_string, "%d", DTP.cluster_tris_culled);
+    draw_stat_5row(rect, 1, v++, stat_string, sizeof(stat_string));
+    v += 1;
+  }
+
   /* GPU Timings */
   BLI_strncpy(stat_string, "GPU Render Timings", sizeof(stat_string));
   draw_stat(rect, 0, v++, stat_string, sizeof(stat_string));
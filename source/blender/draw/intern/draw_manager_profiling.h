@@ -35,6 +35,8 @@ void DRW_stats_group_end(void);
 void DRW_stats_query_start(const char *name);
 void DRW_stats_query_end(void);
 
+void DRW_stats_clusters_add(int tested, int culled, int tris_culled);
+
 void DRW_stats_draw(const rcti *rect);
 
 #endif /* __DRAW_MANAGER_PROFILING_H__ */
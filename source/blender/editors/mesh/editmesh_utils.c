@@ -1451,6 +1451,7 @@ void EDBM_update_generic(Mesh *mesh, const bool do_tessellation, const bool is_d
   }
   /* don't keep stale derivedMesh data around, see: [#38872] */
   BKE_editmesh_free_derivedmesh(em);
+  BKE_editmesh_deform_tag_reset(em);
 
 #ifdef DEBUG
   {
@@ -178,6 +178,7 @@ static int mask_flood_fill_exec(bContext *C, wmOperator *op)
   BKE_pbvh_update_vertex_data(pbvh, PBVH_UpdateMask);
 
   SCULPT_undo_push_end();
+  BKE_pbvh_grids_page_out_stale(pbvh);
 
   if (nodes) {
     MEM_freeN(nodes);
@@ -359,6 +360,7 @@ bool ED_sculpt_mask_box_select(struct bContext *C, ViewContext *vc, const rcti *
   BKE_pbvh_update_vertex_data(pbvh, PBVH_UpdateMask);
 
   SCULPT_undo_push_end();
+  BKE_pbvh_grids_page_out_stale(pbvh);
 
   ED_region_tag_redraw(region);
 
@@ -548,6 +550,7 @@ static int paint_mask_gesture_lasso_exec(bContext *C, wmOperator *op)
     BKE_pbvh_update_vertex_data(pbvh, PBVH_UpdateMask);
 
     SCULPT_undo_push_end();
+    BKE_pbvh_grids_page_out_stale(pbvh);
 
     ED_region_tag_redraw(vc.region);
     MEM_freeN((void *)mcoords);
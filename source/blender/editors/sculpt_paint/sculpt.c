@@ -131,6 +131,20 @@ int SCULPT_vertex_count_get(SculptSession *ss)
   return 0;
 }
 
+/* Element of a multires grid vertex, NULL when its grid can't be read back from the swap file.
+ * The read error is reported by the paging, sculpt operators stop running after it. */
+static CCGElem *sculpt_vertex_grid_elem_get(SculptSession *ss, int index)
+{
+  const CCGKey *key = BKE_pbvh_get_grid_key(ss->pbvh);
+  const int grid_index = index / key->grid_area;
+  const int vertex_index = index - grid_index * key->grid_area;
+  CCGElem *grid = BKE_pbvh_get_grid(ss->pbvh, grid_index);
+  if (UNLIKELY(grid == NULL)) {
+    return NULL;
+  }
+  return CCG_elem_offset(key, grid, vertex_index);
+}
+
 const float *SCULPT_vertex_co_get(SculptSession *ss, int index)
 {
   switch (BKE_pbvh_type(ss->pbvh)) {
@@ -145,10 +159,12 @@ const float *SCULPT_vertex_co_get(SculptSession *ss, int index)
       return BM_vert_at_index(BKE_pbvh_get_bmesh(ss->pbvh), index)->co;
     case PBVH_GRIDS: {
       const CCGKey *key = BKE_pbvh_get_grid_key(ss->pbvh);
-      const int grid_index = index / key->grid_area;
-      const int vertex_index = index - grid_index * key->grid_area;
-      CCGElem *elem = BKE_pbvh_get_grids(ss->pbvh)[grid_index];
-      return CCG_elem_co(key, CCG_elem_offset(key, elem, vertex_index));
+      CCGElem *elem = sculpt_vertex_grid_elem_get(ss, index);
+      if (UNLIKELY(elem == NULL)) {
+        static const float zero_co[3] = {0.0f, 0.0f, 0.0f};
+        return zero_co;
+      }
+      return CCG_elem_co(key, elem);
     }
   }
   return NULL;
@@ -187,10 +203,12 @@ void SCULPT_vertex_normal_get(SculptSession *ss, int index, float no[3])
       break;
     case PBVH_GRIDS: {
       const CCGKey *key = BKE_pbvh_get_grid_key(ss->pbvh);
-      const int grid_index = index / key->grid_area;
-      const int vertex_index = index - grid_index * key->grid_area;
-      CCGElem *elem = BKE_pbvh_get_grids(ss->pbvh)[grid_index];
-      copy_v3_v3(no, CCG_elem_no(key, CCG_elem_offset(key, elem, vertex_index)));
+      CCGElem *elem = sculpt_vertex_grid_elem_get(ss, index);
+      if (UNLIKELY(elem == NULL)) {
+        zero_v3(no);
+        break;
+      }
+      copy_v3_v3(no, CCG_elem_no(key, elem));
       break;
     }
   }
@@ -226,10 +244,11 @@ float SCULPT_vertex_mask_get(SculptSession *ss, int index)
       return *mask;
     case PBVH_GRIDS: {
       const CCGKey *key = BKE_pbvh_get_grid_key(ss->pbvh);
-      const int grid_index = index / key->grid_area;
-      const int vertex_index = index - grid_index * key->grid_area;
-      CCGElem *elem = BKE_pbvh_get_grids(ss->pbvh)[grid_index];
-      return *CCG_elem_mask(key, CCG_elem_offset(key, elem, vertex_index));
+      CCGElem *elem = sculpt_vertex_grid_elem_get(ss, index);
+      if (UNLIKELY(elem == NULL)) {
+        return 0.0f;
+      }
+      return *CCG_elem_mask(key, elem);
     }
   }
 
@@ -753,6 +772,13 @@ static void sculpt_vertex_neighbors_get_grids(SculptSession *ss,
   iter->neighbors = iter->neighbors_fixed;
 
   for (int i = 0; i < neighbors.size; i++) {
+    /* Leave out neighbors in grids which can't be read back from the swap file. */
+    if (BKE_subdiv_ccg_grid_get(ss->subdiv_ccg, neighbors.coords[i].grid_index) == NULL) {
+      if (i >= neighbors.size - neighbors.num_duplicates) {
+        iter->num_duplicates--;
+      }
+      continue;
+    }
     sculpt_vertex_neighbor_add(iter,
                                neighbors.coords[i].grid_index * key->grid_area +
                                    neighbors.coords[i].y * key->grid_size + neighbors.coords[i].x);
@@ -2952,6 +2978,59 @@ static void do_draw_brush_task_cb_ex(void *__restrict userdata,
   BKE_pbvh_vertex_iter_end;
 }
 
+static void do_draw_brush_batch_flush(SculptThreadedTaskData *data,
+                                      SculptBrushBatch *batch,
+                                      const SculptBrushTest *test,
+                                      float (*proxy)[3],
+                                      const int thread_id)
+{
+  SculptSession *ss = data->ob->sculpt;
+  const Brush *brush = data->brush;
+
+  SCULPT_brush_batch_test_sphere(batch, test, brush->falloff_shape);
+  SCULPT_brush_batch_strength_factor(ss, brush, batch, thread_id);
+
+  for (int i = 0; i < batch->len; i++) {
+    mul_v3_v3fl(proxy[batch->vd_i[i]], data->offset, batch->fade[i]);
+    if (batch->mvert[i]) {
+      batch->mvert[i]->flag |= ME_VERT_PBVH_UPDATE;
+    }
+  }
+  batch->len = 0;
+}
+
+/* Same as #do_draw_brush_task_cb_ex, for #BRUSH_USE_BATCHED_KERNELS. */
+static void do_draw_brush_batch_task_cb_ex(void *__restrict userdata,
+                                           const int n,
+                                           const TaskParallelTLS *__restrict tls)
+{
+  SculptThreadedTaskData *data = userdata;
+  SculptSession *ss = data->ob->sculpt;
+
+  PBVHVertexIter vd;
+  float(*proxy)[3];
+
+  proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
+
+  SculptBrushTest test;
+  SCULPT_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
+  const int thread_id = BLI_task_parallel_thread_id(tls);
+
+  SculptBrushBatch batch;
+  SCULPT_brush_batch_init(&batch, data->brush, true);
+
+  BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
+  {
+    SCULPT_brush_batch_add(&batch, &vd);
+    if (SCULPT_brush_batch_full(&batch)) {
+      do_draw_brush_batch_flush(data, &batch, &test, proxy, thread_id);
+    }
+  }
+  BKE_pbvh_vertex_iter_end;
+
+  do_draw_brush_batch_flush(data, &batch, &test, proxy, thread_id);
+}
+
 static void do_draw_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
 {
   SculptSession *ss = ob->sculpt;
@@ -2979,7 +3058,13 @@ static void do_draw_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
 
   TaskParallelSettings settings;
   BKE_pbvh_parallel_range_settings(&settings, true, totnode);
-  BLI_task_parallel_range(0, totnode, &data, do_draw_brush_task_cb_ex, &settings);
+  BLI_task_parallel_range(0,
+                          totnode,
+                          &data,
+                          (brush->flag2 & BRUSH_USE_BATCHED_KERNELS) ?
+                              do_draw_brush_batch_task_cb_ex :
+                              do_draw_brush_task_cb_ex,
+                          &settings);
 }
 
 static void do_draw_sharp_brush_task_cb_ex(void *__restrict userdata,
@@ -4821,6 +4906,87 @@ static void do_clay_strips_brush_task_cb_ex(void *__restrict userdata,
   BKE_pbvh_vertex_iter_end;
 }
 
+BLI_INLINE float clay_strips_batch_plane_side(const SculptBrushBatch *batch,
+                                              const float plane[4],
+                                              const int i)
+{
+  return batch->co[0][i] * plane[0] + batch->co[1][i] * plane[1] + batch->co[2][i] * plane[2] +
+         plane[3];
+}
+
+static void do_clay_strips_brush_batch_flush(SculptThreadedTaskData *data,
+                                             SculptBrushBatch *batch,
+                                             const SculptBrushTest *test,
+                                             float (*proxy)[3],
+                                             const int thread_id)
+{
+  SculptSession *ss = data->ob->sculpt;
+  const Brush *brush = data->brush;
+  const float *plane = test->plane_tool;
+  const bool flip = (ss->cache->bstrength < 0.0f);
+  const float bstrength = flip ? -ss->cache->bstrength : ss->cache->bstrength;
+  const bool use_plane_trim = (brush->flag & BRUSH_PLANE_TRIM) != 0;
+  const float plane_trim_sq = ss->cache->radius_squared * ss->cache->plane_trim_squared;
+
+  SCULPT_brush_batch_test_cube(batch, test, data->mat, brush->tip_roundness, ss->cache->radius);
+
+  /* Same as #plane_point_side_flip and #SCULPT_plane_trim, the distance to the plane is the
+   * length of the displacement. */
+  for (int i = 0; i < batch->len; i++) {
+    const float d = clay_strips_batch_plane_side(batch, plane, i);
+    batch->keep[i] = ((flip ? -d : d) <= 0.0f) && (!use_plane_trim || d * d <= plane_trim_sq);
+  }
+  SCULPT_brush_batch_compact(batch);
+
+  /* The normal from the vertices is ignored, it causes glitch with planes, see: T44390. */
+  SCULPT_brush_batch_strength_factor(ss, brush, batch, thread_id);
+
+  for (int i = 0; i < batch->len; i++) {
+    const float fade = bstrength * batch->fade[i];
+    const float d = clay_strips_batch_plane_side(batch, plane, i);
+    float val[3];
+    mul_v3_v3fl(val, plane, -d);
+    mul_v3_v3fl(proxy[batch->vd_i[i]], val, fade);
+    if (batch->mvert[i]) {
+      batch->mvert[i]->flag |= ME_VERT_PBVH_UPDATE;
+    }
+  }
+  batch->len = 0;
+}
+
+/* Same as #do_clay_strips_brush_task_cb_ex, for #BRUSH_USE_BATCHED_KERNELS. */
+static void do_clay_strips_brush_batch_task_cb_ex(void *__restrict userdata,
+                                                  const int n,
+                                                  const TaskParallelTLS *__restrict tls)
+{
+  SculptThreadedTaskData *data = userdata;
+  SculptSession *ss = data->ob->sculpt;
+
+  PBVHVertexIter vd;
+  SculptBrushTest test;
+  float(*proxy)[3];
+
+  proxy = BKE_pbvh_node_add_proxy(ss->pbvh, data->nodes[n])->co;
+
+  SCULPT_brush_test_init(ss, &test);
+  plane_from_point_normal_v3(test.plane_tool, data->area_co, data->area_no_sp);
+  const int thread_id = BLI_task_parallel_thread_id(tls);
+
+  SculptBrushBatch batch;
+  SCULPT_brush_batch_init(&batch, data->brush, true);
+
+  BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
+  {
+    SCULPT_brush_batch_add(&batch, &vd);
+    if (SCULPT_brush_batch_full(&batch)) {
+      do_clay_strips_brush_batch_flush(data, &batch, &test, proxy, thread_id);
+    }
+  }
+  BKE_pbvh_vertex_iter_end;
+
+  do_clay_strips_brush_batch_flush(data, &batch, &test, proxy, thread_id);
+}
+
 static void do_clay_strips_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int totnode)
 {
   SculptSession *ss = ob->sculpt;
@@ -4910,7 +5076,13 @@ static void do_clay_strips_brush(Sculpt *sd, Object *ob, PBVHNode **nodes, int t
 
   TaskParallelSettings settings;
   BKE_pbvh_parallel_range_settings(&settings, true, totnode);
-  BLI_task_parallel_range(0, totnode, &data, do_clay_strips_brush_task_cb_ex, &settings);
+  BLI_task_parallel_range(0,
+                          totnode,
+                          &data,
+                          (brush->flag2 & BRUSH_USE_BATCHED_KERNELS) ?
+                              do_clay_strips_brush_batch_task_cb_ex :
+                              do_clay_strips_brush_task_cb_ex,
+                          &settings);
 }
 
 static void do_fill_brush_task_cb_ex(void *__restrict userdata,
@@ -6150,7 +6322,17 @@ static void sculpt_update_tex(const Scene *scene, Sculpt *sd, SculptSession *ss)
 bool SCULPT_mode_poll(bContext *C)
 {
   Object *ob = CTX_data_active_object(C);
-  return ob && ob->mode & OB_MODE_SCULPT;
+  if (!(ob && ob->mode & OB_MODE_SCULPT)) {
+    return false;
+  }
+  SculptSession *ss = ob->sculpt;
+  if (ss && ss->subdiv_ccg && BKE_subdiv_ccg_paging_has_error(ss->subdiv_ccg)) {
+    CTX_wm_operator_poll_msg_set(C,
+                                 "Multires grids could not be read back from the swap file, "
+                                 "exit and re-enter Sculpt Mode to reload them");
+    return false;
+  }
+  return true;
 }
 
 bool SCULPT_vertex_colors_poll(bContext *C)
@@ -7370,6 +7552,9 @@ void SCULPT_flush_update_done(const bContext *C, Object *ob, SculptUpdateType up
   if (need_tag) {
     DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
   }
+
+  /* Multires grids of the parts which weren't sculpted recently go to the swap file. */
+  BKE_pbvh_grids_page_out_stale(ss->pbvh);
 }
 
 /* Returns whether the mouse/stylus is over the mesh (1)
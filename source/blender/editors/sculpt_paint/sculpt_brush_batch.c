@@ -0,0 +1,432 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup edsculpt
+ *
+ * Batched brush kernels. The vertices of a node are gathered in blocks with every coordinate
+ * component in its own array, so the brush test and falloff are computed four vertices at a
+ * time with SSE. Texture sampling, custom falloff curves and topology automasking stay per
+ * vertex.
+ */
+
+#include "BLI_math.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_brush_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_brush.h"
+#include "BKE_colortools.h"
+#include "BKE_context.h"
+#include "BKE_paint.h"
+#include "BKE_pbvh.h"
+
+#include "ED_view3d.h"
+#include "paint_intern.h"
+#include "sculpt_intern.h"
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+BLI_STATIC_ASSERT((SCULPT_BRUSH_BATCH_SIZE % 4) == 0, "Batch size must be a multiple of 4")
+
+void SCULPT_brush_batch_init(SculptBrushBatch *batch, const Brush *brush, const bool use_mask)
+{
+  batch->len = 0;
+  batch->use_mask = use_mask;
+  batch->use_normals = (brush->flag & BRUSH_FRONTFACE) != 0;
+}
+
+void SCULPT_brush_batch_add(SculptBrushBatch *batch, const PBVHVertexIter *vd)
+{
+  BLI_assert(batch->len < SCULPT_BRUSH_BATCH_SIZE);
+  const int i = batch->len++;
+
+  batch->vd_i[i] = vd->i;
+  batch->index[i] = vd->index;
+  batch->mvert[i] = vd->mvert;
+  batch->co_ptr[i] = vd->co;
+  batch->mask_ptr[i] = vd->mask;
+
+  batch->co[0][i] = vd->co[0];
+  batch->co[1][i] = vd->co[1];
+  batch->co[2][i] = vd->co[2];
+  batch->mask[i] = (batch->use_mask && vd->mask) ? *vd->mask : 0.0f;
+
+  if (batch->use_normals) {
+    float no[3];
+    if (vd->no) {
+      normal_short_to_float_v3(no, vd->no);
+    }
+    else {
+      copy_v3_v3(no, vd->fno);
+    }
+    batch->no[0][i] = no[0];
+    batch->no[1][i] = no[1];
+    batch->no[2][i] = no[2];
+  }
+}
+
+/* Fill the arrays up to a multiple of four, so the last SIMD group reads defined values. */
+static void brush_batch_pad(SculptBrushBatch *batch)
+{
+  const int len_padded = (batch->len + 3) & ~3;
+  for (int i = batch->len; i < len_padded; i++) {
+    batch->co[0][i] = batch->co[1][i] = batch->co[2][i] = 0.0f;
+    batch->no[0][i] = batch->no[1][i] = batch->no[2][i] = 0.0f;
+    batch->mask[i] = 0.0f;
+    batch->dist[i] = 0.0f;
+  }
+}
+
+void SCULPT_brush_batch_compact(SculptBrushBatch *batch)
+{
+  int len = 0;
+  for (int i = 0; i < batch->len; i++) {
+    if (!batch->keep[i]) {
+      continue;
+    }
+    if (len != i) {
+      batch->vd_i[len] = batch->vd_i[i];
+      batch->index[len] = batch->index[i];
+      batch->mvert[len] = batch->mvert[i];
+      batch->co_ptr[len] = batch->co_ptr[i];
+      batch->mask_ptr[len] = batch->mask_ptr[i];
+      for (int k = 0; k < 3; k++) {
+        batch->co[k][len] = batch->co[k][i];
+        batch->no[k][len] = batch->no[k][i];
+      }
+      batch->mask[len] = batch->mask[i];
+      batch->dist[len] = batch->dist[i];
+    }
+    len++;
+  }
+  batch->len = len;
+  brush_batch_pad(batch);
+}
+
+/* Same as the clipping done by the scalar brush tests. */
+static void brush_batch_clip(SculptBrushBatch *batch, const SculptBrushTest *test)
+{
+  if (test->clip_rv3d == NULL) {
+    return;
+  }
+  for (int i = 0; i < batch->len; i++) {
+    if (batch->keep[i]) {
+      const float co[3] = {batch->co[0][i], batch->co[1][i], batch->co[2][i]};
+      float symm_co[3];
+      flip_v3_v3(symm_co, co, test->mirror_symmetry_pass);
+      if (ED_view3d_clipping_test(test->clip_rv3d, symm_co, true)) {
+        batch->keep[i] = false;
+      }
+    }
+  }
+}
+
+#ifdef __SSE2__
+static void brush_batch_keep_set(SculptBrushBatch *batch, const int i, const __m128 keep)
+{
+  const int bits = _mm_movemask_ps(keep);
+  batch->keep[i + 0] = (bits & 1) != 0;
+  batch->keep[i + 1] = (bits & 2) != 0;
+  batch->keep[i + 2] = (bits & 4) != 0;
+  batch->keep[i + 3] = (bits & 8) != 0;
+}
+
+BLI_INLINE __m128 brush_batch_select(const __m128 mask, const __m128 a, const __m128 b)
+{
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+#endif
+
+void SCULPT_brush_batch_test_sphere(SculptBrushBatch *batch,
+                                    const SculptBrushTest *test,
+                                    const char falloff_shape)
+{
+  const bool use_circle = (falloff_shape != PAINT_FALLOFF_SHAPE_SPHERE);
+  const float *plane = test->plane_view;
+  const float *location = test->location;
+  brush_batch_pad(batch);
+
+#ifdef __SSE2__
+  const __m128 radius_squared = _mm_set1_ps(test->radius_squared);
+  for (int i = 0; i < batch->len; i += 4) {
+    __m128 x = _mm_loadu_ps(&batch->co[0][i]);
+    __m128 y = _mm_loadu_ps(&batch->co[1][i]);
+    __m128 z = _mm_loadu_ps(&batch->co[2][i]);
+    if (use_circle) {
+      /* Project on the view plane. */
+      const __m128 nx = _mm_set1_ps(plane[0]), ny = _mm_set1_ps(plane[1]);
+      const __m128 nz = _mm_set1_ps(plane[2]);
+      const __m128 d = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(x, nx), _mm_mul_ps(y, ny)),
+          _mm_add_ps(_mm_mul_ps(z, nz), _mm_set1_ps(plane[3])));
+      x = _mm_sub_ps(x, _mm_mul_ps(d, nx));
+      y = _mm_sub_ps(y, _mm_mul_ps(d, ny));
+      z = _mm_sub_ps(z, _mm_mul_ps(d, nz));
+    }
+    const __m128 dx = _mm_sub_ps(x, _mm_set1_ps(location[0]));
+    const __m128 dy = _mm_sub_ps(y, _mm_set1_ps(location[1]));
+    const __m128 dz = _mm_sub_ps(z, _mm_set1_ps(location[2]));
+    const __m128 dist_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                      _mm_mul_ps(dz, dz));
+    brush_batch_keep_set(batch, i, _mm_cmple_ps(dist_sq, radius_squared));
+    _mm_storeu_ps(&batch->dist[i], _mm_sqrt_ps(dist_sq));
+  }
+#else
+  for (int i = 0; i < batch->len; i++) {
+    float co[3] = {batch->co[0][i], batch->co[1][i], batch->co[2][i]};
+    if (use_circle) {
+      closest_to_plane_normalized_v3(co, plane, co);
+    }
+    const float dist_sq = len_squared_v3v3(co, location);
+    batch->keep[i] = dist_sq <= test->radius_squared;
+    batch->dist[i] = sqrtf(dist_sq);
+  }
+#endif
+
+  brush_batch_clip(batch, test);
+  SCULPT_brush_batch_compact(batch);
+}
+
+void SCULPT_brush_batch_test_cube(SculptBrushBatch *batch,
+                                  const SculptBrushTest *test,
+                                  const float local[4][4],
+                                  const float roundness,
+                                  const float radius)
+{
+  /* Keep the square and circular brush tips the same size. */
+  const float side = (float)M_SQRT1_2 + (1.0f - (float)M_SQRT1_2) * roundness;
+  const float constant_side = (1.0f - roundness) * side;
+  const float falloff_side = roundness * side;
+  brush_batch_pad(batch);
+
+#ifdef __SSE2__
+  const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+  const __m128 side_v = _mm_set1_ps(side);
+  const __m128 constant_side_v = _mm_set1_ps(constant_side);
+  const __m128 dist_fac = _mm_set1_ps(radius / falloff_side);
+  for (int i = 0; i < batch->len; i += 4) {
+    const __m128 x = _mm_loadu_ps(&batch->co[0][i]);
+    const __m128 y = _mm_loadu_ps(&batch->co[1][i]);
+    const __m128 z = _mm_loadu_ps(&batch->co[2][i]);
+    __m128 local_co[3];
+    for (int k = 0; k < 3; k++) {
+      local_co[k] = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(local[0][k])),
+                     _mm_mul_ps(y, _mm_set1_ps(local[1][k]))),
+          _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(local[2][k])), _mm_set1_ps(local[3][k])));
+      local_co[k] = _mm_and_ps(local_co[k], abs_mask);
+    }
+    const __m128 inside = _mm_and_ps(
+        _mm_and_ps(_mm_cmple_ps(local_co[0], side_v), _mm_cmple_ps(local_co[1], side_v)),
+        _mm_cmple_ps(local_co[2], side_v));
+
+    const __m128 min_xy = _mm_min_ps(local_co[0], local_co[1]);
+    const __m128 max_xy = _mm_max_ps(local_co[0], local_co[1]);
+    /* Corner, distance to the center of the corner circle. */
+    const __m128 cx = _mm_sub_ps(local_co[0], constant_side_v);
+    const __m128 cy = _mm_sub_ps(local_co[1], constant_side_v);
+    const __m128 dist_corner = _mm_mul_ps(
+        _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy))), dist_fac);
+    /* Side, distance to the square XY axis. */
+    const __m128 dist_side = _mm_mul_ps(_mm_sub_ps(max_xy, constant_side_v), dist_fac);
+    /* Inside the square, constant distance. The corner and side distances are scaled before
+     * they are selected: a square tip has no falloff part, there they are not finite. */
+    __m128 dist = brush_batch_select(
+        _mm_cmpgt_ps(max_xy, constant_side_v), dist_side, _mm_setzero_ps());
+    dist = brush_batch_select(_mm_cmpgt_ps(min_xy, constant_side_v), dist_corner, dist);
+
+    brush_batch_keep_set(batch, i, inside);
+    _mm_storeu_ps(&batch->dist[i], dist);
+  }
+#else
+  for (int i = 0; i < batch->len; i++) {
+    const float co[3] = {batch->co[0][i], batch->co[1][i], batch->co[2][i]};
+    float local_co[3];
+    mul_v3_m4v3(local_co, local, co);
+    abs_v3(local_co);
+    batch->keep[i] = local_co[0] <= side && local_co[1] <= side && local_co[2] <= side;
+    if (min_ff(local_co[0], local_co[1]) > constant_side) {
+      const float dx = local_co[0] - constant_side, dy = local_co[1] - constant_side;
+      batch->dist[i] = sqrtf(dx * dx + dy * dy) / falloff_side * radius;
+    }
+    else if (max_ff(local_co[0], local_co[1]) > constant_side) {
+      batch->dist[i] = (max_ff(local_co[0], local_co[1]) - constant_side) / falloff_side *
+                       radius;
+    }
+    else {
+      batch->dist[i] = 0.0f;
+    }
+  }
+#endif
+
+  brush_batch_clip(batch, test);
+  SCULPT_brush_batch_compact(batch);
+}
+
+/* Brush falloff curve presets, see #BKE_brush_curve_strength. */
+#ifdef __SSE2__
+static __m128 brush_batch_curve_strength(const Brush *br, const __m128 p)
+{
+  const __m128 one = _mm_set1_ps(1.0f);
+  switch (br->curve_preset) {
+    case BRUSH_CURVE_SHARP:
+      return _mm_mul_ps(p, p);
+    case BRUSH_CURVE_SMOOTH:
+      return _mm_mul_ps(_mm_mul_ps(p, p), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_add_ps(p, p)));
+    case BRUSH_CURVE_SMOOTHER: {
+      const __m128 p3 = _mm_mul_ps(_mm_mul_ps(p, p), p);
+      const __m128 poly = _mm_add_ps(
+          _mm_mul_ps(p, _mm_sub_ps(_mm_mul_ps(p, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))),
+          _mm_set1_ps(10.0f));
+      return _mm_mul_ps(p3, poly);
+    }
+    case BRUSH_CURVE_ROOT:
+      return _mm_sqrt_ps(p);
+    case BRUSH_CURVE_LIN:
+      return p;
+    case BRUSH_CURVE_SPHERE:
+      return _mm_sqrt_ps(_mm_sub_ps(_mm_add_ps(p, p), _mm_mul_ps(p, p)));
+    case BRUSH_CURVE_POW4: {
+      const __m128 p2 = _mm_mul_ps(p, p);
+      return _mm_mul_ps(p2, p2);
+    }
+    case BRUSH_CURVE_INVSQUARE:
+      return _mm_mul_ps(p, _mm_sub_ps(_mm_set1_ps(2.0f), p));
+    case BRUSH_CURVE_CONSTANT:
+    default:
+      return one;
+  }
+}
+#endif
+
+/* Falloff of the brush test distance, with hardness. Same as the scalar version in
+ * #SCULPT_brush_strength_factor. */
+static void brush_batch_falloff(const SculptSession *ss, const Brush *br, SculptBrushBatch *batch)
+{
+  const StrokeCache *cache = ss->cache;
+  const float hardness = cache->paint_brush.hardness;
+  const bool use_custom_curve = (br->curve_preset == BRUSH_CURVE_CUSTOM);
+
+#ifdef __SSE2__
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 radius_inv = _mm_set1_ps(1.0f / cache->radius);
+  const __m128 hardness_v = _mm_set1_ps(hardness);
+  const __m128 hardness_fac = _mm_set1_ps(hardness < 1.0f ? 1.0f / (1.0f - hardness) : 0.0f);
+  for (int i = 0; i < batch->len; i += 4) {
+    const __m128 p = _mm_mul_ps(_mm_loadu_ps(&batch->dist[i]), radius_inv);
+    /* Distance remapped by hardness, as a factor of the radius. */
+    __m128 len = (hardness < 1.0f) ? _mm_mul_ps(_mm_sub_ps(p, hardness_v), hardness_fac) : one;
+    len = brush_batch_select(_mm_cmplt_ps(p, hardness_v), zero, len);
+    const __m128 in_radius = _mm_cmplt_ps(len, one);
+
+    __m128 fade;
+    if (use_custom_curve) {
+      float len_f[4], fade_f[4];
+      _mm_storeu_ps(len_f, len);
+      for (int k = 0; k < 4; k++) {
+        fade_f[k] = (len_f[k] < 1.0f) ? BKE_curvemapping_evaluateF(br->curve, 0, len_f[k]) :
+                                         0.0f;
+      }
+      fade = _mm_loadu_ps(fade_f);
+    }
+    else {
+      fade = brush_batch_curve_strength(br, _mm_sub_ps(one, len));
+    }
+    fade = _mm_and_ps(in_radius, fade);
+
+    /* Paint mask. */
+    fade = _mm_mul_ps(fade, _mm_sub_ps(one, _mm_loadu_ps(&batch->mask[i])));
+
+    /* Front face. */
+    if (batch->use_normals && (br->flag & BRUSH_FRONTFACE)) {
+      const float *view_normal = cache->view_normal;
+      const __m128 dot = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&batch->no[0][i]), _mm_set1_ps(view_normal[0])),
+                     _mm_mul_ps(_mm_loadu_ps(&batch->no[1][i]), _mm_set1_ps(view_normal[1]))),
+          _mm_mul_ps(_mm_loadu_ps(&batch->no[2][i]), _mm_set1_ps(view_normal[2])));
+      fade = _mm_mul_ps(fade, _mm_max_ps(dot, zero));
+    }
+
+    _mm_storeu_ps(&batch->fade[i], fade);
+  }
+#else
+  for (int i = 0; i < batch->len; i++) {
+    const float p = batch->dist[i] / cache->radius;
+    float len;
+    if (p < hardness) {
+      len = 0.0f;
+    }
+    else if (hardness == 1.0f) {
+      len = 1.0f;
+    }
+    else {
+      len = (p - hardness) / (1.0f - hardness);
+    }
+    float fade = BKE_brush_curve_strength(br, len, 1.0f);
+    fade *= 1.0f - batch->mask[i];
+    if (batch->use_normals && (br->flag & BRUSH_FRONTFACE)) {
+      const float no[3] = {batch->no[0][i], batch->no[1][i], batch->no[2][i]};
+      fade *= max_ff(dot_v3v3(no, cache->view_normal), 0.0f);
+    }
+    batch->fade[i] = fade;
+  }
+  UNUSED_VARS(use_custom_curve);
+#endif
+}
+
+void SCULPT_brush_batch_strength_factor(SculptSession *ss,
+                                        const Brush *br,
+                                        SculptBrushBatch *batch,
+                                        const int thread_id)
+{
+  if (br->mtex.tex) {
+    /* Textures are sampled per vertex, use the scalar version for everything. */
+    for (int i = 0; i < batch->len; i++) {
+      const float co[3] = {batch->co[0][i], batch->co[1][i], batch->co[2][i]};
+      const float no[3] = {batch->no[0][i], batch->no[1][i], batch->no[2][i]};
+      batch->fade[i] = SCULPT_brush_strength_factor(ss,
+                                                    br,
+                                                    co,
+                                                    batch->dist[i],
+                                                    NULL,
+                                                    batch->use_normals ? no : NULL,
+                                                    batch->mask[i],
+                                                    batch->index[i],
+                                                    thread_id);
+    }
+    return;
+  }
+
+  brush_batch_falloff(ss, br, batch);
+
+  /* Auto-masking. */
+  if (ss->cache->automask_factor || ss->cache->automask_settings.flags) {
+    for (int i = 0; i < batch->len; i++) {
+      batch->fade[i] *= SCULPT_automasking_factor_get(ss, batch->index[i]);
+    }
+  }
+}
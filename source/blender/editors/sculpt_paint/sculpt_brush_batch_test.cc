@@ -0,0 +1,128 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math.h"
+
+#include "DNA_brush_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_paint.h"
+
+#include "ED_view3d.h"
+
+extern "C" {
+#include "sculpt_intern.h"
+}
+
+namespace blender::ed::sculpt_paint::tests {
+
+/* Fade of the batched cube test and strength of a grid of points around a brush tip, compared to
+ * the per vertex #SCULPT_brush_test_cube and #SCULPT_brush_strength_factor, the way the Clay
+ * Strips brush uses them. */
+static void brush_batch_test_cube_compare(const float roundness)
+{
+  const float radius = 0.5f;
+  const int grid_size = 24;
+  const int points_len = grid_size * grid_size * 2;
+
+  Brush brush = {};
+  brush.curve_preset = BRUSH_CURVE_SMOOTH;
+
+  ViewContext vc = {};
+  StrokeCache cache = {};
+  cache.vc = &vc;
+  cache.radius = radius;
+  SculptSession ss = {};
+  ss.cache = &cache;
+
+  SculptBrushTest test = {};
+  test.radius = radius;
+  test.radius_squared = radius * radius;
+
+  float local[4][4];
+  scale_m4_fl(local, 1.0f / radius);
+
+  float(*points)[3] = (float(*)[3])MEM_malloc_arrayN(points_len, sizeof(*points), __func__);
+  for (int z = 0, i = 0; z < 2; z++) {
+    for (int y = 0; y < grid_size; y++) {
+      for (int x = 0; x < grid_size; x++, i++) {
+        points[i][0] = (2.4f * x / (grid_size - 1) - 1.2f) * radius;
+        points[i][1] = (2.4f * y / (grid_size - 1) - 1.2f) * radius;
+        points[i][2] = 0.3f * z * radius;
+      }
+    }
+  }
+
+  int fade_full = 0;
+  for (int start = 0; start < points_len; start += SCULPT_BRUSH_BATCH_SIZE) {
+    const int end = min_ii(start + SCULPT_BRUSH_BATCH_SIZE, points_len);
+
+    SculptBrushBatch batch;
+    SCULPT_brush_batch_init(&batch, &brush, false);
+    for (int p = start; p < end; p++) {
+      const int i = batch.len++;
+      batch.index[i] = p;
+      for (int k = 0; k < 3; k++) {
+        batch.co[k][i] = points[p][k];
+      }
+      batch.mask[i] = 0.0f;
+    }
+    SCULPT_brush_batch_test_cube(&batch, &test, local, roundness, radius);
+    SCULPT_brush_batch_strength_factor(&ss, &brush, &batch, 0);
+
+    int batch_i = 0;
+    for (int p = start; p < end; p++) {
+      if (!SCULPT_brush_test_cube(&test, points[p], local, roundness)) {
+        continue;
+      }
+      const float fade = SCULPT_brush_strength_factor(
+          &ss, &brush, points[p], radius * test.dist, NULL, NULL, 0.0f, p, 0);
+
+      /* Compaction keeps the order of the vertices. */
+      ASSERT_LT(batch_i, batch.len);
+      EXPECT_EQ(batch.index[batch_i], p);
+      EXPECT_NEAR(batch.fade[batch_i], fade, 1e-5f);
+      if (fade == 1.0f) {
+        fade_full++;
+      }
+      batch_i++;
+    }
+    EXPECT_EQ(batch_i, batch.len);
+  }
+
+  /* Every tip has a part in the middle at full strength. */
+  EXPECT_GT(fade_full, 0);
+
+  MEM_freeN(points);
+}
+
+TEST(sculpt_brush_batch, TestCubeSquareTip)
+{
+  brush_batch_test_cube_compare(0.0f);
+}
+
+TEST(sculpt_brush_batch, TestCubeRoundTip)
+{
+  brush_batch_test_cube_compare(1.0f);
+}
+
+}  // namespace blender::ed::sculpt_paint::tests
@@ -533,6 +533,12 @@ typedef struct SculptUndoNode {
   /* Sculpt Face Sets */
   int *face_sets;
 
+  /* Compressed difference of co, mask or col with the values in the mesh once the step is
+   * pushed, the array is NULL while this is set. */
+  void *delta;
+  size_t delta_size;
+  uint delta_hash;
+
   size_t undo_size;
 } SculptUndoNode;
 
@@ -721,6 +727,56 @@ float SCULPT_brush_strength_factor(struct SculptSession *ss,
                                    const int vertex_index,
                                    const int thread_id);
 
+/* Batched brush kernels, see #BRUSH_USE_BATCHED_KERNELS. */
+#define SCULPT_BRUSH_BATCH_SIZE 256
+
+typedef struct SculptBrushBatch {
+  int len;
+  bool use_mask;
+  bool use_normals;
+
+  /* Gathered from #PBVHVertexIter, to scatter the results back. */
+  int vd_i[SCULPT_BRUSH_BATCH_SIZE];
+  int index[SCULPT_BRUSH_BATCH_SIZE];
+  struct MVert *mvert[SCULPT_BRUSH_BATCH_SIZE];
+  float *co_ptr[SCULPT_BRUSH_BATCH_SIZE];
+  float *mask_ptr[SCULPT_BRUSH_BATCH_SIZE];
+
+  /* One array per component. */
+  float co[3][SCULPT_BRUSH_BATCH_SIZE];
+  float no[3][SCULPT_BRUSH_BATCH_SIZE];
+  float mask[SCULPT_BRUSH_BATCH_SIZE];
+
+  /* Results of the brush test and strength. */
+  float dist[SCULPT_BRUSH_BATCH_SIZE];
+  float fade[SCULPT_BRUSH_BATCH_SIZE];
+  char keep[SCULPT_BRUSH_BATCH_SIZE];
+} SculptBrushBatch;
+
+void SCULPT_brush_batch_init(SculptBrushBatch *batch,
+                             const struct Brush *brush,
+                             const bool use_mask);
+void SCULPT_brush_batch_add(SculptBrushBatch *batch, const PBVHVertexIter *vd);
+/* Remove the vertices which didn't pass the test. */
+void SCULPT_brush_batch_compact(SculptBrushBatch *batch);
+void SCULPT_brush_batch_test_sphere(SculptBrushBatch *batch,
+                                    const SculptBrushTest *test,
+                                    const char falloff_shape);
+void SCULPT_brush_batch_test_cube(SculptBrushBatch *batch,
+                                  const SculptBrushTest *test,
+                                  const float local[4][4],
+                                  const float roundness,
+                                  const float radius);
+void SCULPT_brush_batch_strength_factor(struct SculptSession *ss,
+                                        const struct Brush *br,
+                                        SculptBrushBatch *batch,
+                                        const int thread_id);
+
+BLI_INLINE bool SCULPT_brush_batch_full(const SculptBrushBatch *batch)
+{
+  return batch->len == SCULPT_BRUSH_BATCH_SIZE;
+}
+
 /* just for vertex paint. */
 bool SCULPT_pbvh_calc_area_normal(const struct Brush *brush,
                                   Object *ob,
@@ -250,6 +250,77 @@ static void do_smooth_brush_task_cb_ex(void *__restrict userdata,
   BKE_pbvh_vertex_iter_end;
 }
 
+static void do_smooth_brush_batch_flush(SculptThreadedTaskData *data,
+                                        SculptBrushBatch *batch,
+                                        const SculptBrushTest *test,
+                                        const float bstrength,
+                                        const int thread_id)
+{
+  SculptSession *ss = data->ob->sculpt;
+  Sculpt *sd = data->sd;
+  const Brush *brush = data->brush;
+
+  SCULPT_brush_batch_test_sphere(batch, test, brush->falloff_shape);
+  SCULPT_brush_batch_strength_factor(ss, brush, batch, thread_id);
+
+  for (int i = 0; i < batch->len; i++) {
+    const float fade = bstrength * batch->fade[i];
+    if (data->smooth_mask) {
+      float *mask = batch->mask_ptr[i];
+      float val = SCULPT_neighbor_mask_average(ss, batch->index[i]) - *mask;
+      val *= fade * bstrength;
+      *mask += val;
+      CLAMP(*mask, 0.0f, 1.0f);
+    }
+    else {
+      float *co = batch->co_ptr[i];
+      float avg[3], val[3];
+      SCULPT_neighbor_coords_average(ss, avg, batch->index[i]);
+      sub_v3_v3v3(val, avg, co);
+      madd_v3_v3v3fl(val, co, val, fade);
+      SCULPT_clip(sd, ss, co, val);
+    }
+    if (batch->mvert[i]) {
+      batch->mvert[i]->flag |= ME_VERT_PBVH_UPDATE;
+    }
+  }
+  batch->len = 0;
+}
+
+/* Same as #do_smooth_brush_task_cb_ex, for #BRUSH_USE_BATCHED_KERNELS. Only the brush test and
+ * strength are batched, the neighbor average is still computed per vertex. */
+static void do_smooth_brush_batch_task_cb_ex(void *__restrict userdata,
+                                             const int n,
+                                             const TaskParallelTLS *__restrict tls)
+{
+  SculptThreadedTaskData *data = userdata;
+  SculptSession *ss = data->ob->sculpt;
+  float bstrength = data->strength;
+
+  PBVHVertexIter vd;
+
+  CLAMP(bstrength, 0.0f, 1.0f);
+
+  SculptBrushTest test;
+  SCULPT_brush_test_init_with_falloff_shape(ss, &test, data->brush->falloff_shape);
+
+  const int thread_id = BLI_task_parallel_thread_id(tls);
+
+  SculptBrushBatch batch;
+  SCULPT_brush_batch_init(&batch, data->brush, !data->smooth_mask);
+
+  BKE_pbvh_vertex_iter_begin(ss->pbvh, data->nodes[n], vd, PBVH_ITER_UNIQUE)
+  {
+    SCULPT_brush_batch_add(&batch, &vd);
+    if (SCULPT_brush_batch_full(&batch)) {
+      do_smooth_brush_batch_flush(data, &batch, &test, bstrength, thread_id);
+    }
+  }
+  BKE_pbvh_vertex_iter_end;
+
+  do_smooth_brush_batch_flush(data, &batch, &test, bstrength, thread_id);
+}
+
 void SCULPT_smooth(Sculpt *sd,
                    Object *ob,
                    PBVHNode **nodes,
@@ -293,7 +364,13 @@ void SCULPT_smooth(Sculpt *sd,
 
     TaskParallelSettings settings;
     BKE_pbvh_parallel_range_settings(&settings, true, totnode);
-    BLI_task_parallel_range(0, totnode, &data, do_smooth_brush_task_cb_ex, &settings);
+    BLI_task_parallel_range(0,
+                            totnode,
+                            &data,
+                            (brush->flag2 & BRUSH_USE_BATCHED_KERNELS) ?
+                                do_smooth_brush_batch_task_cb_ex :
+                                do_smooth_brush_task_cb_ex,
+                            &settings);
   }
 }
 
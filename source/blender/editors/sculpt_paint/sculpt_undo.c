@@ -27,6 +27,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_ghash.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_string.h"
@@ -45,6 +46,7 @@
 #include "BKE_customdata.h"
 #include "BKE_global.h"
 #include "BKE_key.h"
+#include "BKE_lib_id.h"
 #include "BKE_main.h"
 #include "BKE_mesh.h"
 #include "BKE_multires.h"
@@ -70,6 +72,19 @@
 #include "bmesh.h"
 #include "sculpt_intern.h"
 
+#include "CLG_log.h"
+
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#  define LZO_OUT_LEN(size) ((size) + (size) / 16 + 64 + 3)
+#endif
+
+static CLG_LogRef LOG = {"ed.undo.sculpt"};
+
 /* Implementation of undo system for objects in sculpt mode.
  *
  * Each undo step in sculpt mode consists of list of nodes, each node contains:
@@ -87,7 +102,8 @@
  * redo is possible after undo.
  *
  * The COORDS, HIDDEN or MASK type of nodes contains arrays of the corresponding
- * values.
+ * values. Once the step is pushed, coordinates, masks and colors are kept compressed
+ * as their difference with the mesh, see "Compressed Undo Nodes".
  *
  * Operations like Symmetrize are using GEOMETRY type of nodes which pushes the
  * entire state of the mesh to the undo stack. This node contains all CustomData
@@ -270,18 +286,22 @@ static bool sculpt_undo_restore_coords(bContext *C, Depsgraph *depsgraph, Sculpt
   }
   else if (unode->maxgrid && subdiv_ccg != NULL) {
     /* Multires restore. */
-    CCGElem **grids, *grid;
+    CCGElem *grid;
     CCGKey key;
     float(*co)[3];
     int gridsize;
 
-    grids = subdiv_ccg->grids;
     gridsize = subdiv_ccg->grid_size;
     BKE_subdiv_ccg_key_top_level(&key, subdiv_ccg);
 
     co = unode->co;
     for (int j = 0; j < unode->totgrid; j++) {
-      grid = grids[unode->grids[j]];
+      grid = BKE_subdiv_ccg_grid_get(subdiv_ccg, unode->grids[j]);
+      if (grid == NULL) {
+        /* Can't be read back from the swap file, leave it as it is. */
+        co += gridsize * gridsize;
+        continue;
+      }
 
       for (int i = 0; i < gridsize * gridsize; i++, co++) {
         swap_v3_v3(CCG_elem_offset_co(&key, grid, i), co[0]);
@@ -371,18 +391,21 @@ static bool sculpt_undo_restore_mask(bContext *C, SculptUndoNode *unode)
   }
   else if (unode->maxgrid && subdiv_ccg != NULL) {
     /* Multires restore. */
-    CCGElem **grids, *grid;
+    CCGElem *grid;
     CCGKey key;
     float *mask;
     int gridsize;
 
-    grids = subdiv_ccg->grids;
     gridsize = subdiv_ccg->grid_size;
     BKE_subdiv_ccg_key_top_level(&key, subdiv_ccg);
 
     mask = unode->mask;
     for (int j = 0; j < unode->totgrid; j++) {
-      grid = grids[unode->grids[j]];
+      grid = BKE_subdiv_ccg_grid_get(subdiv_ccg, unode->grids[j]);
+      if (grid == NULL) {
+        mask += gridsize * gridsize;
+        continue;
+      }
 
       for (int i = 0; i < gridsize * gridsize; i++, mask++) {
         SWAP(float, *CCG_elem_offset_mask(&key, grid, i), *mask);
@@ -612,6 +635,304 @@ static int sculpt_undo_bmesh_restore(bContext *C,
   return false;
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Compressed Undo Nodes
+ *
+ * Once the step is pushed, the coordinates, masks and colors of the nodes are stored as their
+ * difference (XOR of the bits) with the values currently in the mesh, which is the state this
+ * step is undone from. Vertices the stroke didn't affect become zero, and the bytes of the
+ * differences are split in planes so the mostly equal sign and exponent bytes compress well.
+ * The nodes are compressed with LZO, when Blender is built with it.
+ *
+ * Undo and redo exchange the values of the node and the mesh, so the node is expanded for the
+ * restore and compressed again against the new state of the mesh afterwards.
+ * \{ */
+
+#ifdef WITH_LZO
+
+static int sculpt_undo_node_values_per_vert(const SculptUndoNode *unode)
+{
+  switch (unode->type) {
+    case SCULPT_UNDO_COORDS:
+      return 3;
+    case SCULPT_UNDO_MASK:
+      return 1;
+    case SCULPT_UNDO_COLOR:
+      return 4;
+    default:
+      BLI_assert(0);
+      return 0;
+  }
+}
+
+static unsigned char *sculpt_undo_node_values(const SculptUndoNode *unode)
+{
+  switch (unode->type) {
+    case SCULPT_UNDO_COORDS:
+      return (unsigned char *)unode->co;
+    case SCULPT_UNDO_MASK:
+      return (unsigned char *)unode->mask;
+    case SCULPT_UNDO_COLOR:
+      return (unsigned char *)unode->col;
+    default:
+      return NULL;
+  }
+}
+
+static void sculpt_undo_node_values_set(SculptUndoNode *unode, void *values)
+{
+  switch (unode->type) {
+    case SCULPT_UNDO_COORDS:
+      unode->co = values;
+      break;
+    case SCULPT_UNDO_MASK:
+      unode->mask = values;
+      break;
+    case SCULPT_UNDO_COLOR:
+      unode->col = values;
+      break;
+    default:
+      BLI_assert(0);
+      break;
+  }
+}
+
+static bool sculpt_undo_node_is_compressible(const SculptUndoNode *unode)
+{
+  switch (unode->type) {
+    case SCULPT_UNDO_COORDS:
+      /* Deformed and shape key coordinates are restored from other arrays. */
+      return unode->co && !unode->orig_co && unode->shapeName[0] == '\0';
+    case SCULPT_UNDO_MASK:
+      return unode->mask != NULL;
+    case SCULPT_UNDO_COLOR:
+      return unode->col && unode->maxvert;
+    default:
+      return false;
+  }
+}
+
+/* Copy the values of the node's vertices which are currently in the mesh, in the layout of the
+ * node. Returns false when the mesh doesn't match the node anymore.
+ *
+ * Multires grids are evaluated again when entering sculpt mode, so they can't be relied on to
+ * be exactly the same when the step is restored later. Their values are compressed as they are,
+ * against zero. */
+static bool sculpt_undo_node_gather(SculptSession *ss,
+                                    const SculptUndoNode *unode,
+                                    float *r_values)
+{
+  const int *index = unode->index;
+
+  if (unode->maxvert == 0) {
+    memset(r_values,
+           0,
+           sizeof(float) * (size_t)unode->totvert * sculpt_undo_node_values_per_vert(unode));
+    return true;
+  }
+  if (ss->totvert != unode->maxvert) {
+    return false;
+  }
+
+  switch (unode->type) {
+    case SCULPT_UNDO_COORDS:
+      if (ss->shapekey_active) {
+        return false;
+      }
+      for (int i = 0; i < unode->totvert; i++) {
+        copy_v3_v3(&r_values[i * 3], ss->mvert[index[i]].co);
+      }
+      return true;
+    case SCULPT_UNDO_MASK:
+      if (ss->vmask == NULL) {
+        return false;
+      }
+      for (int i = 0; i < unode->totvert; i++) {
+        r_values[i] = ss->vmask[index[i]];
+      }
+      return true;
+    case SCULPT_UNDO_COLOR:
+      if (ss->vcol == NULL) {
+        return false;
+      }
+      for (int i = 0; i < unode->totvert; i++) {
+        copy_v4_v4(&r_values[i * 4], ss->vcol[index[i]].color);
+      }
+      return true;
+    default:
+      return false;
+  }
+}
+
+static void sculpt_undo_node_compress(SculptSession *ss, SculptUndoNode *unode, void *wrkmem)
+{
+  const size_t values_len = (size_t)unode->totvert * sculpt_undo_node_values_per_vert(unode);
+  const size_t size = values_len * sizeof(float);
+  const unsigned char *values = sculpt_undo_node_values(unode);
+
+  float *base = MEM_malloc_arrayN(values_len, sizeof(float), __func__);
+  if (!sculpt_undo_node_gather(ss, unode, base)) {
+    MEM_freeN(base);
+    return;
+  }
+
+  /* Difference with the mesh, one plane per byte of the values. */
+  const unsigned char *base_bytes = (const unsigned char *)base;
+  unsigned char *planes = MEM_mallocN(size, __func__);
+  for (size_t i = 0; i < values_len; i++) {
+    for (int b = 0; b < (int)sizeof(float); b++) {
+      planes[b * values_len + i] = values[i * sizeof(float) + b] ^
+                                   base_bytes[i * sizeof(float) + b];
+    }
+  }
+
+  lzo_uint out_len = LZO_OUT_LEN(size);
+  unsigned char *out = MEM_mallocN(out_len, __func__);
+  const int r = lzo1x_1_compress(planes, (lzo_uint)size, out, &out_len, wrkmem);
+
+  if (r == LZO_E_OK && out_len < size) {
+    unode->delta = MEM_mallocN(out_len, "SculptUndoNode.delta");
+    memcpy(unode->delta, out, out_len);
+    unode->delta_size = out_len;
+    unode->delta_hash = BLI_hash_mm2(base_bytes, size, 0);
+
+    MEM_freeN(sculpt_undo_node_values(unode));
+    sculpt_undo_node_values_set(unode, NULL);
+
+    unode->undo_size = unode->delta_size + sizeof(int) * (unode->maxvert ? unode->totvert :
+                                                                           unode->totgrid);
+    /* Normals and original coordinates are kept as they are. */
+    if (unode->no) {
+      unode->undo_size += MEM_allocN_len(unode->no);
+    }
+    if (unode->orig_co) {
+      unode->undo_size += MEM_allocN_len(unode->orig_co);
+    }
+  }
+
+  MEM_freeN(out);
+  MEM_freeN(planes);
+  MEM_freeN(base);
+}
+
+static void sculpt_undo_node_expand(SculptSession *ss, SculptUndoNode *unode)
+{
+  const size_t values_len = (size_t)unode->totvert * sculpt_undo_node_values_per_vert(unode);
+  const size_t size = values_len * sizeof(float);
+
+  float *base = MEM_malloc_arrayN(values_len, sizeof(float), __func__);
+  const unsigned char *base_bytes = (const unsigned char *)base;
+  if (!sculpt_undo_node_gather(ss, unode, base) ||
+      BLI_hash_mm2(base_bytes, size, 0) != unode->delta_hash) {
+    /* The mesh isn't in the state the difference was made against, the node is skipped. */
+    CLOG_WARN(&LOG, "mesh was modified outside of sculpt undo, skipping undo node");
+    MEM_freeN(base);
+    return;
+  }
+
+  unsigned char *planes = MEM_mallocN(size, __func__);
+  lzo_uint out_len = (lzo_uint)size;
+  const int r = lzo1x_decompress_safe(
+      unode->delta, (lzo_uint)unode->delta_size, planes, &out_len, NULL);
+
+  if (r == LZO_E_OK && out_len == size) {
+    unsigned char *values = MEM_mallocN(size, __func__);
+    for (size_t i = 0; i < values_len; i++) {
+      for (int b = 0; b < (int)sizeof(float); b++) {
+        values[i * sizeof(float) + b] = planes[b * values_len + i] ^
+                                        base_bytes[i * sizeof(float) + b];
+      }
+    }
+    sculpt_undo_node_values_set(unode, values);
+
+    MEM_freeN(unode->delta);
+    unode->delta = NULL;
+    unode->delta_size = 0;
+  }
+
+  MEM_freeN(planes);
+  MEM_freeN(base);
+}
+
+typedef struct SculptUndoCompressData {
+  SculptSession *ss;
+  SculptUndoNode **nodes;
+} SculptUndoCompressData;
+
+static void sculpt_undo_compress_task_cb(void *__restrict userdata,
+                                         const int n,
+                                         const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptUndoCompressData *data = userdata;
+  void *wrkmem = MEM_mallocN(LZO1X_MEM_COMPRESS, __func__);
+  sculpt_undo_node_compress(data->ss, data->nodes[n], wrkmem);
+  MEM_freeN(wrkmem);
+}
+
+static void sculpt_undo_expand_task_cb(void *__restrict userdata,
+                                       const int n,
+                                       const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  SculptUndoCompressData *data = userdata;
+  sculpt_undo_node_expand(data->ss, data->nodes[n]);
+}
+
+/* Compress (or expand with \a expand) the nodes of \a ob in the list. */
+static void sculpt_undo_compress_list_ex(Object *ob, ListBase *lb, const bool expand)
+{
+  SculptSession *ss = ob->sculpt;
+  if (ss == NULL || ss->bm) {
+    return;
+  }
+
+  int totnode = 0;
+  SculptUndoNode **nodes = MEM_malloc_arrayN(
+      BLI_listbase_count(lb), sizeof(SculptUndoNode *), __func__);
+  LISTBASE_FOREACH (SculptUndoNode *, unode, lb) {
+    if (STREQ(unode->idname, ob->id.name) &&
+        (expand ? (unode->delta != NULL) : sculpt_undo_node_is_compressible(unode))) {
+      nodes[totnode++] = unode;
+    }
+  }
+
+  SculptUndoCompressData data = {
+      .ss = ss,
+      .nodes = nodes,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = totnode > 1;
+  BLI_task_parallel_range(0,
+                          totnode,
+                          &data,
+                          expand ? sculpt_undo_expand_task_cb : sculpt_undo_compress_task_cb,
+                          &settings);
+  MEM_freeN(nodes);
+}
+
+#else
+
+static void sculpt_undo_compress_list_ex(Object *UNUSED(ob),
+                                         ListBase *UNUSED(lb),
+                                         const bool UNUSED(expand))
+{
+}
+
+#endif /* WITH_LZO */
+
+static void sculpt_undo_compress_list(Object *ob, ListBase *lb)
+{
+  sculpt_undo_compress_list_ex(ob, lb, false);
+}
+
+static void sculpt_undo_expand_list(Object *ob, ListBase *lb)
+{
+  sculpt_undo_compress_list_ex(ob, lb, true);
+}
+
+/** \} */
+
 static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase *lb)
 {
   Scene *scene = CTX_data_scene(C);
@@ -685,12 +1006,19 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
   char *undo_modified_grids = NULL;
   bool use_multires_undo = false;
 
+  sculpt_undo_expand_list(ob, lb);
+
   for (unode = lb->first; unode; unode = unode->next) {
 
     if (!STREQ(unode->idname, ob->id.name)) {
       continue;
     }
 
+    /* Still compressed when it couldn't be expanded against the current mesh. */
+    if (unode->delta) {
+      continue;
+    }
+
     /* Check if undo data matches current data well enough to
      * continue. */
     if (unode->maxvert) {
@@ -746,6 +1074,8 @@ static void sculpt_undo_restore_list(bContext *C, Depsgraph *depsgraph, ListBase
     }
   }
 
+  sculpt_undo_compress_list(ob, lb);
+
   if (use_multires_undo) {
     for (unode = lb->first; unode; unode = unode->next) {
       if (!STREQ(unode->idname, ob->id.name)) {
@@ -860,6 +1190,12 @@ static void sculpt_undo_free_list(ListBase *lb)
     if (unode->mask) {
       MEM_freeN(unode->mask);
     }
+    if (unode->col) {
+      MEM_freeN(unode->col);
+    }
+    if (unode->delta) {
+      MEM_freeN(unode->delta);
+    }
 
     if (unode->bm_entry) {
       BM_log_entry_drop(unode->bm_entry);
@@ -1001,7 +1337,7 @@ static SculptUndoNode *sculpt_undo_alloc_node(Object *ob, PBVHNode *node, Sculpt
       unode->co = MEM_callocN(sizeof(float[3]) * allvert, "SculptUndoNode.co");
       unode->no = MEM_callocN(sizeof(short[3]) * allvert, "SculptUndoNode.no");
 
-      usculpt->undo_size = (sizeof(float[3]) + sizeof(short[3]) + sizeof(int)) * allvert;
+      unode->undo_size = (sizeof(float[3]) + sizeof(short[3]) + sizeof(int)) * allvert;
       break;
     case SCULPT_UNDO_HIDDEN:
       if (maxgrid) {
@@ -1015,13 +1351,13 @@ static SculptUndoNode *sculpt_undo_alloc_node(Object *ob, PBVHNode *node, Sculpt
     case SCULPT_UNDO_MASK:
       unode->mask = MEM_callocN(sizeof(float) * allvert, "SculptUndoNode.mask");
 
-      usculpt->undo_size += (sizeof(float) * sizeof(int)) * allvert;
+      unode->undo_size = (sizeof(float) + sizeof(int)) * allvert;
 
       break;
     case SCULPT_UNDO_COLOR:
       unode->col = MEM_callocN(sizeof(MPropCol) * allvert, "SculptUndoNode.col");
 
-      usculpt->undo_size += (sizeof(MPropCol) * sizeof(int)) * allvert;
+      unode->undo_size = (sizeof(MPropCol) + sizeof(int)) * allvert;
 
       break;
     case SCULPT_UNDO_DYNTOPO_BEGIN:
@@ -1048,8 +1384,11 @@ static SculptUndoNode *sculpt_undo_alloc_node(Object *ob, PBVHNode *node, Sculpt
 
   if (ss->deform_modifiers_active) {
     unode->orig_co = MEM_callocN(allvert * sizeof(*unode->orig_co), "undoSculpt orig_cos");
+    unode->undo_size += sizeof(*unode->orig_co) * allvert;
   }
 
+  usculpt->undo_size += unode->undo_size;
+
   return unode;
 }
 
@@ -1401,12 +1740,30 @@ static bool sculpt_undosys_step_encode(struct bContext *UNUSED(C),
                                        struct Main *bmain,
                                        UndoStep *us_p)
 {
-  /* Dummy, encoding is done along the way by adding tiles
-   * to the current 'SculptUndoStep' added by encode_init. */
+  /* Encoding is done along the way by adding tiles to the current 'SculptUndoStep' added by
+   * encode_init, only the compression of the nodes is left. */
   SculptUndoStep *us = (SculptUndoStep *)us_p;
+
+  SculptUndoNode *unode = us->data.nodes.first;
+  Object *ob = unode ? (Object *)BKE_libblock_find_name(bmain, ID_OB, unode->idname + 2) : NULL;
+  if (ob) {
+    const size_t undo_size = us->data.undo_size;
+    sculpt_undo_compress_list(ob, &us->data.nodes);
+
+    us->data.undo_size = 0;
+    LISTBASE_FOREACH (SculptUndoNode *, unode_iter, &us->data.nodes) {
+      us->data.undo_size += unode_iter->undo_size;
+    }
+    CLOG_INFO(&LOG,
+              1,
+              "step '%s': %zu bytes, compressed to %zu bytes",
+              us->step.name,
+              undo_size,
+              us->data.undo_size);
+  }
   us->step.data_size = us->data.undo_size;
 
-  SculptUndoNode *unode = us->data.nodes.last;
+  unode = us->data.nodes.last;
   if (unode && unode->type == SCULPT_UNDO_DYNTOPO_END) {
     us->step.use_memfile_step = true;
   }
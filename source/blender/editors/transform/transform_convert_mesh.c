@@ -1440,6 +1440,20 @@ void recalcData_mesh(TransInfo *t)
 
     DEG_id_tag_update(tc->obedit->data, 0); /* sets recalc flags */
     BMEditMesh *em = BKE_editmesh_from_object(tc->obedit);
+
+    if (t->data_type == TC_MESH_VERTS) {
+      /* Only vertices are moved, let drawing update the parts of the mesh around them. */
+      BKE_editmesh_deform_tag_begin(em);
+      TransData *td = tc->data;
+      for (int i = 0; i < tc->data_len; i++, td++) {
+        BKE_editmesh_deform_tag_vert(em, td->extra);
+      }
+      TransDataMirror *td_mirror = tc->data_mirror;
+      for (int i = 0; i < tc->data_mirror_len; i++, td_mirror++) {
+        BKE_editmesh_deform_tag_vert(em, td_mirror->extra);
+      }
+    }
+
     EDBM_mesh_normals_update(em);
     BKE_editmesh_looptri_calc(em);
   }
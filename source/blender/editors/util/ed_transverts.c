@@ -58,6 +58,8 @@ void ED_transverts_update_obedit(TransVertStore *tvs, Object *obedit)
   if (obedit->type == OB_MESH) {
     BMEditMesh *em = BKE_editmesh_from_object(obedit);
     BM_mesh_normals_update(em->bm);
+    /* Moved vertices are not tagged, drawing has to update the whole mesh. */
+    BKE_editmesh_deform_tag_reset(em);
   }
   else if (ELEM(obedit->type, OB_CURVE, OB_SURF)) {
     Curve *cu = obedit->data;
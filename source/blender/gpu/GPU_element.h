@@ -39,6 +39,14 @@ typedef enum {
   GPU_INDEX_U32,
 } GPUIndexBufType;
 
+/* Bounds of a range of consecutive indices, used to skip drawing the parts of an index buffer
+ * that are not visible. */
+typedef struct GPUIndexBufCluster {
+  float min[3], max[3];
+  uint index_start;
+  uint index_len;
+} GPUIndexBufCluster;
+
 typedef struct GPUIndexBuf {
   uint index_start;
   uint index_len;
@@ -53,6 +61,9 @@ typedef struct GPUIndexBuf {
     void *data;              /* non-NULL indicates not yet sent to VRAM */
     struct GPUIndexBuf *src; /* if is_subrange is true, this is the source buffer. */
   };
+  /** Optional, sorted by start. Sub-ranges reference the clusters of their source buffer. */
+  const GPUIndexBufCluster *clusters;
+  uint cluster_len;
 } GPUIndexBuf;
 
 void GPU_indexbuf_use(GPUIndexBuf *);
@@ -99,6 +110,9 @@ void GPU_indexbuf_create_subrange_in_place(GPUIndexBuf *r_ibo,
                                            uint start,
                                            uint length);
 
+/* Takes ownership of the clusters, which must cover the buffer in order. */
+void GPU_indexbuf_clusters_set(GPUIndexBuf *elem, GPUIndexBufCluster *clusters, uint cluster_len);
+
 void GPU_indexbuf_discard(GPUIndexBuf *);
 
 int GPU_indexbuf_primitive_len(GPUPrimType prim_type);
@@ -131,6 +131,7 @@ GPU_INLINE uint GPU_vertbuf_raw_used(GPUVertBufRaw *a)
 void GPU_vertbuf_attr_get_raw_data(GPUVertBuf *, uint a_idx, GPUVertBufRaw *access);
 
 void GPU_vertbuf_use(GPUVertBuf *);
+void GPU_vertbuf_update_sub(GPUVertBuf *verts, uint v_first, uint v_len);
 
 /* Metrics */
 uint GPU_vertbuf_get_memory_usage(void);
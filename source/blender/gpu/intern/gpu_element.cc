@@ -260,6 +260,22 @@ void GPU_indexbuf_create_subrange_in_place(GPUIndexBuf *elem,
   elem->src = elem_src;
   elem->index_start = start;
   elem->index_len = length;
+
+  /* Reference the clusters contained in the range. */
+  elem->clusters = NULL;
+  elem->cluster_len = 0;
+  for (uint i = 0; i < elem_src->cluster_len; i++) {
+    const GPUIndexBufCluster *cluster = &elem_src->clusters[i];
+    if (cluster->index_start >= start + length) {
+      break;
+    }
+    if (cluster->index_start >= start) {
+      if (elem->clusters == NULL) {
+        elem->clusters = cluster;
+      }
+      elem->cluster_len++;
+    }
+  }
 }
 
 #if GPU_TRACK_INDEX_RANGE
@@ -367,6 +383,13 @@ void GPU_indexbuf_build_in_place(GPUIndexBufBuilder *builder, GPUIndexBuf *elem)
   /* other fields are safe to leave */
 }
 
+void GPU_indexbuf_clusters_set(GPUIndexBuf *elem, GPUIndexBufCluster *clusters, uint cluster_len)
+{
+  BLI_assert(!elem->is_subrange && elem->clusters == NULL);
+  elem->clusters = clusters;
+  elem->cluster_len = cluster_len;
+}
+
 static void indexbuf_upload_data(GPUIndexBuf *elem)
 {
   /* send data to GPU */
@@ -399,5 +422,8 @@ void GPU_indexbuf_discard(GPUIndexBuf *elem)
   if (!elem->is_subrange && elem->data) {
     MEM_freeN(elem->data);
   }
+  if (!elem->is_subrange && elem->clusters) {
+    MEM_freeN((void *)elem->clusters);
+  }
   MEM_freeN(elem);
 }
@@ -313,6 +313,27 @@ void GPU_vertbuf_use(GPUVertBuf *verts)
   }
 }
 
+/**
+ * Upload a range of vertices of dynamic data that was modified after the buffer was used.
+ * Buffers not yet uploaded or tagged dirty are left to the full upload of #GPU_vertbuf_use.
+ */
+void GPU_vertbuf_update_sub(GPUVertBuf *verts, uint v_first, uint v_len)
+{
+#if TRUST_NO_ONE
+  assert(verts->data != NULL); /* only for dynamic data */
+  assert(v_first + v_len <= verts->vertex_len);
+#endif
+  if (verts->vbo_id == 0 || verts->dirty || v_len == 0) {
+    return;
+  }
+  const uint stride = verts->format.stride;
+  glBindBuffer(GL_ARRAY_BUFFER, verts->vbo_id);
+  glBufferSubData(GL_ARRAY_BUFFER,
+                  (GLintptr)v_first * stride,
+                  (GLsizeiptr)v_len * stride,
+                  verts->data + (size_t)v_first * stride);
+}
+
 uint GPU_vertbuf_get_memory_usage(void)
 {
   return vbo_memory_usage;
@@ -315,6 +315,12 @@ void IMB_colormanagement_processor_apply(struct ColormanageProcessor *cm_process
                                          int height,
                                          int channels,
                                          bool predivide);
+void IMB_colormanagement_processor_apply_threaded(struct ColormanageProcessor *cm_processor,
+                                                  float *buffer,
+                                                  int width,
+                                                  int height,
+                                                  int channels,
+                                                  bool predivide);
 void IMB_colormanagement_processor_apply_byte(struct ColormanageProcessor *cm_processor,
                                               unsigned char *buffer,
                                               int width,
@@ -457,6 +457,12 @@ bool IMB_scalefastImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy
  */
 void IMB_scaleImBuf_threaded(struct ImBuf *ibuf, unsigned int newx, unsigned int newy);
 
+/**
+ *
+ * \attention Defined in scaling.c
+ */
+bool IMB_scale_box_threaded(struct ImBuf *ibuf, unsigned int newx, unsigned int newy);
+
 /**
  *
  * \attention Defined in writeimage.c
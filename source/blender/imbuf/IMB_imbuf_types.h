@@ -170,6 +170,12 @@ typedef enum eImBufFlags {
   IB_thumbnail = 1 << 16,
   IB_multiview = 1 << 17,
   IB_halffloat = 1 << 18,
+  /**
+   * Decode image at half or quarter resolution if file format supports it (JPEG).
+   * Loaders set the flag on the image buffer when the image was actually reduced.
+   */
+  IB_reduce_2 = 1 << 19,
+  IB_reduce_4 = 1 << 20,
 } eImBufFlags;
 
 /** \} */
@@ -44,6 +44,12 @@ typedef void *(*MovieCacheGetPriorityDataFP)(void *userkey);
 typedef int (*MovieCacheGetItemPriorityFP)(void *last_userkey, void *priority_data);
 typedef void (*MovieCachePriorityDeleterFP)(void *priority_data);
 
+typedef struct MovieCacheStats {
+  uint64_t hits, misses, evictions;
+  size_t memory_in_use, memory_limit;
+  int totitem;
+} MovieCacheStats;
+
 void IMB_moviecache_init(void);
 void IMB_moviecache_destruct(void);
 
@@ -57,6 +63,8 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache,
                                           MovieCacheGetPriorityDataFP getprioritydatafp,
                                           MovieCacheGetItemPriorityFP getitempriorityfp,
                                           MovieCachePriorityDeleterFP prioritydeleterfp);
+void IMB_moviecache_set_memory_limit(struct MovieCache *cache, size_t memory_limit);
+void IMB_moviecache_set_memory_limit_fraction(struct MovieCache *cache, float fraction);
 
 void IMB_moviecache_put(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
 bool IMB_moviecache_put_if_possible(struct MovieCache *cache, void *userkey, struct ImBuf *ibuf);
@@ -65,6 +73,12 @@ void IMB_moviecache_remove(struct MovieCache *cache, void *userkey);
 bool IMB_moviecache_has_frame(struct MovieCache *cache, void *userkey);
 void IMB_moviecache_free(struct MovieCache *cache);
 
+void IMB_moviecache_get_stats(struct MovieCache *cache, struct MovieCacheStats *r_stats);
+void IMB_moviecache_stats_foreach(void (*callback)(const char *name,
+                                                   const struct MovieCacheStats *stats,
+                                                   void *userdata),
+                                  void *userdata);
+
 void IMB_moviecache_cleanup(struct MovieCache *cache,
                             bool(cleanup_check_cb)(struct ImBuf *ibuf,
                                                    void *userkey,
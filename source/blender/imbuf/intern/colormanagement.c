@@ -27,6 +27,10 @@
 #include <math.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "DNA_color_types.h"
 #include "DNA_image_types.h"
 #include "DNA_movieclip_types.h"
@@ -101,6 +105,10 @@ typedef struct ColormanageProcessor {
   OCIO_ConstProcessorRcPtr *processor;
   CurveMapping *curve_mapping;
   bool is_data_result;
+  /* Optional 3D LUT used to transform byte buffers, see colormanage_byte_lut_ensure(). */
+  struct ColormanageByteLUT *byte_lut;
+  /* Byte pixels transformed without a matching LUT since the last one was built. */
+  size_t byte_lut_pixels;
 } ColormanageProcessor;
 
 static struct global_glsl_state {
@@ -284,6 +292,8 @@ static struct MovieCache *colormanage_moviecache_ensure(ImBuf *ibuf)
                                        sizeof(ColormanageCacheKey),
                                        colormanage_hashhash,
                                        colormanage_hashcmp);
+    /* Display buffers of a single image, sequencer frames included. */
+    IMB_moviecache_set_memory_limit_fraction(moviecache, 0.25f);
 
     ibuf->colormanage_cache->moviecache = moviecache;
   }
@@ -1461,10 +1471,217 @@ const float *IMB_colormangement_get_xyz_to_rgb()
   return &imbuf_xyz_to_rgb[0][0];
 }
 
+/*********************** Byte buffer 3D LUT routines *************************/
+
+/* Byte buffers can only hold 256 distinct values per channel, so instead of running every pixel
+ * through OCIO the processor is sampled once on a regular grid and pixels are evaluated with
+ * tetrahedral interpolation. Grid nodes are placed at every COLORMANAGE_BYTE_LUT_STEP byte
+ * values so that nodes coincide with exactly representable inputs. */
+#define COLORMANAGE_BYTE_LUT_STEP 5
+#define COLORMANAGE_BYTE_LUT_EDGE (255 / COLORMANAGE_BYTE_LUT_STEP + 1)
+#define COLORMANAGE_BYTE_LUT_NODES \
+  (COLORMANAGE_BYTE_LUT_EDGE * COLORMANAGE_BYTE_LUT_EDGE * COLORMANAGE_BYTE_LUT_EDGE)
+
+/* Building the table costs about as much as transforming this many pixels directly, so it is
+ * only built once a processor has transformed that many byte pixels, in one or more calls. */
+#define COLORMANAGE_BYTE_LUT_MIN_PIXELS (4 * COLORMANAGE_BYTE_LUT_NODES)
+
+typedef struct ColormanageByteLUT {
+  /* Color space the byte values are converted from before the processor is applied,
+   * empty when the processor is applied to the byte values directly. */
+  char from_colorspace[MAX_COLORSPACE_NAME];
+  /* RGB result for every grid node, padded to 4 floats for aligned SIMD loads. */
+  float *table;
+  /* Offset of the lower grid node into the table for every byte value, per channel. */
+  int offset[3][256];
+  /* Position of every byte value within its grid cell. */
+  float frac[256];
+} ColormanageByteLUT;
+
+/* Sample cm_processor for every grid node. Input values are interpreted in from_colorspace and
+ * converted to scene linear before the processor is applied, NULL means the processor is applied
+ * to the byte values directly. */
+static ColormanageByteLUT *colormanage_byte_lut_create(ColormanageProcessor *cm_processor,
+                                                       const char *from_colorspace)
+{
+  const int edge = COLORMANAGE_BYTE_LUT_EDGE;
+  ColormanageByteLUT *lut = MEM_mallocN(sizeof(ColormanageByteLUT), "colormanage byte lut");
+  float *fp;
+
+  lut->table = MEM_mallocN(sizeof(float[4]) * COLORMANAGE_BYTE_LUT_NODES,
+                           "colormanage byte lut table");
+  BLI_strncpy(lut->from_colorspace,
+              from_colorspace ? from_colorspace : "",
+              sizeof(lut->from_colorspace));
+
+  fp = lut->table;
+  for (int b = 0; b < edge; b++) {
+    for (int g = 0; g < edge; g++) {
+      for (int r = 0; r < edge; r++, fp += 4) {
+        fp[0] = (float)(r * COLORMANAGE_BYTE_LUT_STEP) / 255.0f;
+        fp[1] = (float)(g * COLORMANAGE_BYTE_LUT_STEP) / 255.0f;
+        fp[2] = (float)(b * COLORMANAGE_BYTE_LUT_STEP) / 255.0f;
+        fp[3] = 1.0f;
+      }
+    }
+  }
+
+  if (from_colorspace) {
+    IMB_colormanagement_transform_threaded(
+        lut->table, edge * edge, edge, 4, from_colorspace, global_role_scene_linear, false);
+  }
+  IMB_colormanagement_processor_apply_threaded(
+      cm_processor, lut->table, edge * edge, edge, 4, false);
+
+  for (int i = 0; i < 256; i++) {
+    const int node = min_ii(i / COLORMANAGE_BYTE_LUT_STEP, edge - 2);
+
+    lut->offset[0][i] = 4 * node;
+    lut->offset[1][i] = 4 * node * edge;
+    lut->offset[2][i] = 4 * node * edge * edge;
+    lut->frac[i] = (float)(i - node * COLORMANAGE_BYTE_LUT_STEP) /
+                   (float)COLORMANAGE_BYTE_LUT_STEP;
+  }
+
+  return lut;
+}
+
+static void colormanage_byte_lut_free(ColormanageByteLUT *lut)
+{
+  MEM_freeN(lut->table);
+  MEM_freeN(lut);
+}
+
+/* Get the LUT of cm_processor for byte pixels in from_colorspace (NULL when the processor is
+ * applied to the byte values directly), about to be used for num_pixels pixels.
+ * Returns NULL when the pixels are to be transformed through OCIO instead. A processor keeps a
+ * single LUT, it is replaced when enough pixels of another color space have been transformed.
+ * Not thread safe, to be called before the work is split between threads. */
+static const ColormanageByteLUT *colormanage_byte_lut_ensure(ColormanageProcessor *cm_processor,
+                                                             const char *from_colorspace,
+                                                             size_t num_pixels)
+{
+  ColormanageByteLUT *lut = cm_processor->byte_lut;
+
+  if (lut && STREQ(lut->from_colorspace, from_colorspace ? from_colorspace : "")) {
+    return lut;
+  }
+
+  cm_processor->byte_lut_pixels += num_pixels;
+  if (cm_processor->byte_lut_pixels < COLORMANAGE_BYTE_LUT_MIN_PIXELS) {
+    return NULL;
+  }
+
+  if (lut) {
+    colormanage_byte_lut_free(lut);
+  }
+  cm_processor->byte_lut = colormanage_byte_lut_create(cm_processor, from_colorspace);
+  cm_processor->byte_lut_pixels = 0;
+
+  return cm_processor->byte_lut;
+}
+
+/* Tetrahedral interpolation of the RGB values of a single byte pixel, r_rgb must have room for
+ * 4 floats, the fourth one is undefined on return. */
+BLI_INLINE void colormanage_byte_lut_eval(const ColormanageByteLUT *lut,
+                                          const unsigned char *cp,
+                                          float r_rgb[4])
+{
+  const int dr = 4;
+  const int dg = 4 * COLORMANAGE_BYTE_LUT_EDGE;
+  const int db = 4 * COLORMANAGE_BYTE_LUT_EDGE * COLORMANAGE_BYTE_LUT_EDGE;
+  const float fr = lut->frac[cp[0]], fg = lut->frac[cp[1]], fb = lut->frac[cp[2]];
+  const float *c0 = lut->table + lut->offset[0][cp[0]] + lut->offset[1][cp[1]] +
+                    lut->offset[2][cp[2]];
+  const float *c3 = c0 + dr + dg + db;
+  const float *c1, *c2;
+  float w0, w1, w2, w3;
+
+  /* Pick the tetrahedron of the cell containing the sample, walking along the axes from the
+   * largest to the smallest fraction. */
+  if (fr > fg) {
+    if (fg > fb) {
+      c1 = c0 + dr;
+      c2 = c1 + dg;
+      w0 = 1.0f - fr, w1 = fr - fg, w2 = fg - fb, w3 = fb;
+    }
+    else if (fr > fb) {
+      c1 = c0 + dr;
+      c2 = c1 + db;
+      w0 = 1.0f - fr, w1 = fr - fb, w2 = fb - fg, w3 = fg;
+    }
+    else {
+      c1 = c0 + db;
+      c2 = c1 + dr;
+      w0 = 1.0f - fb, w1 = fb - fr, w2 = fr - fg, w3 = fg;
+    }
+  }
+  else {
+    if (fb > fg) {
+      c1 = c0 + db;
+      c2 = c1 + dg;
+      w0 = 1.0f - fb, w1 = fb - fg, w2 = fg - fr, w3 = fr;
+    }
+    else if (fb > fr) {
+      c1 = c0 + dg;
+      c2 = c1 + db;
+      w0 = 1.0f - fg, w1 = fg - fb, w2 = fb - fr, w3 = fr;
+    }
+    else {
+      c1 = c0 + dg;
+      c2 = c1 + dr;
+      w0 = 1.0f - fg, w1 = fg - fr, w2 = fr - fb, w3 = fb;
+    }
+  }
+
+#ifdef __SSE2__
+  __m128 result = _mm_mul_ps(_mm_set1_ps(w0), _mm_loadu_ps(c0));
+  result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(w1), _mm_loadu_ps(c1)));
+  result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(w2), _mm_loadu_ps(c2)));
+  result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(w3), _mm_loadu_ps(c3)));
+  _mm_storeu_ps(r_rgb, result);
+#else
+  for (int i = 0; i < 3; i++) {
+    r_rgb[i] = w0 * c0[i] + w1 * c1[i] + w2 * c2[i] + w3 * c3[i];
+  }
+#endif
+}
+
+/* Transform straight alpha RGBA byte pixels, writing byte and/or float results.
+ * The byte output may alias the input. */
+static void colormanage_byte_lut_apply(const ColormanageByteLUT *lut,
+                                       const unsigned char *byte_buffer,
+                                       unsigned char *r_byte_buffer,
+                                       float *r_float_buffer,
+                                       size_t num_pixels)
+{
+  float rgb[4];
+
+  for (size_t i = 0; i < num_pixels; i++, byte_buffer += 4) {
+    const unsigned char alpha = byte_buffer[3];
+
+    colormanage_byte_lut_eval(lut, byte_buffer, rgb);
+
+    if (r_float_buffer) {
+      copy_v3_v3(r_float_buffer, rgb);
+      r_float_buffer[3] = (float)alpha * (1.0f / 255.0f);
+      r_float_buffer += 4;
+    }
+    if (r_byte_buffer) {
+      r_byte_buffer[0] = unit_float_to_uchar_clamp(rgb[0]);
+      r_byte_buffer[1] = unit_float_to_uchar_clamp(rgb[1]);
+      r_byte_buffer[2] = unit_float_to_uchar_clamp(rgb[2]);
+      r_byte_buffer[3] = alpha;
+      r_byte_buffer += 4;
+    }
+  }
+}
+
 /*********************** Threaded display buffer transform routines *************************/
 
 typedef struct DisplayBufferThread {
   ColormanageProcessor *cm_processor;
+  const struct ColormanageByteLUT *byte_lut;
 
   const float *buffer;
   unsigned char *byte_buffer;
@@ -1488,6 +1705,7 @@ typedef struct DisplayBufferThread {
 typedef struct DisplayBufferInitData {
   ImBuf *ibuf;
   ColormanageProcessor *cm_processor;
+  const struct ColormanageByteLUT *byte_lut;
   const float *buffer;
   unsigned char *byte_buffer;
 
@@ -1519,6 +1737,7 @@ static void display_buffer_init_handle(void *handle_v,
   memset(handle, 0, sizeof(DisplayBufferThread));
 
   handle->cm_processor = init_data->cm_processor;
+  handle->byte_lut = init_data->byte_lut;
 
   if (init_data->buffer) {
     handle->buffer = init_data->buffer + offset;
@@ -1671,13 +1890,22 @@ static void *do_display_buffer_apply_thread(void *handle_v)
     float *linear_buffer = MEM_mallocN(((size_t)channels) * width * height * sizeof(float),
                                        "color conversion linear buffer");
 
-    display_buffer_apply_get_linear_buffer(handle, height, linear_buffer, &is_straight_alpha);
+    if (handle->byte_lut) {
+      /* byte -> linear -> display transform of the whole pixel at once */
+      colormanage_byte_lut_apply(
+          handle->byte_lut, handle->byte_buffer, NULL, linear_buffer, (size_t)width * height);
+      is_straight_alpha = true;
+    }
+    else {
+      display_buffer_apply_get_linear_buffer(handle, height, linear_buffer, &is_straight_alpha);
+    }
 
     bool predivide = handle->predivide && (is_straight_alpha == false);
 
-    if (is_data) {
+    if (is_data || handle->byte_lut) {
       /* special case for data buffers - no color space conversions,
-       * only generate byte buffers
+       * only generate byte buffers, or the display transform was already
+       * applied through the byte LUT
        */
     }
     else {
@@ -1733,6 +1961,7 @@ static void display_buffer_apply_threaded(ImBuf *ibuf,
 
   init_data.ibuf = ibuf;
   init_data.cm_processor = cm_processor;
+  init_data.byte_lut = NULL;
   init_data.buffer = buffer;
   init_data.byte_buffer = byte_buffer;
   init_data.display_buffer = display_buffer;
@@ -1756,6 +1985,14 @@ static void display_buffer_apply_threaded(ImBuf *ibuf,
     init_data.float_colorspace = NULL;
   }
 
+  /* Byte images can be transformed through a LUT which includes the conversion to
+   * scene linear, see display_buffer_apply_get_linear_buffer() for the regular path. */
+  if (cm_processor && buffer == NULL && byte_buffer && ibuf->channels == 4 &&
+      !cm_processor->is_data_result && (ibuf->colormanage_flag & IMB_COLORMANAGE_IS_DATA) == 0) {
+    init_data.byte_lut = colormanage_byte_lut_ensure(
+        cm_processor, init_data.byte_colorspace, ((size_t)ibuf->x) * ibuf->y);
+  }
+
   IMB_processor_apply_threaded(ibuf->y,
                                sizeof(DisplayBufferThread),
                                &init_data,
@@ -1833,6 +2070,7 @@ static void colormanage_display_buffer_process(ImBuf *ibuf,
 
 typedef struct ProcessorTransformThread {
   ColormanageProcessor *cm_processor;
+  const struct ColormanageByteLUT *byte_lut;
   unsigned char *byte_buffer;
   float *float_buffer;
   int width;
@@ -1845,6 +2083,7 @@ typedef struct ProcessorTransformThread {
 
 typedef struct ProcessorTransformInit {
   ColormanageProcessor *cm_processor;
+  const struct ColormanageByteLUT *byte_lut;
   unsigned char *byte_buffer;
   float *float_buffer;
   int width;
@@ -1872,6 +2111,7 @@ static void processor_transform_init_handle(void *handle_v,
   memset(handle, 0, sizeof(ProcessorTransformThread));
 
   handle->cm_processor = init_data->cm_processor;
+  handle->byte_lut = init_data->byte_lut;
 
   if (init_data->byte_buffer != NULL) {
     /* TODO(serge): Offset might be different for byte and float buffers. */
@@ -1917,7 +2157,11 @@ static void *do_processor_transform_thread(void *handle_v)
     IMB_premultiply_rect_float(float_buffer, 4, width, height);
   }
   else {
-    if (byte_buffer != NULL) {
+    if (handle->byte_lut) {
+      colormanage_byte_lut_apply(
+          handle->byte_lut, byte_buffer, byte_buffer, NULL, ((size_t)width) * height);
+    }
+    else if (byte_buffer != NULL) {
       IMB_colormanagement_processor_apply_byte(
           handle->cm_processor, byte_buffer, width, height, channels);
     }
@@ -1942,6 +2186,7 @@ static void processor_transform_apply_threaded(unsigned char *byte_buffer,
   ProcessorTransformInitData init_data;
 
   init_data.cm_processor = cm_processor;
+  init_data.byte_lut = NULL;
   init_data.byte_buffer = byte_buffer;
   init_data.float_buffer = float_buffer;
   init_data.width = width;
@@ -1950,6 +2195,11 @@ static void processor_transform_apply_threaded(unsigned char *byte_buffer,
   init_data.predivide = predivide;
   init_data.float_from_byte = float_from_byte;
 
+  if (byte_buffer && !float_from_byte && channels == 4) {
+    init_data.byte_lut = colormanage_byte_lut_ensure(
+        cm_processor, NULL, ((size_t)width) * height);
+  }
+
   IMB_processor_apply_threaded(height,
                                sizeof(ProcessorTransformThread),
                                &init_data,
@@ -2797,7 +3047,8 @@ void IMB_display_buffer_transform_apply(unsigned char *display_buffer,
                        "display transform temp buffer");
   memcpy(buffer, linear_buffer, (size_t)channels * width * height * sizeof(float));
 
-  IMB_colormanagement_processor_apply(cm_processor, buffer, width, height, channels, predivide);
+  IMB_colormanagement_processor_apply_threaded(
+      cm_processor, buffer, width, height, channels, predivide);
 
   IMB_colormanagement_processor_free(cm_processor);
 
@@ -3908,6 +4159,19 @@ void IMB_colormanagement_processor_apply(ColormanageProcessor *cm_processor,
   }
 }
 
+/* Same as IMB_colormanagement_processor_apply, but splits the buffer into
+ * chunks of scanlines which are processed in parallel. */
+void IMB_colormanagement_processor_apply_threaded(ColormanageProcessor *cm_processor,
+                                                  float *buffer,
+                                                  int width,
+                                                  int height,
+                                                  int channels,
+                                                  bool predivide)
+{
+  processor_transform_apply_threaded(
+      NULL, buffer, width, height, channels, cm_processor, predivide, false);
+}
+
 void IMB_colormanagement_processor_apply_byte(
     ColormanageProcessor *cm_processor, unsigned char *buffer, int width, int height, int channels)
 {
@@ -3915,6 +4179,7 @@ void IMB_colormanagement_processor_apply_byte(
    * but for now it's not so important.
    */
   BLI_assert(channels == 4);
+
   float pixel[4];
   for (int y = 0; y < height; y++) {
     for (int x = 0; x < width; x++) {
@@ -3934,6 +4199,9 @@ void IMB_colormanagement_processor_free(ColormanageProcessor *cm_processor)
   if (cm_processor->processor) {
     OCIO_processorRelease(cm_processor->processor);
   }
+  if (cm_processor->byte_lut) {
+    colormanage_byte_lut_free(cm_processor->byte_lut);
+  }
 
   MEM_freeN(cm_processor);
 }
@@ -0,0 +1,104 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation
+ * All rights reserved.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "testing/testing.h"
+
+#include "BLI_threads.h"
+
+#include "IMB_colormanagement.h"
+#include "IMB_imbuf.h"
+
+namespace blender::imbuf::tests {
+
+class ColormanagementTest : public testing::Test {
+ public:
+  static void SetUpTestCase()
+  {
+    testing::Test::SetUpTestCase();
+    BLI_threadapi_init();
+    IMB_init();
+  }
+
+  static void TearDownTestCase()
+  {
+    IMB_exit();
+    BLI_threadapi_exit();
+    testing::Test::TearDownTestCase();
+  }
+};
+
+/* Every combination of byte values in steps of 3, 86^3 pixels. That is enough pixels for the
+ * threaded transform to go through the byte LUT and it covers values on and between LUT nodes. */
+static const int BYTE_STEP = 3;
+static const int BYTE_SAMPLES = 255 / BYTE_STEP + 1;
+
+static std::vector<unsigned char> byte_samples_create()
+{
+  std::vector<unsigned char> buffer;
+  buffer.reserve(size_t(4) * BYTE_SAMPLES * BYTE_SAMPLES * BYTE_SAMPLES);
+  for (int b = 0; b < BYTE_SAMPLES; b++) {
+    for (int g = 0; g < BYTE_SAMPLES; g++) {
+      for (int r = 0; r < BYTE_SAMPLES; r++) {
+        buffer.push_back(r * BYTE_STEP);
+        buffer.push_back(g * BYTE_STEP);
+        buffer.push_back(b * BYTE_STEP);
+        buffer.push_back(255 - r * BYTE_STEP);
+      }
+    }
+  }
+  return buffer;
+}
+
+/* Transform all samples with the threaded byte transform and with the exact per pixel
+ * processor, and return the largest difference of any channel. */
+static int byte_transform_max_error(const char *from_colorspace, const char *to_colorspace)
+{
+  const int width = BYTE_SAMPLES * BYTE_SAMPLES;
+  const int height = BYTE_SAMPLES;
+
+  std::vector<unsigned char> result = byte_samples_create();
+  IMB_colormanagement_transform_byte_threaded(
+      result.data(), width, height, 4, from_colorspace, to_colorspace);
+
+  std::vector<unsigned char> exact = byte_samples_create();
+  ColormanageProcessor *cm_processor = IMB_colormanagement_colorspace_processor_new(
+      from_colorspace, to_colorspace);
+  IMB_colormanagement_processor_apply_byte(cm_processor, exact.data(), width, height, 4);
+  IMB_colormanagement_processor_free(cm_processor);
+
+  int max_error = 0;
+  for (size_t i = 0; i < exact.size(); i++) {
+    if (i % 4 == 3) {
+      EXPECT_EQ(result[i], exact[i]) << "alpha changed at pixel " << i / 4;
+    }
+    max_error = std::max(max_error, std::abs(int(result[i]) - int(exact[i])));
+  }
+  return max_error;
+}
+
+TEST_F(ColormanagementTest, byte_lut_srgb_to_linear)
+{
+  EXPECT_LE(byte_transform_max_error("sRGB", "Linear"), 1);
+}
+
+}  // namespace blender::imbuf::tests
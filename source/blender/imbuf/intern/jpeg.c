@@ -276,16 +276,24 @@ static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int fla
   jpeg_save_markers(cinfo, JPEG_COM, 0xffff);
 
   if (jpeg_read_header(cinfo, false) == JPEG_HEADER_OK) {
-    x = cinfo->image_width;
-    y = cinfo->image_height;
     depth = cinfo->num_components;
 
     if (cinfo->jpeg_color_space == JCS_YCCK) {
       cinfo->out_color_space = JCS_CMYK;
     }
 
+    /* Let IDCT produce image at reduced resolution, this skips most of decoding work. */
+    if ((flags & (IB_reduce_2 | IB_reduce_4)) && !(flags & IB_test)) {
+      cinfo->scale_num = 1;
+      cinfo->scale_denom = (flags & IB_reduce_4) ? 4 : 2;
+      cinfo->dct_method = JDCT_IFAST;
+    }
+
     jpeg_start_decompress(cinfo);
 
+    x = cinfo->output_width;
+    y = cinfo->output_height;
+
     if (flags & IB_test) {
       jpeg_abort_decompress(cinfo);
       ibuf = IMB_allocImBuf(x, y, 8 * depth, 0);
@@ -294,6 +302,13 @@ static ImBuf *ibJpegImageFromCinfo(struct jpeg_decompress_struct *cinfo, int fla
       jpeg_abort_decompress(cinfo);
     }
     else {
+      if (cinfo->scale_denom == 2) {
+        ibuf->flags |= IB_reduce_2;
+      }
+      else if (cinfo->scale_denom == 4) {
+        ibuf->flags |= IB_reduce_4;
+      }
+
       row_stride = cinfo->output_width * depth;
 
       row_pointer = (*cinfo->mem->alloc_sarray)((j_common_ptr)cinfo, JPOOL_IMAGE, row_stride, 1);
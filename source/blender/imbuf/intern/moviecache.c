@@ -30,11 +30,17 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_ghash.h"
+#include "BLI_listbase.h"
+#include "BLI_math_base.h"
 #include "BLI_mempool.h"
 #include "BLI_string.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
+#include "PIL_time.h"
+
+#include "atomic_ops.h"
+
 #include "IMB_moviecache.h"
 
 #include "IMB_imbuf.h"
@@ -53,7 +59,16 @@
 static MEM_CacheLimiterC *limitor = NULL;
 static pthread_mutex_t limitor_lock = BLI_MUTEX_INITIALIZER;
 
+/* All existing caches, used to gather statistics. Protected by limitor_lock. */
+static ListBase caches = {NULL, NULL};
+
+/* Running average of the time it took to produce cached buffers, used to weight eviction
+ * priorities by how expensive an item is to recompute. Protected by limitor_lock. */
+static float average_cost = 0.0f;
+
 typedef struct MovieCache {
+  struct MovieCache *next, *prev;
+
   char name[64];
 
   GHash *hash;
@@ -75,6 +90,26 @@ typedef struct MovieCache {
 
   int totseg, *points, proxy, render_flags; /* for visual statistics optimization */
   int pad;
+
+  /* Key and time of the last lookup which missed, the next put of the same key
+   * measures how long it took to produce the buffer. */
+  void *last_miss_userkey;
+  double last_miss_time;
+
+  /* Counter used to order items by their last use for per-cache eviction. */
+  unsigned int use_counter;
+
+  /* Per-cache memory budget in bytes, 0 means only the global limit applies. */
+  size_t memory_limit;
+  /* Per-cache memory budget as part of the global limit, used when there is no budget in bytes.
+   * Follows changes of the global limit. */
+  float memory_limit_fraction;
+
+  /* Statistics. Updated atomically since items can be destroyed by the global
+   * limiter while putting buffers into another cache. */
+  size_t memory_in_use;
+  uint64_t hits, misses, evictions;
+  int totitem;
 } MovieCache;
 
 typedef struct MovieCacheKey {
@@ -87,8 +122,22 @@ typedef struct MovieCacheItem {
   ImBuf *ibuf;
   MEM_CacheLimiterHandleC *c_handle;
   void *priority_data;
+  /* Memory accounted for this item in the owner's statistics. */
+  size_t size;
+  /* Seconds it took to produce the buffer, 0 when unknown. */
+  float cost;
+  unsigned int last_used;
 } MovieCacheItem;
 
+static void moviecache_item_release_stats(MovieCacheItem *item)
+{
+  MovieCache *cache = item->cache_owner;
+
+  atomic_sub_and_fetch_z(&cache->memory_in_use, item->size);
+  atomic_sub_and_fetch_int32(&cache->totitem, 1);
+  item->size = 0;
+}
+
 static unsigned int moviecache_hashhash(const void *keyv)
 {
   const MovieCacheKey *key = keyv;
@@ -123,6 +172,7 @@ static void moviecache_valfree(void *val)
   if (item->ibuf) {
     MEM_CacheLimiter_unmanage(item->c_handle);
     IMB_freeImBuf(item->ibuf);
+    moviecache_item_release_stats(item);
   }
 
   if (item->priority_data && cache->prioritydeleterfp) {
@@ -178,6 +228,9 @@ static void IMB_moviecache_destructor(void *p)
     item->ibuf = NULL;
     item->c_handle = NULL;
 
+    moviecache_item_release_stats(item);
+    atomic_add_and_fetch_uint64(&cache->evictions, 1);
+
     /* force cached segments to be updated */
     if (cache->points) {
       MEM_freeN(cache->points);
@@ -208,10 +261,21 @@ static size_t get_item_size(void *p)
   return size;
 }
 
+/* Items which took longer than average to produce are kept longer,
+ * cheap ones are evicted sooner. */
+static float get_item_cost_weight(const MovieCacheItem *item)
+{
+  if (item->cost <= 0.0f || average_cost <= 0.0f) {
+    return 1.0f;
+  }
+  return clamp_f(item->cost / average_cost, 0.25f, 4.0f);
+}
+
 static int get_item_priority(void *item_v, int default_priority)
 {
   MovieCacheItem *item = (MovieCacheItem *)item_v;
   MovieCache *cache = item->cache_owner;
+  float weight = get_item_cost_weight(item);
   int priority;
 
   if (!cache->getitempriorityfp) {
@@ -221,14 +285,19 @@ static int get_item_priority(void *item_v, int default_priority)
           item,
           default_priority);
 
-    return default_priority;
+    priority = default_priority;
   }
+  else {
+    priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
 
-  priority = cache->getitempriorityfp(cache->last_userkey, item->priority_data);
-
-  PRINT("%s: cache '%s' item %p priority %d\n", __func__, cache->name, item, priority);
+    PRINT("%s: cache '%s' item %p priority %d\n", __func__, cache->name, item, priority);
+  }
 
-  return priority;
+  /* Lower priority is evicted first, scale to keep some precision when dividing. */
+  if (priority < 0) {
+    return (int)((float)(priority * 16) / weight);
+  }
+  return (int)((float)(priority * 16) * weight);
 }
 
 static bool get_item_destroyable(void *item_v)
@@ -284,6 +353,10 @@ MovieCache *IMB_moviecache_create(const char *name,
   cache->cmpfp = cmpfp;
   cache->proxy = -1;
 
+  BLI_mutex_lock(&limitor_lock);
+  BLI_addtail(&caches, cache);
+  BLI_mutex_unlock(&limitor_lock);
+
   return cache;
 }
 
@@ -304,10 +377,90 @@ void IMB_moviecache_set_priority_callback(struct MovieCache *cache,
   cache->prioritydeleterfp = prioritydeleterfp;
 }
 
+void IMB_moviecache_set_memory_limit(MovieCache *cache, size_t memory_limit)
+{
+  cache->memory_limit = memory_limit;
+}
+
+void IMB_moviecache_set_memory_limit_fraction(MovieCache *cache, float fraction)
+{
+  cache->memory_limit_fraction = fraction;
+}
+
+static size_t moviecache_get_memory_limit(const MovieCache *cache)
+{
+  if (cache->memory_limit) {
+    return cache->memory_limit;
+  }
+  if (cache->memory_limit_fraction > 0.0f) {
+    return (size_t)((double)MEM_CacheLimiter_get_maximum() * cache->memory_limit_fraction);
+  }
+  return 0;
+}
+
+typedef struct MovieCacheEvictCandidate {
+  MovieCacheKey *key;
+  int priority;
+} MovieCacheEvictCandidate;
+
+static int compare_evict_candidate(const void *av, const void *bv)
+{
+  const MovieCacheEvictCandidate *a = av;
+  const MovieCacheEvictCandidate *b = bv;
+  if (a->priority < b->priority) {
+    return -1;
+  }
+  if (a->priority > b->priority) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Evict items of this cache only, until it fits into its own budget. Items are ordered by
+ * priority once, then evicted in that order. */
+static void moviecache_enforce_memory_limit(MovieCache *cache, MovieCacheItem *keep_item)
+{
+  const size_t memory_limit = moviecache_get_memory_limit(cache);
+  if (memory_limit == 0 || cache->memory_in_use <= memory_limit) {
+    return;
+  }
+
+  MovieCacheEvictCandidate *candidates = MEM_malloc_arrayN(
+      BLI_ghash_len(cache->hash), sizeof(*candidates), __func__);
+  int num_candidates = 0;
+
+  GHashIterator gh_iter;
+  GHASH_ITER (gh_iter, cache->hash) {
+    MovieCacheKey *key = BLI_ghashIterator_getKey(&gh_iter);
+    MovieCacheItem *item = BLI_ghashIterator_getValue(&gh_iter);
+
+    if (item == keep_item || item->ibuf == NULL || !get_item_destroyable(item)) {
+      continue;
+    }
+
+    MovieCacheEvictCandidate *candidate = &candidates[num_candidates++];
+    candidate->key = key;
+    candidate->priority = get_item_priority(item,
+                                            -(int)(cache->use_counter - item->last_used));
+  }
+
+  qsort(candidates, num_candidates, sizeof(*candidates), compare_evict_candidate);
+
+  for (int i = 0; i < num_candidates && cache->memory_in_use > memory_limit; i++) {
+    PRINT("%s: cache '%s' evict key %p\n", __func__, cache->name, candidates[i].key);
+
+    BLI_ghash_remove(cache->hash, candidates[i].key, moviecache_keyfree, moviecache_valfree);
+    atomic_add_and_fetch_uint64(&cache->evictions, 1);
+  }
+
+  MEM_freeN(candidates);
+}
+
 static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, bool need_lock)
 {
   MovieCacheKey *key;
   MovieCacheItem *item;
+  float cost = 0.0f;
 
   if (!limitor) {
     IMB_moviecache_init();
@@ -324,10 +477,21 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
 
   PRINT("%s: cache '%s' put %p, item %p\n", __func__, cache->name, ibuf, item);
 
+  if (cache->last_miss_time != 0.0 && !cache->cmpfp(userkey, cache->last_miss_userkey)) {
+    cost = (float)(PIL_check_seconds_timer() - cache->last_miss_time);
+    cache->last_miss_time = 0.0;
+  }
+
   item->ibuf = ibuf;
   item->cache_owner = cache;
   item->c_handle = NULL;
   item->priority_data = NULL;
+  item->size = get_size_in_memory(ibuf);
+  item->cost = cost;
+  item->last_used = ++cache->use_counter;
+
+  atomic_add_and_fetch_z(&cache->memory_in_use, item->size);
+  atomic_add_and_fetch_int32(&cache->totitem, 1);
 
   if (cache->getprioritydatafp) {
     item->priority_data = cache->getprioritydatafp(userkey);
@@ -343,10 +507,15 @@ static void do_moviecache_put(MovieCache *cache, void *userkey, ImBuf *ibuf, boo
     BLI_mutex_lock(&limitor_lock);
   }
 
+  if (cost > 0.0f) {
+    average_cost = (average_cost == 0.0f) ? cost : interpf(cost, average_cost, 0.05f);
+  }
+
   item->c_handle = MEM_CacheLimiter_insert(limitor, item);
 
   MEM_CacheLimiter_ref(item->c_handle);
   MEM_CacheLimiter_enforce_limits(limitor);
+  moviecache_enforce_memory_limit(cache, item);
   MEM_CacheLimiter_unref(item->c_handle);
 
   if (need_lock) {
@@ -413,10 +582,21 @@ ImBuf *IMB_moviecache_get(MovieCache *cache, void *userkey)
 
       IMB_refImBuf(item->ibuf);
 
+      item->last_used = ++cache->use_counter;
+      atomic_add_and_fetch_uint64(&cache->hits, 1);
+
       return item->ibuf;
     }
   }
 
+  if (cache->last_miss_userkey == NULL) {
+    cache->last_miss_userkey = MEM_mallocN(cache->keysize, "movie cache last miss key");
+  }
+  memcpy(cache->last_miss_userkey, userkey, cache->keysize);
+  cache->last_miss_time = PIL_check_seconds_timer();
+
+  atomic_add_and_fetch_uint64(&cache->misses, 1);
+
   return NULL;
 }
 
@@ -436,6 +616,10 @@ void IMB_moviecache_free(MovieCache *cache)
 {
   PRINT("%s: cache '%s' free\n", __func__, cache->name);
 
+  BLI_mutex_lock(&limitor_lock);
+  BLI_remlink(&caches, cache);
+  BLI_mutex_unlock(&limitor_lock);
+
   BLI_ghash_free(cache->hash, moviecache_keyfree, moviecache_valfree);
 
   BLI_mempool_destroy(cache->keys_pool);
@@ -450,9 +634,40 @@ void IMB_moviecache_free(MovieCache *cache)
     MEM_freeN(cache->last_userkey);
   }
 
+  if (cache->last_miss_userkey) {
+    MEM_freeN(cache->last_miss_userkey);
+  }
+
   MEM_freeN(cache);
 }
 
+void IMB_moviecache_get_stats(MovieCache *cache, MovieCacheStats *r_stats)
+{
+  r_stats->hits = cache->hits;
+  r_stats->misses = cache->misses;
+  r_stats->evictions = cache->evictions;
+  r_stats->memory_in_use = cache->memory_in_use;
+  r_stats->memory_limit = moviecache_get_memory_limit(cache);
+  r_stats->totitem = cache->totitem;
+}
+
+/* Call callback for every existing cache, for statistics display. */
+void IMB_moviecache_stats_foreach(void (*callback)(const char *name,
+                                                   const MovieCacheStats *stats,
+                                                   void *userdata),
+                                  void *userdata)
+{
+  BLI_mutex_lock(&limitor_lock);
+
+  LISTBASE_FOREACH (MovieCache *, cache, &caches) {
+    MovieCacheStats stats;
+    IMB_moviecache_get_stats(cache, &stats);
+    callback(cache->name, &stats, userdata);
+  }
+
+  BLI_mutex_unlock(&limitor_lock);
+}
+
 void IMB_moviecache_cleanup(MovieCache *cache,
                             bool(cleanup_check_cb)(ImBuf *ibuf, void *userkey, void *userdata),
                             void *userdata)
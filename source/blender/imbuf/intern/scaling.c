@@ -35,6 +35,10 @@
 
 #include "BLI_sys_types.h"  // for intptr_t support
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 static void imb_half_x_no_alloc(struct ImBuf *ibuf2, struct ImBuf *ibuf1)
 {
   uchar *p1, *_p1, *dest;
@@ -1874,3 +1878,233 @@ void IMB_scaleImBuf_threaded(ImBuf *ibuf, unsigned int newx, unsigned int newy)
     ibuf->rect_float = init_data.float_buffer;
   }
 }
+
+/* ******** threaded box filter downscaling ******** */
+
+/* Each output pixel is average of box of source pixels, which has size of integer part of
+ * scale factor. This is much faster than IMB_scaleImBuf and gives smoother result than
+ * IMB_scalefastImBuf, which is good fit for preview of large images. */
+
+typedef struct ScaleBoxThreadData {
+  ImBuf *ibuf;
+
+  unsigned int newx;
+  unsigned int newy;
+
+  int start_line;
+  int tot_line;
+
+  unsigned char *byte_buffer;
+  float *float_buffer;
+} ScaleBoxThreadData;
+
+static void scale_box_thread_init(void *data_v, int start_line, int tot_line, void *init_data_v)
+{
+  ScaleBoxThreadData *data = (ScaleBoxThreadData *)data_v;
+  ScaleTreadInitData *init_data = (ScaleTreadInitData *)init_data_v;
+
+  data->ibuf = init_data->ibuf;
+
+  data->newx = init_data->newx;
+  data->newy = init_data->newy;
+
+  data->start_line = start_line;
+  data->tot_line = tot_line;
+
+  data->byte_buffer = init_data->byte_buffer;
+  data->float_buffer = init_data->float_buffer;
+}
+
+/* Byte buffer has straight alpha, so colors are weighted by alpha. */
+static void scale_box_byte_pixel(const unsigned char *rect,
+                                 int stride,
+                                 int box_x,
+                                 int box_y,
+                                 unsigned char *r_pixel)
+{
+  uint64_t sum[4];
+
+#ifdef __SSE2__
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i mask_alpha = _mm_set_epi16(0, 0, 0, 0, -1, 0, 0, 0);
+  const __m128i alpha_weight = _mm_set_epi16(0, 0, 0, 0, 255, 0, 0, 0);
+  __m128i acc = _mm_setzero_si128();
+
+  for (int y = 0; y < box_y; y++) {
+    const unsigned char *src = rect + (size_t)y * stride;
+    for (int x = 0; x < box_x; x++, src += 4) {
+      int value;
+      memcpy(&value, src, sizeof(value));
+      const __m128i px = _mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero);
+      /* Multiply colors by alpha and alpha by 255, values fit into 16 bits. */
+      __m128i weight = _mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3));
+      weight = _mm_or_si128(_mm_andnot_si128(mask_alpha, weight), alpha_weight);
+      const __m128i weighted = _mm_mullo_epi16(px, weight);
+      acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(weighted, zero));
+    }
+  }
+
+  unsigned int acc_values[4];
+  _mm_storeu_si128((__m128i *)acc_values, acc);
+  for (int i = 0; i < 4; i++) {
+    sum[i] = acc_values[i];
+  }
+#else
+  sum[0] = sum[1] = sum[2] = sum[3] = 0;
+  for (int y = 0; y < box_y; y++) {
+    const unsigned char *src = rect + (size_t)y * stride;
+    for (int x = 0; x < box_x; x++, src += 4) {
+      sum[0] += src[0] * src[3];
+      sum[1] += src[1] * src[3];
+      sum[2] += src[2] * src[3];
+      sum[3] += src[3] * 255;
+    }
+  }
+#endif
+
+  if (sum[3] == 0) {
+    r_pixel[0] = r_pixel[1] = r_pixel[2] = r_pixel[3] = 0;
+    return;
+  }
+
+  const uint64_t tot = (uint64_t)box_x * box_y * 255;
+  for (int i = 0; i < 3; i++) {
+    r_pixel[i] = (unsigned char)((sum[i] * 255 + sum[3] / 2) / sum[3]);
+  }
+  r_pixel[3] = (unsigned char)((sum[3] + tot / 2) / tot);
+}
+
+/* Float buffer is premultiplied, so all channels are averaged. */
+static void scale_box_float_pixel(
+    const float *rect, int stride, int channels, int box_x, int box_y, float *r_pixel)
+{
+  const float weight = 1.0f / (box_x * box_y);
+
+#ifdef __SSE2__
+  if (channels == 4) {
+    __m128 acc = _mm_setzero_ps();
+    for (int y = 0; y < box_y; y++) {
+      const float *src = rect + (size_t)y * stride;
+      for (int x = 0; x < box_x; x++, src += 4) {
+        acc = _mm_add_ps(acc, _mm_loadu_ps(src));
+      }
+    }
+    _mm_storeu_ps(r_pixel, _mm_mul_ps(acc, _mm_set1_ps(weight)));
+    return;
+  }
+#endif
+
+  for (int c = 0; c < channels; c++) {
+    r_pixel[c] = 0.0f;
+  }
+  for (int y = 0; y < box_y; y++) {
+    const float *src = rect + (size_t)y * stride;
+    for (int x = 0; x < box_x; x++, src += channels) {
+      for (int c = 0; c < channels; c++) {
+        r_pixel[c] += src[c];
+      }
+    }
+  }
+  for (int c = 0; c < channels; c++) {
+    r_pixel[c] *= weight;
+  }
+}
+
+static void *do_scale_box_thread(void *data_v)
+{
+  ScaleBoxThreadData *data = (ScaleBoxThreadData *)data_v;
+  ImBuf *ibuf = data->ibuf;
+  const int channels = ibuf->channels;
+  const float factor_x = (float)ibuf->x / data->newx;
+  const float factor_y = (float)ibuf->y / data->newy;
+  const int box_x = max_ii((int)factor_x, 1);
+  const int box_y = max_ii((int)factor_y, 1);
+
+  for (int i = 0; i < data->tot_line; i++) {
+    const int y = data->start_line + i;
+    const int src_y = min_ii((int)(y * factor_y), ibuf->y - box_y);
+
+    for (int x = 0; x < data->newx; x++) {
+      const int src_x = min_ii((int)(x * factor_x), ibuf->x - box_x);
+      const size_t offset = (size_t)y * data->newx + x;
+      const size_t src_offset = (size_t)src_y * ibuf->x + src_x;
+
+      if (data->byte_buffer) {
+        scale_box_byte_pixel((unsigned char *)(ibuf->rect + src_offset),
+                             ibuf->x * 4,
+                             box_x,
+                             box_y,
+                             data->byte_buffer + 4 * offset);
+      }
+
+      if (data->float_buffer) {
+        scale_box_float_pixel(ibuf->rect_float + channels * src_offset,
+                              ibuf->x * channels,
+                              channels,
+                              box_x,
+                              box_y,
+                              data->float_buffer + channels * offset);
+      }
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * Downscale \a ibuf using box filter, falls back to #IMB_scalefastImBuf when enlarging.
+ * Return true if \a ibuf is modified.
+ */
+bool IMB_scale_box_threaded(struct ImBuf *ibuf, unsigned int newx, unsigned int newy)
+{
+  ScaleTreadInitData init_data = {NULL};
+
+  if (ibuf == NULL || (ibuf->rect == NULL && ibuf->rect_float == NULL)) {
+    return false;
+  }
+
+  if (newx == ibuf->x && newy == ibuf->y) {
+    return false;
+  }
+
+  if (newx > ibuf->x || newy > ibuf->y) {
+    return IMB_scalefastImBuf(ibuf, newx, newy);
+  }
+
+  init_data.ibuf = ibuf;
+
+  init_data.newx = newx;
+  init_data.newy = newy;
+
+  if (ibuf->rect) {
+    init_data.byte_buffer = MEM_mallocN(4 * newx * newy * sizeof(char), "box scale byte buffer");
+  }
+
+  if (ibuf->rect_float) {
+    init_data.float_buffer = MEM_mallocN(ibuf->channels * newx * newy * sizeof(float),
+                                         "box scale float buffer");
+  }
+
+  IMB_processor_apply_threaded(
+      newy, sizeof(ScaleBoxThreadData), &init_data, scale_box_thread_init, do_scale_box_thread);
+
+  /* Z-buffers are not averaged, use nearest sample like fast scaling does. */
+  scalefast_Z_ImBuf(ibuf, newx, newy);
+
+  ibuf->x = newx;
+  ibuf->y = newy;
+
+  if (ibuf->rect) {
+    imb_freerectImBuf(ibuf);
+    ibuf->mall |= IB_rect;
+    ibuf->rect = (unsigned int *)init_data.byte_buffer;
+  }
+
+  if (ibuf->rect_float) {
+    imb_freerectfloatImBuf(ibuf);
+    ibuf->mall |= IB_rectfloat;
+    ibuf->rect_float = init_data.float_buffer;
+  }
+
+  return true;
+}
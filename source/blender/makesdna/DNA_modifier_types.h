@@ -156,6 +156,7 @@ typedef enum {
   eSubsurfModifierFlag_SubsurfUv_DEPRECATED = (1 << 3),
   eSubsurfModifierFlag_UseCrease = (1 << 4),
   eSubsurfModifierFlag_UseCustomNormals = (1 << 5),
+  eSubsurfModifierFlag_UseAdaptiveViewport = (1 << 6),
 } SubsurfModifierFlag;
 
 typedef enum {
@@ -178,7 +179,8 @@ typedef struct SubsurfModifierData {
   short subdivType, levels, renderLevels, flags;
   short uv_smooth;
   short quality;
-  char _pad[4];
+  /** Length of the subdivided edges on screen with adaptive viewport levels. */
+  float adaptive_pixel_size;
 
   /* TODO(sergey): Get rid of those with the old CCG subdivision code. */
   void *emCache, *mCache;
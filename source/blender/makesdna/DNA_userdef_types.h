@@ -623,8 +623,9 @@ typedef struct UserDef_Experimental {
   char use_new_hair_type;
   char use_cycles_debug;
   char use_sculpt_vertex_colors;
-  /** `makesdna` does not allow empty structs. */
-  char _pad[3];
+  char use_draw_mesh_clusters;
+  char use_sculpt_pbvh_sah;
+  char use_sculpt_grids_paging;
 } UserDef_Experimental;
 
 #define USER_EXPERIMENTAL_TEST(userdef, member) \
@@ -877,7 +878,8 @@ typedef struct UserDef {
   int sequencer_disk_cache_compression; /* eUserpref_DiskCacheCompression */
   int sequencer_disk_cache_size_limit;
   short sequencer_disk_cache_flag;
-  char _pad5[2];
+  /** Number of sequencer prefetch threads, 0 for automatic. */
+  short sequencer_prefetch_threads;
 
   float collection_instance_empty_size;
   char _pad10[3];
@@ -1806,6 +1806,24 @@ static void rna_def_modifier_subsurf(BlenderRNA *brna)
   RNA_def_property_ui_text(
       prop, "Render Levels", "Number of subdivisions to perform when rendering");
 
+  prop = RNA_def_property(srna, "use_adaptive_viewport_levels", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "flags", eSubsurfModifierFlag_UseAdaptiveViewport);
+  RNA_def_property_ui_text(prop,
+                           "Adaptive Viewport Levels",
+                           "Use fewer subdivisions in the viewport for objects which are small on "
+                           "screen, as seen from the scene camera");
+  RNA_def_property_update(prop, 0, "rna_Modifier_dependency_update");
+
+  prop = RNA_def_property(srna, "adaptive_pixel_size", PROP_FLOAT, PROP_PIXEL);
+  RNA_def_property_float_sdna(prop, NULL, "adaptive_pixel_size");
+  RNA_def_property_range(prop, 1.0f, 1000.0f);
+  RNA_def_property_ui_range(prop, 1.0f, 100.0f, 100, 1);
+  RNA_def_property_ui_text(prop,
+                           "Pixel Size",
+                           "Length of the subdivided edges on screen with adaptive viewport "
+                           "levels, up to the number of viewport levels");
+  RNA_def_property_update(prop, 0, "rna_Modifier_update");
+
   prop = RNA_def_property(srna, "show_only_control_edges", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "flags", eSubsurfModifierFlag_ControlEdges);
   RNA_def_property_ui_text(
@@ -36,6 +36,7 @@
 
 #include "BKE_addon.h"
 #include "BKE_appdir.h"
+#include "BKE_sequencer.h"
 #include "BKE_sound.h"
 #include "BKE_studiolight.h"
 
@@ -5292,6 +5293,14 @@ static void rna_def_userdef_system(BlenderRNA *brna)
   RNA_def_property_ui_text(prop, "Memory Cache Limit", "Memory cache limit (in megabytes)");
   RNA_def_property_update(prop, 0, "rna_Userdef_memcache_update");
 
+  prop = RNA_def_property(srna, "sequencer_prefetch_threads", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "sequencer_prefetch_threads");
+  RNA_def_property_range(prop, 0, SEQ_PREFETCH_THREADS_MAX);
+  RNA_def_property_ui_text(prop,
+                           "Prefetch Threads",
+                           "Number of threads used to render frames ahead of playhead "
+                           "(0 for automatic)");
+
   /* Sequencer disk cache */
 
   prop = RNA_def_property(srna, "use_sequencer_disk_cache", PROP_BOOLEAN, PROP_NONE);
@@ -6117,6 +6126,31 @@ static void rna_def_userdef_experimental(BlenderRNA *brna)
   prop = RNA_def_property(srna, "use_sculpt_vertex_colors", PROP_BOOLEAN, PROP_NONE);
   RNA_def_property_boolean_sdna(prop, NULL, "use_sculpt_vertex_colors", 1);
   RNA_def_property_ui_text(prop, "Sculpt Vertex Colors", "Use the new Vertex Painting system");
+
+  prop = RNA_def_property(srna, "use_draw_mesh_clusters", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "use_draw_mesh_clusters", 1);
+  RNA_def_property_ui_text(
+      prop,
+      "Mesh Cluster Culling",
+      "Sort the faces of meshes that are not in edit-mode by location and skip drawing the "
+      "groups of faces outside of the view");
+  RNA_def_property_update(prop, 0, "rna_userdef_update");
+
+  prop = RNA_def_property(srna, "use_sculpt_pbvh_sah", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "use_sculpt_pbvh_sah", 1);
+  RNA_def_property_ui_text(
+      prop,
+      "Sculpt SAH Tree",
+      "Split the sculpt acceleration tree using the surface area heuristic, which builds slower "
+      "but gives faster ray-casts");
+
+  prop = RNA_def_property(srna, "use_sculpt_grids_paging", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(prop, NULL, "use_sculpt_grids_paging", 1);
+  RNA_def_property_ui_text(
+      prop,
+      "Sculpt Multires Paging",
+      "Keep multires grids in a swap file in the temporary directory and only the parts of the "
+      "mesh which were sculpted recently in memory, to sculpt meshes which don't fit in memory");
 }
 
 static void rna_def_userdef_addon_collection(BlenderRNA *brna, PropertyRNA *cprop)
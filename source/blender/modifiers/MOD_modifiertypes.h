@@ -91,6 +91,10 @@ extern ModifierTypeInfo modifierType_Simulation;
 /* MOD_util.c */
 void modifier_type_init(ModifierTypeInfo *types[]);
 
+/* MOD_subsurf.c */
+struct Depsgraph;
+void MOD_subsurf_adaptive_levels_tag_update(struct Depsgraph *depsgraph);
+
 #ifdef __cplusplus
 }
 #endif
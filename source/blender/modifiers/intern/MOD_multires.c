@@ -33,6 +33,7 @@
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 #include "DNA_screen_types.h"
+#include "DNA_userdef_types.h"
 
 #include "BKE_cdderivedmesh.h"
 #include "BKE_context.h"
@@ -190,6 +191,8 @@ static void multires_ccg_settings_init(SubdivToCCGSettings *settings,
   settings->resolution = (1 << level) + 1;
   settings->need_normal = true;
   settings->need_mask = has_mask;
+  /* Grids are only created for sculpting, see #modifyMesh. */
+  settings->use_paging = USER_EXPERIMENTAL_TEST(&U, use_sculpt_grids_paging);
 }
 
 static Mesh *multires_as_ccg(MultiresModifierData *mmd,
@@ -26,15 +26,20 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_listbase.h"
+#include "BLI_math.h"
+#include "BLI_rect.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
 
 #include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 #include "DNA_screen_types.h"
 
+#include "BKE_camera.h"
 #include "BKE_context.h"
 #include "BKE_mesh.h"
 #include "BKE_scene.h"
@@ -65,6 +70,13 @@
 typedef struct SubsurfRuntimeData {
   /* Cached subdivision surface descriptor, with topology and settings. */
   struct Subdiv *subdiv;
+  /* Viewport levels picked from the screen size of the object on the previous
+   * evaluation, -1 when not picked yet. */
+  int adaptive_levels;
+  /* Bounds and average edge length of the coarse mesh in object space, from the previous
+   * evaluation. Used to check if the levels change without evaluating the mesh. */
+  float adaptive_min[3], adaptive_max[3];
+  float adaptive_edge_length;
 } SubsurfRuntimeData;
 
 static void initData(ModifierData *md)
@@ -75,6 +87,7 @@ static void initData(ModifierData *md)
   smd->renderLevels = 2;
   smd->uv_smooth = SUBSURF_UV_SMOOTH_PRESERVE_CORNERS;
   smd->quality = 3;
+  smd->adaptive_pixel_size = 8.0f;
   smd->flags |= (eSubsurfModifierFlag_UseCrease | eSubsurfModifierFlag_ControlEdges);
 }
 
@@ -117,7 +130,7 @@ static void freeRuntimeData(void *runtime_data_v)
   }
   SubsurfRuntimeData *runtime_data = (SubsurfRuntimeData *)runtime_data_v;
   if (runtime_data->subdiv != NULL) {
-    BKE_subdiv_free(runtime_data->subdiv);
+    BKE_subdiv_release(runtime_data->subdiv);
   }
   MEM_freeN(runtime_data);
 }
@@ -145,13 +158,198 @@ static bool isDisabled(const Scene *scene, ModifierData *md, bool useRenderParam
   return get_render_subsurf_level(&scene->r, levels, useRenderParams != 0) == 0;
 }
 
+static bool subdiv_use_adaptive_levels(const SubsurfModifierData *smd,
+                                       const ModifierEvalContext *ctx)
+{
+  return (smd->flags & eSubsurfModifierFlag_UseAdaptiveViewport) &&
+         !(ctx->flag & (MOD_APPLY_RENDER | MOD_APPLY_TO_BASE_MESH));
+}
+
 static int subdiv_levels_for_modifier_get(const SubsurfModifierData *smd,
                                           const ModifierEvalContext *ctx)
 {
   Scene *scene = DEG_get_evaluated_scene(ctx->depsgraph);
   const bool use_render_params = (ctx->flag & MOD_APPLY_RENDER);
   const int requested_levels = (use_render_params) ? smd->renderLevels : smd->levels;
-  return get_render_subsurf_level(&scene->r, requested_levels, use_render_params);
+  const int levels = get_render_subsurf_level(&scene->r, requested_levels, use_render_params);
+  if (subdiv_use_adaptive_levels(smd, ctx)) {
+    const SubsurfRuntimeData *runtime_data = (SubsurfRuntimeData *)smd->modifier.runtime;
+    return min_ii(levels, runtime_data->adaptive_levels);
+  }
+  return levels;
+}
+
+/* Adaptive viewport levels.
+ *
+ * Every level halves the length of the edges, the levels are picked so that the
+ * subdivided edges are about adaptive_pixel_size long on screen, as seen from the
+ * scene camera. The view of the 3D viewports is not known during evaluation.
+ *
+ * There are no relations to the camera and object transforms, the levels are checked
+ * after every viewport depsgraph update instead and the geometry is only tagged for
+ * update when they change, see MOD_subsurf_adaptive_levels_tag_update(). */
+
+/* Test a bounding sphere in camera space against the view frustum of the camera. */
+static bool subdiv_adaptive_sphere_in_view(const CameraParams *params,
+                                           const float center[3],
+                                           const float radius)
+{
+  const rctf *viewplane = &params->viewplane;
+  const float depth = -center[2];
+  if (depth + radius < params->clip_start || depth - radius > params->clip_end) {
+    return false;
+  }
+  if (params->is_ortho) {
+    return center[0] + radius >= viewplane->xmin && center[0] - radius <= viewplane->xmax &&
+           center[1] + radius >= viewplane->ymin && center[1] - radius <= viewplane->ymax;
+  }
+  /* Side planes go through the camera and the edges of the view plane at clip start. */
+  const float clip_start = params->clip_start;
+  const float side_planes[4][3] = {
+      {-clip_start, 0.0f, -viewplane->xmin},
+      {clip_start, 0.0f, viewplane->xmax},
+      {0.0f, -clip_start, -viewplane->ymin},
+      {0.0f, clip_start, viewplane->ymax},
+  };
+  for (int i = 0; i < 4; i++) {
+    float normal[3];
+    normalize_v3_v3(normal, side_planes[i]);
+    if (dot_v3v3(normal, center) > radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Bounds and average edge length of the coarse mesh, in object space. */
+static void subdiv_adaptive_stats_compute(SubsurfRuntimeData *runtime_data, const Mesh *mesh)
+{
+  INIT_MINMAX(runtime_data->adaptive_min, runtime_data->adaptive_max);
+  for (int i = 0; i < mesh->totvert; i++) {
+    minmax_v3v3_v3(runtime_data->adaptive_min, runtime_data->adaptive_max, mesh->mvert[i].co);
+  }
+  float edge_length = 0.0f;
+  for (int i = 0; i < mesh->totedge; i++) {
+    const MEdge *edge = &mesh->medge[i];
+    edge_length += len_v3v3(mesh->mvert[edge->v1].co, mesh->mvert[edge->v2].co);
+  }
+  runtime_data->adaptive_edge_length = (mesh->totedge != 0) ? edge_length / mesh->totedge :
+                                                              0.0f;
+}
+
+/* Levels needed for the coarse edges to get short enough on screen, not rounded. */
+static float subdiv_adaptive_levels_compute(const SubsurfModifierData *smd,
+                                            const SubsurfRuntimeData *runtime_data,
+                                            const Scene *scene,
+                                            const Object *object)
+{
+  Object *camera = scene->camera;
+  if (camera == NULL || camera->type != OB_CAMERA || runtime_data->adaptive_edge_length <= 0.0f) {
+    return FLT_MAX;
+  }
+
+  /* Average edge length and bounding sphere of the coarse mesh, in world space. */
+  const float scale = mat4_to_scale(object->obmat);
+  const float edge_length = runtime_data->adaptive_edge_length * scale;
+  const float radius = len_v3v3(runtime_data->adaptive_min, runtime_data->adaptive_max) * 0.5f *
+                       scale;
+  float center[3];
+  mid_v3_v3v3(center, runtime_data->adaptive_min, runtime_data->adaptive_max);
+  mul_m4_v3(object->obmat, center);
+
+  CameraParams params;
+  BKE_camera_params_init(&params);
+  BKE_camera_params_from_object(&params, camera);
+  const int winx = max_ii(scene->r.xsch * scene->r.size / 100, 1);
+  const int winy = max_ii(scene->r.ysch * scene->r.size / 100, 1);
+  BKE_camera_params_compute_viewplane(&params, winx, winy, scene->r.xasp, scene->r.yasp);
+
+  /* Objects the camera doesn't see may still be seen in the 3D viewports, they get the
+   * viewport levels. */
+  float view_center[3];
+  float viewmat[4][4];
+  normalize_m4_m4(viewmat, camera->obmat);
+  invert_m4(viewmat);
+  mul_v3_m4v3(view_center, viewmat, center);
+  if (!subdiv_adaptive_sphere_in_view(&params, view_center, radius)) {
+    return FLT_MAX;
+  }
+
+  /* Size of a pixel, at the clip start distance for perspective cameras. */
+  float pixel_size = BLI_rctf_size_x(&params.viewplane) / winx;
+  if (!params.is_ortho) {
+    /* Use the part of the object nearest to the camera. */
+    const float depth = max_ff(-view_center[2] - radius, params.clip_start);
+    pixel_size *= depth / params.clip_start;
+  }
+  if (pixel_size <= 0.0f) {
+    return FLT_MAX;
+  }
+
+  const float edge_pixels = edge_length / pixel_size;
+  return log2f(max_ff(edge_pixels, 1e-6f) / max_ff(smd->adaptive_pixel_size, 1.0f));
+}
+
+/* Switch levels only when the screen size changed past the point where the other level is
+ * needed by some margin, to avoid levels popping back and forth. */
+#define ADAPTIVE_LEVELS_HYSTERESIS 0.25f
+
+static int subdiv_adaptive_levels_pick(const SubsurfModifierData *smd,
+                                       const SubsurfRuntimeData *runtime_data,
+                                       const Scene *scene,
+                                       const Object *object)
+{
+  const float levels_max = (float)smd->levels;
+  const float levels_exact = clamp_f(
+      subdiv_adaptive_levels_compute(smd, runtime_data, scene, object), -1.0f, levels_max);
+  const int levels = runtime_data->adaptive_levels;
+  if (levels < 0 || levels_exact > levels + ADAPTIVE_LEVELS_HYSTERESIS ||
+      levels_exact < levels - 1 - ADAPTIVE_LEVELS_HYSTERESIS) {
+    return max_ii((int)ceilf(levels_exact), 0);
+  }
+  return levels;
+}
+
+static void subdiv_adaptive_levels_update(SubsurfModifierData *smd,
+                                          const ModifierEvalContext *ctx,
+                                          const Mesh *mesh)
+{
+  SubsurfRuntimeData *runtime_data = (SubsurfRuntimeData *)smd->modifier.runtime;
+  subdiv_adaptive_stats_compute(runtime_data, mesh);
+  runtime_data->adaptive_levels = subdiv_adaptive_levels_pick(
+      smd, runtime_data, DEG_get_evaluated_scene(ctx->depsgraph), ctx->object);
+}
+
+void MOD_subsurf_adaptive_levels_tag_update(Depsgraph *depsgraph)
+{
+  if (DEG_get_mode(depsgraph) != DAG_EVAL_VIEWPORT) {
+    return;
+  }
+  const Scene *scene = DEG_get_evaluated_scene(depsgraph);
+  DEG_OBJECT_ITER_BEGIN (depsgraph,
+                         object,
+                         DEG_ITER_OBJECT_FLAG_LINKED_DIRECTLY |
+                             DEG_ITER_OBJECT_FLAG_LINKED_VIA_SET | DEG_ITER_OBJECT_FLAG_VISIBLE) {
+    if (object->type == OB_MESH) {
+      LISTBASE_FOREACH (ModifierData *, md, &object->modifiers) {
+        SubsurfModifierData *smd = (SubsurfModifierData *)md;
+        SubsurfRuntimeData *runtime_data = (SubsurfRuntimeData *)md->runtime;
+        if (md->type != eModifierType_Subsurf || !(md->mode & eModifierMode_Realtime) ||
+            !(smd->flags & eSubsurfModifierFlag_UseAdaptiveViewport) || runtime_data == NULL ||
+            runtime_data->adaptive_levels < 0) {
+          continue;
+        }
+        /* Stored right away, so a modifier which doesn't get evaluated isn't tagged again on
+         * every update. The evaluation picks the same levels. */
+        const int levels = subdiv_adaptive_levels_pick(smd, runtime_data, scene, object);
+        if (levels != runtime_data->adaptive_levels) {
+          runtime_data->adaptive_levels = levels;
+          DEG_id_tag_update(DEG_get_original_id(&object->id), ID_RECALC_GEOMETRY);
+        }
+      }
+    }
+  }
+  DEG_OBJECT_ITER_END;
 }
 
 static void subdiv_settings_init(SubdivSettings *settings, const SubsurfModifierData *smd)
@@ -214,6 +412,7 @@ static void subdiv_ccg_settings_init(SubdivToCCGSettings *settings,
   settings->resolution = (1 << level) + 1;
   settings->need_normal = true;
   settings->need_mask = false;
+  settings->use_paging = false;
 }
 
 static Mesh *subdiv_as_ccg(SubsurfModifierData *smd,
@@ -236,6 +435,7 @@ static SubsurfRuntimeData *subsurf_ensure_runtime(SubsurfModifierData *smd)
   SubsurfRuntimeData *runtime_data = (SubsurfRuntimeData *)smd->modifier.runtime;
   if (runtime_data == NULL) {
     runtime_data = MEM_callocN(sizeof(*runtime_data), "subsurf runtime");
+    runtime_data->adaptive_levels = -1;
     smd->modifier.runtime = runtime_data;
   }
   return runtime_data;
@@ -258,6 +458,12 @@ static Mesh *modifyMesh(ModifierData *md, const ModifierEvalContext *ctx, Mesh *
   }
   BKE_subdiv_settings_validate_for_mesh(&subdiv_settings, mesh);
   SubsurfRuntimeData *runtime_data = subsurf_ensure_runtime(smd);
+  if (subdiv_use_adaptive_levels(smd, ctx)) {
+    subdiv_adaptive_levels_update(smd, ctx, mesh);
+    if (subdiv_levels_for_modifier_get(smd, ctx) == 0) {
+      return result;
+    }
+  }
   Subdiv *subdiv = subdiv_descriptor_ensure(smd, &subdiv_settings, mesh);
   if (subdiv == NULL) {
     /* Happens on bad topology, but also on empty input mesh. */
@@ -422,6 +628,11 @@ static void panel_draw(const bContext *C, Panel *panel)
     uiItemR(col, &ptr, "render_levels", 0, IFACE_("Render"), ICON_NONE);
   }
 
+  uiItemR(layout, &ptr, "use_adaptive_viewport_levels", 0, NULL, ICON_NONE);
+  uiLayout *row = uiLayoutRow(layout, false);
+  uiLayoutSetActive(row, RNA_boolean_get(&ptr, "use_adaptive_viewport_levels"));
+  uiItemR(row, &ptr, "adaptive_pixel_size", 0, NULL, ICON_NONE);
+
   uiItemR(layout, &ptr, "show_only_control_edges", 0, NULL, ICON_NONE);
 
   modifier_panel_end(layout, &ptr);
@@ -53,6 +53,8 @@
 
 #include "DNA_ID.h"
 
+#include "IMB_moviecache.h"
+
 #include "UI_interface_icons.h"
 
 /* for notifiers */
@@ -391,6 +393,52 @@ static PyObject *bpy_app_autoexec_fail_message_get(PyObject *UNUSED(self), void
   return PyC_UnicodeFromByte(G.autoexec_fail);
 }
 
+static void bpy_app_moviecache_stats_add(const char *name,
+                                         const MovieCacheStats *stats,
+                                         void *userdata)
+{
+  PyObject *dict = userdata;
+  PyObject *item = PyDict_GetItemString(dict, name);
+  MovieCacheStats total = *stats;
+
+  /* Caches of the same kind (one per image, clip, ...) share a name, accumulate them. */
+  if (item) {
+    total.hits += PyLong_AsUnsignedLongLong(PyDict_GetItemString(item, "hits"));
+    total.misses += PyLong_AsUnsignedLongLong(PyDict_GetItemString(item, "misses"));
+    total.evictions += PyLong_AsUnsignedLongLong(PyDict_GetItemString(item, "evictions"));
+    total.memory_in_use += PyLong_AsSize_t(PyDict_GetItemString(item, "memory_in_use"));
+    total.memory_limit += PyLong_AsSize_t(PyDict_GetItemString(item, "memory_limit"));
+    total.totitem += PyLong_AsLong(PyDict_GetItemString(item, "items"));
+  }
+
+  item = Py_BuildValue("{s:K,s:K,s:K,s:n,s:n,s:i}",
+                       "hits",
+                       (unsigned long long)total.hits,
+                       "misses",
+                       (unsigned long long)total.misses,
+                       "evictions",
+                       (unsigned long long)total.evictions,
+                       "memory_in_use",
+                       (Py_ssize_t)total.memory_in_use,
+                       "memory_limit",
+                       (Py_ssize_t)total.memory_limit,
+                       "items",
+                       total.totitem);
+  PyDict_SetItemString(dict, name, item);
+  Py_DECREF(item);
+}
+
+PyDoc_STRVAR(bpy_app_moviecache_stats_doc,
+             "Statistics of the image, movie clip and color management caches, "
+             "a dictionary mapping cache names to hits, misses, evictions, items, "
+             "memory_in_use and memory_limit (read-only)");
+static PyObject *bpy_app_moviecache_stats_get(PyObject *UNUSED(self), void *UNUSED(closure))
+{
+  PyObject *dict = PyDict_New();
+  IMB_moviecache_stats_foreach(bpy_app_moviecache_stats_add, dict);
+  return dict;
+}
+
 static PyGetSetDef bpy_app_getsets[] = {
     {"debug", bpy_app_debug_get, bpy_app_debug_set, bpy_app_debug_doc, (void *)G_DEBUG},
     {"debug_ffmpeg",
@@ -506,6 +554,8 @@ static PyGetSetDef bpy_app_getsets[] = {
      NULL,
      (void *)G_FLAG_SCRIPT_AUTOEXEC_FAIL_QUIET},
     {"autoexec_fail_message", bpy_app_autoexec_fail_message_get, NULL, NULL, NULL},
+
+    {"moviecache_stats", bpy_app_moviecache_stats_get, NULL, bpy_app_moviecache_stats_doc, NULL},
     {NULL, NULL, NULL, NULL, NULL},
 };
 
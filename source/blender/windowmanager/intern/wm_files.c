@@ -85,6 +85,7 @@
 #include "BKE_scene.h"
 #include "BKE_screen.h"
 #include "BKE_sound.h"
+#include "BKE_subdiv.h"
 #include "BKE_undo_system.h"
 #include "BKE_workspace.h"
 
@@ -569,6 +570,8 @@ static void wm_file_read_post(bContext *C,
       wm_window_ghostwindows_remove_invalid(C, wm);
     }
     CTX_wm_window_set(C, wm->windows.first);
+    /* Subdivision descriptors released by the previous file won't be re-used. */
+    BKE_subdiv_cache_flush();
   }
 
 #ifdef WITH_PYTHON
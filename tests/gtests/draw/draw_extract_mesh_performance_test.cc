@@ -0,0 +1,236 @@
+/* Apache License, Version 2.0 */
+
+/* Benchmark of the mesh extraction into GPU buffers, without a GPU.
+ *
+ * Every `MeshExtract` (and some combinations used together when drawing) runs on a grid mesh
+ * through the same threaded path as the viewport, writing into the CPU side of the buffers.
+ * Reports the time per loop for each number of threads and the scaling compared to one thread.
+ *
+ * Run with `draw_extract_mesh_performance_test [--grid_size=N] [--runs=N] [--max_threads=N]`,
+ * `--gtest_filter` selects the extractions. */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_customdata.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+
+#include "GPU_batch.h"
+
+#include "PIL_time.h"
+
+#include "draw_cache_extract.h"
+}
+
+DEFINE_int32(grid_size, 512, "Number of quads along each side of the benchmark grid.");
+DEFINE_int32(runs, 10, "Number of extractions averaged for each measurement.");
+DEFINE_int32(max_threads, 0, "Highest number of threads to measure, 0 uses all system threads.");
+
+/* Smooth shaded wavy grid with a UV map, so normals and tangents do real work. */
+static Mesh *grid_mesh_create(const int size)
+{
+  const int verts_len = (size + 1) * (size + 1);
+  const int polys_len = size * size;
+  Mesh *me = BKE_mesh_new_nomain(verts_len, 0, 0, polys_len * 4, polys_len);
+
+  MVert *mv = me->mvert;
+  for (int y = 0; y <= size; y++) {
+    for (int x = 0; x <= size; x++, mv++) {
+      const float u = (float)x / size, v = (float)y / size;
+      mv->co[0] = u;
+      mv->co[1] = v;
+      mv->co[2] = 0.05f * sinf(u * 20.0f) * cosf(v * 20.0f);
+    }
+  }
+
+  MPoly *mp = me->mpoly;
+  MLoop *ml = me->mloop;
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++, mp++, ml += 4) {
+      const int v = y * (size + 1) + x;
+      mp->loopstart = (int)(ml - me->mloop);
+      mp->totloop = 4;
+      mp->flag = ME_SMOOTH;
+      ml[0].v = v;
+      ml[1].v = v + 1;
+      ml[2].v = v + size + 2;
+      ml[3].v = v + size + 1;
+    }
+  }
+
+  BKE_mesh_calc_edges(me, false, false);
+  BKE_mesh_calc_normals(me);
+
+  MLoopUV *mloopuv = (MLoopUV *)CustomData_add_layer_named(
+      &me->ldata, CD_MLOOPUV, CD_CALLOC, NULL, me->totloop, "UVMap");
+  for (int i = 0; i < me->totloop; i++) {
+    copy_v2_v2(mloopuv[i].uv, me->mvert[me->mloop[i].v].co);
+  }
+  return me;
+}
+
+static void vbo_request(GPUVertBuf **vbo)
+{
+  *vbo = (GPUVertBuf *)MEM_callocN(sizeof(GPUVertBuf), __func__);
+}
+
+static void ibo_request(GPUIndexBuf **ibo)
+{
+  *ibo = (GPUIndexBuf *)MEM_callocN(sizeof(GPUIndexBuf), __func__);
+}
+
+static void mesh_buffer_cache_free(MeshBufferCache *mbc)
+{
+  GPUVertBuf **vbos = (GPUVertBuf **)&mbc->vbo;
+  GPUIndexBuf **ibos = (GPUIndexBuf **)&mbc->ibo;
+  for (uint i = 0; i < sizeof(mbc->vbo) / sizeof(void *); i++) {
+    GPU_VERTBUF_DISCARD_SAFE(vbos[i]);
+  }
+  for (uint i = 0; i < sizeof(mbc->ibo) / sizeof(void *); i++) {
+    GPU_INDEXBUF_DISCARD_SAFE(ibos[i]);
+  }
+}
+
+typedef void (*ExtractRequestFn)(MeshBufferCache &mbc);
+
+/* Time in seconds of one extraction of the buffers set by \a request, averaged over runs. */
+static double extract_time(Mesh *me, const Scene *scene, ExtractRequestFn request)
+{
+  MeshBatchCache cache = {};
+  cache.cd_used.uv = 1;
+  cache.cd_used.tan = 1;
+
+  float obmat[4][4];
+  unit_m4(obmat);
+
+  double time = 0.0;
+  /* First run is a warm-up. */
+  for (int run = -1; run < FLAGS_runs; run++) {
+    request(cache.final);
+
+    const double time_start = PIL_check_seconds_timer();
+    struct TaskGraph *task_graph = BLI_task_graph_create();
+    mesh_buffer_cache_create_requested(task_graph,
+                                       &cache,
+                                       cache.final,
+                                       me,
+                                       false,
+                                       false,
+                                       obmat,
+                                       true,
+                                       false,
+                                       false,
+                                       &cache.cd_used,
+                                       scene,
+                                       scene->toolsettings,
+                                       false);
+    BLI_task_graph_work_and_wait(task_graph);
+    BLI_task_graph_free(task_graph);
+    if (run >= 0) {
+      time += PIL_check_seconds_timer() - time_start;
+    }
+
+    EXPECT_TRUE(cache.final.vbo.pos_nor == nullptr ||
+                cache.final.vbo.pos_nor->vertex_len == (uint)me->totloop);
+    mesh_buffer_cache_free(&cache.final);
+  }
+  return time / FLAGS_runs;
+}
+
+static void extract_benchmark(const char *name, ExtractRequestFn request)
+{
+  BLI_threadapi_init();
+  BKE_idtype_init();
+
+  Mesh *me = grid_mesh_create(max_ii(FLAGS_grid_size, 1));
+  ToolSettings toolsettings = {};
+  Scene scene = {};
+  scene.toolsettings = &toolsettings;
+
+  const int max_threads = (FLAGS_max_threads > 0) ? FLAGS_max_threads :
+                                                    BLI_system_thread_count();
+
+  printf("\n%s: %d loops, %d polys\n", name, me->totloop, me->totpoly);
+  double time_single = 0.0;
+  for (int threads = 1;; threads = min_ii(threads * 2, max_threads)) {
+    BLI_system_num_threads_override_set(threads);
+    BLI_task_scheduler_init();
+
+    const double time = extract_time(me, &scene, request);
+    if (threads == 1) {
+      time_single = time;
+    }
+    printf("  %3d threads: %9.3f ms, %7.2f ns/loop, x%.2f\n",
+           threads,
+           time * 1e3,
+           time * 1e9 / me->totloop,
+           time_single / time);
+
+    BLI_task_scheduler_exit();
+    if (threads == max_threads) {
+      break;
+    }
+  }
+  BLI_system_num_threads_override_set(0);
+
+  BKE_id_free(nullptr, me);
+  BLI_threadapi_exit();
+}
+
+#define EXTRACT_BENCHMARK(name, ...) \
+  TEST(draw_extract_mesh, name) \
+  { \
+    extract_benchmark(#name, [](MeshBufferCache &mbc) { __VA_ARGS__; }); \
+  }
+
+/* Single extractions. */
+EXTRACT_BENCHMARK(pos_nor, vbo_request(&mbc.vbo.pos_nor))
+EXTRACT_BENCHMARK(lnor, vbo_request(&mbc.vbo.lnor))
+EXTRACT_BENCHMARK(uv, vbo_request(&mbc.vbo.uv))
+EXTRACT_BENCHMARK(tan, vbo_request(&mbc.vbo.tan))
+EXTRACT_BENCHMARK(edge_fac, vbo_request(&mbc.vbo.edge_fac))
+EXTRACT_BENCHMARK(fdots_pos, vbo_request(&mbc.vbo.fdots_pos))
+EXTRACT_BENCHMARK(poly_idx, vbo_request(&mbc.vbo.poly_idx))
+EXTRACT_BENCHMARK(edge_idx, vbo_request(&mbc.vbo.edge_idx))
+EXTRACT_BENCHMARK(vert_idx, vbo_request(&mbc.vbo.vert_idx))
+EXTRACT_BENCHMARK(tris, ibo_request(&mbc.ibo.tris))
+EXTRACT_BENCHMARK(lines, ibo_request(&mbc.ibo.lines))
+EXTRACT_BENCHMARK(points, ibo_request(&mbc.ibo.points))
+EXTRACT_BENCHMARK(lines_adjacency, ibo_request(&mbc.ibo.lines_adjacency))
+
+/* Buffers extracted together by common batches. */
+EXTRACT_BENCHMARK(surface,
+                  ibo_request(&mbc.ibo.tris);
+                  vbo_request(&mbc.vbo.pos_nor);
+                  vbo_request(&mbc.vbo.lnor))
+EXTRACT_BENCHMARK(surface_shaded,
+                  ibo_request(&mbc.ibo.tris);
+                  vbo_request(&mbc.vbo.pos_nor);
+                  vbo_request(&mbc.vbo.lnor);
+                  vbo_request(&mbc.vbo.uv);
+                  vbo_request(&mbc.vbo.tan))
+EXTRACT_BENCHMARK(wireframe,
+                  ibo_request(&mbc.ibo.lines);
+                  vbo_request(&mbc.vbo.pos_nor);
+                  vbo_request(&mbc.vbo.edge_fac))
+EXTRACT_BENCHMARK(selection,
+                  ibo_request(&mbc.ibo.tris);
+                  ibo_request(&mbc.ibo.lines);
+                  ibo_request(&mbc.ibo.points);
+                  vbo_request(&mbc.vbo.pos_nor);
+                  vbo_request(&mbc.vbo.poly_idx);
+                  vbo_request(&mbc.vbo.edge_idx);
+                  vbo_request(&mbc.vbo.vert_idx))